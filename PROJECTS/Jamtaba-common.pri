@@ -23,6 +23,9 @@ VPATH += $$SOURCE_PATH/Common
 DEFINES += VST_FORCE_DEPRECATED=0#enable VST 2.3 features
 DEFINES += OV_EXCLUDE_STATIC_CALLBACKS  #avoid ogg static callback warnings
 
+#debug/test builds: 'qmake CONFIG+=allocation_tripwire' reports every heap allocation made in the audio callback
+allocation_tripwire:DEFINES += JAMTABA_ALLOCATION_TRIPWIRE
+
 linux{ #avoid errors in VST SDK when compiling in Linux
     DEFINES += __cdecl=""
     QMAKE_CXXFLAGS += -D__LINUX_ALSA__
@@ -58,7 +61,13 @@ HEADERS += audio/core/LocalInputGroup.h
 HEADERS += audio/core/AudioNodeProcessor.h
 HEADERS += audio/core/AudioMixer.h
 HEADERS += audio/core/SamplesBuffer.h
+HEADERS += audio/core/SimdKernels.h
+HEADERS += audio/core/SamplesRingBuffer.h
+HEADERS += audio/core/RcuSnapshot.h
+HEADERS += audio/core/RenderPool.h
+HEADERS += audio/core/AllocationTripwire.h
 HEADERS += audio/core/AudioPeak.h
+HEADERS += audio/core/MeteringBus.h
 HEADERS += audio/core/Plugins.h
 HEADERS += audio/core/Filters.h
 HEADERS += audio/core/PluginDescriptor.h
@@ -96,6 +105,7 @@ HEADERS += MetronomeUtils.h
 HEADERS += ninjam/client/User.h
 HEADERS += ninjam/client/UserChannel.h
 HEADERS += ninjam/client/Service.h
+HEADERS += ninjam/client/UploadScheduler.h
 HEADERS += ninjam/client/ServerInfo.h
 HEADERS += ninjam/client/ServerMessages.h
 HEADERS += ninjam/client/ClientMessages.h
@@ -191,16 +201,22 @@ SOURCES += audio/Mp3Decoder.cpp
 SOURCES += audio/NinjamTrackNode.cpp
 SOURCES += audio/MetronomeTrackNode.cpp
 SOURCES += audio/core/SamplesBuffer.cpp
+SOURCES += audio/core/SimdKernels.cpp
+SOURCES += audio/core/SamplesRingBuffer.cpp
+SOURCES += audio/core/RenderPool.cpp
+SOURCES += audio/core/AllocationTripwire.cpp
 SOURCES += audio/core/PluginDescriptor.cpp
 SOURCES += audio/SamplesBufferResampler.cpp
 SOURCES += audio/vorbis/VorbisDecoder.cpp
 SOURCES += audio/vorbis/VorbisEncoder.cpp
 SOURCES += audio/core/AudioPeak.cpp
+SOURCES += audio/core/MeteringBus.cpp
 SOURCES += audio/Resampler.cpp
 SOURCES += video/FFMpegMuxer.cpp
 SOURCES += video/FFMpegDemuxer.cpp
 SOURCES += video/VideoFrameGrabber.cpp
 SOURCES += video/VideoWidget.cpp
+SOURCES += file/FileReader.cpp
 SOURCES += file/FileReaderFactory.cpp
 SOURCES += file/WaveFileReader.cpp
 SOURCES += file/OggFileReader.cpp
@@ -212,6 +228,7 @@ SOURCES += recorder/ClipSortLogGenerator.cpp
 SOURCES += ninjam/Ninjam.cpp
 SOURCES += ninjam/client/ServerInfo.cpp
 SOURCES += ninjam/client/Service.cpp
+SOURCES += ninjam/client/UploadScheduler.cpp
 SOURCES += ninjam/client/User.cpp
 SOURCES += ninjam/client/ServerMessages.cpp
 SOURCES += ninjam/client/ClientMessages.cpp
@@ -1,6 +1,7 @@
 TEMPLATE = subdirs
 
 SUBDIRS += VstScanner
+SUBDIRS += VstBridge
 
 mac {
     SUBDIRS += AUScanner
@@ -32,12 +32,17 @@ HEADERS += gui/CrashReportDialog.h
 HEADERS += audio/PortAudioDriver.h
 HEADERS += audio/Host.h
 HEADERS += midi/RtMidiDriver.h
+HEADERS += midi/MidiInputQueue.h
 HEADERS += vst/VstPlugin.h
 HEADERS += vst/VstHost.h
 HEADERS += vst/VstLoader.h
 HEADERS += PluginFinder.h
 HEADERS += vst/VstPluginFinder.h
 HEADERS += vst/Utils.h
+HEADERS += vst/VstBridge.h
+HEADERS += vst/BridgedVstPlugin.h
+HEADERS += vst/ScanMessage.h
+HEADERS += vst/PluginScanCache.h
 HEADERS += Libs/SingleApplication/singleapplication.h
 HEADERS += Libs/RtMidi/RtMidi.h
 
@@ -62,6 +67,10 @@ SOURCES += PluginFinder.cpp
 SOURCES += vst/VstPluginFinder.cpp
 SOURCES += vst/Utils.cpp
 SOURCES += vst/VstLoader.cpp
+SOURCES += vst/VstBridge.cpp
+SOURCES += vst/BridgedVstPlugin.cpp
+SOURCES += vst/ScanMessage.cpp
+SOURCES += vst/PluginScanCache.cpp
 SOURCES += Libs/SingleApplication/singleapplication.cpp
 SOURCES += Libs/RtMidi/RtMidi.cpp
 SOURCES += audio/PortAudioDriver.cpp
@@ -37,6 +37,7 @@ VPATH       += $$SOURCE_PATH/Scanners
 
 HEADERS += vst/VstHost.h
 HEADERS += vst/Utils.h
+HEADERS += vst/ScanMessage.h
 HEADERS += VstScanner/VstPluginScanner.h
 HEADERS += BaseScanner.h
 
@@ -46,6 +47,7 @@ SOURCES += VstScanner/VstPluginScanner.cpp
 SOURCES += vst/VstHost.cpp
 SOURCES += vst/VstLoader.cpp
 SOURCES += vst/Utils.cpp
+SOURCES += vst/ScanMessage.cpp
 SOURCES += audio/core/PluginDescriptor.cpp
 SOURCES += midi/MidiMessage.cpp
 SOURCES += log/logging.cpp
@@ -11,6 +11,8 @@
 #include "audio/core/AudioNode.h"
 #include "audio/core/LocalInputNode.h"
 #include "audio/core/LocalInputGroup.h"
+#include "audio/core/AllocationTripwire.h"
+#include "audio/core/AudioDriver.h"
 #include "audio/RoomStreamerNode.h"
 #include "ninjam/client/Service.h"
 #include "recorder/JamRecorder.h"
@@ -39,9 +41,9 @@ const QString MainController::CRASH_FLAG_STRING = "JamTaba closed without crash
 
 // ++++++++++++++++++++++++++++++++++++++++++++++
 
-MainController::MainController(const Settings &settings) :
+MainController::MainController(const Settings &settings, int renderWorkers) :
     loginService(this),
-    audioMixer(44100),
+    audioMixer(44100, renderWorkers),
     ninjamService(new Service()),
     settings(settings),
     mainWindow(nullptr),
@@ -50,19 +52,30 @@ MainController::MainController(const Settings &settings) :
     currentStreamingRoomID(-1000),
     started(false),
     masterGain(1),
+    masterMeterSlot(meteringBus.allocateSlot()),
+    meterPeaks(meteringBus.getMaxSlots(), AudioPeak()),
+    meterCursors(meteringBus.getMaxSlots(), 0),
     usersDataCache(Configurator::getInstance()->getCacheDir()),
     lastInputTrackID(0),
     lastFrameTimeStamp(0),
+    audioInputChannels(2),
+    audioOutputChannels(2),
+    audioMaxFrames(audio::MaxBufferSize),
     emojiManager(":/emoji/emoji.json", ":/emoji/icons")
 {
     QDir cacheDir = Configurator::getInstance()->getCacheDir();
 
+    blockMidiMessages.reserve(MAX_MIDI_MESSAGES_PER_BLOCK); // not allocating in audio thread
+    slicedMidiMessages.reserve(MAX_MIDI_MESSAGES_PER_BLOCK);
+
     // Register known JamRecorders here:
     jamRecorders.append(new recorder::JamRecorder(new recorder::ReaperProjectGenerator()));
     jamRecorders.append(new recorder::JamRecorder(new recorder::ClipSortLogGenerator()));
 
     connect(&videoEncoder, &FFMpegMuxer::dataEncoded, this, &MainController::enqueueVideoDataToUpload);
 
+    ninjamService->startNetworkThread(); // the GUI stalls are not delaying the downloads and keep alives
+
     for (auto emojiCode: settings.getRecentEmojis())
         emojiManager.addRecent(emojiCode);
 
@@ -109,6 +122,22 @@ long MainController::getTotalUploadTransferRate() const
     return ninjamService->getTotalUploadTransferRate();
 }
 
+qint64 MainController::getUploadHeadroom() const
+{
+    if (!isPlayingInNinjamRoom())
+        return 0;
+
+    return ninjamService->getUploadHeadroom();
+}
+
+int MainController::getUploadChunkSize(const UploadIntervalData &interval, bool voiceChatActivated) const
+{
+    qint64 ellapsedTime = QDateTime::currentMSecsSinceEpoch() - interval.getStartTime();
+    qint64 msToIntervalEnd = static_cast<qint64>(ninjamService->getIntervalPeriod()) - ellapsedTime;
+
+    return ninjamService->getUploadChunkSize(msToIntervalEnd, voiceChatActivated);
+}
+
 void MainController::setVideoProperties(const QSize &resolution)
 {
     QSize bestResolution(resolution);
@@ -231,6 +260,9 @@ void MainController::connectInNinjamServer(const ServerInfo &server)
     stopNinjamController();
 
     auto newNinjamController = createNinjamController();
+    newNinjamController->setAudioBuffersLayout(audioInputChannels, audioOutputChannels, audioMaxFrames); // not published yet
+
+    publishNinjamController(nullptr); // the audio thread is not using the previous controller after this point
     ninjamController.reset(newNinjamController);
 
     setupNinjamControllerSignals();
@@ -245,6 +277,8 @@ void MainController::connectInNinjamServer(const ServerInfo &server)
 
     newNinjamController->start(server);
 
+    publishNinjamController(newNinjamController);
+
     if (settings.isSaveMultiTrackActivated()) {
         QString userName = getUserName();
         QDir recordBasePath = QDir(settings.getRecordingPath());
@@ -275,7 +309,7 @@ void MainController::handleNewNinjamInterval()
             jamRecorder->newInterval();
     }
 
-    if (mainWindow->cameraIsActivated())
+    if (mainWindow && mainWindow->cameraIsActivated()) // no window when rendering offline
         videoEncoder.startNewInterval();
 }
 
@@ -289,7 +323,7 @@ void MainController::processCapturedFrame(int frameID, const QImage &frame)
 
 void MainController::requestCameraFrame(int intervalPosition)
 {
-    if (isPlayingInNinjamRoom() && mainWindow->cameraIsActivated()) {
+    if (isPlayingInNinjamRoom() && mainWindow && mainWindow->cameraIsActivated()) {
         bool isFirstPart = intervalPosition == 0;
         if (isFirstPart || canGrabNewFrameFromCamera()) {
             static int frameID = 0;
@@ -350,7 +384,8 @@ void MainController::enqueueAudioDataToUpload(const QByteArray &encodedData, qui
 
         interval.appendData(encodedData);
 
-        auto sendThreshold = isVoiceChatActivated(channelIndex) ? 1 : 4096; // when voice chat is activated jamtaba will send all small packets
+        // when voice chat is activated jamtaba will send all small packets
+        auto sendThreshold = getUploadChunkSize(interval, isVoiceChatActivated(channelIndex));
         //qDebug() << "Sending threshdold: " << sendThreshold;
         bool canSend = interval.getTotalBytes() >= sendThreshold;
         if (canSend) {
@@ -382,7 +417,7 @@ void MainController::enqueueVideoDataToUpload(const QByteArray &encodedData, boo
 
     videoIntervalToUpload->appendData(encodedData);
 
-    bool canSend = videoIntervalToUpload->getTotalBytes() >= 4096;
+    bool canSend = videoIntervalToUpload->getTotalBytes() >= getUploadChunkSize(*videoIntervalToUpload, false);
     if (canSend) {
         ninjamService->sendIntervalPart(videoIntervalToUpload->getGUID(), videoIntervalToUpload->getData(), false); // is not the last part of interval
         videoIntervalToUpload->clear();
@@ -398,11 +433,10 @@ void MainController::enqueueVideoDataToUpload(const QByteArray &encodedData, boo
 
 int MainController::getMaxAudioChannelsForEncoding(uint trackGroupIndex) const
 {
-    if (trackGroups.contains(trackGroupIndex)) {
-        audio::LocalInputGroup *group = trackGroups[trackGroupIndex];
-        if (group)
-            return group->getMaxInputChannelsForEncoding();
-    }
+    audio::RcuSnapshot<InputsSnapshot>::Reader inputs(inputsSnapshot); // called from audio thread
+    audio::LocalInputGroup *group = inputs->trackGroups.value(trackGroupIndex, nullptr);
+    if (group)
+        return group->getMaxInputChannelsForEncoding();
 
     return 0;
 }
@@ -449,8 +483,10 @@ login::Location MainController::getGeoLocation(const QString &ip)
 
 void MainController::mixGroupedInputs(int groupIndex, audio::SamplesBuffer &out)
 {
-    if (groupIndex >= 0 && groupIndex < trackGroups.size())
-        trackGroups[groupIndex]->mixGroupedInputs(out);
+    audio::RcuSnapshot<InputsSnapshot>::Reader inputs(inputsSnapshot);
+    audio::LocalInputGroup *group = inputs->trackGroups.value(groupIndex, nullptr);
+    if (group)
+        group->mixGroupedInputs(out);
 }
 
 // this is called when a new ninjam interval is received and the 'record multi track' option is enabled
@@ -478,11 +514,17 @@ void MainController::removeInputTrackNode(int inputTrackIndex)
         int trackGroupIndex = inputTrack->getChanneGroupIndex();
         if (trackGroups.contains(trackGroupIndex)) {
             trackGroups[trackGroupIndex]->removeInput(inputTrack);
-            if (trackGroups[trackGroupIndex]->isEmpty())
-                trackGroups.remove(trackGroupIndex);
         }
 
         inputTracks.remove(inputTrackIndex);
+        publishInputsSnapshot(); // the audio thread is not using the removed track and group after this point
+
+        if (trackGroups.contains(trackGroupIndex) && trackGroups[trackGroupIndex]->isEmpty()) {
+            delete trackGroups[trackGroupIndex];
+            trackGroups.remove(trackGroupIndex);
+            publishInputsSnapshot();
+        }
+
         removeTrack(inputTrackIndex);
     }
 }
@@ -499,9 +541,28 @@ int MainController::addInputTrackNode(audio::LocalInputNode *inputTrackNode)
     else
         trackGroups[trackGroupIndex]->addInputNode(inputTrackNode);
 
+    publishInputsSnapshot();
+
     return inputTrackID;
 }
 
+void MainController::publishNinjamController(controller::NinjamController *newController)
+{
+    ninjamSnapshot.update([&](NinjamSnapshot &snapshot) {
+        snapshot.controller = newController;
+    });
+}
+
+void MainController::publishInputsSnapshot()
+{
+    auto tracks = inputTracks.values();
+    auto groups = trackGroups;
+    inputsSnapshot.update([&](InputsSnapshot &snapshot) {
+        snapshot.inputTracks = tracks;
+        snapshot.trackGroups = groups;
+    });
+}
+
 audio::LocalInputNode *MainController::getInputTrack(int localInputIndex)
 {
     if (inputTracks.contains(localInputIndex))
@@ -524,6 +585,7 @@ bool MainController::addTrack(long trackID, audio::AudioNode *trackNode)
 {
     QMutexLocker locker(&mutex);
 
+    trackNode->attachMeter(&meteringBus); // before the audio thread see the node
     tracksNodes.insert(trackID, trackNode);
     audioMixer.addNode(trackNode);
 
@@ -643,13 +705,12 @@ void MainController::storeIOSettings(int firstIn, int lastIn, int firstOut, int
 
 void MainController::removeTrack(long trackID)
 {
-    QMutexLocker locker(&mutex);
-    /** remove Track is called from ninjam service thread, and cause a crash if the process callback (audio Thread) is iterating over tracksNodes to render audio */
+    QMutexLocker locker(&mutex); // removeTrack is called from GUI and ninjam service threads
 
-    auto trackNode = tracksNodes[trackID];
+    auto trackNode = tracksNodes.value(trackID, nullptr);
     if (trackNode) {
         trackNode->suspendProcessors();
-        audioMixer.removeNode(trackNode);
+        audioMixer.removeNode(trackNode); // wait until the audio thread is not using the node, so is safe to delete it
         tracksNodes.remove(trackID);
         delete trackNode;
     }
@@ -661,30 +722,38 @@ void MainController::setAllLoopersStatus(bool activated)
         inputTrack->getLooper()->setActivated(activated);
 }
 
-void MainController::doAudioProcess(const audio::SamplesBuffer &in, audio::SamplesBuffer &out, int sampleRate)
+void MainController::doAudioProcess(const audio::SamplesBuffer &in, audio::SamplesBuffer &out, int sampleRate, uint blockOffset)
 {
-    auto incommingMidi = pullMidiMessagesFromDevices();
-    audioMixer.process(in, out, sampleRate, incommingMidi);
+    // the messages inside this part of the audio block, the offsets are relative to the part start
+    midi::MidiDriver::sliceMessages(blockMidiMessages, blockOffset, out.getFrameLenght(), slicedMidiMessages);
+
+    audioMixer.process(in, out, sampleRate, slicedMidiMessages);
 
     out.applyGain(masterGain, 1.0f); // using 1 as boost factor/multiplier (no boost)
-    masterPeak.update(out.computePeak());
+    meteringBus.publish(masterMeterSlot, out.computePeak());
 }
 
 void MainController::process(const audio::SamplesBuffer &in, audio::SamplesBuffer &out, int sampleRate)
 {
-    QMutexLocker locker(&mutex);
+    audio::tripwire::AudioThreadScope audioThreadScope; // report allocations in audio thread (when building with CONFIG+=allocation_tripwire)
 
+    // no locks here, the mixer nodes, the input tracks and the ninjam controller are snapshots published by the GUI thread
     if (!started)
         return;
 
+    // MIDI is pulled one time per callback. NinjamController is splitting the block in the interval end.
+    const qint64 blockStartTime = midi::MidiDriver::getHostTime();
+    blockMidiMessages.clear();
+    pullMidiMessagesFromDevices(blockMidiMessages);
+    midi::MidiDriver::computeFrameOffsets(blockMidiMessages, blockStartTime, out.getFrameLenght(), sampleRate);
+
     try
     {
-        if (!isPlayingInNinjamRoom()) {
+        audio::RcuSnapshot<NinjamSnapshot>::Reader ninjam(ninjamSnapshot); // the controller is not deleted while the reader is alive
+        if (ninjam->controller && ninjam->controller->isRunning())
+            ninjam->controller->process(in, out, sampleRate);
+        else
             doAudioProcess(in, out, sampleRate);
-        } else {
-            if (ninjamController)
-                ninjamController->process(in, out, sampleRate);
-        }
     }
     catch (...)
     {
@@ -699,20 +768,29 @@ void MainController::process(const audio::SamplesBuffer &in, audio::SamplesBuffe
     }
 }
 
+void MainController::setAudioBuffersLayout(int inputChannels, int outputChannels, int maxFrames)
+{
+    audioInputChannels = inputChannels;
+    audioOutputChannels = outputChannels;
+    audioMaxFrames = maxFrames;
+
+    if (ninjamController)
+        ninjamController->setAudioBuffersLayout(inputChannels, outputChannels, maxFrames); // the audio driver is stopped
+}
+
 void MainController::syncWithNinjamIntervalStart(uint intervalLenght)
 {
-    for (auto inputTrack : inputTracks.values())
+    audio::RcuSnapshot<InputsSnapshot>::Reader inputs(inputsSnapshot); // called from audio thread
+    for (auto inputTrack : inputs->inputTracks)
         inputTrack->startNewLoopCycle(intervalLenght);
 }
 
 audio::AudioPeak MainController::getTrackPeak(int trackID)
 {
-    // QMutexLocker locker(&mutex);
-
-    auto trackNode = tracksNodes[trackID];
+    auto trackNode = tracksNodes.value(trackID, nullptr);
 
     if (trackNode && !trackNode->isMuted())
-        return trackNode->getLastPeak();
+        return getMeterPeak(trackNode->getMeterSlot());
 
     if (!trackNode)
         qWarning(jtGUI) << "trackNode not found! ID:" << trackID;
@@ -722,7 +800,31 @@ audio::AudioPeak MainController::getTrackPeak(int trackID)
 
 audio::AudioPeak MainController::getRoomStreamPeak()
 {
-    return roomStreamer->getLastPeak();
+    return getMeterPeak(roomStreamer->getMeterSlot());
+}
+
+void MainController::updateMeters()
+{
+    // the max of all blocks published since the last frame, the short peaks are not lost
+    for (int slot = 0; slot < meteringBus.getMaxSlots(); ++slot)
+        meterPeaks[slot] = meteringBus.readMaxPeak(slot, meterCursors[slot]);
+}
+
+int MainController::getTrackMeterSlot(int trackID) const
+{
+    auto trackNode = tracksNodes.value(trackID, nullptr);
+    if (trackNode)
+        return trackNode->getMeterSlot();
+
+    return -1;
+}
+
+audio::AudioPeak MainController::getMeterPeak(int meterSlot) const
+{
+    if (meterSlot >= 0 && meterSlot < static_cast<int>(meterPeaks.size()))
+        return meterPeaks[meterSlot];
+
+    return audio::AudioPeak();
 }
 
 void MainController::setVoiceChatStatus(int channelID, bool voiceChatActivated)
@@ -735,8 +837,10 @@ void MainController::setVoiceChatStatus(int channelID, bool voiceChatActivated)
 
 bool MainController::isVoiceChatActivated(int channelID) const
 {
-    if (trackGroups.contains(channelID))
-        return trackGroups[channelID]->isVoiceChatActivated();
+    audio::RcuSnapshot<InputsSnapshot>::Reader inputs(inputsSnapshot);
+    audio::LocalInputGroup *group = inputs->trackGroups.value(channelID, nullptr);
+    if (group)
+        return group->isVoiceChatActivated();
 
     return false;
 }
@@ -752,8 +856,10 @@ void MainController::setTransmitingStatus(int channelID, bool transmiting)
 
 bool MainController::isTransmiting(int channelID) const
 {
-    if (trackGroups.contains(channelID))
-        return trackGroups[channelID]->isTransmiting();
+    audio::RcuSnapshot<InputsSnapshot>::Reader inputs(inputsSnapshot); // called from audio thread
+    audio::LocalInputGroup *group = inputs->trackGroups.value(channelID, nullptr);
+    if (group)
+        return group->isTransmiting();
 
     return false;
 }
@@ -872,15 +978,18 @@ MainController::~MainController()
 
     tracksNodes.clear();
 
-    for (auto input : inputTracks)
-        delete input;
+    auto inputs = inputTracks.values();
+    auto groups = trackGroups.values();
 
     inputTracks.clear();
+    trackGroups.clear();
+    publishInputsSnapshot(); // the audio thread is not seeing the inputs after this point
 
-    for (auto group : trackGroups)
-        delete group;
+    for (auto input : inputs)
+        delete input;
 
-    trackGroups.clear();
+    for (auto group : groups)
+        delete group;
 
     qCDebug(jtCore()) << "cleaning tracksNodes done!";
 
@@ -1017,6 +1126,7 @@ void MainController::start()
         qCInfo(jtCore) << "Creating roomStreamer ...";
 
         roomStreamer.reset(new audio::NinjamRoomStreamerNode()); // new Audio::AudioFileStreamerNode(":/teste.mp3");
+        roomStreamer->attachMeter(&meteringBus);
         this->audioMixer.addNode(roomStreamer.data());
 
         connect(ninjamService.data(), &Service::connectedInServer, this, &MainController::connectInNinjamServer);
@@ -9,6 +9,8 @@
 #include "persistence/Settings.h"
 #include "persistence/UsersDataCache.h"
 #include "audio/core/AudioMixer.h"
+#include "audio/core/MeteringBus.h"
+#include "audio/core/RcuSnapshot.h"
 #include "midi/MidiDriver.h"
 #include "video/FFMpegMuxer.h"
 #include "gui/chat/EmojiManager.h"
@@ -59,6 +61,7 @@ using audio::LocalInputGroup;
 using audio::SamplesBuffer;
 using audio::AbstractMp3Streamer;
 using audio::AudioMixer;
+using audio::MeteringBus;
 using login::RoomInfo;
 using login::LoginService;
 using recorder::JamRecorder;
@@ -70,7 +73,7 @@ class MainController : public QObject
     friend class controller::NinjamController;
 
 protected:
-    explicit MainController(const Settings &settings);
+    explicit MainController(const Settings &settings, int renderWorkers = -1); // see AudioMixer
 
 public:
 
@@ -82,6 +85,7 @@ public:
     long getTotalUploadTransferRate() const;
     long getTotalDownloadTransferRate() const;
     long getDownloadTransferRate(const QString userFullName, quint8 channelIndex) const;
+    qint64 getUploadHeadroom() const;
 
     void setVideoProperties(const QSize &resolution);
 
@@ -95,8 +99,6 @@ public:
 
     MainWindow *getMainWindow() const;
 
-    virtual std::vector<midi::MidiMessage> pullMidiMessagesFromPlugins() = 0;     // pull midi messages generated by plugins. This function can be called many times in each audio processing cicle because every VSTi can be a midi messages generator, and we need get the generated messages after call the plugin 'process' function.
-
     void saveLastUserSettings(const LocalInputTrackSettings &inputsSettings);
 
     // presets
@@ -109,6 +111,9 @@ public:
     // main audio processing routine
     virtual void process(const SamplesBuffer &in, SamplesBuffer &out, int sampleRate);
 
+    // the channels and the max frames of the buffers passed to process(). Called when the audio driver is reconfigured, not in the audio callback.
+    void setAudioBuffersLayout(int inputChannels, int outputChannels, int maxFrames);
+
     void sendNewChannelsNames(const QList<ChannelMetadata> &channels);
     void sendRemovedChannelMessage(int removedChannelIndex);
 
@@ -173,6 +178,11 @@ public:
     AudioPeak getTrackPeak(int trackID);
     AudioPeak getMasterPeak();
 
+    // the GUI read all meters in one pass (one time per frame) and get the peaks using the track meter slots
+    void updateMeters();
+    int getTrackMeterSlot(int trackID) const;
+    AudioPeak getMeterPeak(int meterSlot) const;
+
     float getMasterGain() const;
 
     void setMasterGain(float newGain);
@@ -337,6 +347,8 @@ protected:
 
     QMap<QString, login::Location> locationCache;
 
+    MeteringBus meteringBus; // declared before the nodes owners, the nodes are releasing the meter slots when deleted
+
     AudioMixer audioMixer;
 
     // ninjam
@@ -361,11 +373,15 @@ protected:
 
     virtual void setCSS(const QString &css) = 0;
 
-    virtual std::vector<midi::MidiMessage> pullMidiMessagesFromDevices() = 0;     // pull midi messages generated by midi controllers. This function is called just one time in each audio processing cicle.
+    virtual void pullMidiMessagesFromDevices(std::vector<midi::MidiMessage> &outBuffer) = 0;     // pull midi messages generated by midi controllers (appended in the preallocated outBuffer). This function is called just one time in each audio processing cicle.
 
-    // audio process is here too (see MainController::process)
+    // audio process is here too (see MainController::process). The blockOffset is the position of 'out' in the audio callback block.
     virtual void doAudioProcess(const SamplesBuffer &in, SamplesBuffer &out,
-                                int sampleRate);
+                                int sampleRate, uint blockOffset = 0);
+
+    std::vector<midi::MidiMessage> blockMidiMessages; // pulled from devices in each audio callback
+    std::vector<midi::MidiMessage> slicedMidiMessages; // messages for the current doAudioProcess call, preallocated
+    static const int MAX_MIDI_MESSAGES_PER_BLOCK = 512;
 
     virtual void syncWithNinjamIntervalStart(uint intervalLenght);
 
@@ -379,6 +395,33 @@ private:
 
     QMap<int, LocalInputGroup *> trackGroups;
 
+    /**
+        Immutable copy of the input tracks and groups used in the audio thread. The GUI changes
+        'inputTracks' and 'trackGroups' and publish a new snapshot, the audio thread never locks.
+    */
+    struct InputsSnapshot
+    {
+        QList<LocalInputNode *> inputTracks;
+        QMap<int, LocalInputGroup *> trackGroups;
+    };
+
+    audio::RcuSnapshot<InputsSnapshot> inputsSnapshot;
+
+    void publishInputsSnapshot();
+
+    /**
+        The ninjam controller used in the audio thread. 'ninjamController' is replaced (and the previous
+        controller deleted) only after publishing nullptr, when the audio thread is not using it anymore.
+    */
+    struct NinjamSnapshot
+    {
+        controller::NinjamController *controller = nullptr;
+    };
+
+    audio::RcuSnapshot<NinjamSnapshot> ninjamSnapshot;
+
+    void publishNinjamController(controller::NinjamController *newController);
+
     QMap<int, bool> getXmitChannelsFlags() const;
 
     QMap<long, AudioNode *> tracksNodes;
@@ -394,7 +437,11 @@ private:
 
     // master
     float masterGain;
-    AudioPeak masterPeak;
+    int masterMeterSlot;
+
+    // indexed by meter slot, updated by the GUI in each frame
+    std::vector<AudioPeak> meterPeaks;
+    std::vector<quint64> meterCursors; // the next history block in the metering bus
 
     UsersDataCache usersDataCache;
 
@@ -406,10 +453,16 @@ private:
 
     quint64 lastFrameTimeStamp;
 
+    int audioInputChannels; // the ninjam controller buffers are preallocated using this layout
+    int audioOutputChannels;
+    int audioMaxFrames;
+
     void recreateMetronome();
 
     uint getFramesPerInterval() const;
 
+    int getUploadChunkSize(const UploadIntervalData &interval, bool voiceChatActivated) const; // adapted to the uplink rate and the time left in interval
+
     static const QString CRASH_FLAG_STRING;
 
     EmojiManager emojiManager;
@@ -542,7 +595,8 @@ inline int MainController::getInputTracksCount() const
 
 inline int MainController::getInputTrackGroupsCount() const
 {
-    return trackGroups.size();     // return the track groups (channels) count
+    audio::RcuSnapshot<InputsSnapshot>::Reader inputs(inputsSnapshot); // called from audio thread
+    return inputs->trackGroups.size();     // return the track groups (channels) count
 }
 
 inline bool MainController::isStarted() const
@@ -552,7 +606,7 @@ inline bool MainController::isStarted() const
 
 inline AudioPeak MainController::getMasterPeak()
 {
-    return masterPeak;
+    return getMeterPeak(masterMeterSlot);
 }
 
 inline float MainController::getMasterGain() const
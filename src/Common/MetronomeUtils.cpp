@@ -160,8 +160,7 @@ void metronomeUtils::createResampledBuffer(const SamplesBuffer &buffer, SamplesB
     outBuffer.setFrameLenght(finalSize);
 
     for (int c = 0; c < channels; ++c) {
-        SimpleResampler resampler;
-        resampler.process(buffer.getSamplesArray(c),
+        PolyphaseResampler::resample(buffer.getSamplesArray(c),
                           buffer.getFrameLenght(), outBuffer.getSamplesArray(c), finalSize);
     }
 }
@@ -29,105 +29,170 @@
 #include <QDebug>
 #include <QThread>
 #include <QFileInfo>
-#include <QWaitCondition>
+
+#include "audio/readerwriterqueue.h"
 
 #include <cmath>
 #include <cassert>
 #include <vector>
+#include <atomic>
 
 using controller::NinjamController;
 using ninjam::client::ServerInfo;
 
-// +++++++++++++  ENCODING THREAD  +++++++++++++
+// +++++++++++++  ENCODING POOL  +++++++++++++
 
-class NinjamController::EncodingThread : public QThread // TODO: use better thread approach, avoid inheritance form QThread
+/**
+ * Encode the input channels in parallel. Each channel is pinned to one worker thread
+ * (channelIndex % workers), so the chunks of a channel are encoded in order by the same
+ * vorbis::Encoder. The audio thread copy the samples to recycled (preallocated) chunks and
+ * push just pointers to the workers using lock free SPSC queues.
+ */
+class NinjamController::EncodingPool
 {
 public:
 
-    explicit EncodingThread(NinjamController *controller) :
-        stopRequested(false),
-        controller(controller)
+    explicit EncodingPool(NinjamController *controller)
     {
-        qCDebug(jtNinjamCore) << "Starting Encoding Thread";
-        start();
-    }
+        int workersCount = QThread::idealThreadCount() - 1; // keeping one core to audio thread
+        if (workersCount > MAX_WORKERS)
+            workersCount = MAX_WORKERS;
+        if (workersCount < 1)
+            workersCount = 1;
 
-    ~EncodingThread()
-    {
-        stop();
+        qCDebug(jtNinjamCore) << "Starting Encoding Pool with" << workersCount << "workers";
+
+        for (int i = 0; i < workersCount; ++i)
+            workers.push_back(new Worker(controller));
+
+        for (int c = 0; c < MAX_ENCODING_CHANNELS; ++c) {
+            fillingChunks[c] = nullptr;
+            pendingFirstPart[c] = false;
+            pendingLastPart[c] = false;
+        }
     }
 
-    void addSamplesToEncode(const audio::SamplesBuffer &samplesToEncode, quint8 channelIndex,
-                            bool isFirstPart, bool isLastPart)
+    ~EncodingPool()
     {
-        // qCDebug(jtNinjamCore) << "Adding samples to encode";
-        QMutexLocker locker(&mutex);
-        chunksToEncode.push_back(EncodingChunk(samplesToEncode, channelIndex, isFirstPart,
-                                               isLastPart));
-        // this method is called by Qt main thread (the producer thread).
-        hasAvailableChunksToEncode.wakeAll();// wakeup the encoding thread (consumer thread)
+        for (Worker *worker : workers)
+            delete worker; // the worker wait the thread finish
+
+        for (int c = 0; c < MAX_ENCODING_CHANNELS; ++c)
+            delete fillingChunks[c];
+
+        qCDebug(jtNinjamCore) << "Encoding pool stopped!";
     }
 
-    void stop()
+    // called by the audio thread, the samples are accumulated until a chunk is full or the interval is finished
+    void addSamplesToEncode(const audio::SamplesBuffer &samples, quint8 channelIndex, bool isFirstPart, bool isLastPart)
     {
-        if (!stopRequested)
-        {
-            // QMutexLocker locker(&mutex);
-            stopRequested = true;
-            hasAvailableChunksToEncode.wakeAll();
-            qCDebug(jtNinjamCore) << "Stopping Encoding Thread";
-        }
-    }
+        if (channelIndex >= MAX_ENCODING_CHANNELS)
+            return;
 
-protected:
+        Worker *worker = workers[channelIndex % workers.size()];
 
-    void run()
-    {
-        while (!stopRequested)
+        const uint totalFrames = samples.getFrameLenght();
+        uint offset = 0;
+        do
         {
-            mutex.lock();
-            if (chunksToEncode.empty())
-                hasAvailableChunksToEncode.wait(&mutex);
-
-            if (stopRequested)
+            EncodingChunk *chunk = fillingChunks[channelIndex];
+            if (chunk && chunk->buffer.getChannels() != samples.getChannels()) // channels changed, send the accumulated samples
             {
-                mutex.unlock();
-                break;
+                worker->enqueue(chunk);
+                chunk = nullptr;
             }
 
-            EncodingChunk chunk = !chunksToEncode.empty() ? chunksToEncode.front() : EncodingChunk(
-                audio::SamplesBuffer::ZERO_BUFFER, 0, false, false);
+            if (!chunk)
+            {
+                if (pendingLastPart[channelIndex] && !sendPendingLastPart(worker, channelIndex, samples.getChannels()))
+                    chunk = nullptr;
+                else
+                    chunk = worker->acquireChunk();
 
-            chunksToEncode.erase(chunksToEncode.begin()); // remove first element
+                if (!chunk) // encoder is too late and all chunks are in use. Dropping samples instead of allocating memory in audio thread.
+                {
+                    // the interval flags are not dropped, the Ogg stream is always closed
+                    if (isFirstPart && offset == 0)
+                        pendingFirstPart[channelIndex] = true;
+                    if (isLastPart)
+                        pendingLastPart[channelIndex] = true;
+
+                    fillingChunks[channelIndex] = nullptr;
+                    return;
+                }
 
-            mutex.unlock();
+                chunk->reset(channelIndex, samples.getChannels(), (isFirstPart && offset == 0) || pendingFirstPart[channelIndex]);
+                pendingFirstPart[channelIndex] = false;
+            }
+            fillingChunks[channelIndex] = chunk;
 
-            if (!chunk.buffer.isEmpty())
-            {
-                QByteArray encodedBytes(controller->encode(chunk.buffer, chunk.channelIndex));
-                if (chunk.lastPart)
-                    encodedBytes.append(controller->encodeLastPartOfInterval(chunk.channelIndex));
+            const uint chunkFrames = chunk->buffer.getFrameLenght();
+            const uint framesToCopy = std::min(totalFrames - offset, CHUNK_FRAMES - chunkFrames);
+            chunk->buffer.setFrameLenght(chunkFrames + framesToCopy);
+            chunk->buffer.set(samples, offset, framesToCopy, chunkFrames);
+            offset += framesToCopy;
 
-                if (!encodedBytes.isEmpty())
-                    emit controller->encodedAudioAvailableToSend(encodedBytes, chunk.channelIndex,
-                                                                 chunk.firstPart, chunk.lastPart);
+            const bool chunkIsFull = chunk->buffer.getFrameLenght() >= CHUNK_FRAMES;
+            const bool intervalFinished = isLastPart && offset >= totalFrames;
+            if (chunkIsFull || intervalFinished)
+            {
+                chunk->lastPart = intervalFinished;
+                worker->enqueue(chunk);
+                fillingChunks[channelIndex] = nullptr;
             }
         }
-        qCDebug(jtNinjamCore) << "Encoding thread stopped!";
+        while (offset < totalFrames);
     }
 
 private:
 
+    class Worker;
+
+    // an empty chunk closing the interval whose last samples were dropped, sent before the next samples
+    bool sendPendingLastPart(Worker *worker, quint8 channelIndex, int channels)
+    {
+        EncodingChunk *chunk = worker->acquireChunk();
+        if (!chunk)
+            return false;
+
+        chunk->reset(channelIndex, channels, pendingFirstPart[channelIndex]);
+        chunk->lastPart = true;
+        worker->enqueue(chunk);
+
+        pendingFirstPart[channelIndex] = false;
+        pendingLastPart[channelIndex] = false;
+
+        return true;
+    }
+
+    static const int MAX_WORKERS = 4;
+    static const int MAX_ENCODING_CHANNELS = 32;
+    static const uint CHUNK_FRAMES = 1024; // small blocks are accumulated to reduce the encoding overhead
+    static const int CHUNKS_PER_WORKER = 64;
+
     class EncodingChunk
     {
     public:
-        EncodingChunk(const audio::SamplesBuffer &buffer, quint8 channelIndex, bool firstPart,
-                      bool lastPart) :
-            buffer(buffer),
-            channelIndex(channelIndex),
-            firstPart(firstPart),
-            lastPart(lastPart)
+        EncodingChunk() :
+            buffer(2),
+            channelIndex(0),
+            firstPart(false),
+            lastPart(false)
         {
+            buffer.reserve(CHUNK_FRAMES);
+        }
+
+        void reset(quint8 channelIndex, int channels, bool firstPart)
+        {
+            if (channels == 1)
+                buffer.setToMono();
+            else
+                buffer.setToStereo();
+
+            buffer.setFrameLenght(0);
+            this->channelIndex = channelIndex;
+            this->firstPart = firstPart;
+            this->lastPart = false;
         }
 
         audio::SamplesBuffer buffer;
@@ -136,11 +201,83 @@ private:
         bool lastPart;
     };
 
-    std::vector<EncodingChunk> chunksToEncode;
-    QMutex mutex;
-    volatile bool stopRequested;
-    NinjamController *controller;
-    QWaitCondition hasAvailableChunksToEncode;
+    class Worker : public QThread
+    {
+    public:
+        explicit Worker(NinjamController *controller) :
+            chunksToEncode(CHUNKS_PER_WORKER),
+            freeChunks(CHUNKS_PER_WORKER),
+            stopRequested(false),
+            controller(controller)
+        {
+            for (int i = 0; i < CHUNKS_PER_WORKER; ++i)
+                freeChunks.enqueue(new EncodingChunk());
+
+            start();
+        }
+
+        ~Worker()
+        {
+            stopRequested = true;
+            wait();
+
+            EncodingChunk *chunk = nullptr;
+            while (chunksToEncode.try_dequeue(chunk))
+                delete chunk;
+
+            while (freeChunks.try_dequeue(chunk))
+                delete chunk;
+        }
+
+        EncodingChunk *acquireChunk() // audio thread
+        {
+            EncodingChunk *chunk = nullptr;
+            freeChunks.try_dequeue(chunk);
+            return chunk;
+        }
+
+        void enqueue(EncodingChunk *chunk) // audio thread
+        {
+            chunksToEncode.try_enqueue(chunk); // never allocate, the queue capacity is the total of chunks
+        }
+
+    protected:
+        void run() override
+        {
+            while (!stopRequested)
+            {
+                EncodingChunk *chunk = nullptr;
+                if (!chunksToEncode.wait_dequeue_timed(chunk, 100000)) // waking up every 100 ms to check stopRequested
+                    continue;
+
+                if (!chunk->buffer.isEmpty() || chunk->lastPart)
+                {
+                    QByteArray encodedBytes(controller->encode(chunk->buffer, chunk->channelIndex));
+                    if (chunk->lastPart)
+                        encodedBytes.append(controller->encodeLastPartOfInterval(chunk->channelIndex));
+
+                    if (!encodedBytes.isEmpty())
+                        emit controller->encodedAudioAvailableToSend(encodedBytes, chunk->channelIndex,
+                                                                     chunk->firstPart, chunk->lastPart);
+                }
+
+                freeChunks.try_enqueue(chunk); // recycling
+            }
+        }
+
+    private:
+        moodycamel::BlockingReaderWriterQueue<EncodingChunk *> chunksToEncode; // audio thread -> worker
+        moodycamel::ReaderWriterQueue<EncodingChunk *> freeChunks; // worker -> audio thread
+        std::atomic<bool> stopRequested;
+        NinjamController *controller;
+    };
+
+    std::vector<Worker *> workers;
+    EncodingChunk *fillingChunks[MAX_ENCODING_CHANNELS]; // chunks being filled by audio thread, one per channel
+
+    // interval flags of dropped samples, carried by the next acquired chunk
+    bool pendingFirstPart[MAX_ENCODING_CHANNELS];
+    bool pendingLastPart[MAX_ENCODING_CHANNELS];
 };
 
 // +++++++++++++++++ Nested classes to handle schedulable events ++++++++++++++++
@@ -228,6 +365,62 @@ private:
     bool voiceChannelActivated;
 };
 
+// +++++++++++++  DOWNLOADED INTERVALS  +++++++++++++
+
+/**
+ * The downloaded intervals are decoded by decoders created in the network thread (never holding the mutex
+ * used in process()). The decoders are added to the tracks in the audio thread, in process().
+ */
+class NinjamController::DownloadedIntervals
+{
+public:
+    DownloadedIntervals() :
+        intervals(64)
+    {
+    }
+
+    ~DownloadedIntervals()
+    {
+        discardAll();
+    }
+
+    // network thread
+    void enqueue(long trackID, NinjamTrackNode::IntervalDecoder *decoder)
+    {
+        QMutexLocker locker(&producerMutex); // single producer queue
+        intervals.enqueue(DownloadedInterval{trackID, decoder});
+    }
+
+    // audio thread, or any thread holding the NinjamController mutex
+    bool tryDequeue(long &trackID, NinjamTrackNode::IntervalDecoder *&decoder)
+    {
+        DownloadedInterval interval;
+        if (!intervals.try_dequeue(interval))
+            return false;
+
+        trackID = interval.trackID;
+        decoder = interval.decoder;
+        return true;
+    }
+
+    void discardAll()
+    {
+        DownloadedInterval interval;
+        while (intervals.try_dequeue(interval))
+            NinjamTrackNode::discardIntervalDecoder(interval.decoder);
+    }
+
+private:
+    struct DownloadedInterval
+    {
+        long trackID;
+        NinjamTrackNode::IntervalDecoder *decoder;
+    };
+
+    moodycamel::ReaderWriterQueue<DownloadedInterval> intervals;
+    QMutex producerMutex;
+};
+
 // +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 
 NinjamController::NinjamController(controller::MainController *mainController) :
@@ -240,11 +433,19 @@ NinjamController::NinjamController(controller::MainController *mainController) :
     currentBpm(0),
     mutex(QMutex::Recursive),
     encodersMutex(QMutex::Recursive),
-    encodingThread(nullptr),
+    encodingPool(nullptr),
+    downloadedIntervals(new DownloadedIntervals()),
+    tempInBuffer(2),
+    tempOutBuffer(2),
+    inputMixBuffer(2),
     preparedForTransmit(false),
     waitingIntervals(0) // waiting for start transmit
 {
     running = false;
+
+    tempInBuffer.reserve(audio::MaxBufferSize);
+    tempOutBuffer.reserve(audio::MaxBufferSize);
+    inputMixBuffer.reserve(audio::MaxBufferSize);
 }
 
 User NinjamController::getUserByName(const QString &userName) const
@@ -270,7 +471,7 @@ void NinjamController::setBpm(int newBpm)
 
 void NinjamController::removeEncoder(int groupChannelIndex)
 {
-    QMutexLocker locker(&mutex);
+    QMutexLocker locker(&encodersMutex);
     if (encoders.contains(groupChannelIndex))
         encoders.remove(groupChannelIndex);
 }
@@ -285,6 +486,10 @@ void NinjamController::process(const audio::SamplesBuffer &in, audio::SamplesBuf
     if (!running || samplesInInterval <= 0)
         return; // not initialized
 
+    audio::RcuSnapshot<TrackNodes>::Reader tracks(processedTracks); // lock free, the tracks can be added and removed while we are processing
+
+    addDownloadedIntervals(*tracks);
+
     int totalSamplesToProcess = out.getFrameLenght();
     int samplesProcessed = 0;
 
@@ -300,16 +505,16 @@ void NinjamController::process(const audio::SamplesBuffer &in, audio::SamplesBuf
 
         assert(samplesToProcessInThisStep);
 
-        static audio::SamplesBuffer tempOutBuffer(out.getChannels(), samplesToProcessInThisStep);
+        // the temp buffers are preallocated in setAudioBuffersLayout, using the audio driver channels
         tempOutBuffer.setFrameLenght(samplesToProcessInThisStep);
         tempOutBuffer.zero();
 
-        audio::SamplesBuffer tempInBuffer(in.getChannels(), samplesToProcessInThisStep);
+        tempInBuffer.setFrameLenght(samplesToProcessInThisStep);
         tempInBuffer.set(in, offset, samplesToProcessInThisStep, 0);
 
         bool newInterval = intervalPosition == 0;
         if (newInterval)   // starting new interval
-            handleNewInterval();
+            handleNewInterval(*tracks);
 
         metronomeTrackNode->setIntervalPosition(this->intervalPosition);
         int currentBeat = intervalPosition / getSamplesPerBeat();
@@ -323,7 +528,7 @@ void NinjamController::process(const audio::SamplesBuffer &in, audio::SamplesBuf
         bool isLastPart = intervalPosition + samplesToProcessInThisStep >= samplesInInterval;
         //for (NinjamTrackNode *track : trackNodes)
         //    track->setProcessingLastPartOfInterval(isLastPart); // TODO resampler still need a flag indicating the last part?
-        mainController->doAudioProcess(tempInBuffer, tempOutBuffer, sampleRate);
+        mainController->doAudioProcess(tempInBuffer, tempOutBuffer, sampleRate, offset); // the midi messages are sliced too
         out.add(tempOutBuffer, offset); // generate audio output
         // ++++++++++++++++++++++++++++++++++++++++++++++++++++++
 
@@ -339,16 +544,22 @@ void NinjamController::process(const audio::SamplesBuffer &in, audio::SamplesBuf
                     int channels = mainController->getMaxAudioChannelsForEncoding(groupIndex);
                     if (channels > 0)
                     {
-                        audio::SamplesBuffer inputMixBuffer(channels, samplesToProcessInThisStep);
+                        if (channels == 1)
+                            inputMixBuffer.setToMono();
+                        else
+                            inputMixBuffer.setToStereo();
+
+                        inputMixBuffer.setFrameLenght(samplesToProcessInThisStep);
 
                         if (encoders.contains(groupIndex))
                         {
                             inputMixBuffer.zero();
                             mainController->mixGroupedInputs(groupIndex, inputMixBuffer);
 
-                            // encoding is running in another thread to avoid slow down the audio thread
-                            encodingThread->addSamplesToEncode(inputMixBuffer, groupIndex,
-                                                               isFirstPart, isLastPart);
+                            // encoding is running in other threads to avoid slow down the audio thread
+                            if (encodingPool)
+                                encodingPool->addSamplesToEncode(inputMixBuffer, groupIndex,
+                                                                 isFirstPart, isLastPart);
                         }
                     }
                 }
@@ -415,10 +626,47 @@ void NinjamController::recreateMetronome(int newSampleRate)
 
 void NinjamController::stop(bool emitDisconnectedSignal)
 {
+    qCDebug(jtNinjamCore) << "NinjamController destructor - disconnecting...";
+
+    // the service signals are disconnected before removing the tracks, the network thread stops handing intervals to the tracks
+    auto ninjamService = mainController->getNinjamService();
+    disconnect(ninjamService, &Service::serverBpmChanged, this,
+               &NinjamController::scheduleBpmChangeEvent);
+    disconnect(ninjamService, &Service::serverBpiChanged, this,
+               &NinjamController::scheduleBpiChangeEvent);
+    disconnect(ninjamService, &Service::audioIntervalCompleted, this,
+               &NinjamController::handleIntervalCompleted);
+    disconnect(ninjamService, &Service::audioIntervalCompleted, this,
+               &NinjamController::recordDownloadedInterval);
+
+    disconnect(ninjamService, &Service::userChannelCreated, this,
+               &NinjamController::addNinjamRemoteChannel);
+    disconnect(ninjamService, &Service::userChannelRemoved, this,
+               &NinjamController::removeNinjamRemoteChannel);
+    disconnect(ninjamService, &Service::userChannelUpdated, this,
+               &NinjamController::updateNinjamRemoteChannel);
+    disconnect(ninjamService, &Service::audioIntervalDownloading, this,
+               &NinjamController::handleIntervalDownloading);
+
+    disconnect(ninjamService, &Service::publicChatMessageReceived, this,
+               &NinjamController::publicChatMessageReceived);
+    disconnect(ninjamService, &Service::privateChatMessageReceived, this,
+               &NinjamController::privateChatMessageReceived);
+    disconnect(ninjamService, &Service::serverTopicMessageReceived, this,
+               &NinjamController::topicMessageReceived);
+
     if (isRunning())
     {
         this->running = false;
 
+        QList<NinjamTrackNode *> removedTracks;
+        {
+            QMutexLocker tracksLocker(&tracksMutex); // a disconnected slot can be still running in the network thread
+            removedTracks = trackNodes.values();
+            trackNodes.clear();
+            publishTrackNodes();
+        } // the mixer is waiting the audio thread in removeTrack(), the mutexes are not locked
+
         // store metronome settings
         auto metronomeTrack = mainController->getTrackNode(METRONOME_TRACK_ID);
         if (metronomeTrack)
@@ -432,22 +680,25 @@ void NinjamController::stop(bool emitDisconnectedSignal)
         }
 
         // clear all tracks
-        for (auto trackNode : trackNodes.values())
+        for (auto trackNode : removedTracks)
             mainController->removeTrack(trackNode->getID());
-        trackNodes.clear();
+
+        QMutexLocker locker(&mutex);
+        downloadedIntervals->discardAll(); // not added in process()
     }
 
-    if (encodingThread)
+    EncodingPool *pool = nullptr;
     {
-        encodingThread->stop();
-        encodingThread->wait(); // wait the encoding thread to finish
-        delete encodingThread;
-        encodingThread = nullptr;
+        QMutexLocker locker(&mutex); // audio thread is using the pool in process()
+        pool = encodingPool;
+        encodingPool = nullptr;
     }
+    delete pool; // wait the encoding workers finish
 
-    for (AudioEncoder *encoder : encoders.values())
-        delete encoder;
-    encoders.clear();
+    {
+        QMutexLocker locker(&encodersMutex);
+        encoders.clear();
+    }
 
     // delete possible non consumed events
     for (SchedulableEvent *e : scheduledEvents)
@@ -455,32 +706,6 @@ void NinjamController::stop(bool emitDisconnectedSignal)
 
     scheduledEvents.clear();
 
-    qCDebug(jtNinjamCore) << "NinjamController destructor - disconnecting...";
-
-    auto ninjamService = mainController->getNinjamService();
-    disconnect(ninjamService, &Service::serverBpmChanged, this,
-               &NinjamController::scheduleBpmChangeEvent);
-    disconnect(ninjamService, &Service::serverBpiChanged, this,
-               &NinjamController::scheduleBpiChangeEvent);
-    disconnect(ninjamService, &Service::audioIntervalCompleted, this,
-               &NinjamController::handleIntervalCompleted);
-
-    disconnect(ninjamService, &Service::userChannelCreated, this,
-               &NinjamController::addNinjamRemoteChannel);
-    disconnect(ninjamService, &Service::userChannelRemoved, this,
-               &NinjamController::removeNinjamRemoteChannel);
-    disconnect(ninjamService, &Service::userChannelUpdated, this,
-               &NinjamController::updateNinjamRemoteChannel);
-    disconnect(ninjamService, &Service::audioIntervalDownloading, this,
-               &NinjamController::handleIntervalDownloading);
-
-    disconnect(ninjamService, &Service::publicChatMessageReceived, this,
-               &NinjamController::publicChatMessageReceived);
-    disconnect(ninjamService, &Service::privateChatMessageReceived, this,
-               &NinjamController::privateChatMessageReceived);
-    disconnect(ninjamService, &Service::serverTopicMessageReceived, this,
-               &NinjamController::topicMessageReceived);
-
     ninjamService->disconnectFromServer(emitDisconnectedSignal);
 }
 
@@ -494,6 +719,8 @@ NinjamController::~NinjamController()
     // delete possible non consumed events
     for (SchedulableEvent *e : scheduledEvents)
         delete e;
+
+    delete downloadedIntervals;
 }
 
 void NinjamController::start(const ServerInfo &server)
@@ -518,7 +745,7 @@ void NinjamController::start(const ServerInfo &server)
 
     if (!running)
     {
-        encodingThread = new NinjamController::EncodingThread(this);
+        encodingPool = new NinjamController::EncodingPool(this);
 
         // add a sine wave generator as input to test audio transmission
         // mainController->addInputTrackNode(new Audio::LocalInputTestStreamer(440, mainController->getAudioDriverSampleRate()));
@@ -539,7 +766,9 @@ void NinjamController::start(const ServerInfo &server)
         connect(ninjamService, &Service::serverBpiChanged, this,
                 &NinjamController::scheduleBpiChangeEvent);
         connect(ninjamService, &Service::audioIntervalCompleted, this,
-                &NinjamController::handleIntervalCompleted);
+                &NinjamController::handleIntervalCompleted, Qt::DirectConnection);
+        connect(ninjamService, &Service::audioIntervalCompleted, this,
+                &NinjamController::recordDownloadedInterval); // queued, recording in main thread
 
         connect(ninjamService, &Service::userChannelCreated, this,
                 &NinjamController::addNinjamRemoteChannel);
@@ -548,7 +777,7 @@ void NinjamController::start(const ServerInfo &server)
         connect(ninjamService, &Service::userChannelUpdated, this,
                 &NinjamController::updateNinjamRemoteChannel);
         connect(ninjamService, &Service::audioIntervalDownloading, this,
-                &NinjamController::handleIntervalDownloading);
+                &NinjamController::handleIntervalDownloading, Qt::DirectConnection);
         connect(ninjamService, &Service::userExited, this,
                 &NinjamController::handleNinjamUserExiting);
         connect(ninjamService, &Service::userEntered, this,
@@ -639,8 +868,9 @@ void NinjamController::addTrack(const User &user, const UserChannel &channel)
 
     // checkThread("addTrack();");
     {
-        QMutexLocker locker(&mutex);
+        QMutexLocker tracksLocker(&tracksMutex);
         trackNodes.insert(getUniqueKeyForChannel(channel, user.getFullName()), trackNode);
+        publishTrackNodes();
     } // release the mutex before emit the signal
 
     trackAdded = mainController->addTrack(trackNode->getID(), trackNode);
@@ -651,18 +881,28 @@ void NinjamController::addTrack(const User &user, const UserChannel &channel)
     }
     else
     {
-        QMutexLocker locker(&mutex);
-        trackNodes.remove(getUniqueKeyForChannel(channel, user.getFullName()));
+        {
+            QMutexLocker tracksLocker(&tracksMutex);
+            trackNodes.remove(getUniqueKeyForChannel(channel, user.getFullName()));
+            publishTrackNodes(); // the audio thread is not using the track after this
+        }
         delete trackNode;
     }
 }
 
+void NinjamController::publishTrackNodes()
+{
+    processedTracks.update([this](TrackNodes &tracks) {
+        tracks.assign(trackNodes.begin(), trackNodes.end());
+    });
+}
+
 void NinjamController::removeTrack(const User &user, const UserChannel &channel)
 {
     bool channelDeleted = false;
     long ID = -1;
     {
-        QMutexLocker locker(&mutex);
+        QMutexLocker tracksLocker(&tracksMutex);
         // checkThread("removeTrack();");
         QString uniqueKey = getUniqueKeyForChannel(channel, user.getFullName());
 
@@ -671,13 +911,16 @@ void NinjamController::removeTrack(const User &user, const UserChannel &channel)
             auto trackNode = trackNodes[uniqueKey];
             ID = trackNode->getID();
             trackNodes.remove(uniqueKey);
-            mainController->removeTrack(ID);
+            publishTrackNodes();
             channelDeleted = true;
         }
-    }
+    } // the mixer is waiting the audio thread in removeTrack(), the mutexes are not locked
 
     if (channelDeleted)
+    {
+        mainController->removeTrack(ID); // the track is deleted
         emit channelRemoved(user, channel, ID);
+    }
 }
 
 void NinjamController::voteBpi(int bpi)
@@ -719,7 +962,7 @@ void NinjamController::setMetronomeAccentBeats(QList<int> accentBeats)
 // }
 // }
 
-void NinjamController::handleNewInterval()
+void NinjamController::handleNewInterval(const TrackNodes &tracks)
 {
     // check if the transmiting can start
     if (!preparedForTransmit)
@@ -739,15 +982,13 @@ void NinjamController::handleNewInterval()
     if (hasScheduledChanges())
         processScheduledChanges();
 
-    //mutex.lock();
-    for (NinjamTrackNode *track : trackNodes.values())
+    for (NinjamTrackNode *track : tracks)
     {
         bool trackWasPlaying = track->isPlaying();
         bool trackIsPlaying = track->startNewInterval();
         if (trackWasPlaying != trackIsPlaying)
             emit channelXmitChanged(track->getID(), trackIsPlaying);
     }
-    //mutex.unlock();
 
     emit startingNewInterval(); // update the UI
 
@@ -802,7 +1043,7 @@ void NinjamController::removeNinjamRemoteChannel(const User &user, const UserCha
 void NinjamController::updateNinjamRemoteChannel(const User &user, const UserChannel &channel)
 {
     auto uniqueKey = getUniqueKeyForChannel(channel, user.getFullName());
-    QMutexLocker locker(&mutex);
+    QMutexLocker locker(&tracksMutex);
     if (trackNodes.contains(uniqueKey))
     {
         auto trackNode = trackNodes[uniqueKey];
@@ -824,8 +1065,8 @@ void NinjamController::scheduleBpmChangeEvent(quint16 newBpm)
     scheduledEvents.append(new BpmChangeEvent(this, newBpm));
 }
 
-void NinjamController::handleIntervalCompleted(const User &user, quint8 channelIndex,
-                                               const QByteArray &encodedData)
+void NinjamController::recordDownloadedInterval(const User &user, quint8 channelIndex,
+                                                const QByteArray &encodedData)
 {
     if (mainController->isMultiTrackRecordingActivated())
     {
@@ -833,16 +1074,21 @@ void NinjamController::handleIntervalCompleted(const User &user, quint8 channelI
         QString userName = user.getName() + " from " + geoLocation.countryName;
         mainController->saveEncodedAudio(userName, channelIndex, encodedData);
     }
+}
 
+void NinjamController::handleIntervalCompleted(const User &user, quint8 channelIndex,
+                                               const QByteArray &encodedData)
+{
     auto channel = user.getChannel(channelIndex);
     QString channelKey = getUniqueKeyForChannel(channel, user.getFullName());
-    QMutexLocker locker(&mutex);
+    QMutexLocker locker(&tracksMutex); // the track is not removed (and deleted) while the mutex is locked, the audio thread is not blocked
     if (trackNodes.contains(channelKey))
     {
         NinjamTrackNode *trackNode = trackNodes[channelKey];
         if (trackNode)
         {
-            trackNode->addVorbisEncodedInterval(encodedData);
+            // the decoder is allocated here and added to the track in process()
+            downloadedIntervals->enqueue(trackNode->getID(), NinjamTrackNode::createIntervalDecoder(encodedData));
             emit channelAudioFullyDownloaded(trackNode->getID());
         }
     }
@@ -853,11 +1099,38 @@ void NinjamController::handleIntervalCompleted(const User &user, quint8 channelI
     }
 }
 
+void NinjamController::addDownloadedIntervals(const TrackNodes &tracks)
+{
+    long trackID = -1;
+    NinjamTrackNode::IntervalDecoder *decoder = nullptr;
+    while (downloadedIntervals->tryDequeue(trackID, decoder))
+    {
+        NinjamTrackNode *trackNode = nullptr;
+        for (NinjamTrackNode *track : tracks)
+        {
+            if (track->getID() == trackID)
+            {
+                trackNode = track;
+                break;
+            }
+        }
+
+        if (trackNode)
+            trackNode->addIntervalDecoder(decoder);
+        else
+            NinjamTrackNode::discardIntervalDecoder(decoder); // the track was removed after the download
+    }
+}
+
 void NinjamController::reset()
 {
+    {
+        QMutexLocker tracksLocker(&tracksMutex);
+        for (NinjamTrackNode *trackNode : trackNodes)
+            trackNode->discardDownloadedIntervals(); // lock free, the intervals are discarded in the audio thread
+    }
+
     QMutexLocker locker(&mutex);
-    for (NinjamTrackNode *trackNode : trackNodes.values())
-        trackNode->discardDownloadedIntervals();
     intervalPosition = lastBeat = 0;
 }
 
@@ -866,19 +1139,26 @@ void NinjamController::scheduleEncoderChangeForChannel(int channelIndex, bool vo
     scheduledEvents.append(new InputChannelChangedEvent(this, channelIndex, voiceChatActivated));
 }
 
-QByteArray NinjamController::encode(const audio::SamplesBuffer &buffer, uint channelIndex)
+QSharedPointer<AudioEncoder> NinjamController::getEncoder(quint8 channelIndex)
 {
     QMutexLocker locker(&encodersMutex);
-    if (encoders.contains(channelIndex))
-        return encoders[channelIndex]->encode(buffer);
+    return encoders.value(channelIndex);
+}
+
+// the encoders mutex is locked only to get the encoder, so many channels can be encoded in parallel
+QByteArray NinjamController::encode(const audio::SamplesBuffer &buffer, uint channelIndex)
+{
+    auto encoder = getEncoder(channelIndex);
+    if (encoder)
+        return encoder->encode(buffer);
     return QByteArray();
 }
 
 QByteArray NinjamController::encodeLastPartOfInterval(uint channelIndex)
 {
-    QMutexLocker locker(&encodersMutex);
-    if (encoders.contains(channelIndex))
-        return encoders[channelIndex]->finishIntervalEncoding();
+    auto encoder = getEncoder(channelIndex);
+    if (encoder)
+        return encoder->finishIntervalEncoding();
     return QByteArray();
 }
 
@@ -898,13 +1178,11 @@ void NinjamController::recreateEncoderForChannel(int channelIndex, bool voiceCha
 
     if (!encoders.contains(channelIndex) || currentEncoderIsInvalid)   // a new encoder is necessary?
     {
-        if (currentEncoderIsInvalid && encoders.contains(channelIndex))
-            delete encoders[channelIndex];
-
         int sampleRate = mainController->getSampleRate();
         float encodingQuality = voiceChannelActivated ? vorbis::EncoderQualityLow : mainController->getEncodingQuality();
 
-        encoders[channelIndex] = new vorbis::Encoder(maxChannelsForEncoding, sampleRate, encodingQuality);
+        // the old encoder (if any) is deleted when the encoding worker release it
+        encoders[channelIndex] = QSharedPointer<AudioEncoder>(new vorbis::Encoder(maxChannelsForEncoding, sampleRate, encodingQuality));
     }
 }
 
@@ -912,9 +1190,7 @@ void NinjamController::recreateEncoders()
 {
     if (isRunning())
     {
-        QMutexLocker locker(&encodersMutex); // this method is called from main thread, and the encoders are used in audio thread every time
-        for (int e = 0; e < encoders.size(); ++e)
-            delete encoders[e];
+        QMutexLocker locker(&encodersMutex); // this method is called from main thread, and the encoders are used in encoding threads every time
         encoders.clear(); // new encoders will be create on demand
 
         int trackGroupsCount = mainController->getInputTrackGroupsCount();
@@ -924,6 +1200,15 @@ void NinjamController::recreateEncoders()
     }
 }
 
+void NinjamController::setAudioBuffersLayout(int inputChannels, int outputChannels, int maxFrames)
+{
+    tempInBuffer = audio::SamplesBuffer(inputChannels);
+    tempOutBuffer = audio::SamplesBuffer(outputChannels);
+
+    tempInBuffer.reserve(maxFrames);
+    tempOutBuffer.reserve(maxFrames);
+}
+
 void NinjamController::setSampleRate(int newSampleRate)
 {
     if (!isRunning())
@@ -943,9 +1228,8 @@ void NinjamController::handleIntervalDownloading(const User &user, quint8 channe
     auto channel = user.getChannel(channelIndex);
     QString channelKey = getUniqueKeyForChannel(channel, user.getFullName());
 
-    mutex.lock();
-    NinjamTrackNode *track = trackNodes[channelKey];
-    mutex.unlock();
+    QMutexLocker locker(&tracksMutex); // the track is not removed (and deleted) while the mutex is locked, the audio thread is not blocked
+    NinjamTrackNode *track = trackNodes.value(channelKey);
 
     if (track)
     {
@@ -5,8 +5,13 @@
 #include <QMutex>
 #include <QThread>
 #include <QMap>
+#include <QSharedPointer>
 
 #include "audio/Encoder.h"
+#include "audio/core/SamplesBuffer.h"
+#include "audio/core/RcuSnapshot.h"
+
+#include <vector>
 
 class NinjamTrackNode;
 
@@ -18,7 +23,6 @@ class UserChannel;
 
 namespace audio {
     class MetronomeTrackNode;
-    class SamplesBuffer;
 }
 
 namespace controller {
@@ -71,6 +75,8 @@ public:
 
     void setSampleRate(int newSampleRate);
 
+    void setAudioBuffersLayout(int inputChannels, int outputChannels, int maxFrames); // never called while the audio driver is running
+
     void reset();     // discard downloaded intervals and reset intervalPosition
 
     bool isPreparedForTransmit() const;
@@ -137,6 +143,11 @@ private:
 
     QMutex mutex;
     QMutex encodersMutex;
+    QMutex tracksMutex; // 'trackNodes' is changed and read (in network thread) holding 'tracksMutex'
+
+    typedef std::vector<NinjamTrackNode *> TrackNodes;
+    audio::RcuSnapshot<TrackNodes> processedTracks; // the audio thread is iterating this without locks
+    void publishTrackNodes(); // called holding 'tracksMutex', blocks until the audio thread is not using the previous tracks
 
     long computeTotalSamplesInInterval();
     long getSamplesPerBeat();
@@ -148,10 +159,10 @@ private:
 
     MetronomeTrackNode *createMetronomeTrackNode(int sampleRate);
 
-    QMap<int, AudioEncoder *> encoders;
-    AudioEncoder *getEncoder(quint8 channelIndex);
+    QMap<int, QSharedPointer<AudioEncoder>> encoders; // shared with encoding workers
+    QSharedPointer<AudioEncoder> getEncoder(quint8 channelIndex);
 
-    void handleNewInterval();
+    void handleNewInterval(const TrackNodes &tracks);
     void recreateEncoderForChannel(int channelIndex, bool voiceChannelActivated);
 
     void setXmitStatus(int channelID, bool transmiting);
@@ -164,9 +175,18 @@ private:
     class InputChannelChangedEvent;    // user change the channel input selection from mono to stereo or vice-versa, or user added a new channel, both cases requires a new encoder in next interval
     QList<SchedulableEvent *> scheduledEvents;
 
-    class EncodingThread;
+    class EncodingPool; // parallel encoding, one worker thread per channel
+
+    EncodingPool *encodingPool;
+
+    class DownloadedIntervals; // decoders created in the network thread, added to the tracks in process()
+    DownloadedIntervals *downloadedIntervals;
+    void addDownloadedIntervals(const TrackNodes &tracks);
 
-    EncodingThread *encodingThread;
+    // preallocated buffers used in process(), avoiding allocations in audio thread
+    SamplesBuffer tempInBuffer;
+    SamplesBuffer tempOutBuffer;
+    SamplesBuffer inputMixBuffer;
 
     bool preparedForTransmit;
     int waitingIntervals;
@@ -176,9 +196,11 @@ private slots:
     // ninjam events
     void scheduleBpmChangeEvent(quint16 newBpm);
     void scheduleBpiChangeEvent(quint16 newBpi, quint16 oldBpi);
+    // the downloaded audio is handled in the network thread, the intervals are added to the track nodes in process()
     void handleIntervalCompleted(const User &user, quint8 channelIndex,
                                  const QByteArray &encodedAudioData);
     void handleIntervalDownloading(const User &user, quint8 channelIndex, const QByteArray &encodedAudio, bool isFirstPart, bool isLastPart);
+    void recordDownloadedInterval(const User &user, quint8 channelIndex, const QByteArray &encodedAudioData);
     void addNinjamRemoteChannel(const User &user, const UserChannel &channel);
     void removeNinjamRemoteChannel(const User &user, const UserChannel &channel);
     void updateNinjamRemoteChannel(const User &user, const UserChannel &channel);
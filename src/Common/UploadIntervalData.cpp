@@ -1,8 +1,10 @@
 #include "UploadIntervalData.h"
 #include <QUuid>
+#include <QDateTime>
 
 UploadIntervalData::UploadIntervalData() :
-    GUID(newGUID())
+    GUID(newGUID()),
+    startTime(QDateTime::currentMSecsSinceEpoch())
 {
 }
 
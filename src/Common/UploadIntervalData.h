@@ -37,10 +37,16 @@ public:
         dataToUpload.clear();
     }
 
+    inline qint64 getStartTime() const // used to compute the upload chunk sizes
+    {
+        return startTime;
+    }
+
 private:
     static QByteArray newGUID();
     QByteArray GUID;
     QByteArray dataToUpload;
+    qint64 startTime; // ms since epoch
 
 };
 
@@ -90,7 +90,7 @@ SamplesBuffer *MetronomeTrackNode::getSamplesBuffer(int beat)
 }
 
 void MetronomeTrackNode::processReplacing(const SamplesBuffer &in, SamplesBuffer &out,
-                                          int SampleRate, std::vector<midi::MidiMessage> &midiBuffer)
+                                          int SampleRate, const std::vector<midi::MidiMessage> &midiBuffer)
 {
     if (samplesPerBeat <= 0)
         return;
@@ -6,15 +6,19 @@
 #include <QByteArray>
 #include <QMutexLocker>
 #include <QDateTime>
-#include <QtConcurrent/QtConcurrent>
+#include <QThread>
 
 #include "audio/core/Filters.h"
 #include "audio/core/AudioDriver.h"
 #include "audio/vorbis/VorbisDecoder.h"
 
+#include <algorithm>
+#include <atomic>
+
 
 const double NinjamTrackNode::LOW_CUT_DRASTIC_FREQUENCY = 220.0; // in Hertz
 const double NinjamTrackNode::LOW_CUT_NORMAL_FREQUENCY = 120.0; // in Hertz
+const qint64 NinjamTrackNode::DEFAULT_LOOK_AHEAD_DECODING_BUDGET = 64 * 1024 * 1024; // in bytes
 
 using audio::Filter;
 
@@ -95,73 +99,504 @@ class NinjamTrackNode::IntervalDecoder
 {
 public:
     explicit IntervalDecoder(const QByteArray &vorbisData = QByteArray());
-    void decode(quint32 maxSamplesToDecode);
+    ~IntervalDecoder(); // called from look ahead thread, the blocks are returned to the pool
+
+    // called from look ahead thread, the vorbis decoder is used in audio thread only when no block is published
+    quint32 decodeAhead(quint32 maxSamplesToDecode); // return the decoded samples, zero when waiting for blocks or encoded data
+    bool isDecodingFinished() const { return decodingFinished; }
+    void recycleConsumedBlocks();
+    quint32 getBlocksInUse() const { return blocksInUse; }
+
+    // called from network thread
     void addEncodedData(const QByteArray &vorbisData);
-    quint32 getDecodedSamples(audio::SamplesBuffer &outBuffer, uint samplesToDecode);
-    inline int getSampleRate() const { return vorbisDecoder.getSampleRate(); }
-    inline bool isStereo() const { return vorbisDecoder.isStereo(); }
-    void stopDecoding();
-    bool isFullyDecoded() const { return vorbisDecoder.isFinished(); }
-    bool isValid() const { return vorbisDecoder.isValid(); }
+    void setInputComplete() { vorbisDecoder.setInputComplete(true); }
+    void releaseProducer() { producerReleased.store(true, std::memory_order_release); } // the network thread is not touching the decoder anymore
+    bool isProducerReleased() const { return producerReleased.load(std::memory_order_acquire); }
+
+    // called from audio thread, the published blocks are read and the missing samples are decoded (bounded) when the look ahead thread is late
+    quint32 getDecodedSamples(audio::SamplesBuffer &outBuffer, uint samplesToDecode, bool &decodedAhead);
+    void setPlaying() { playing.store(true, std::memory_order_relaxed); } // the playing decoders have priority in the look ahead thread
+    bool isPlaying() const { return playing.load(std::memory_order_relaxed); }
+    inline int getSampleRate() const { return sampleRate; }
+    inline bool isStereo() const { return stereo; }
+    bool isFullyDecoded() const;
+    bool isValid() const { return valid; }
+
+    IntervalDecoder *nextRetired; // link used in the look ahead thread reclaim stack
 private:
     vorbis::Decoder vorbisDecoder;
-    audio::SamplesBuffer decodedBuffer;
-    QMutex mutex;
+    std::atomic<bool> decoderBusy; // the look ahead and audio threads never use the vorbis decoder at same time
+    std::atomic<bool> producerReleased; // voice chat decoders are fed by the network thread after handed to the audio thread
+
+    // published by the thread holding the vorbis decoder
+    std::atomic<int> sampleRate;
+    std::atomic<bool> stereo;
+    std::atomic<bool> valid;
+    std::atomic<bool> decodingFinished; // set after the last block is enqueued
+    std::atomic<bool> playing;
+
+    // blocks decoded in the look ahead thread, consumed (in order) by the audio thread and returned in 'consumedBlocks'
+    moodycamel::ReaderWriterQueue<audio::SamplesBuffer *> lookAheadBlocks;
+    moodycamel::ReaderWriterQueue<audio::SamplesBuffer *> consumedBlocks;
+    quint32 blocksInUse; // touched only by the look ahead thread, never more than MAX_BLOCKS (the queues are not growing)
+    audio::SamplesBuffer *currentBlock;
+    quint32 currentBlockPosition;
+
+    bool tryLockDecoder() { return !decoderBusy.exchange(true, std::memory_order_acquire); }
+    void unlockDecoder() { decoderBusy.store(false, std::memory_order_release); }
+    void publishDecoderState();
+
+    quint32 readLookAheadSamples(audio::SamplesBuffer &outBuffer, quint32 outOffset, quint32 samplesToRead);
+    quint32 decodeLazily(audio::SamplesBuffer &outBuffer, quint32 outOffset, quint32 samplesToDecode);
+
+    static const quint32 MAX_BLOCKS = 128; // about 12 seconds in 44.1 KHz
+    static const quint32 MAX_LAZY_DECODED_SAMPLES = 2048; // decoded in the audio thread per callback
 };
 
-NinjamTrackNode::IntervalDecoder::IntervalDecoder(const QByteArray &vorbisData)
-    :decodedBuffer(2)
+//-------------------------------------------------------------
+
+/**
+    Decode the downloaded intervals of all remote tracks in background, so in interval start (the
+    worst case for the audio thread, all tracks starting a new decoder at same time) the audio
+    thread is just copying PCM samples. The audio thread is reading the published blocks, a missing
+    block (budget exhausted or decoding late) is decoded in the audio thread (bounded by callback) when
+    the vorbis decoder is not used here, or played as silence. The blocks are taken from a pool limited
+    by a memory budget and recycled when consumed, the decoding continues while the interval is playing.
+    The playing intervals have priority and a part of the budget is reserved for them, so the buffered
+    (future) intervals are not starving the interval played now.
+
+    The decoders are destroyed in this thread. The audio thread never drops a decoder, the decoders
+    are retired (lock free) and the vorbis state and blocks are released here. A retired voice chat
+    decoder is destroyed only after the network thread release it.
+*/
+
+class NinjamTrackNode::LookAheadDecoder : public QThread
+{
+public:
+    static LookAheadDecoder &getInstance();
+
+    ~LookAheadDecoder();
+
+    void schedule(IntervalDecoder *decoder); // called from GUI and network threads, never from audio thread
+    void retire(IntervalDecoder *decoder); // lock free, can be called from audio thread
+
+    void setBudget(qint64 bytes) { budget = bytes; }
+    qint64 getUsedBytes() const { return usedBytes; }
+
+    // look ahead thread only
+    audio::SamplesBuffer *acquireBlock(bool forPlayingDecoder); // nullptr when the budget is exhausted
+    void recycleBlock(audio::SamplesBuffer *block);
+
+    static const quint32 BLOCK_FRAMES = 4096;
+    static const qint64 BLOCK_BYTES = BLOCK_FRAMES * 2 * sizeof(float); // blocks are always stereo
+
+protected:
+    void run() override;
+
+private:
+    LookAheadDecoder();
+
+    moodycamel::BlockingReaderWriterQueue<IntervalDecoder *> scheduledDecoders;
+    QMutex scheduleMutex; // the queue is single producer
+    std::atomic<IntervalDecoder *> retiredDecoders; // stack linked by IntervalDecoder::nextRetired
+    std::vector<audio::SamplesBuffer *> freeBlocks; // pool touched only by the look ahead thread
+    std::atomic<qint64> budget;
+    std::atomic<qint64> usedBytes;
+    std::atomic<bool> stopRequested;
+
+    static const quint32 FIRST_BLOCKS_FRAMES = 8192; // the interval beginning is decoded first for all tracks
+    static const int PREALLOCATED_BLOCKS = 64;
+    static const int IDLE_WAIT = 100000; // in microseconds
+    static const int STALLED_WAIT = 2000; // waiting for consumed blocks or voice chat data
+    static const quint32 PLAYING_AHEAD_BLOCKS = 8; // the playing decoders are decoded first until this limit
+    static const int PLAYING_RESERVED_BUDGET_DIVISOR = 4; // a quarter of the budget is used only by the playing decoders
+};
+
+NinjamTrackNode::LookAheadDecoder &NinjamTrackNode::LookAheadDecoder::getInstance()
+{
+    static LookAheadDecoder instance;
+    return instance;
+}
+
+NinjamTrackNode::LookAheadDecoder::LookAheadDecoder() :
+    scheduledDecoders(64),
+    retiredDecoders(nullptr),
+    budget(DEFAULT_LOOK_AHEAD_DECODING_BUDGET),
+    usedBytes(0),
+    stopRequested(false)
 {
-    // this funcion is called from GUI thread
+    freeBlocks.reserve(PREALLOCATED_BLOCKS);
+    for (int i = 0; i < PREALLOCATED_BLOCKS; ++i)
+        freeBlocks.push_back(new audio::SamplesBuffer(2, BLOCK_FRAMES));
 
+    setObjectName("Look ahead decoder");
+    start(QThread::HighPriority);
+}
+
+NinjamTrackNode::LookAheadDecoder::~LookAheadDecoder()
+{
+    stopRequested = true;
+    wait();
+
+    IntervalDecoder *retired = retiredDecoders.exchange(nullptr);
+    while (retired) {
+        IntervalDecoder *next = retired->nextRetired;
+        delete retired;
+        retired = next;
+    }
 
+    for (auto block : freeBlocks)
+        delete block;
+}
+
+void NinjamTrackNode::LookAheadDecoder::schedule(IntervalDecoder *decoder)
+{
+    QMutexLocker locker(&scheduleMutex);
+
+    scheduledDecoders.enqueue(decoder);
+}
+
+void NinjamTrackNode::LookAheadDecoder::retire(IntervalDecoder *decoder)
+{
+    if (!decoder)
+        return;
+
+    IntervalDecoder *head = retiredDecoders.load(std::memory_order_relaxed);
+    do {
+        decoder->nextRetired = head;
+    } while (!retiredDecoders.compare_exchange_weak(head, decoder, std::memory_order_release, std::memory_order_relaxed));
+}
+
+audio::SamplesBuffer *NinjamTrackNode::LookAheadDecoder::acquireBlock(bool forPlayingDecoder)
+{
+    qint64 availableBudget = budget;
+    if (!forPlayingDecoder)
+        availableBudget -= availableBudget / PLAYING_RESERVED_BUDGET_DIVISOR;
+
+    if (usedBytes + BLOCK_BYTES > availableBudget)
+        return nullptr; // over budget, waiting the audio thread to consume the blocks
+
+    usedBytes += BLOCK_BYTES;
+
+    if (freeBlocks.empty())
+        return new audio::SamplesBuffer(2, BLOCK_FRAMES); // the pool is growing until the budget
+
+    auto block = freeBlocks.back();
+    freeBlocks.pop_back();
+    block->setFrameLenght(BLOCK_FRAMES);
+
+    return block;
+}
+
+void NinjamTrackNode::LookAheadDecoder::recycleBlock(audio::SamplesBuffer *block)
+{
+    usedBytes -= BLOCK_BYTES;
+
+    qint64 pooledBytes = static_cast<qint64>(freeBlocks.size()) * BLOCK_BYTES;
+    if (freeBlocks.size() >= static_cast<size_t>(PREALLOCATED_BLOCKS) && pooledBytes + usedBytes >= budget) {
+        delete block; // the budget was reduced
+        return;
+    }
+
+    freeBlocks.push_back(block);
+}
+
+void NinjamTrackNode::LookAheadDecoder::run()
+{
+    QList<IntervalDecoder *> decoders; // all decoders not retired, the consumed blocks are recycled
+    QList<IntervalDecoder *> newDecoders; // nothing decoded yet
+    QList<IntervalDecoder *> partiallyDecoded;
+    QList<IntervalDecoder *> unreleasedDecoders; // waiting the network thread release
+    int stalledDecoders = 0; // decoders visited in the round robin without progress
+
+    auto addScheduledDecoder = [&](IntervalDecoder *decoder) {
+        stalledDecoders = 0;
+        if (!decoders.contains(decoder)) { // voice chat decoders are scheduled again when new data arrives
+            decoders.append(decoder);
+            newDecoders.append(decoder);
+        }
+    };
+
+    while (!stopRequested) {
+        // the retired stack is taken before the scheduled decoders, a decoder is always scheduled before being retired
+        IntervalDecoder *retired = retiredDecoders.exchange(nullptr, std::memory_order_acquire);
+        while (retired) {
+            IntervalDecoder *next = retired->nextRetired;
+            decoders.removeOne(retired);
+            newDecoders.removeOne(retired);
+            partiallyDecoded.removeOne(retired);
+            unreleasedDecoders.append(retired);
+            retired = next;
+        }
+
+        // the network thread is scheduling a voice chat decoder before releasing it, the released decoders
+        // are collected before taking the scheduled decoders and destroyed after
+        QList<IntervalDecoder *> releasedDecoders;
+        for (auto retiredDecoder : unreleasedDecoders) {
+            if (retiredDecoder->isProducerReleased())
+                releasedDecoders.append(retiredDecoder);
+        }
+
+        IntervalDecoder *decoder = nullptr;
+        while (scheduledDecoders.try_dequeue(decoder)) {
+            if (!unreleasedDecoders.contains(decoder)) // voice chat data arriving after the decoder was retired
+                addScheduledDecoder(decoder);
+        }
+
+        for (auto releasedDecoder : releasedDecoders) {
+            unreleasedDecoders.removeOne(releasedDecoder);
+            delete releasedDecoder;
+        }
+
+        for (auto decoder : decoders)
+            decoder->recycleConsumedBlocks();
+
+        // the playing intervals are decoded first, the audio thread is consuming them now
+        IntervalDecoder *playingDecoder = nullptr;
+        for (auto partialDecoder : partiallyDecoded) {
+            if (partialDecoder->isPlaying() && partialDecoder->getBlocksInUse() < PLAYING_AHEAD_BLOCKS) {
+                playingDecoder = partialDecoder;
+                break;
+            }
+        }
+
+        if (playingDecoder && playingDecoder->decodeAhead(BLOCK_FRAMES) > 0) {
+            stalledDecoders = 0;
+            if (playingDecoder->isDecodingFinished())
+                partiallyDecoded.removeOne(playingDecoder);
+            continue;
+        }
+
+        // new intervals have priority, only the first samples are decoded before check the next new interval
+        if (!newDecoders.isEmpty()) {
+            decoder = newDecoders.takeFirst();
+            decoder->decodeAhead(FIRST_BLOCKS_FRAMES);
+            if (!decoder->isDecodingFinished())
+                partiallyDecoded.append(decoder);
+            continue;
+        }
+
+        if (!partiallyDecoded.isEmpty()) {
+            decoder = partiallyDecoded.takeFirst(); // round robin, one block per interval
+            if (decoder->decodeAhead(BLOCK_FRAMES) > 0)
+                stalledDecoders = 0;
+            else
+                stalledDecoders++;
+
+            if (!decoder->isDecodingFinished())
+                partiallyDecoded.append(decoder);
+
+            if (stalledDecoders < partiallyDecoded.size())
+                continue;
+        }
+
+        // nothing to decode, waiting for new intervals (or consumed blocks and voice chat data when some decoder is stalled)
+        stalledDecoders = 0;
+        if (scheduledDecoders.wait_dequeue_timed(decoder, partiallyDecoded.isEmpty() ? IDLE_WAIT : STALLED_WAIT)) {
+            if (!unreleasedDecoders.contains(decoder))
+                addScheduledDecoder(decoder);
+        }
+    }
+
+    for (auto retiredDecoder : unreleasedDecoders)
+        delete retiredDecoder; // the application is finishing
+}
+
+//-------------------------------------------------------------
+
+NinjamTrackNode::IntervalDecoder::IntervalDecoder(const QByteArray &vorbisData)
+    : nextRetired(nullptr),
+      decoderBusy(false),
+      producerReleased(!vorbisData.isEmpty()), // full intervals are not touched in network thread after created
+      sampleRate(44100),
+      stereo(false),
+      valid(true),
+      decodingFinished(false),
+      playing(false),
+      lookAheadBlocks(MAX_BLOCKS),
+      consumedBlocks(MAX_BLOCKS),
+      blocksInUse(0),
+      currentBlock(nullptr),
+      currentBlockPosition(0)
+{
+    // this funcion is called from network thread, the decoder is not shared yet
 
-    QMutexLocker locker(&mutex);
     vorbisDecoder.setInputData(vorbisData);
+    vorbisDecoder.setInputComplete(!vorbisData.isEmpty()); // voice chat chunks are arriving
+}
+
+NinjamTrackNode::IntervalDecoder::~IntervalDecoder()
+{
+    // the decoder was retired, the audio thread is not using the blocks anymore
+    auto &lookAheadDecoder = LookAheadDecoder::getInstance();
+
+    audio::SamplesBuffer *block = nullptr;
+    while (lookAheadBlocks.try_dequeue(block))
+        lookAheadDecoder.recycleBlock(block);
+
+    while (consumedBlocks.try_dequeue(block))
+        lookAheadDecoder.recycleBlock(block);
+
+    if (currentBlock)
+        lookAheadDecoder.recycleBlock(currentBlock);
+}
+
+void NinjamTrackNode::IntervalDecoder::recycleConsumedBlocks()
+{
+    auto &lookAheadDecoder = LookAheadDecoder::getInstance();
+
+    audio::SamplesBuffer *block = nullptr;
+    while (consumedBlocks.try_dequeue(block)) {
+        lookAheadDecoder.recycleBlock(block);
+        blocksInUse--;
+    }
+}
+
+bool NinjamTrackNode::IntervalDecoder::isFullyDecoded() const
+{
+    // 'decodingFinished' is set after the last block is enqueued
+    return decodingFinished.load(std::memory_order_acquire) && !currentBlock && !lookAheadBlocks.peek();
 }
 
 void NinjamTrackNode::IntervalDecoder::addEncodedData(const QByteArray &vorbisData)
 {
-    // this funcion is called from GUI thread
+    // this funcion is called from network thread, the data is handed off to the decoder without locks
 
-    QMutexLocker locker(&mutex);
     vorbisDecoder.addInputData(vorbisData);
 }
 
-void NinjamTrackNode::IntervalDecoder::decode(quint32 maxSamplesToDecode)
+void NinjamTrackNode::IntervalDecoder::publishDecoderState()
 {
-    mutex.lock();
+    sampleRate = vorbisDecoder.getSampleRate();
+    stereo = vorbisDecoder.isStereo();
 
-    decodedBuffer.append(vorbisDecoder.decode(maxSamplesToDecode));
-
-    mutex.unlock();
+    if (!vorbisDecoder.isValid())
+        valid = false;
 }
 
-void NinjamTrackNode::IntervalDecoder::stopDecoding()
+quint32 NinjamTrackNode::IntervalDecoder::decodeAhead(quint32 maxSamplesToDecode)
 {
-    mutex.lock(); // this funcion is called from GUI thread
+    if (decodingFinished)
+        return 0;
+
+    if (!tryLockDecoder())
+        return 0; // the audio thread is decoding the missing samples
+
+    auto &lookAheadDecoder = LookAheadDecoder::getInstance();
+    const quint32 blockFrames = LookAheadDecoder::BLOCK_FRAMES;
+
+    bool finished = false;
+    quint32 totalDecoded = 0;
+    while (totalDecoded < maxSamplesToDecode && blocksInUse < MAX_BLOCKS) {
+        auto block = lookAheadDecoder.acquireBlock(isPlaying());
+        if (!block)
+            break; // budget exhausted
+
+        quint32 blockPosition = 0;
+        while (blockPosition < blockFrames) {
+            const auto &samples = vorbisDecoder.decode(blockFrames - blockPosition);
+            if (samples.isEmpty()) {
+                finished = vorbisDecoder.isFinished() || !vorbisDecoder.isValid(); // or waiting for more voice chat data
+                break;
+            }
+
+            block->set(samples, 0, samples.getFrameLenght(), blockPosition);
+            blockPosition += samples.getFrameLenght();
+        }
+
+        if (blockPosition > 0) {
+            publishDecoderState(); // published before the first block
+
+            block->setFrameLenght(blockPosition);
+            blocksInUse++;
+            lookAheadBlocks.try_enqueue(block); // never full, 'blocksInUse' is limited by the queue capacity
+            totalDecoded += blockPosition;
+        }
+        else {
+            lookAheadDecoder.recycleBlock(block);
+        }
+
+        if (finished || blockPosition < blockFrames)
+            break;
+    }
+
+    if (!vorbisDecoder.isValid())
+        valid = false;
+
+    if (finished)
+        decodingFinished.store(true, std::memory_order_release);
+
+    unlockDecoder();
 
-    vorbisDecoder.setInputData(QByteArray()); // empty data
+    return totalDecoded;
+}
 
-    mutex.unlock();
+quint32 NinjamTrackNode::IntervalDecoder::readLookAheadSamples(audio::SamplesBuffer &outBuffer, quint32 outOffset, quint32 samplesToRead)
+{
+    quint32 totalSamples = 0;
+    while (totalSamples < samplesToRead) {
+        if (!currentBlock && !lookAheadBlocks.try_dequeue(currentBlock))
+            break;
+
+        quint32 samples = qMin(samplesToRead - totalSamples, currentBlock->getFrameLenght() - currentBlockPosition);
+        outBuffer.set(*currentBlock, currentBlockPosition, samples, outOffset + totalSamples);
+        totalSamples += samples;
+        currentBlockPosition += samples;
+
+        if (currentBlockPosition >= currentBlock->getFrameLenght()) { // block consumed, returned to the look ahead thread
+            consumedBlocks.try_enqueue(currentBlock);
+            currentBlock = nullptr;
+            currentBlockPosition = 0;
+        }
+    }
+
+    return totalSamples;
 }
 
-quint32 NinjamTrackNode::IntervalDecoder::getDecodedSamples(audio::SamplesBuffer &outBuffer, uint samplesToDecode)
+quint32 NinjamTrackNode::IntervalDecoder::decodeLazily(audio::SamplesBuffer &outBuffer, quint32 outOffset, quint32 samplesToDecode)
 {
-    mutex.lock();
-    while (decodedBuffer.getFrameLenght() < samplesToDecode) { //need decode more samples to fill outBuffer?
-        quint32 toDecode = samplesToDecode - decodedBuffer.getFrameLenght();
-        const auto &decodedSamples = vorbisDecoder.decode(toDecode);
-        decodedBuffer.append(decodedSamples);
-        if (decodedSamples.isEmpty())
-            break; //no more samples to decode
+    if (decodingFinished || !tryLockDecoder())
+        return 0; // the look ahead thread is decoding, the missing samples are silence
+
+    // blocks published while the look ahead thread was holding the decoder are read first, the samples order is preserved
+    quint32 totalSamples = readLookAheadSamples(outBuffer, outOffset, samplesToDecode);
+
+    // bounded, the decoding is not blocking the audio thread when the look ahead thread is far behind
+    const quint32 maxSamples = qMin(samplesToDecode, totalSamples + MAX_LAZY_DECODED_SAMPLES);
+    while (totalSamples < maxSamples && !decodingFinished) {
+        const auto &samples = vorbisDecoder.decode(maxSamples - totalSamples);
+        if (samples.isEmpty()) {
+            if (vorbisDecoder.isFinished() || !vorbisDecoder.isValid())
+                decodingFinished.store(true, std::memory_order_release); // nothing in look ahead queue, all samples were consumed
+            break;
+        }
+
+        outBuffer.set(samples, 0, samples.getFrameLenght(), outOffset + totalSamples);
+        totalSamples += samples.getFrameLenght();
     }
 
-    quint32 totalSamples = qMin(samplesToDecode, decodedBuffer.getFrameLenght());
-    outBuffer.setFrameLenght(totalSamples);
-    outBuffer.set(decodedBuffer);
-    decodedBuffer.discardFirstSamples(totalSamples);
-    mutex.unlock();
+    publishDecoderState();
+
+    unlockDecoder();
+
+    return totalSamples;
+}
+
+quint32 NinjamTrackNode::IntervalDecoder::getDecodedSamples(audio::SamplesBuffer &outBuffer, uint samplesToDecode, bool &decodedAhead)
+{
+    outBuffer.setFrameLenght(samplesToDecode);
+
+    quint32 totalSamples = readLookAheadSamples(outBuffer, 0, samplesToDecode);
+
+    decodedAhead = totalSamples == samplesToDecode || isFullyDecoded();
+    if (!decodedAhead)
+        totalSamples += decodeLazily(outBuffer, totalSamples, samplesToDecode - totalSamples); // the look ahead thread is late
+
+    // the missing samples (decoder in use or interval end) are silence
+    for (int c = 0; c < outBuffer.getChannels(); ++c) {
+        float *samples = outBuffer.getSamplesArray(c);
+        std::fill(samples + totalSamples, samples + samplesToDecode, 0.0f);
+    }
 
     return totalSamples;
 }
@@ -173,25 +608,104 @@ NinjamTrackNode::NinjamTrackNode(int ID) :
     lowCut(new NinjamTrackNode::LowCutFilter(44100)),
     //processingLastPartOfInterval(false),
     currentDecoder(nullptr),
-    decodersMutex(QMutex::NonRecursive)
+    discardsDone(0),
+    streamedDecoders(MAX_BUFFERED_INTERVALS),
+    streamingDecoder(nullptr),
+    streamingDiscards(0),
+    discardRequests(0),
+    playing(false),
+    publishedSampleRate(44100),
+    publishedStereo(true),
+    decodingUnderruns(0)
 {
-
+    decoders.reserve(MAX_BUFFERED_INTERVALS); // the audio thread is not allocating when the decoders are changed
 }
 
 bool NinjamTrackNode::isStereo() const
 {
-    if (currentDecoder)
-        return currentDecoder->isStereo();
+    return publishedStereo.load(std::memory_order_relaxed);
+}
+
+void NinjamTrackNode::stopDecoding()
+{
+    discardDownloadedIntervals(); // the current decoder is retired too
+}
+
+void NinjamTrackNode::retireDecoder(IntervalDecoder *decoder)
+{
+    LookAheadDecoder::getInstance().retire(decoder); // lock free, the decoder is destroyed in the look ahead thread
+}
+
+void NinjamTrackNode::retireAllDecoders()
+{
+    for (auto decoder : decoders)
+        retireDecoder(decoder);
+
+    decoders.clear();
+
+    retireDecoder(currentDecoder);
+    currentDecoder = nullptr;
+}
+
+bool NinjamTrackNode::appendDecoder(IntervalDecoder *decoder)
+{
+    if (decoders.size() >= MAX_BUFFERED_INTERVALS) {
+        retireDecoder(decoder); // too many intervals buffered, the vector capacity is not changed
+        return false;
+    }
+
+    decoders.push_back(decoder);
 
     return true;
 }
 
-void NinjamTrackNode::stopDecoding()
+void NinjamTrackNode::consumeStreamedDecoders()
 {
-    discardDownloadedIntervals();
+    quint32 requestedDiscards = discardRequests.load(std::memory_order_acquire);
+    if (requestedDiscards != discardsDone) {
+        retireAllDecoders();
+        discardsDone = requestedDiscards;
+    }
+
+    StreamedDecoder streamed;
+    while (streamedDecoders.try_dequeue(streamed)) {
+        qint32 age = static_cast<qint32>(discardsDone - streamed.discards);
+        if (age < 0) { // discard requested after the first check
+            retireAllDecoders();
+            discardsDone = streamed.discards;
+            age = 0;
+        }
 
-    if (currentDecoder != nullptr)
-        currentDecoder->stopDecoding();
+        if (age > 0 || mode != VoiceChat)
+            retireDecoder(streamed.decoder); // discarded before taken by the audio thread
+        else
+            appendDecoder(streamed.decoder);
+    }
+}
+
+void NinjamTrackNode::publishDecoderState()
+{
+    if (currentDecoder)
+        currentDecoder->setPlaying(); // decoded first in the look ahead thread
+
+    playing.store(currentDecoder != nullptr, std::memory_order_relaxed);
+    publishedSampleRate.store(currentDecoder ? currentDecoder->getSampleRate() : 44100, std::memory_order_relaxed);
+    publishedStereo.store(currentDecoder ? currentDecoder->isStereo() : true, std::memory_order_relaxed);
+}
+
+void NinjamTrackNode::setLookAheadDecodingBudget(qint64 bytes)
+{
+    LookAheadDecoder::getInstance().setBudget(bytes);
+}
+
+qint64 NinjamTrackNode::getLookAheadDecodedBytes()
+{
+    return LookAheadDecoder::getInstance().getUsedBytes();
+}
+
+quint64 NinjamTrackNode::getDecodingUnderruns() const
+{
+    return decodingUnderruns.load(std::memory_order_relaxed);
 }
 
 NinjamTrackNode::LowCutState NinjamTrackNode::setLowCutToNextState()
@@ -227,6 +741,11 @@ void NinjamTrackNode::setLowCutState(LowCutState newState)
 }
 
 int NinjamTrackNode::getSampleRate() const
+{
+    return publishedSampleRate.load(std::memory_order_relaxed);
+}
+
+int NinjamTrackNode::getDecoderSampleRate() const
 {
     if (currentDecoder)
         return currentDecoder->getSampleRate();
@@ -237,35 +756,26 @@ NinjamTrackNode::~NinjamTrackNode()
 {
     //qDebug() << "Deastrutor NinjamTrackNode";
 
-    decodersMutex.lock();
-    for (auto decoder : decoders)
-        delete decoder;
+    // the track was removed, the audio and network threads are not using this node anymore
+    releaseStreamingDecoder();
 
-    decoders.clear();
-    if (currentDecoder) {
-        //delete currentDecoder;
-        currentDecoder = nullptr;
-    }
-    decodersMutex.unlock();
+    StreamedDecoder streamed;
+    while (streamedDecoders.try_dequeue(streamed))
+        retireDecoder(streamed.decoder);
+
+    retireAllDecoders();
 }
 
 void NinjamTrackNode::discardDownloadedIntervals()
 {
-    QMutexLocker locker(&decodersMutex);
-
-    while (!decoders.isEmpty())
-        delete decoders.takeFirst();
-
-    currentDecoder = nullptr;
+    discardRequests.fetch_add(1, std::memory_order_release); // the decoders are retired in the audio thread
 
     //qDebug() << "intervals discarded";
 }
 
 bool NinjamTrackNode::isPlaying()
 {
-    QMutexLocker locker(&decodersMutex);
-
-    return currentDecoder != nullptr || mode == VoiceChat; // voice chat is always playing
+    return playing.load(std::memory_order_relaxed) || mode == VoiceChat; // voice chat is always playing
 }
 
 void NinjamTrackNode::consumePendingEvents()
@@ -282,20 +792,20 @@ bool NinjamTrackNode::startNewInterval()
     //qDebug() << "--------START INTERVAL------------";
 
     consumePendingEvents();
+    consumeStreamedDecoders();
 
     if (mode == Intervalic) {
-        decodersMutex.lock();
-        if (currentDecoder) {
-            delete currentDecoder; //discard the previous interval decoder
-            currentDecoder = nullptr;
+        retireDecoder(currentDecoder); //discard the previous interval decoder, destroyed in the look ahead thread
+        currentDecoder = nullptr;
+        if (!decoders.empty()) {
+            currentDecoder = decoders.front(); //using the next buffered decoder (next interval)
+            decoders.erase(decoders.begin());
         }
-        if (!decoders.isEmpty())
-            currentDecoder = decoders.takeFirst(); //using the next buffered decoder (next interval)
-
-        decodersMutex.unlock();
     }
 
-    return isPlaying();
+    publishDecoderState();
+
+    return currentDecoder || mode == VoiceChat;
 }
 
 // this function is used only for voice chat mode. The parameter is not a full Ogg Vorbis interval, it's just a chunk of data.
@@ -303,31 +813,54 @@ void NinjamTrackNode::addVorbisEncodedChunk(const QByteArray &chunkBytes, bool i
 {
     //qDebug() << "   Chunk received " << chunkBytes.left(4) << "\tFirst:" << isFirstPart << " Last:" << isLastPart << " Bytes received:" << chunkBytes.size();
 
-    if(mode != VoiceChat)
+    // network thread, the decoders are handed to the audio thread in 'streamedDecoders' and fed here without locks
+
+    if (mode != VoiceChat) {
+        releaseStreamingDecoder();
         return;
+    }
 
+    if (streamingDecoder && streamingDiscards != discardRequests.load(std::memory_order_acquire))
+        releaseStreamingDecoder(); // discarded, retired in the audio thread
 
-    QMutexLocker locker(&decodersMutex);
+    if (!streamingDecoder) {
+        if (!isFirstPart) { // we are receinving partial data of the previous interval, we must wait until receive a new interval
+            //qDebug() << "Returning, not the first part of an interval";
+            return;
+        }
 
-    if (decoders.isEmpty()) {
+        // qDebug() << "First interval part received, creating new interval";
+        auto decoder = new IntervalDecoder();
+        LookAheadDecoder::getInstance().schedule(decoder); // scheduled before shared, the look ahead thread knows the decoder when it is retired
 
-        if (!isFirstPart) { // if decoders are empty and the chunk is not the first part we are receinving partial data of the previous interval, we must wait until receive a new interval
-            //qDebug() << "Returning, not the first part of an interval";
+        streamingDiscards = discardRequests.load(std::memory_order_acquire);
+        if (!streamedDecoders.try_enqueue(StreamedDecoder{decoder, streamingDiscards})) {
+            decoder->releaseProducer();
+            retireDecoder(decoder); // too many intervals waiting the audio thread
             return;
         }
 
-       // qDebug() << "First interval part received, creating new interval";
-        decoders.push_back(new IntervalDecoder());
+        streamingDecoder = decoder;
     }
 
+    streamingDecoder->addEncodedData(chunkBytes);
 
-    decoders.last()->addEncodedData(chunkBytes);
+    if (isLastPart)
+        streamingDecoder->setInputComplete();
 
-    if (isLastPart) {
-        //qDebug() << "Last part received, creating new IntervalDecoder";
-        decoders.push_back(new IntervalDecoder());
-    }
+    // scheduled again in every chunk, the look ahead thread is waked up to decode the new data
+    LookAheadDecoder::getInstance().schedule(streamingDecoder);
 
+    if (isLastPart)
+        releaseStreamingDecoder(); // the next chunk is the first part of a new interval
+}
+
+void NinjamTrackNode::releaseStreamingDecoder()
+{
+    if (streamingDecoder) {
+        streamingDecoder->releaseProducer(); // the last access, the decoder can be destroyed after retired
+        streamingDecoder = nullptr;
+    }
 }
 
  // this function is used only for Intervalic mode. The parameter is a full Ogg Vorbis Interval data
@@ -338,16 +871,33 @@ void NinjamTrackNode::addVorbisEncodedInterval(const QByteArray &fullIntervalByt
     if (mode != Intervalic)
         return;
 
+    addIntervalDecoder(createIntervalDecoder(fullIntervalBytes));
+}
+
+NinjamTrackNode::IntervalDecoder *NinjamTrackNode::createIntervalDecoder(const QByteArray &fullIntervalBytes)
+{
     auto newIntervalDecoder = new IntervalDecoder(fullIntervalBytes);
 
-    decodersMutex.lock();
+    //decoding in a separated thread to avoid slow down the audio thread in interval start (first beat)
+    LookAheadDecoder::getInstance().schedule(newIntervalDecoder); // scheduled before shared, the look ahead thread knows the decoder when it is retired
 
-    decoders.append(newIntervalDecoder);
+    return newIntervalDecoder;
+}
+
+void NinjamTrackNode::discardIntervalDecoder(IntervalDecoder *decoder)
+{
+    LookAheadDecoder::getInstance().retire(decoder);
+}
 
-    decodersMutex.unlock();
+void NinjamTrackNode::addIntervalDecoder(IntervalDecoder *decoder)
+{
+    // audio thread, the decoders are owned by the audio thread
+    if (mode != Intervalic) {
+        retireDecoder(decoder); // the channel mode was changed after the download
+        return;
+    }
 
-    //decoding the first samples in a separated thread to avoid slow down the audio thread in interval start (first beat)
-    QtConcurrent::run(newIntervalDecoder, &NinjamTrackNode::IntervalDecoder::decode, 256);
+    appendDecoder(decoder);
 }
 
 // ++++++++++++++
@@ -373,63 +923,57 @@ void NinjamTrackNode::schefuleSetChannelMode(ChannelMode mode)
 int NinjamTrackNode::getFramesToProcess(int targetSampleRate, int outFrameLenght)
 {
     return needResamplingFor(targetSampleRate) ? getInputResamplingLength(
-        getSampleRate(), targetSampleRate, outFrameLenght) : outFrameLenght;
+        getDecoderSampleRate(), targetSampleRate, outFrameLenght) : outFrameLenght;
 }
 
 void NinjamTrackNode::processReplacing(const audio::SamplesBuffer &in, audio::SamplesBuffer &out,
-                                       int sampleRate, std::vector<midi::MidiMessage> &midiBuffer)
+                                       int sampleRate, const std::vector<midi::MidiMessage> &midiBuffer)
 {
-    if (!isPlaying())
-        return;
-
-    { // mutex scope
-        QMutexLocker locker(&decodersMutex);
+    consumeStreamedDecoders();
 
-        if (!currentDecoder) {
-            if (mode == VoiceChat && !decoders.isEmpty()) {
-                currentDecoder = decoders.first();
-                //qDebug() << "USING FIRST DECODER";
-            }
-            else {
-                //qDebug() << "Current decoder is null, not playing!";
-                return;
-            }
+    if (!currentDecoder) {
+        if (mode == VoiceChat && !decoders.empty()) { // in voice chat we will not wait until startInterval to use the next available downloaded decoder
+            currentDecoder = decoders.front();
+            decoders.erase(decoders.begin());
+            //qDebug() << "USING FIRST DECODER";
         }
-
-        if (!currentDecoder || !currentDecoder->isValid()) {
-            if (currentDecoder && !currentDecoder->isValid()){
-                //qDebug() << "Current decoder is not valid, returning!";
-                currentDecoder = nullptr; // the current decoder is corrupted, setting to nullptr to force a new decoder usage
-                decoders.clear();
-                internalInputBuffer.zero();
-            }
+        else {
+            //qDebug() << "Current decoder is null, not playing!";
+            publishDecoderState();
             return;
         }
+    }
 
-        auto framesToProcess = getFramesToProcess(sampleRate, out.getFrameLenght());
-        internalInputBuffer.setFrameLenght(framesToProcess);
+    if (!currentDecoder->isValid()) {
+        //qDebug() << "Current decoder is not valid, returning!";
+        retireAllDecoders(); // the current decoder is corrupted, setting to nullptr to force a new decoder usage
+        internalInputBuffer.zero();
+        publishDecoderState();
+        return;
+    }
 
-        auto samplesDecoded = 0;
+    int decoderSampleRate = currentDecoder->getSampleRate();
 
-        if (currentDecoder)
-            currentDecoder->getDecodedSamples(internalInputBuffer, framesToProcess);
+    auto framesToProcess = getFramesToProcess(sampleRate, out.getFrameLenght());
+    internalInputBuffer.setFrameLenght(framesToProcess);
 
-        if (mode == VoiceChat) { // in voice chat we will not wait until startInterval to use the next available downloaded decoder
-            if (samplesDecoded <= framesToProcess && currentDecoder->isFullyDecoded()) {
-                //qDebug() << "current decoder consumed, using the next decoder";
-                currentDecoder = nullptr;
-                if (!decoders.isEmpty()) {
-                    auto decoder = decoders.takeFirst();
-                    delete decoder;
-                }
-            }
-        }
+    bool decodedAhead = true;
+    currentDecoder->getDecodedSamples(internalInputBuffer, framesToProcess, decodedAhead);
+    if (!decodedAhead)
+        decodingUnderruns.fetch_add(1, std::memory_order_relaxed); // the look ahead thread is late, decoded here or played as silence
 
+    if (mode == VoiceChat && currentDecoder->isFullyDecoded()) {
+        //qDebug() << "current decoder consumed, using the next decoder";
+        retireDecoder(currentDecoder);
+        currentDecoder = nullptr;
     }
 
+    publishDecoderState();
+
     if (!internalInputBuffer.isEmpty()) {
-        if (needResamplingFor(sampleRate)) {
-            const auto &resampledBuffer = resampler.resample(internalInputBuffer, out.getFrameLenght());
+        if (decoderSampleRate != sampleRate) {
+            const auto &resampledBuffer = resampler.resample(internalInputBuffer, out.getFrameLenght(),
+                                                                 decoderSampleRate, sampleRate);
             internalInputBuffer.setFrameLenght(resampledBuffer.getFrameLenght());
             internalInputBuffer.set(resampledBuffer);
         }
@@ -3,6 +3,7 @@
 
 #include "core/AudioNode.h"
 #include <QByteArray>
+#include <atomic>
 #include "SamplesBufferResampler.h"
 #include "readerwriterqueue.h"
 
@@ -27,12 +28,23 @@ public:
         Changing // used when waiting for the next interval do change the mode. Nothing is played in this 'transition state mode'
     };
 
+    class IntervalDecoder;
+
     explicit NinjamTrackNode(int ID);
     virtual ~NinjamTrackNode();
     void addVorbisEncodedInterval(const QByteArray &fullIntervalBytes);
+
+    // Intervalic mode hand-off: the decoder is created (and scheduled in the look ahead thread) in the network
+    // thread and added in the audio thread, not allocating. The decoders not added are discarded.
+    static IntervalDecoder *createIntervalDecoder(const QByteArray &fullIntervalBytes);
+    static void discardIntervalDecoder(IntervalDecoder *decoder);
+    void addIntervalDecoder(IntervalDecoder *decoder);
+
+    // Voice chat hand-off: the chunks are decoded by a decoder created in the network thread and taken
+    // by the audio thread in processReplacing()
     void addVorbisEncodedChunk(const QByteArray &chunkBytes, bool isFirstPart, bool isLastPart);
     void processReplacing(const audio::SamplesBuffer &in, audio::SamplesBuffer &out, int sampleRate,
-                          std::vector<midi::MidiMessage> &midiBuffer) override;
+                          const std::vector<midi::MidiMessage> &midiBuffer) override;
 
     void setLowCutState(LowCutState newState);
     LowCutState setLowCutToNextState();
@@ -41,6 +53,7 @@ public:
     bool startNewInterval();
     int getID() const;
 
+    // published by the audio thread, can be called from any thread
     int getSampleRate() const;
 
     bool isPlaying();
@@ -53,11 +66,17 @@ public:
 
     void schefuleSetChannelMode(ChannelMode mode);
 
-    // Discard all downloaded (but not played yet) intervals
+    // Discard all downloaded intervals, the decoders are retired in the next audio callback
     void discardDownloadedIntervals();
 
     void stopDecoding();
 
+    // memory used to decode the downloaded intervals in background, shared by all tracks
+    static void setLookAheadDecodingBudget(qint64 bytes);
+    static qint64 getLookAheadDecodedBytes(); // decoded blocks not consumed yet
+
+    quint64 getDecodingUnderruns() const; // audio callbacks with samples not decoded ahead (decoded in audio thread or silence)
+
     //void setProcessingLastPartOfInterval(bool status);
 
 protected:
@@ -84,18 +103,52 @@ private:
     QScopedPointer<LowCutFilter> lowCut;
     const static double LOW_CUT_NORMAL_FREQUENCY;
     const static double LOW_CUT_DRASTIC_FREQUENCY;
+    const static qint64 DEFAULT_LOOK_AHEAD_DECODING_BUDGET;
 
+    // the functions below are called from the audio thread
     bool needResamplingFor(int targetSampleRate) const;
 
     int getFramesToProcess(int targetSampleRate, int outFrameLenght);
 
+    int getDecoderSampleRate() const;
+
     //bool processingLastPartOfInterval;
 
-    class IntervalDecoder;
+    class LookAheadDecoder;
+
+    // the decoders are owned by the audio thread and never deleted here, they are retired and destroyed in the look ahead decoding thread
+    std::vector<IntervalDecoder *> decoders;
+    IntervalDecoder *currentDecoder;
+    quint32 discardsDone; // audio thread
+
+    struct StreamedDecoder
+    {
+        IntervalDecoder *decoder;
+        quint32 discards; // discard requests before the decoder creation
+    };
+
+    // voice chat decoders created in the network thread (the single producer) and taken in the audio thread
+    moodycamel::ReaderWriterQueue<StreamedDecoder> streamedDecoders;
+    IntervalDecoder *streamingDecoder; // network thread, receiving the chunks of the current voice chat interval
+    quint32 streamingDiscards;
+
+    std::atomic<quint32> discardRequests; // incremented in any thread, the discard is done in the audio thread
+
+    // published by the audio thread
+    std::atomic<bool> playing;
+    std::atomic<int> publishedSampleRate;
+    std::atomic<bool> publishedStereo;
+
+    static const size_t MAX_BUFFERED_INTERVALS = 32;
+
+    std::atomic<quint64> decodingUnderruns;
 
-    QList<IntervalDecoder*> decoders;
-    IntervalDecoder* currentDecoder;
-    QMutex decodersMutex;
+    void retireDecoder(IntervalDecoder *decoder);
+    void retireAllDecoders();
+    bool appendDecoder(IntervalDecoder *decoder); // the decoder is retired if 'decoders' is full
+    void consumeStreamedDecoders();
+    void publishDecoderState();
+    void releaseStreamingDecoder(); // network thread
 
     ChannelMode mode = Intervalic;
 
@@ -1,18 +1,222 @@
 #include "Resampler.h"
+#include "audio/core/SimdKernels.h"
 
-SimpleResampler::SimpleResampler()
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+namespace {
+
+const double PI = 3.14159265358979323846;
+
+const float ROLLOFF = 0.95f; // cutoff frequency, leave some space to the transition band
+
+double sinc(double x)
+{
+    if (std::abs(x) < 1e-9)
+        return 1.0;
+
+    return std::sin(PI * x) / (PI * x);
+}
+
+double blackmanWindow(double x, double halfWidth) // x in [-halfWidth, halfWidth]
+{
+    if (std::abs(x) >= halfWidth)
+        return 0.0;
+
+    double t = PI * x / halfWidth;
+    return 0.42 + 0.5 * std::cos(t) + 0.08 * std::cos(2 * t);
+}
+
+} // namespace
+
+PolyphaseResampler::PolyphaseResampler(Quality quality) :
+    quality(quality),
+    taps(getTaps(quality)),
+    cutoff(ROLLOFF),
+    coefficients(audio::simd::alignedAlloc((PHASES + 1) * MAX_TAPS)),
+    history(audio::simd::alignedAlloc((MAX_TAPS + HISTORY_MARGIN * 2) * 2)),
+    phase(0),
+    currentRatio(0)
+{
+    buildCoefficients();
+    reset();
+}
+
+PolyphaseResampler::~PolyphaseResampler()
 {
+    audio::simd::alignedFree(coefficients);
+    audio::simd::alignedFree(history);
+}
+
+unsigned int PolyphaseResampler::getTaps(Quality quality)
+{
+    switch (quality) {
+    case LowQuality: return 8;
+    case MediumQuality: return 16;
+    case HighQuality: return 32;
+    }
+
+    return 16;
+}
+
+void PolyphaseResampler::setQuality(Quality quality)
+{
+    if (quality == this->quality)
+        return;
 
+    this->quality = quality;
+    taps = getTaps(quality);
+    buildCoefficients();
+    reset();
+}
+
+void PolyphaseResampler::reset()
+{
+    std::memset(history, 0, (MAX_TAPS + HISTORY_MARGIN * 2) * 2 * sizeof(float));
+    phase = 0;
+    currentRatio = 0;
+}
+
+void PolyphaseResampler::updateCutoff(double step)
+{
+    // down sampling (step > 1) need a lower cutoff to avoid aliasing
+    float newCutoff = ROLLOFF * static_cast<float>(step > 1.0 ? 1.0 / step : 1.0);
+
+    // small variations in the block lenghts are ignored, the coefficients are rebuilt only when the ratio changes
+    if (std::abs(newCutoff - cutoff) > cutoff * 0.02f) {
+        cutoff = newCutoff;
+        buildCoefficients();
+    }
 }
 
-void SimpleResampler::process(const float *in, int inLength, float *out, int outLenght)
+void PolyphaseResampler::buildCoefficients()
 {
-    double step = static_cast<double>(inLength)/static_cast<double>(outLenght);
-    double doubleCursor = 0;
+    const double halfWidth = taps / 2.0;
+    for (unsigned int p = 0; p <= PHASES; ++p) {
+        float *row = coefficients + p * MAX_TAPS;
+        const double fraction = static_cast<double>(p) / PHASES;
+        double sum = 0;
+        for (unsigned int t = 0; t < taps; ++t) {
+            double x = (static_cast<double>(t) - (halfWidth - 1)) - fraction;
+            double value = cutoff * sinc(cutoff * x) * blackmanWindow(x, halfWidth);
+            row[t] = static_cast<float>(value);
+            sum += value;
+        }
+
+        for (unsigned int t = 0; t < taps; ++t) // unity gain in all phases
+            row[t] = static_cast<float>(row[t] / sum);
+
+        for (unsigned int t = taps; t < MAX_TAPS; ++t)
+            row[t] = 0;
+    }
+}
+
+float PolyphaseResampler::interpolate(const float *samples, double fraction) const
+{
+    double position = fraction * PHASES;
+    unsigned int row = static_cast<unsigned int>(position);
+    float weight = static_cast<float>(position - row);
+    if (row >= PHASES) {
+        row = PHASES - 1;
+        weight = 1.0f;
+    }
+
+    const auto &kernels = audio::simd::kernels();
+    const float *firstRow = coefficients + row * MAX_TAPS;
+    float first = kernels.dotProduct(samples, firstRow, taps);
+    float second = kernels.dotProduct(samples, firstRow + MAX_TAPS, taps);
+
+    return first + (second - first) * weight;
+}
+
+void PolyphaseResampler::process(const float *in, int inLength, float *out, int outLenght, double ratio)
+{
+    if (outLenght <= 0)
+        return;
+
+    if (inLength <= 0) {
+        std::fill(out, out + outLenght, 0.0f);
+        return;
+    }
+
+    // When the ratio is known (sample rates ratio) the phase is preserved between blocks and the
+    // output samples are placed in the right position even if the callers are jittering the input
+    // lenght (rounding corrections). Otherwise the output is aligned with the block start.
+    const double step = ratio > 0 ? ratio : static_cast<double>(inLength) / outLenght;
+    if (ratio <= 0 || ratio != currentRatio)
+        phase = 0;
+
+    currentRatio = ratio;
+    updateCutoff(step);
+
+    // the history samples are followed by the first input samples, so the filter
+    // can read the block edges without copy the entire input block
+    const int historyLength = getHistoryLength();
+    const int bridgedSamples = std::min(inLength, historyLength);
+    std::memcpy(history + historyLength, in, bridgedSamples * sizeof(float));
+
+    const int lastIndex = historyLength + inLength - static_cast<int>(taps); // the last tap is the last input sample
+    double position = phase;
+    for (int i = 0; i < outLenght; ++i) {
+        double floorPosition = std::floor(position);
+        double fraction = position - floorPosition;
+        int index = static_cast<int>(floorPosition) + HISTORY_MARGIN; // first tap index (history + input)
+        if (index < 0) {
+            index = 0;
+            fraction = 0;
+        }
+        else if (index > lastIndex) {
+            index = lastIndex;
+            fraction = 0;
+        }
+
+        const float *samples = index < historyLength ? history + index : in + (index - historyLength);
+        out[i] = interpolate(samples, fraction);
+        position += step;
+    }
+
+    const double maxPhase = HISTORY_MARGIN;
+    phase = std::min(maxPhase, std::max(-maxPhase, position - inLength));
+
+    // keeping the last samples for the next block
+    if (inLength >= historyLength)
+        std::memcpy(history, in + inLength - historyLength, historyLength * sizeof(float));
+    else
+        std::memmove(history, history + inLength, historyLength * sizeof(float));
+}
+
+void PolyphaseResampler::resample(const float *in, int inLength, float *out, int outLenght, Quality quality)
+{
+    if (outLenght <= 0)
+        return;
+
+    if (inLength <= 0) {
+        std::fill(out, out + outLenght, 0.0f);
+        return;
+    }
+
+    PolyphaseResampler resampler(quality);
+    const double step = static_cast<double>(inLength) / outLenght;
+    resampler.updateCutoff(step);
+
+    const int taps = resampler.taps;
+    const int firstTapOffset = taps / 2 - 1;
+    float *samples = resampler.history; // used to gather the zero padded samples in the signal edges
+
     for (int i = 0; i < outLenght; ++i) {
-        int cursor = (int)doubleCursor;
-        double frac = (cursor < inLength-1) ? doubleCursor - cursor : 0; // the last input samples are just copied
-        out[i] = in[cursor] * (1.0-frac) + in[cursor+1] * frac;
-        doubleCursor += step;
+        double position = i * step;
+        int index = static_cast<int>(position);
+        int firstTap = index - firstTapOffset;
+        if (firstTap >= 0 && firstTap + taps <= inLength) {
+            out[i] = resampler.interpolate(in + firstTap, position - index);
+        }
+        else {
+            for (int t = 0; t < taps; ++t) {
+                int inputIndex = firstTap + t;
+                samples[t] = (inputIndex >= 0 && inputIndex < inLength) ? in[inputIndex] : 0.0f;
+            }
+            out[i] = resampler.interpolate(samples, position - index);
+        }
     }
 }
@@ -1,13 +1,81 @@
 #ifndef RESAMPLER_H
 #define RESAMPLER_H
 
-class SimpleResampler
+/**
+ * Band limited resampler using a polyphase windowed-sinc filter. The filter coefficients are
+ * precomputed for PHASES fractional positions (linear interpolation between adjacent phases) and
+ * the FIR inner loop uses the SIMD kernels.
+ *
+ * process() is stateful: the last input samples and the fractional phase are kept between calls,
+ * so the block edges are continuous. This introduces a latency of getLatency() input samples.
+ */
+
+class PolyphaseResampler
 {
 
 public:
-    explicit SimpleResampler();
-    void process(const float *in, int inLength, float *out, int outLenght);
+    enum Quality
+    {
+        LowQuality,     // 8 taps
+        MediumQuality,  // 16 taps
+        HighQuality     // 32 taps
+    };
+
+    explicit PolyphaseResampler(Quality quality = MediumQuality);
+    ~PolyphaseResampler();
+
+    // stream resampling, all 'inLength' samples are consumed and exactly 'outLenght' samples are produced.
+    // 'ratio' is the input/output sample rates ratio, when zero inLength/outLenght is used.
+    void process(const float *in, int inLength, float *out, int outLenght, double ratio = 0);
+
+    // one shot resampling of a complete signal (no latency, the edges are zero padded)
+    static void resample(const float *in, int inLength, float *out, int outLenght, Quality quality = HighQuality);
+
+    void reset(); // discard the samples stored from previous blocks
+
+    void setQuality(Quality quality);
+    Quality getQuality() const;
+
+    unsigned int getLatency() const;
+
+private:
+    PolyphaseResampler(const PolyphaseResampler &other);
+    PolyphaseResampler &operator=(const PolyphaseResampler &other);
+
+    Quality quality;
+    unsigned int taps;
+    float cutoff; // normalized to the input nyquist frequency
+    float *coefficients; // PHASES + 1 rows, each row has MAX_TAPS aligned coefficients
+    float *history; // getHistoryLength() samples from previous blocks followed by the first samples of the current block
+    double phase; // position of the next output sample (relative to the block start), preserved between blocks
+    double currentRatio;
 
+    void updateCutoff(double step);
+    void buildCoefficients();
+    float interpolate(const float *samples, double fraction) const;
+
+    static unsigned int getTaps(Quality quality);
+
+    int getHistoryLength() const;
+
+    static const unsigned int PHASES = 256;
+    static const unsigned int MAX_TAPS = 32;
+    static const int HISTORY_MARGIN = 2; // extra samples before and after the filter, the phase is oscillating around zero
 };
 
+inline PolyphaseResampler::Quality PolyphaseResampler::getQuality() const
+{
+    return quality;
+}
+
+inline unsigned int PolyphaseResampler::getLatency() const
+{
+    return taps / 2 + HISTORY_MARGIN;
+}
+
+inline int PolyphaseResampler::getHistoryLength() const
+{
+    return taps - 1 + HISTORY_MARGIN * 2;
+}
+
 #endif // RESAMPLER_H
@@ -57,7 +57,7 @@ void AbstractMp3Streamer::stopCurrentStream()
         streaming = false;
     }
     bytesToDecode.clear();
-    lastPeak.zero();
+    resetLastPeak();
 }
 
 int AbstractMp3Streamer::getSamplesToRender(int targetSampleRate, int outLenght)
@@ -68,7 +68,7 @@ int AbstractMp3Streamer::getSamplesToRender(int targetSampleRate, int outLenght)
     return samplesToRender;
 }
 
-void AbstractMp3Streamer::processReplacing(const SamplesBuffer &in, SamplesBuffer &out, int targetSampleRate, std::vector<midi::MidiMessage> &)
+void AbstractMp3Streamer::processReplacing(const SamplesBuffer &in, SamplesBuffer &out, int targetSampleRate, const std::vector<midi::MidiMessage> &)
 {
     Q_UNUSED(in);
 
@@ -83,7 +83,8 @@ void AbstractMp3Streamer::processReplacing(const SamplesBuffer &in, SamplesBuffe
     internalInputBuffer.set(bufferedSamples);
 
     if (needResamplingFor(targetSampleRate)) {
-        const auto &resampledBuffer = resampler.resample(internalInputBuffer, out.getFrameLenght());
+        const auto &resampledBuffer = resampler.resample(internalInputBuffer, out.getFrameLenght(),
+                                                         getSampleRate(), targetSampleRate);
         internalOutputBuffer.setFrameLenght(resampledBuffer.getFrameLenght());
         internalOutputBuffer.set(resampledBuffer);
     } else {
@@ -97,7 +98,7 @@ void AbstractMp3Streamer::processReplacing(const SamplesBuffer &in, SamplesBuffe
         qCDebug(jtNinjamRoomStreamer) << out.getFrameLenght()
             - internalOutputBuffer.getFrameLenght() << " samples missing";
 
-    this->lastPeak.update(internalOutputBuffer.computePeak());
+    publishPeak(internalOutputBuffer.computePeak());
 
     out.add(internalOutputBuffer);
 }
@@ -219,7 +220,7 @@ NinjamRoomStreamerNode::~NinjamRoomStreamerNode()
 }
 
 void NinjamRoomStreamerNode::processReplacing(const SamplesBuffer &in, SamplesBuffer &out,
-                                              int sampleRate, std::vector<midi::MidiMessage> &midiBuffer)
+                                              int sampleRate, const std::vector<midi::MidiMessage> &midiBuffer)
 {
     Q_UNUSED(in)
     QMutexLocker locker(&mutex);
@@ -274,7 +275,7 @@ AudioFileStreamerNode::~AudioFileStreamerNode()
 }
 
 void AudioFileStreamerNode::processReplacing(const SamplesBuffer &in, SamplesBuffer &out,
-                                             int sampleRate, std::vector<midi::MidiMessage> &midiBuffer)
+                                             int sampleRate, const std::vector<midi::MidiMessage> &midiBuffer)
 {
     while (bufferedSamples.getFrameLenght() < out.getFrameLenght())
         decode(1024 + 1024);
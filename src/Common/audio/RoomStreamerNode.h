@@ -20,7 +20,7 @@ public:
     explicit AbstractMp3Streamer(audio::Mp3Decoder *decoder);
     virtual ~AbstractMp3Streamer();
     void processReplacing(const audio::SamplesBuffer &in, audio::SamplesBuffer &out,
-                          int sampleRate, std::vector<midi::MidiMessage> &midiBuffer) override;
+                          int sampleRate, const std::vector<midi::MidiMessage> &midiBuffer) override;
     virtual void stopCurrentStream();
     virtual void setStreamPath(const QString &streamPath);
     bool isStreaming() const;
@@ -66,7 +66,7 @@ public:
     explicit NinjamRoomStreamerNode(const QUrl &streamPath = QUrl(""));
     ~NinjamRoomStreamerNode();
 
-    void processReplacing(const SamplesBuffer &in, SamplesBuffer &out, int sampleRate, std::vector<midi::MidiMessage> &midiBuffer) override;
+    void processReplacing(const SamplesBuffer &in, SamplesBuffer &out, int sampleRate, const std::vector<midi::MidiMessage> &midiBuffer) override;
     bool needResamplingFor(int targetSampleRate) const override;
 
     bool isBuffering() const override;
@@ -104,7 +104,7 @@ public:
     explicit AudioFileStreamerNode(const QString &file);
     ~AudioFileStreamerNode();
     void processReplacing(const SamplesBuffer &in, SamplesBuffer &out, int sampleRate,
-                                  std::vector<midi::MidiMessage> &midiBuffer) override;
+                                  const std::vector<midi::MidiMessage> &midiBuffer) override;
 };
 
 } // namespace end
@@ -2,10 +2,12 @@
 #include <algorithm>
 #include <QDebug>
 
-SamplesBufferResampler::SamplesBufferResampler() :
-    outBuffer(2, 4096 * 2)
+SamplesBufferResampler::SamplesBufferResampler(PolyphaseResampler::Quality quality) :
+    outBuffer(2)
 {
-    //
+    outBuffer.reserve(4096 * 2); // enough space, avoiding allocations in audio thread
+
+    setQuality(quality);
 }
 
 SamplesBufferResampler::~SamplesBufferResampler()
@@ -13,17 +15,35 @@ SamplesBufferResampler::~SamplesBufferResampler()
 
 }
 
+void SamplesBufferResampler::setQuality(PolyphaseResampler::Quality quality)
+{
+    for (auto &resampler : resamplers)
+        resampler.setQuality(quality);
+}
+
+void SamplesBufferResampler::reset()
+{
+    for (auto &resampler : resamplers)
+        resampler.reset();
+}
+
 const audio::SamplesBuffer &SamplesBufferResampler::resample(const audio::SamplesBuffer &in,
-                                                             int desiredOutLenght)
+                                                             int desiredOutLenght, int sourceSampleRate,
+                                                             int targetSampleRate)
 {
-    outBuffer.zero();
-    outBuffer.setFrameLenght(desiredOutLenght * 2); // enough space
+    double ratio = targetSampleRate > 0 ? static_cast<double>(sourceSampleRate) / targetSampleRate : 0;
+
+    if (in.isMono()) // the output has the same channels as the input
+        outBuffer.setToMono();
+    else
+        outBuffer.setToStereo();
+
+    outBuffer.setFrameLenght(desiredOutLenght);
     uint channels = std::min(in.getChannels(), outBuffer.getChannels());
     for (uint c = 0; c < channels; ++c) {
         float *input = in.getSamplesArray(c);
         float *output = outBuffer.getSamplesArray(c);
-        resamplers[c].process(input, in.getFrameLenght(), output, desiredOutLenght);
+        resamplers[c].process(input, in.getFrameLenght(), output, desiredOutLenght, ratio);
     }
-    outBuffer.setFrameLenght(desiredOutLenght);
     return outBuffer;
 }
@@ -8,13 +8,18 @@ class SamplesBufferResampler
 {
 
 public:
-    SamplesBufferResampler();
+    explicit SamplesBufferResampler(PolyphaseResampler::Quality quality = PolyphaseResampler::MediumQuality);
     ~SamplesBufferResampler();
-    const audio::SamplesBuffer &resample(const audio::SamplesBuffer &in, int desiredOutLenght);
+    const audio::SamplesBuffer &resample(const audio::SamplesBuffer &in, int desiredOutLenght,
+                                         int sourceSampleRate, int targetSampleRate);
+
+    void reset(); // discard the resampling state, used when a new stream is started
+
+    void setQuality(PolyphaseResampler::Quality quality);
 
 private:
     audio::SamplesBuffer outBuffer;
-    SimpleResampler resamplers[2];
+    PolyphaseResampler resamplers[2];
 };
 
 #endif // SAMPLESBUFFERRESAMPLER_H
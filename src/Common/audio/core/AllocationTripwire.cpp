@@ -0,0 +1,181 @@
+#include "AllocationTripwire.h"
+
+#ifdef JAMTABA_ALLOCATION_TRIPWIRE
+
+#include "log/Logging.h"
+
+#include <QDebug>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#if defined(Q_OS_WIN)
+    #include "log/stackwalker/WindowsStackWalker.h"
+#else
+    #include <execinfo.h>
+#endif
+
+#if defined(__GLIBC__)
+extern "C" {
+    void *__libc_malloc(size_t size);
+    void *__libc_calloc(size_t count, size_t size);
+    void *__libc_realloc(void *ptr, size_t size);
+}
+#endif
+
+namespace {
+
+thread_local bool insideAudioThread = false;
+thread_local bool reporting = false; // avoid recursion when the report itself allocates
+
+std::atomic<quint64> detectedAllocations(0);
+
+const int MAX_REPORTED_STACKS = 64; // after this only the counter is updated, avoiding flood the log
+
+void reportAllocation(size_t bytes)
+{
+    reporting = true;
+
+    quint64 allocations = ++detectedAllocations;
+    if (allocations <= MAX_REPORTED_STACKS) {
+        qCCritical(jtAudio) << "Allocation tripwire:" << bytes << "bytes allocated in the audio thread!";
+
+#if defined(Q_OS_WIN)
+        WindowsStackWalker stackWalker;
+        stackWalker.ShowCallstack();
+#else
+        void *frames[32];
+        int size = backtrace(frames, 32);
+        char **symbols = backtrace_symbols(frames, size);
+        if (symbols) {
+            for (int i = 1; i < size; ++i) // skipping the tripwire frame
+                qCCritical(jtAudio) << "    " << symbols[i];
+
+            std::free(symbols);
+        }
+#endif
+    }
+
+    reporting = false;
+}
+
+inline void checkAllocation(size_t bytes)
+{
+    if (insideAudioThread && !reporting)
+        reportAllocation(bytes);
+}
+
+} // namespace
+
+namespace audio {
+
+namespace tripwire {
+
+AudioThreadScope::AudioThreadScope() :
+    previousState(insideAudioThread)
+{
+    insideAudioThread = true;
+}
+
+AudioThreadScope::~AudioThreadScope()
+{
+    insideAudioThread = previousState;
+}
+
+AllowAllocationsScope::AllowAllocationsScope() :
+    previousState(insideAudioThread)
+{
+    insideAudioThread = false;
+}
+
+AllowAllocationsScope::~AllowAllocationsScope()
+{
+    insideAudioThread = previousState;
+}
+
+quint64 getDetectedAllocations()
+{
+    return detectedAllocations.load();
+}
+
+} // namespace tripwire
+
+} // namespace audio
+
+// ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+#if defined(__GLIBC__)
+
+// glibc allow replacing malloc family, operator new is calling malloc internally
+
+extern "C" void *malloc(size_t size)
+{
+    checkAllocation(size);
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size)
+{
+    checkAllocation(count * size);
+    return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size)
+{
+    checkAllocation(size);
+    return __libc_realloc(ptr, size);
+}
+
+#else
+
+void *operator new(std::size_t size)
+{
+    checkAllocation(size);
+    void *ptr = std::malloc(size ? size : 1);
+    if (!ptr)
+        throw std::bad_alloc();
+
+    return ptr;
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    checkAllocation(size);
+    return std::malloc(size ? size : 1);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+    checkAllocation(size);
+    return std::malloc(size ? size : 1);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept
+{
+    std::free(ptr);
+}
+
+#endif
+
+#endif // JAMTABA_ALLOCATION_TRIPWIRE
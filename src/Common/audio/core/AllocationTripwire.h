@@ -0,0 +1,67 @@
+#ifndef ALLOCATION_TRIPWIRE_H
+#define ALLOCATION_TRIPWIRE_H
+
+#include <QtGlobal>
+
+/**
+ * Debug helper to catch heap allocations in the real time audio callback.
+ *
+ * Build with 'qmake CONFIG+=allocation_tripwire' (defines JAMTABA_ALLOCATION_TRIPWIRE) to
+ * hook malloc/operator new. Every allocation made while an AudioThreadScope is alive in the
+ * current thread is logged with its stack trace. In normal builds the scopes are empty.
+ */
+
+namespace audio {
+
+namespace tripwire {
+
+#ifdef JAMTABA_ALLOCATION_TRIPWIRE
+
+class AudioThreadScope // mark the current thread as the audio callback thread
+{
+public:
+    AudioThreadScope();
+    ~AudioThreadScope();
+
+private:
+    bool previousState;
+};
+
+class AllowAllocationsScope // used for the few known (and not real time critical) allocations
+{
+public:
+    AllowAllocationsScope();
+    ~AllowAllocationsScope();
+
+private:
+    bool previousState;
+};
+
+quint64 getDetectedAllocations(); // total allocations detected in audio thread
+
+#else
+
+class AudioThreadScope
+{
+public:
+    AudioThreadScope() {}
+};
+
+class AllowAllocationsScope
+{
+public:
+    AllowAllocationsScope() {}
+};
+
+inline quint64 getDetectedAllocations()
+{
+    return 0;
+}
+
+#endif
+
+} // namespace tripwire
+
+} // namespace audio
+
+#endif // ALLOCATION_TRIPWIRE_H
@@ -1,8 +1,10 @@
 #include "AudioDriver.h"
 #include "SamplesBuffer.h"
+#include "MainController.h"
 #include <vector>
 #include <QDebug>
 #include <cmath>
+#include <algorithm>
 #include <QMutexLocker>
 #include "log/Logging.h"
 
@@ -48,13 +50,20 @@ AudioDriver::AudioDriver(controller::MainController *mainController) :
     outputBuffer(SamplesBuffer(2)),
     mainController(mainController)
 {
-
+    inputBuffer.reserve(MaxBufferSize);
+    outputBuffer.reserve(MaxBufferSize);
 }
 
 void AudioDriver::recreateBuffers()
 {
     inputBuffer = SamplesBuffer(globalInputRange.getChannels());
     outputBuffer = SamplesBuffer(globalOutputRange.getChannels());
+
+    inputBuffer.reserve(std::max(bufferSize, MaxBufferSize));
+    outputBuffer.reserve(std::max(bufferSize, MaxBufferSize));
+
+    if (mainController) // the buffers used in the audio callback are resized here, the driver is not running
+        mainController->setAudioBuffersLayout(inputBuffer.getChannels(), outputBuffer.getChannels(), std::max(bufferSize, MaxBufferSize));
 }
 
 AudioDriver::~AudioDriver()
@@ -72,6 +72,8 @@ inline bool ChannelRange::isMono() const
 // ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 const int CurrentAudioDeviceSelection = -1;
 
+const int MaxBufferSize = 4096; // buffers used in audio callback are preallocated to this size, avoiding allocations in audio thread
+
 class AudioDriver : public QObject
 {
     Q_OBJECT
@@ -1,40 +1,69 @@
 #include "AudioMixer.h"
 #include "AudioNode.h"
+#include "AudioDriver.h"
 #include <QDebug>
 #include "Plugins.h"
 #include "midi/MidiDriver.h"
-#include <QMutexLocker>
 #include "log/Logging.h"
 
+#include <algorithm>
+
 using audio::AudioMixer;
 using audio::AudioNode;
 using audio::SamplesBuffer;
 
-AudioMixer::AudioMixer(int sampleRate) :
-    sampleRate(sampleRate)
+AudioMixer::RenderSlot::RenderSlot() :
+    buffer(2),
+    audible(true),
+    serial(false)
+{
+    buffer.reserve(audio::MaxBufferSize);
+}
+
+void AudioMixer::RenderTask::process(int index)
+{
+    if (!nodes->at(index).slot->serial)
+        render(index);
+}
+
+void AudioMixer::RenderTask::render(int index)
+{
+    const MixerNode &mixerNode = nodes->at(index);
+    RenderSlot &slot = *mixerNode.slot;
+    mixerNode.node->processReplacing(*in, slot.buffer, sampleRate, slot.audible ? *midiBuffer : noMidiMessages);
+}
+
+AudioMixer::AudioMixer(int sampleRate, int renderWorkers) :
+    sampleRate(sampleRate),
+    renderPool(renderWorkers)
 {
 
 }
 
 void AudioMixer::addNode(AudioNode *node)
 {
-    nodes.append(node);
-    resamplers.insert(node, SamplesBufferResampler());
+    QSharedPointer<RenderSlot> slot(new RenderSlot()); // allocated here, not in the audio thread
+
+    nodes.update([node, slot](std::vector<MixerNode> &nodes) {
+        nodes.push_back({ node, slot });
+    });
 }
 
 void AudioMixer::removeNode(AudioNode *node)
 {
-    nodes.removeOne(node);
-    resamplers.remove(node);
+    nodes.update([node](std::vector<MixerNode> &nodes) {
+        auto isRemovedNode = [node](const MixerNode &mixerNode) { return mixerNode.node == node; };
+        nodes.erase(std::remove_if(nodes.begin(), nodes.end(), isRemovedNode), nodes.end());
+    });
 }
 
 AudioMixer::~AudioMixer()
 {
     qCDebug(jtAudio) << "Audio mixer destructor...";
 
-    for (auto node : resamplers.keys()) {
-        removeNode(node);
-    }
+    nodes.update([](std::vector<MixerNode> &nodes) {
+        nodes.clear();
+    });
 
     qCDebug(jtAudio) << "Audio mixer destructor finished!";
 }
@@ -45,28 +74,50 @@ void AudioMixer::process(const SamplesBuffer &in, SamplesBuffer &out, int sample
     // --------------------------------------
     bool hasSoloedBuffers = soloedBuffersInLastProcess > 0;
     soloedBuffersInLastProcess = 0;
-    for (auto node : nodes) {
-        bool canProcess = (!hasSoloedBuffers && !node->isMuted()) || (hasSoloedBuffers && node->isSoloed());
-        if (canProcess) {
-
-            // each channel (not subchannel) will receive a full copy of incomming midi messages
-            std::vector<midi::MidiMessage> midiMessages(midiBuffer.size());
-            midiMessages.insert(midiMessages.begin(), midiBuffer.begin(), midiBuffer.end());
-
-            node->processReplacing(in, out, sampleRate, midiMessages);
-        }
-        else { // just discard the samples if node is muted, the internalBuffer is not copyed to out buffer
-            static audio::SamplesBuffer internalBuffer(2);
-            static std::vector<midi::MidiMessage> emptyMidiBuffer;
-            internalBuffer.setFrameLenght(out.getFrameLenght());
-            node->processReplacing(in, internalBuffer, sampleRate, emptyMidiBuffer);
-        }
+
+    RcuSnapshot<std::vector<MixerNode>>::Reader currentNodes(nodes); // lock free, the GUI thread can publish a new nodes list while we are processing
+
+    // preparing the private buffers, the mute/solo flags are read only once per callback
+    for (const MixerNode &mixerNode : *currentNodes) {
+        auto node = mixerNode.node;
+        RenderSlot &slot = *mixerNode.slot;
+
+        slot.audible = (!hasSoloedBuffers && !node->isMuted()) || (hasSoloedBuffers && node->isSoloed());
+        slot.serial = node->needsSerialRendering();
+
+        if (out.getChannels() == 1)
+            slot.buffer.setToMono();
+        else
+            slot.buffer.setToStereo();
+
+        slot.buffer.setFrameLenght(out.getFrameLenght());
+        slot.buffer.zero();
+
         if (node->isSoloed())
             soloedBuffersInLastProcess++;
     }
 
+    // rendering the nodes in parallel
+    renderTask.nodes = &(*currentNodes);
+    renderTask.in = &in;
+    renderTask.midiBuffer = &midiBuffer;
+    renderTask.sampleRate = sampleRate;
+    renderPool.run(renderTask, static_cast<int>(currentNodes->size()));
+
+    // the dependent nodes are rendered in the audio thread, one by one
+    for (int i = 0; i < static_cast<int>(currentNodes->size()); ++i) {
+        if (currentNodes->at(i).slot->serial)
+            renderTask.render(i);
+    }
+
+    // summing in the nodes order, so the output is deterministic. Muted nodes are just discarded.
+    for (const MixerNode &mixerNode : *currentNodes) {
+        if (mixerNode.slot->audible)
+            out.add(mixerNode.slot->buffer);
+    }
+
     if (attenuateAfterSumming) {
-        int nodesConnected = nodes.size();
+        int nodesConnected = static_cast<int>(currentNodes->size());
         if (nodesConnected > 1) // attenuate
             out.applyGain(1.0/nodesConnected, 0.0);
     }
@@ -1,15 +1,12 @@
 #ifndef AUDIO_MIXER_H
 #define AUDIO_MIXER_H
 
-#include <QList>
-#include <QMutex>
-#include <QMap>
-#include <QScopedPointer>
-#include "audio/SamplesBufferResampler.h"
-
-namespace midi {
-class MidiMessage;
-}
+#include <QSharedPointer>
+
+#include "audio/core/SamplesBuffer.h"
+#include "audio/core/RcuSnapshot.h"
+#include "audio/core/RenderPool.h"
+#include "midi/MidiMessage.h"
 
 namespace audio {
 
@@ -24,19 +21,52 @@ private:
     AudioMixer(const AudioMixer &other);
 
 public:
-    explicit AudioMixer(int sampleRate);
+    explicit AudioMixer(int sampleRate, int renderWorkers = -1); // 0 = all nodes are rendered in the audio thread
     ~AudioMixer();
     void process(const SamplesBuffer &in, SamplesBuffer &out, int sampleRate, const std::vector<midi::MidiMessage> &midiBuffer, bool attenuateAfterSumming = false);
+
+    // called by GUI or network threads. When removeNode() returns the node is not used by the audio thread.
     void addNode(AudioNode *node);
     void removeNode(AudioNode *node);
 
     void setSampleRate(int newSampleRate);
 
 private:
-    QList<AudioNode *> nodes;
+
+    // the nodes are independent, each node is rendered (in parallel) in a private preallocated buffer
+    struct RenderSlot
+    {
+        RenderSlot();
+
+        SamplesBuffer buffer;
+        bool audible; // muted nodes (or not soloed nodes) are processed, but the samples are discarded
+        bool serial; // rendered by the audio thread after the parallel nodes (see AudioNode::needsSerialRendering)
+    };
+
+    struct MixerNode
+    {
+        AudioNode *node;
+        QSharedPointer<RenderSlot> slot; // the slot is reused by the next snapshots
+    };
+
+    class RenderTask : public RenderPool::Task
+    {
+    public:
+        void process(int index) override; // the serial nodes are skipped
+        void render(int index);
+
+        const std::vector<MixerNode> *nodes;
+        const SamplesBuffer *in;
+        const std::vector<midi::MidiMessage> *midiBuffer; // shared by all nodes, the nodes are filtering without copy
+        const std::vector<midi::MidiMessage> noMidiMessages; // used by muted nodes
+        int sampleRate;
+    };
+
+    RcuSnapshot<std::vector<MixerNode>> nodes; // the audio thread is iterating this without locks
     int sampleRate;
-    QMap<AudioNode *, SamplesBufferResampler> resamplers;
 
+    RenderTask renderTask;
+    RenderPool renderPool; // declared after the nodes, the workers are stopped first
 };
 
 inline void AudioMixer::setSampleRate(int newSampleRate)
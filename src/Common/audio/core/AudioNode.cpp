@@ -3,8 +3,10 @@
 #include "SamplesBuffer.h"
 #include "AudioNodeProcessor.h"
 #include "AudioPeak.h"
+#include "MeteringBus.h"
 #include <cmath>
 #include <cassert>
+#include <algorithm>
 #include <QDebug>
 #include "midi/MidiDriver.h"
 #include <QMutexLocker>
@@ -19,7 +21,21 @@ using audio::AudioNodeProcessor;
 const double AudioNode::ROOT_2_OVER_2 = 1.414213562373095 * 0.5;
 const double AudioNode::PI_OVER_2 = 3.141592653589793238463 * 0.5;
 
-void AudioNode::processReplacing(const SamplesBuffer &in, SamplesBuffer &out, int sampleRate, std::vector<midi::MidiMessage> &midiBuffer)
+void AudioNode::processReplacing(const SamplesBuffer &in, SamplesBuffer &out, int sampleRate, const std::vector<midi::MidiMessage> &midiBuffer)
+{
+    // midiBuffer is shared by all nodes, the messages are copied only if some plugin will receive them
+    processorsMidiBuffer.clear();
+    for (int i=0; i < MAX_PROCESSORS_PER_TRACK; ++i) {
+        if (processors[i] && !processors[i]->isBypassed()) {
+            processorsMidiBuffer.insert(processorsMidiBuffer.end(), midiBuffer.begin(), midiBuffer.end());
+            break;
+        }
+    }
+
+    processChain(in, out, sampleRate, processorsMidiBuffer);
+}
+
+void AudioNode::processChain(const SamplesBuffer &in, SamplesBuffer &out, int sampleRate, std::vector<midi::MidiMessage> &midiBuffer)
 {
     Q_UNUSED(in);
 
@@ -30,32 +46,29 @@ void AudioNode::processReplacing(const SamplesBuffer &in, SamplesBuffer &out, in
     internalOutputBuffer.setFrameLenght(out.getFrameLenght());
 
     {
-        QMutexLocker locker(&mutex);
-        for (auto node : connections) { // ask connected nodes to generate audio
+        RcuSnapshot<std::vector<AudioNode *>>::Reader connectedNodes(connections);
+        for (auto node : *connectedNodes) { // ask connected nodes to generate audio
             node->processReplacing(internalInputBuffer, internalOutputBuffer, sampleRate, midiBuffer);
         }
     }
 
     internalOutputBuffer.set(internalInputBuffer); // if we have no plugins inserted the input samples are just copied  to output buffer.
 
-    static SamplesBuffer tempInputBuffer(2);
-
     // process inserted plugins
     for (int i=0; i < MAX_PROCESSORS_PER_TRACK; ++i) {
         auto processor = processors[i];
         if (processor && !processor->isBypassed()) {
-            tempInputBuffer.setFrameLenght(internalOutputBuffer.getFrameLenght());
-            tempInputBuffer.set(internalOutputBuffer); // the output from previous plugin is used as input to the next plugin in the chain
+            processorsInputBuffer.setFrameLenght(internalOutputBuffer.getFrameLenght());
+            processorsInputBuffer.set(internalOutputBuffer); // the output from previous plugin is used as input to the next plugin in the chain
 
-            processor->process(tempInputBuffer, internalOutputBuffer, midiBuffer);
+            processor->process(processorsInputBuffer, internalOutputBuffer, midiBuffer);
 
             // some plugins are blocking the midi messages. If a VSTi can't generate messages the previous messages list will be sended for the next plugin in the chain. The messages list is cleared only when the plugin can generate midi messages.
             if (processor->isVirtualInstrument() && processor->canGenerateMidiMessages())
                 midiBuffer.clear(); // only the fresh messages will be passed by the next plugin in the chain
 
 
-            auto pulledMessages = pullMidiMessagesGeneratedByPlugins();
-            midiBuffer.insert(midiBuffer.end(), pulledMessages.begin(), pulledMessages.end());
+            processor->pullGeneratedMidiMessages(midiBuffer); // each plugin has a private buffer, the nodes are rendered in parallel
         }
     }
 
@@ -63,7 +76,7 @@ void AudioNode::processReplacing(const SamplesBuffer &in, SamplesBuffer &out, in
 
     internalOutputBuffer.applyGain(gain, leftGain, rightGain, boost);
 
-    lastPeak.update(internalOutputBuffer.computePeak());
+    publishPeak(internalOutputBuffer.computePeak());
 
     postFaderProcess(internalOutputBuffer);
 
@@ -78,26 +91,29 @@ void AudioNode::setRmsWindowSize(int samples)
 AudioNode::AudioNode() :
     internalInputBuffer(2),
     internalOutputBuffer(2),
-    lastPeak(),
+    processorsInputBuffer(2),
     pan(0),
     leftGain(1.0),
     rightGain(1.0),
     muted(false),
     soloed(false),
     activated(true),
+    generatingMidi(false),
     gain(1),
     boost(1),
-    resamplingCorrection(0)
+    resamplingCorrection(0),
+    meteringBus(nullptr),
+    meterSlot(-1)
 {
 
     for (int i=0; i < MAX_PROCESSORS_PER_TRACK; ++i) {
         processors[i] = nullptr;
     }
-}
 
-std::vector<midi::MidiMessage> AudioNode::pullMidiMessagesGeneratedByPlugins() const
-{
-    return std::vector<midi::MidiMessage>(); // returning empty vector by default, is overrided in LocalInputNode
+    internalInputBuffer.reserve(MaxBufferSize);
+    internalOutputBuffer.reserve(MaxBufferSize);
+    processorsInputBuffer.reserve(MaxBufferSize);
+    processorsMidiBuffer.reserve(MAX_MIDI_MESSAGES_PER_BLOCK); // plugins can append generated messages
 }
 
 int AudioNode::getInputResamplingLength(int sourceSampleRate, int targetSampleRate, int outFrameLenght)
@@ -118,12 +134,45 @@ int AudioNode::getInputResamplingLength(int sourceSampleRate, int targetSampleRa
 
 AudioPeak AudioNode::getLastPeak() const
 {
-    return this->lastPeak;
+    if (meteringBus)
+        return meteringBus->read(meterSlot);
+
+    return AudioPeak();
 }
 
 void AudioNode::resetLastPeak()
 {
-    lastPeak.zero();
+    if (meteringBus)
+        meteringBus->reset(meterSlot); // the readers see zero until the next block, nothing is written in the audio thread data
+}
+
+void AudioNode::publishPeak(const AudioPeak &peak)
+{
+    if (meteringBus)
+        meteringBus->publish(meterSlot, peak);
+}
+
+void AudioNode::attachMeter(MeteringBus *bus)
+{
+    if (bus == meteringBus)
+        return; // already attached, the same node can be added again (metronome)
+
+    detachMeter();
+
+    meterSlot = bus ? bus->allocateSlot() : -1;
+    meteringBus = meterSlot >= 0 ? bus : nullptr;
+
+    if (!meteringBus && bus)
+        qCritical() << "No free slots in the metering bus!";
+}
+
+void AudioNode::detachMeter()
+{
+    if (meteringBus)
+        meteringBus->releaseSlot(meterSlot);
+
+    meteringBus = nullptr;
+    meterSlot = -1;
 }
 
 void AudioNode::setPan(float pan)
@@ -189,6 +238,8 @@ void AudioNode::updateGains()
 
 AudioNode::~AudioNode()
 {
+    detachMeter();
+
     for (int i = 0; i < MAX_PROCESSORS_PER_TRACK; ++i) {
         if (processors[i]){
             delete processors[i];
@@ -199,17 +250,20 @@ AudioNode::~AudioNode()
 
 bool AudioNode::connect(AudioNode &other)
 {
-    QMutexLocker(&(other.mutex));
-
-    other.connections.insert(this);
+    other.connections.update([this](std::vector<AudioNode *> &connections) {
+        if (std::find(connections.begin(), connections.end(), this) == connections.end())
+            connections.push_back(this);
+    });
 
     return true;
 }
 
 bool AudioNode::disconnect(AudioNode &otherNode)
 {
-    QMutexLocker(&(otherNode.mutex));
-    otherNode.connections.remove(this);
+    otherNode.connections.update([this](std::vector<AudioNode *> &connections) {
+        connections.erase(std::remove(connections.begin(), connections.end(), this), connections.end());
+    });
+
     return true;
 }
 
@@ -218,6 +272,9 @@ void AudioNode::addProcessor(AudioNodeProcessor *newProcessor, quint32 slotIndex
     assert(newProcessor);
     assert(slotIndex < MAX_PROCESSORS_PER_TRACK);
     processors[slotIndex] = newProcessor;
+
+    if (newProcessor->canGenerateMidiMessages()) // checked in GUI thread, not in each audio callback
+        generatingMidi = true;
 }
 
 void AudioNode::removeProcessor(AudioNodeProcessor *processor)
@@ -230,6 +287,13 @@ void AudioNode::removeProcessor(AudioNodeProcessor *processor)
             break;
         }
     }
+
+    generatingMidi = false;
+    for (int i = 0; i < MAX_PROCESSORS_PER_TRACK; ++i) {
+        if (processors[i] && processors[i]->canGenerateMidiMessages())
+            generatingMidi = true;
+    }
+
     delete processor;
 }
 
@@ -5,6 +5,7 @@
 #include <QMutex>
 #include "SamplesBuffer.h"
 #include "AudioDriver.h"
+#include "RcuSnapshot.h"
 #include "midi/MidiMessage.h"
 #include <QDebug>
 #include <QList>
@@ -12,6 +13,7 @@
 namespace audio {
 
 class AudioNodeProcessor;
+class MeteringBus;
 
 class AudioNode : public QObject
 {
@@ -21,9 +23,7 @@ public:
     AudioNode();
     virtual ~AudioNode();
 
-    virtual void processReplacing(const SamplesBuffer &in, SamplesBuffer &out, int sampleRate, std::vector<midi::MidiMessage> &midiBuffer);
-
-    virtual std::vector<midi::MidiMessage> pullMidiMessagesGeneratedByPlugins() const;
+    virtual void processReplacing(const SamplesBuffer &in, SamplesBuffer &out, int sampleRate, const std::vector<midi::MidiMessage> &midiBuffer);
 
     virtual void setMute(bool muted);
 
@@ -52,7 +52,12 @@ public:
 
     AudioPeak getLastPeak() const;
 
-    void resetLastPeak();
+    void resetLastPeak(); // safe from any thread, the audio thread is not blocked
+
+    // the peaks are published in a slot of the metering bus (attached before adding the node in the mixer)
+    void attachMeter(MeteringBus *bus);
+    void detachMeter();
+    int getMeterSlot() const;
 
     void setRmsWindowSize(int samples);
 
@@ -62,9 +67,13 @@ public:
 
     virtual bool isActivated() const;
 
+    // nodes sharing state with other nodes while rendering are not rendered in parallel
+    virtual bool needsSerialRendering() const;
+
     virtual void reset(); // reset pan, gain, boost, etc
 
     static const quint8 MAX_PROCESSORS_PER_TRACK = 4;
+    static const int MAX_MIDI_MESSAGES_PER_BLOCK = 512;
 
 protected:
 
@@ -73,13 +82,19 @@ protected:
 
     int getInputResamplingLength(int sourceSampleRate, int targetSampleRate, int outFrameLenght);
 
-    QSet<AudioNode *> connections;
+    // render connected nodes, plugins chain, gain and pan. The plugins can change the messages in midiBuffer.
+    void processChain(const SamplesBuffer &in, SamplesBuffer &out, int sampleRate, std::vector<midi::MidiMessage> &midiBuffer);
+
+    RcuSnapshot<std::vector<AudioNode *>> connections; // read by the audio thread without locks
     AudioNodeProcessor *processors[MAX_PROCESSORS_PER_TRACK];
     SamplesBuffer internalInputBuffer;
     SamplesBuffer internalOutputBuffer;
+    SamplesBuffer processorsInputBuffer; // input for each plugin in the chain
+    std::vector<midi::MidiMessage> processorsMidiBuffer; // messages for the plugins chain, preallocated
 
-    mutable audio::AudioPeak lastPeak;
-    QMutex mutex; // used to protected connections manipulation because nodes can be added or removed by different threads
+    void publishPeak(const AudioPeak &peak); // called by the audio thread
+
+    QMutex mutex; // used by subclasses to protect the state shared with other threads
 
     // pan
     float pan;
@@ -95,6 +110,8 @@ private:
 
     bool activated; // used when room stream is played. All tracks are disabled, except the room streamer.
 
+    bool generatingMidi; // some plugin in the chain can send midi messages to the host
+
     float gain;
     float boost;
 
@@ -103,6 +120,9 @@ private:
 
     double resamplingCorrection;
 
+    MeteringBus *meteringBus;
+    int meterSlot;
+
     void updateGains();
 
 signals:
@@ -144,6 +164,16 @@ inline float AudioNode::getGain() const
     return gain;
 }
 
+inline bool AudioNode::needsSerialRendering() const
+{
+    return generatingMidi;
+}
+
+inline int AudioNode::getMeterSlot() const
+{
+    return meterSlot;
+}
+
 inline bool AudioNode::isMuted() const
 {
     return muted;
@@ -24,6 +24,7 @@ public:
     virtual void openEditor(const QPoint &centerOfScreen) = 0;
     virtual void closeEditor() = 0;
     virtual void setSampleRate(int newSampleRate);
+    virtual void setBlockSize(int newBlockSize); // called with the audio driver stopped
 
     virtual void setBypass(bool state);
     bool isBypassed() const;
@@ -32,6 +33,9 @@ public:
 
     virtual bool canGenerateMidiMessages() const;
 
+    // append the messages generated in the last process() call, called in the same (audio) thread
+    virtual void pullGeneratedMidiMessages(std::vector<midi::MidiMessage> &outBuffer);
+
 protected:
     bool bypassed;
 
@@ -53,6 +57,11 @@ inline bool AudioNodeProcessor::canGenerateMidiMessages() const
     return false;
 }
 
+inline void AudioNodeProcessor::pullGeneratedMidiMessages(std::vector<midi::MidiMessage> &outBuffer)
+{
+    Q_UNUSED(outBuffer);
+}
+
 inline AudioNodeProcessor::~AudioNodeProcessor()
 {
     //
@@ -63,6 +72,11 @@ inline void AudioNodeProcessor::setSampleRate(int newSampleRate)
     Q_UNUSED(newSampleRate);
 }
 
+inline void AudioNodeProcessor::setBlockSize(int newBlockSize)
+{
+    Q_UNUSED(newBlockSize);
+}
+
 
 }//namespace
 
@@ -15,18 +15,21 @@ LocalInputGroup::LocalInputGroup(int groupIndex, LocalInputNode *firstInput) :
 
 LocalInputGroup::~LocalInputGroup()
 {
-    groupedInputs.clear();
+
 }
 
 void LocalInputGroup::addInputNode(LocalInputNode *input)
 {
-    groupedInputs.append(input);
+    groupedInputs.update([input](QList<LocalInputNode *> &inputs) {
+        inputs.append(input);
+    });
 }
 
 LocalInputNode *LocalInputGroup::getInputNode(quint8 index) const
 {
-    if (index < groupedInputs.size()) {
-        return groupedInputs.at(index);
+    RcuSnapshot<QList<LocalInputNode *>>::Reader inputs(groupedInputs);
+    if (index < inputs->size()) {
+        return inputs->at(index);
     }
 
     return nullptr;
@@ -34,7 +37,8 @@ LocalInputNode *LocalInputGroup::getInputNode(quint8 index) const
 
 void LocalInputGroup::mixGroupedInputs(SamplesBuffer &out)
 {
-    for (auto inputTrack : groupedInputs) {
+    RcuSnapshot<QList<LocalInputNode *>>::Reader inputs(groupedInputs);
+    for (auto inputTrack : *inputs) {
         auto lastBuffer = inputTrack->getLastBuffer();
         if (lastBuffer.getChannels() == out.getChannels()) {
             out.add(lastBuffer);
@@ -47,24 +51,29 @@ void LocalInputGroup::mixGroupedInputs(SamplesBuffer &out)
 
 void LocalInputGroup::removeInput(LocalInputNode *input)
 {
-    if (!groupedInputs.removeOne(input))
-        qCritical() << "the input track was not removed!";
+    groupedInputs.update([input](QList<LocalInputNode *> &inputs) {
+        if (!inputs.removeOne(input))
+            qCritical() << "the input track was not removed!";
+    });
 }
 
 int LocalInputGroup::getMaxInputChannelsForEncoding() const
 {
-    if (groupedInputs.size() > 1)
+    RcuSnapshot<QList<LocalInputNode *>>::Reader inputs(groupedInputs);
+
+    if (inputs->size() > 1)
         return 2;    // stereo encoding
 
-    if (!groupedInputs.isEmpty()) {
+    if (!inputs->isEmpty()) {
+        auto firstInput = inputs->first();
 
-        if (groupedInputs.first()->isMidi())
+        if (firstInput->isMidi())
             return 2;    // just one midi track, use stereo encoding
 
-        if (groupedInputs.first()->isAudio())
-            return groupedInputs.first()->getAudioInputRange().getChannels();
+        if (firstInput->isAudio())
+            return firstInput->getAudioInputRange().getChannels();
 
-        if (groupedInputs.first()->isNoInput())
+        if (firstInput->isNoInput())
             return 2;    // allow channels using noInput but processing some vst looper in stereo
     }
     return 0;    // no channels to encoding
@@ -3,6 +3,8 @@
 
 #include <QList>
 
+#include "RcuSnapshot.h"
+
 namespace audio {
 
 class LocalInputNode;
@@ -39,7 +41,7 @@ public:
 
 private:
     int groupIndex;
-    QList<audio::LocalInputNode *> groupedInputs;
+    RcuSnapshot<QList<audio::LocalInputNode *>> groupedInputs; // mixed in the audio thread without locks
     bool transmiting;
     bool voiceChatActivated;
 };
@@ -56,7 +58,8 @@ inline int LocalInputGroup::getIndex() const
 
 inline bool LocalInputGroup::isEmpty() const
 {
-    return groupedInputs.empty();
+    RcuSnapshot<QList<audio::LocalInputNode *>>::Reader inputs(groupedInputs);
+    return inputs->empty();
 }
 
 } //namespace
@@ -154,6 +154,14 @@ void LocalInputNode::setProcessorsSampleRate(int newSampleRate)
     }
 }
 
+void LocalInputNode::setProcessorsBlockSize(int newBlockSize)
+{
+    for (int i = 0; i < MAX_PROCESSORS_PER_TRACK; ++i) {
+        if (processors[i])
+            processors[i]->setBlockSize(newBlockSize);
+    }
+}
+
 void LocalInputNode::closeProcessorsWindows()
 {
     for (int i = 0; i < MAX_PROCESSORS_PER_TRACK; ++i) {
@@ -224,7 +232,7 @@ bool LocalInputNode::isReceivingAllMidiChannels() const
 }
 
 void LocalInputNode::processReplacing(const SamplesBuffer &in, SamplesBuffer &out,
-                                           int sampleRate, std::vector<midi::MidiMessage> &midiBuffer)
+                                           int sampleRate, const std::vector<midi::MidiMessage> &midiBuffer)
 {
     Q_UNUSED(sampleRate);
 
@@ -238,12 +246,13 @@ void LocalInputNode::processReplacing(const SamplesBuffer &in, SamplesBuffer &ou
     *
     */
 
-    std::vector<midi::MidiMessage> filteredMidiBuffer(midiBuffer.size());
+    processorsMidiBuffer.clear(); // only the accepted messages are copied from the shared midiBuffer
     internalInputBuffer.setFrameLenght(out.getFrameLenght());
     internalOutputBuffer.setFrameLenght(out.getFrameLenght());
     internalInputBuffer.zero();
     internalOutputBuffer.zero();
 
+    bool filteringMidi = false;
     if (!isNoInput()) {
         if (isAudio()) { // using audio input
             if (audioInputRange.isEmpty())
@@ -252,25 +261,34 @@ void LocalInputNode::processReplacing(const SamplesBuffer &in, SamplesBuffer &ou
             internalInputBuffer.set(in, audioInputRange.getFirstChannel(), audioInputRange.getChannels());
         }
         else if (isMidi() && !midiBuffer.empty()) {
-            processIncommingMidi(midiBuffer, filteredMidiBuffer);
+            filteringMidi = true;
         }
     }
 
+    LocalInputNode *secondSubchannel = nullptr;
     if (receivingRoutedMidiInput && !midiBuffer.empty()) { // vocoders, for example, can receive midi input from second subchannel
         quint8 subchannelIndex = 1; // second subchannel
-        auto secondSubchannel = mainController->getInputTrackInGroup(channelGroupIndex, subchannelIndex);
-        if (secondSubchannel && secondSubchannel->isMidi()) {
-            secondSubchannel->processIncommingMidi(midiBuffer, filteredMidiBuffer);
+        auto subchannel = mainController->getInputTrackInGroup(channelGroupIndex, subchannelIndex);
+        if (subchannel && subchannel->isMidi())
+            secondSubchannel = subchannel;
+    }
+
+    if (filteringMidi || secondSubchannel) {
+        // one pass in the shared messages, keeping the timing order. A message is accepted by only one subchannel.
+        for (const auto &message : midiBuffer) {
+            bool accepted = filteringMidi && processIncommingMidi(message, processorsMidiBuffer);
+            if (!accepted && secondSubchannel)
+                secondSubchannel->processIncommingMidi(message, processorsMidiBuffer);
         }
     }
 
     if (isRoutingMidiInput()) {
-        lastPeak.update(AudioPeak()); // ensure the audio meters will be ZERO
+        publishPeak(AudioPeak()); // ensure the audio meters will be ZERO
 
         return; // when routing midi this track will not render midi data, this data will be rendered by first subchannel. But the midi data is processed above to update MIDI activity meter
     }
 
-    AudioNode::processReplacing(in, out, sampleRate, filteredMidiBuffer); // only the filtered midi messages are sended to rendering code
+    processChain(in, out, sampleRate, processorsMidiBuffer); // only the filtered midi messages are sended to rendering code
 }
 
 void LocalInputNode::setRoutingMidiInput(bool routeMidiInput)
@@ -302,25 +320,18 @@ void LocalInputNode::setReceivingRoutedMidiInput(bool receiveRoutedMidiInput)
         routingMidiInput = false;
 }
 
-void LocalInputNode::processIncommingMidi(std::vector<midi::MidiMessage> &inBuffer, std::vector<midi::MidiMessage> &outBuffer)
+bool LocalInputNode::processIncommingMidi(const midi::MidiMessage &message, std::vector<midi::MidiMessage> &outBuffer)
 {
-    auto iterator = inBuffer.begin();
-    while(iterator != inBuffer.end()) {
-        auto message(*iterator);
-        if (canProcessMidiMessage(message)) {
-            message.transpose(getTranspose());
+    if (!canProcessMidiMessage(message))
+        return false;
 
-            outBuffer.push_back(message);
+    outBuffer.push_back(message); // the capacity is preallocated, the shared messages are never bigger than one block
+    outBuffer.back().transpose(getTranspose());
 
-            // save the midi activity peak value for notes or controls
-            midiInput.updateActivity(message);
+    // save the midi activity peak value for notes or controls
+    midiInput.updateActivity(outBuffer.back());
 
-            iterator = inBuffer.erase(iterator);
-        }
-        else {
-            ++iterator;
-        }
-    }
+    return true;
 }
 
 qint8 LocalInputNode::getTranspose() const
@@ -387,11 +398,6 @@ bool LocalInputNode::canProcessMidiMessage(const midi::MidiMessage &message) con
     return midiInput.accept(message);
 }
 
-std::vector<midi::MidiMessage> LocalInputNode::pullMidiMessagesGeneratedByPlugins() const
-{
-    return mainController->pullMidiMessagesFromPlugins();
-}
-
 void LocalInputNode::startMidiNoteLearn()
 {
     midiInput.learning = true;
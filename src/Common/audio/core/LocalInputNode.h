@@ -21,7 +21,7 @@ class LocalInputNode : public AudioNode
 public:
     LocalInputNode(controller::MainController *controller, int parentChannelIndex, bool isMono = true);
     ~LocalInputNode();
-    void processReplacing(const SamplesBuffer &in, SamplesBuffer &out, int sampleRate, std::vector<midi::MidiMessage> &midiBuffer) override;
+    void processReplacing(const SamplesBuffer &in, SamplesBuffer &out, int sampleRate, const std::vector<midi::MidiMessage> &midiBuffer) override;
     virtual int getSampleRate() const;
 
     int getChannels() const;
@@ -52,8 +52,6 @@ public:
 
     bool isReceivingAllMidiChannels() const;
 
-    std::vector<midi::MidiMessage> pullMidiMessagesGeneratedByPlugins() const override;
-
     ChannelRange getAudioInputRange() const;
 
     int getChanneGroupIndex() const;
@@ -62,6 +60,7 @@ public:
     SamplesBuffer getLastBufferMixedToMono() const;
 
     void setProcessorsSampleRate(int newSampleRate);
+    void setProcessorsBlockSize(int newBlockSize);
 
     void closeProcessorsWindows();
 
@@ -93,6 +92,8 @@ public:
      The other tracks (ninjam tracks) are deactivated when the 'room preview' is started. Deactivated tracks are not rendered. */
     bool isActivated() const override;
 
+    bool needsSerialRendering() const override; // routed subchannels are touching the sibling midi state
+
     bool isReceivingRoutedMidiInput() const;
     void setReceivingRoutedMidiInput(bool receiveRoutedMidiInput);
     bool isRoutingMidiInput() const;
@@ -162,7 +163,7 @@ private:
 
     bool canProcessMidiMessage(const midi::MidiMessage &msg) const;
 
-    void processIncommingMidi(std::vector<midi::MidiMessage> &inBuffer, std::vector<midi::MidiMessage> &outBuffer);
+    bool processIncommingMidi(const midi::MidiMessage &message, std::vector<midi::MidiMessage> &outBuffer); // return true if the message was accepted
 
     audio::Looper* looper;
 
@@ -180,6 +181,11 @@ inline bool LocalInputNode::isRoutingMidiInput() const
     return isMidi() && routingMidiInput;
 }
 
+inline bool LocalInputNode::needsSerialRendering() const
+{
+    return routingMidiInput || receivingRoutedMidiInput || AudioNode::needsSerialRendering();
+}
+
 inline bool LocalInputNode::isReceivingRoutedMidiInput() const
 {
     return receivingRoutedMidiInput;
@@ -0,0 +1,211 @@
+#include "MeteringBus.h"
+
+#include <QMutexLocker>
+#include <QThread>
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+
+using audio::MeteringBus;
+using audio::AudioPeak;
+
+namespace {
+
+const quintptr CACHE_LINE_SIZE = 64;
+
+} // namespace
+
+struct MeteringBus::Values
+{
+    std::atomic<float> peaks[2];
+    std::atomic<float> rms[2];
+};
+
+struct alignas(CACHE_LINE_SIZE) MeteringBus::Slot
+{
+    std::atomic<quint64> sequence; // odd while the audio thread is writing, the published blocks count is sequence/2
+    std::atomic<quint64> resetBlock; // blocks published before the last reset are not visible
+    Values last;
+    Values history[HISTORY_SIZE]; // ring indexed by the block number
+};
+
+MeteringBus::MeteringBus(int maxSlots) :
+    storage(nullptr),
+    slots(nullptr),
+    maxSlots(maxSlots)
+{
+    storage = new char[sizeof(Slot) * maxSlots + CACHE_LINE_SIZE];
+    quintptr address = reinterpret_cast<quintptr>(storage);
+    slots = reinterpret_cast<Slot *>((address + CACHE_LINE_SIZE - 1) & ~(CACHE_LINE_SIZE - 1));
+
+    const AudioPeak zeroPeak;
+    for (int i = 0; i < maxSlots; ++i) {
+        Slot *slot = new (&slots[i]) Slot;
+        slot->sequence.store(0, std::memory_order_relaxed);
+        slot->resetBlock.store(0, std::memory_order_relaxed);
+        store(slot->last, zeroPeak);
+        for (int h = 0; h < HISTORY_SIZE; ++h)
+            store(slot->history[h], zeroPeak);
+    }
+
+    freeSlots.reserve(maxSlots);
+    for (int i = maxSlots - 1; i >= 0; --i)
+        freeSlots.append(i); // the lower slots are allocated first
+}
+
+MeteringBus::~MeteringBus()
+{
+    delete [] storage; // Slot is trivially destructible
+}
+
+int MeteringBus::allocateSlot()
+{
+    QMutexLocker locker(&freeSlotsMutex);
+
+    if (freeSlots.isEmpty())
+        return -1;
+
+    int slot = freeSlots.takeLast();
+    reset(slot); // the blocks published by the previous owner are not visible
+
+    return slot;
+}
+
+void MeteringBus::releaseSlot(int slot)
+{
+    if (!isValidSlot(slot))
+        return;
+
+    QMutexLocker locker(&freeSlotsMutex);
+
+    reset(slot);
+    freeSlots.append(slot);
+}
+
+void MeteringBus::store(Values &values, const AudioPeak &peak)
+{
+    values.peaks[0].store(peak.getLeftPeak(), std::memory_order_relaxed);
+    values.peaks[1].store(peak.getRightPeak(), std::memory_order_relaxed);
+    values.rms[0].store(peak.getLeftRMS(), std::memory_order_relaxed);
+    values.rms[1].store(peak.getRightRMS(), std::memory_order_relaxed);
+}
+
+AudioPeak MeteringBus::load(const Values &values)
+{
+    return AudioPeak(values.peaks[0].load(std::memory_order_relaxed),
+                     values.peaks[1].load(std::memory_order_relaxed),
+                     values.rms[0].load(std::memory_order_relaxed),
+                     values.rms[1].load(std::memory_order_relaxed));
+}
+
+void MeteringBus::publish(int slotIndex, const AudioPeak &peak)
+{
+    if (!isValidSlot(slotIndex))
+        return;
+
+    Slot &slot = slots[slotIndex];
+
+    const quint64 sequence = slot.sequence.load(std::memory_order_relaxed); // only this thread is writing
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release); // the odd sequence is visible before the values
+
+    store(slot.last, peak);
+    store(slot.history[(sequence / 2) % HISTORY_SIZE], peak);
+
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+AudioPeak MeteringBus::read(int slotIndex) const
+{
+    if (!isValidSlot(slotIndex))
+        return AudioPeak();
+
+    const Slot &slot = slots[slotIndex];
+
+    forever {
+        const quint64 before = slot.sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            QThread::yieldCurrentThread(); // the audio thread is writing
+            continue;
+        }
+
+        AudioPeak peak = load(slot.last);
+        quint64 resetBlock = slot.resetBlock.load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != before)
+            continue; // torn read
+
+        if (resetBlock >= before / 2)
+            return AudioPeak(); // nothing published after the last reset
+
+        return peak;
+    }
+}
+
+int MeteringBus::readHistory(int slotIndex, quint64 &nextBlock, AudioPeak *peaks, int maxPeaks) const
+{
+    if (!isValidSlot(slotIndex) || maxPeaks <= 0)
+        return 0;
+
+    const Slot &slot = slots[slotIndex];
+
+    forever {
+        const quint64 before = slot.sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            QThread::yieldCurrentThread();
+            continue;
+        }
+
+        const quint64 published = before / 2;
+        const quint64 oldestInHistory = published > static_cast<quint64>(HISTORY_SIZE) ? published - HISTORY_SIZE : 0;
+        const quint64 newestToCopy = static_cast<quint64>(std::min(maxPeaks, static_cast<int>(HISTORY_SIZE)));
+
+        quint64 firstBlock = std::max(nextBlock, slot.resetBlock.load(std::memory_order_relaxed));
+        firstBlock = std::max(firstBlock, oldestInHistory);
+        firstBlock = std::min(firstBlock, published); // stale cursor
+        if (published - firstBlock > newestToCopy)
+            firstBlock = published - newestToCopy;
+
+        const int count = static_cast<int>(published - firstBlock);
+        for (int i = 0; i < count; ++i)
+            peaks[i] = load(slot.history[(firstBlock + i) % HISTORY_SIZE]);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != before)
+            continue; // the writer overwrote some history entries while copying
+
+        nextBlock = published;
+
+        return count;
+    }
+}
+
+AudioPeak MeteringBus::readMaxPeak(int slot, quint64 &nextBlock) const
+{
+    AudioPeak blocks[HISTORY_SIZE];
+    const int count = readHistory(slot, nextBlock, blocks, HISTORY_SIZE);
+    if (count == 0)
+        return read(slot); // no new blocks since the last read
+
+    float peaks[2] = { 0, 0 };
+    float rms[2] = { 0, 0 };
+    for (int i = 0; i < count; ++i) {
+        peaks[0] = std::max(peaks[0], blocks[i].getLeftPeak());
+        peaks[1] = std::max(peaks[1], blocks[i].getRightPeak());
+        rms[0] = std::max(rms[0], blocks[i].getLeftRMS());
+        rms[1] = std::max(rms[1], blocks[i].getRightRMS());
+    }
+
+    return AudioPeak(peaks[0], peaks[1], rms[0], rms[1]);
+}
+
+void MeteringBus::reset(int slotIndex)
+{
+    if (!isValidSlot(slotIndex))
+        return;
+
+    Slot &slot = slots[slotIndex];
+    slot.resetBlock.store(slot.sequence.load(std::memory_order_acquire) / 2, std::memory_order_release);
+}
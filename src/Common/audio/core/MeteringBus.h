@@ -0,0 +1,81 @@
+#ifndef METERING_BUS_H
+#define METERING_BUS_H
+
+#include <QMutex>
+#include <QVector>
+
+#include "AudioPeak.h"
+
+namespace audio {
+
+/**
+ * Flat array of meter slots shared by the audio thread (writer) and the GUI (reader). Each slot
+ * has only one writer (the audio node owning the slot) and is published with a sequence counter
+ * (seqlock), so the writer never waits and the readers never see a torn peak. The slots are padded
+ * to cache lines, the nodes rendered in parallel (RenderPool) are not sharing lines.
+ *
+ * The last HISTORY_SIZE blocks are kept in each slot, the GUI can read all blocks published since
+ * the last frame (readMaxPeak) and not only the last one.
+ */
+class MeteringBus
+{
+public:
+    explicit MeteringBus(int maxSlots = DEFAULT_SLOTS);
+    ~MeteringBus();
+
+    // slots are allocated when the tracks are created, never in the audio thread
+    int allocateSlot(); // -1 if all slots are in use
+    void releaseSlot(int slot);
+
+    // audio thread, only one writer per slot
+    void publish(int slot, const AudioPeak &peak);
+
+    // can be called from any thread, readers never block the writer
+    AudioPeak read(int slot) const;
+
+    // copy the blocks published after 'nextBlock' (only the newest if more than 'maxPeaks' are available). Return the copied blocks count and update 'nextBlock'.
+    int readHistory(int slot, quint64 &nextBlock, AudioPeak *peaks, int maxPeaks) const;
+
+    // max of the blocks published after 'nextBlock', or the last peak if no new blocks are available
+    AudioPeak readMaxPeak(int slot, quint64 &nextBlock) const;
+
+    void reset(int slot); // the readers see zero until the next publish. Can be called from any thread.
+
+    int getMaxSlots() const;
+
+    static const int HISTORY_SIZE = 32; // about 90 ms of blocks using 128 samples in 44.1 KHz
+    static const int DEFAULT_SLOTS = 256;
+
+private:
+    MeteringBus(const MeteringBus &other);
+    MeteringBus &operator=(const MeteringBus &other);
+
+    struct Values;
+    struct Slot;
+
+    static void store(Values &values, const AudioPeak &peak);
+    static AudioPeak load(const Values &values);
+
+    bool isValidSlot(int slot) const;
+
+    char *storage; // 'slots' are aligned inside storage
+    Slot *slots;
+    int maxSlots;
+
+    QVector<int> freeSlots;
+    QMutex freeSlotsMutex; // allocate/release are called from GUI and ninjam service threads
+};
+
+inline int MeteringBus::getMaxSlots() const
+{
+    return maxSlots;
+}
+
+inline bool MeteringBus::isValidSlot(int slot) const
+{
+    return slot >= 0 && slot < maxSlots;
+}
+
+} // namespace
+
+#endif // METERING_BUS_H
@@ -0,0 +1,118 @@
+#ifndef RCU_SNAPSHOT_H
+#define RCU_SNAPSHOT_H
+
+#include <QMutex>
+#include <QThread>
+
+#include <atomic>
+
+namespace audio {
+
+/**
+ * Read-copy-update holder for data shared between the audio thread and the GUI/network threads.
+ *
+ * Readers (audio thread) never lock: a Reader pins the current immutable snapshot while it's alive.
+ * Writers copy the current snapshot, modify the copy and publish it atomically. The old snapshot is
+ * deleted only after all readers using it are gone, so when update() returns the previous data is
+ * not referenced by the audio thread anymore (i.e. a removed node can be deleted safely).
+ *
+ * update() can block for the duration of one audio callback, never call it from the audio thread.
+ */
+template <typename T>
+class RcuSnapshot
+{
+public:
+    RcuSnapshot() :
+        current(new T()),
+        phase(0)
+    {
+        readers[0] = 0;
+        readers[1] = 0;
+    }
+
+    ~RcuSnapshot()
+    {
+        delete current.load();
+    }
+
+    class Reader
+    {
+    public:
+        explicit Reader(const RcuSnapshot &owner) :
+            owner(owner),
+            readerPhase(owner.acquire()),
+            data(owner.current.load())
+        {
+        }
+
+        ~Reader()
+        {
+            owner.release(readerPhase);
+        }
+
+        inline const T &operator*() const
+        {
+            return *data;
+        }
+
+        inline const T *operator->() const
+        {
+            return data;
+        }
+
+    private:
+        Q_DISABLE_COPY(Reader)
+
+        const RcuSnapshot &owner;
+        const unsigned int readerPhase;
+        const T *data;
+    };
+
+    // copy, modify and publish. Blocks until the readers of the previous snapshot are finished.
+    template <typename Function>
+    void update(Function modify)
+    {
+        QMutexLocker locker(&writersMutex);
+
+        T *updated = new T(*current.load());
+        modify(*updated);
+
+        T *old = current.exchange(updated);
+
+        // new readers are counted in the other phase, waiting only for the readers that can see 'old'
+        unsigned int oldPhase = phase.fetch_add(1);
+        while (readers[oldPhase & 1].load() > 0)
+            QThread::yieldCurrentThread();
+
+        delete old;
+    }
+
+private:
+    Q_DISABLE_COPY(RcuSnapshot)
+
+    unsigned int acquire() const
+    {
+        forever {
+            unsigned int readerPhase = phase.load();
+            readers[readerPhase & 1].fetch_add(1);
+            if (phase.load() == readerPhase)
+                return readerPhase; // the writer will wait for us before delete the snapshot we'll read
+
+            readers[readerPhase & 1].fetch_sub(1); // a writer flipped the phase, retry in the new phase
+        }
+    }
+
+    inline void release(unsigned int readerPhase) const
+    {
+        readers[readerPhase & 1].fetch_sub(1);
+    }
+
+    std::atomic<T *> current;
+    std::atomic<unsigned int> phase;
+    mutable std::atomic<int> readers[2];
+    QMutex writersMutex;
+};
+
+} // namespace
+
+#endif // RCU_SNAPSHOT_H
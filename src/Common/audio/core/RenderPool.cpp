@@ -0,0 +1,185 @@
+#include "RenderPool.h"
+#include "AllocationTripwire.h"
+#include "log/Logging.h"
+
+#include <QThread>
+#include <QDebug>
+
+#include <algorithm>
+
+#if defined(Q_OS_WIN)
+    #include <windows.h>
+#elif defined(Q_OS_LINUX)
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_IX86)
+    #include <emmintrin.h>
+#endif
+
+using audio::RenderPool;
+
+class RenderPool::Worker : public QThread
+{
+public:
+    Worker(RenderPool &pool, int core) :
+        pool(pool),
+        core(core)
+    {
+        setObjectName(QString("Render worker %1").arg(core));
+    }
+
+protected:
+    void run() override
+    {
+        pinToCore();
+
+        quint32 lastGeneration = pool.generation.load();
+        forever {
+            pool.waitNextGeneration(lastGeneration);
+            if (pool.stopRequested.load())
+                break;
+
+            lastGeneration = pool.generation.load();
+
+            audio::tripwire::AudioThreadScope audioThreadScope; // workers are real time threads too
+            pool.executeTasks(lastGeneration);
+        }
+    }
+
+private:
+    RenderPool &pool;
+    const int core;
+
+    void pinToCore() // best effort, the OS scheduler is used if pinning is not available
+    {
+#if defined(Q_OS_WIN)
+        SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1) << core);
+#elif defined(Q_OS_LINUX)
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        CPU_SET(core, &cpuSet);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuSet) != 0)
+            qCWarning(jtAudio) << "Can't pin the render worker to core" << core;
+#endif
+        // macOS don't allow pinning threads to cores
+    }
+};
+
+// ++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+RenderPool::RenderPool(int workersCount) :
+    work(0),
+    generation(0),
+    currentTask(nullptr),
+    taskCount(0),
+    completedTasks(0),
+    parkedWorkers(0),
+    stopRequested(false)
+{
+    int cores = QThread::idealThreadCount();
+    if (workersCount < 0)
+        workersCount = cores - 1; // the audio thread is rendering too
+
+    workersCount = qBound(0, workersCount, static_cast<int>(MAX_WORKERS));
+
+    for (int w = 0; w < workersCount; ++w) {
+        // the core 0 is leaved to the audio driver thread
+        auto worker = new Worker(*this, cores > 1 ? (w + 1) % cores : 0);
+        workers.push_back(worker);
+        worker->start(QThread::TimeCriticalPriority);
+    }
+
+    qCDebug(jtAudio) << "Render pool using" << workersCount << "workers";
+}
+
+RenderPool::~RenderPool()
+{
+    {
+        QMutexLocker locker(&parkMutex);
+        stopRequested.store(true);
+        wakeUp.wakeAll();
+    }
+
+    for (auto worker : workers) {
+        worker->wait();
+        delete worker;
+    }
+}
+
+void RenderPool::cpuRelax()
+{
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_IX86)
+    _mm_pause();
+#else
+    QThread::yieldCurrentThread();
+#endif
+}
+
+void RenderPool::waitNextGeneration(quint32 lastGeneration)
+{
+    // spin first, the next audio callback is probably coming in a few milliseconds
+    for (int i = 0; i < SPIN_ITERATIONS; ++i) {
+        if (generation.load() != lastGeneration || stopRequested.load())
+            return;
+
+        cpuRelax();
+    }
+
+    QMutexLocker locker(&parkMutex);
+    ++parkedWorkers;
+    while (generation.load() == lastGeneration && !stopRequested.load())
+        wakeUp.wait(&parkMutex);
+
+    --parkedWorkers;
+}
+
+void RenderPool::executeTasks(quint32 taskGeneration)
+{
+    forever {
+        quint64 currentWork = work.load();
+        if (static_cast<quint32>(currentWork >> 32) != taskGeneration)
+            return; // a late worker, this run() is finished
+
+        int index = static_cast<int>(currentWork & 0xFFFFFFFF);
+        if (index >= taskCount.load())
+            return; // all tasks claimed
+
+        if (!work.compare_exchange_weak(currentWork, currentWork + 1))
+            continue; // claimed by other thread, try the next one
+
+        currentTask.load()->process(index);
+
+        ++completedTasks;
+    }
+}
+
+void RenderPool::run(Task &task, int count)
+{
+    if (workers.empty() || count < 2) {
+        for (int i = 0; i < count; ++i)
+            task.process(i);
+
+        return;
+    }
+
+    quint32 newGeneration = generation.load() + 1;
+
+    // the work word is updated first, invalidating claims using the previous generation
+    work.store(static_cast<quint64>(newGeneration) << 32);
+    currentTask.store(&task);
+    taskCount.store(count);
+    completedTasks.store(0);
+    generation.store(newGeneration);
+
+    if (parkedWorkers.load() > 0) {
+        QMutexLocker locker(&parkMutex);
+        wakeUp.wakeAll();
+    }
+
+    executeTasks(newGeneration); // the audio thread is working too
+
+    while (completedTasks.load() < count)
+        cpuRelax();
+}
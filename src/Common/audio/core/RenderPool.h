@@ -0,0 +1,76 @@
+#ifndef RENDER_POOL_H
+#define RENDER_POOL_H
+
+#include <QMutex>
+#include <QWaitCondition>
+
+#include <atomic>
+#include <vector>
+
+namespace audio {
+
+/**
+ * Pool of pre-spawned threads used to render independent audio nodes in parallel. Designed to be
+ * called from the audio thread: run() never allocates or locks (except to wake up parked workers),
+ * and the calling thread is rendering too.
+ *
+ * Idle workers are spinning for a short time waiting the next audio callback and then parking. The
+ * tasks are claimed dynamically (an atomic counter), so a slow node (a heavy VST chain) doesn't stall
+ * the other workers.
+ */
+class RenderPool
+{
+public:
+    class Task
+    {
+    public:
+        virtual ~Task() {}
+        virtual void process(int index) = 0; // called concurrently, with different indexes
+    };
+
+    explicit RenderPool(int workers = -1); // -1 = one worker per core, minus the audio thread core
+    ~RenderPool();
+
+    // execute task.process(0) ... task.process(count - 1) and return when all are finished
+    void run(Task &task, int count);
+
+    int getWorkers() const;
+
+private:
+    RenderPool(const RenderPool &other);
+    RenderPool &operator=(const RenderPool &other);
+
+    class Worker;
+
+    std::vector<Worker *> workers;
+
+    // (generation << 32) | next task index. The generation avoid late workers claiming tasks from the next run()
+    std::atomic<quint64> work;
+    std::atomic<quint32> generation;
+    std::atomic<Task *> currentTask;
+    std::atomic<int> taskCount;
+    std::atomic<int> completedTasks;
+
+    // parking
+    QMutex parkMutex;
+    QWaitCondition wakeUp;
+    std::atomic<int> parkedWorkers;
+    std::atomic<bool> stopRequested;
+
+    void executeTasks(quint32 taskGeneration);
+    void waitNextGeneration(quint32 lastGeneration);
+
+    static void cpuRelax();
+
+    static const int SPIN_ITERATIONS = 20000; // roughly some tens of microseconds before parking
+    static const int MAX_WORKERS = 15;
+};
+
+inline int RenderPool::getWorkers() const
+{
+    return static_cast<int>(workers.size());
+}
+
+} // namespace
+
+#endif // RENDER_POOL_H
@@ -1,4 +1,5 @@
 #include "SamplesBuffer.h"
+#include "SimdKernels.h"
 #include <QDebug>
 #include <cmath>
 #include <algorithm>
@@ -20,10 +21,17 @@ SamplesBuffer::SamplesBuffer(unsigned int channels, unsigned int frameLenght) :
     frameLenght(frameLenght),
     rmsRunningSum(0.0f),
     summedSamples(0),
-    rmsWindowSize(13230) // 300 ms in 44100 KHz
+    rmsWindowSize(13230), // 300 ms in 44100 KHz
+    data(nullptr),
+    allocatedChannels(channels),
+    channelStride(0),
+    initializedFrames(0)
 {
-    for (unsigned int c = 0; c < channels; ++c)
-        samples.emplace_back(frameLenght);
+    if (frameLenght > 0) {
+        reallocate(channels, frameLenght);
+        std::memset(data, 0, channels * channelStride * sizeof(float));
+        initializedFrames = frameLenght;
+    }
 
     squaredSums[0] = squaredSums[1] = 0.0f;
     lastRmsValues[0] = lastRmsValues[1] = 0.0f;
@@ -36,7 +44,10 @@ SamplesBuffer::SamplesBuffer(const SamplesBuffer &other) :
       rmsRunningSum(other.rmsRunningSum),
       summedSamples(other.summedSamples),
       rmsWindowSize(other.rmsWindowSize),
-      samples(other.samples)
+      data(nullptr),
+      allocatedChannels(other.allocatedChannels),
+      channelStride(0),
+      initializedFrames(0)
 {
     // qWarning() << "Samples Buffer copy constructor!";
     squaredSums[0] = other.squaredSums[0];
@@ -44,10 +55,45 @@ SamplesBuffer::SamplesBuffer(const SamplesBuffer &other) :
 
     lastRmsValues[0] = other.lastRmsValues[0];
     lastRmsValues[1] = other.lastRmsValues[1];
+
+    if (other.frameLenght > 0) { // copying only the used frames, not the reserved space
+        reallocate(other.allocatedChannels, other.frameLenght);
+        const size_t bytesToCopy = other.frameLenght * sizeof(float);
+        for (unsigned int c = 0; c < allocatedChannels; ++c)
+            std::memcpy(getSamplesArray(c), other.getSamplesArray(c), bytesToCopy);
+
+        initializedFrames = other.frameLenght;
+    }
+}
+
+SamplesBuffer::SamplesBuffer(SamplesBuffer &&other) :
+    channels(other.channels),
+    frameLenght(other.frameLenght),
+    rmsRunningSum(other.rmsRunningSum),
+    summedSamples(other.summedSamples),
+    rmsWindowSize(other.rmsWindowSize),
+    data(other.data),
+    allocatedChannels(other.allocatedChannels),
+    channelStride(other.channelStride),
+    initializedFrames(other.initializedFrames)
+{
+    squaredSums[0] = other.squaredSums[0];
+    squaredSums[1] = other.squaredSums[1];
+
+    lastRmsValues[0] = other.lastRmsValues[0];
+    lastRmsValues[1] = other.lastRmsValues[1];
+
+    other.data = nullptr;
+    other.channelStride = 0;
+    other.initializedFrames = 0;
+    other.frameLenght = 0;
 }
 
 SamplesBuffer &SamplesBuffer::operator=(const SamplesBuffer &other)
 {
+    if (this == &other)
+        return *this;
+
     this->channels = other.channels;
     this->frameLenght = other.frameLenght;
     this->rmsRunningSum = other.rmsRunningSum;
@@ -60,12 +106,75 @@ SamplesBuffer &SamplesBuffer::operator=(const SamplesBuffer &other)
     lastRmsValues[0] = other.lastRmsValues[0];
     lastRmsValues[1] = other.lastRmsValues[1];
 
-    this->samples = other.samples;
+    // reuse the current block when it is big enough, avoiding allocations in the audio thread
+    if (allocatedChannels < other.allocatedChannels || channelStride < other.frameLenght) {
+        simd::alignedFree(data);
+        data = nullptr;
+        channelStride = 0;
+        if (other.frameLenght > 0)
+            reallocate(other.allocatedChannels, other.frameLenght);
+    }
+
+    allocatedChannels = other.allocatedChannels;
+    initializedFrames = other.frameLenght;
+
+    const size_t bytesToCopy = initializedFrames * sizeof(float);
+    if (bytesToCopy > 0) {
+        for (unsigned int c = 0; c < allocatedChannels; ++c)
+            std::memcpy(getSamplesArray(c), other.getSamplesArray(c), bytesToCopy);
+    }
 
     return *this;
 }
 
-SamplesBuffer::~SamplesBuffer() = default;
+SamplesBuffer &SamplesBuffer::operator=(SamplesBuffer &&other)
+{
+    if (this == &other)
+        return *this;
+
+    this->channels = other.channels;
+    this->frameLenght = other.frameLenght;
+    this->rmsRunningSum = other.rmsRunningSum;
+    this->rmsWindowSize = other.rmsWindowSize;
+    this->summedSamples = other.summedSamples;
+
+    squaredSums[0] = other.squaredSums[0];
+    squaredSums[1] = other.squaredSums[1];
+
+    lastRmsValues[0] = other.lastRmsValues[0];
+    lastRmsValues[1] = other.lastRmsValues[1];
+
+    std::swap(data, other.data);
+    std::swap(allocatedChannels, other.allocatedChannels);
+    std::swap(channelStride, other.channelStride);
+    std::swap(initializedFrames, other.initializedFrames);
+
+    return *this;
+}
+
+SamplesBuffer::~SamplesBuffer()
+{
+    simd::alignedFree(data);
+}
+
+void SamplesBuffer::reallocate(unsigned int newChannels, unsigned int minimumFrames)
+{
+    const unsigned int newStride = simd::alignedStride(minimumFrames);
+    float *newData = simd::alignedAlloc(newChannels * newStride);
+
+    if (data) {
+        const unsigned int channelsToCopy = std::min(allocatedChannels, newChannels);
+        const size_t bytesToCopy = std::min(initializedFrames, newStride) * sizeof(float);
+        for (unsigned int c = 0; c < channelsToCopy; ++c)
+            std::memcpy(newData + c * newStride, data + c * channelStride, bytesToCopy);
+
+        simd::alignedFree(data);
+    }
+
+    data = newData;
+    allocatedChannels = newChannels;
+    channelStride = newStride;
+}
 
 void SamplesBuffer::setRmsWindowSize(int samples)
 {
@@ -77,7 +186,8 @@ void SamplesBuffer::invertStereo()
     if (channels != 2)
         return; // trying invert a non stereo buffer
 
-    std::iter_swap(samples.begin(), samples.begin() + 1); // swap first and second channels
+    float *left = getSamplesArray(0);
+    std::swap_ranges(left, left + frameLenght, getSamplesArray(1)); // swap first and second channels
 }
 
 void SamplesBuffer::discardFirstSamples(unsigned int samplesToDiscard)
@@ -85,8 +195,11 @@ void SamplesBuffer::discardFirstSamples(unsigned int samplesToDiscard)
     int toDiscard = std::min(frameLenght, samplesToDiscard);
     int toCopy = frameLenght - toDiscard;
     uint newFrameLenght = frameLenght - toDiscard;
-    for (uint c = 0; c < channels; ++c) {
-        std::copy_n(samples[c].begin() + toDiscard, toCopy, samples[c].begin());
+    if (toCopy > 0) {
+        for (uint c = 0; c < channels; ++c) {
+            float *channelSamples = getSamplesArray(c);
+            std::memmove(channelSamples, channelSamples + toDiscard, toCopy * sizeof(float));
+        }
     }
     setFrameLenght(newFrameLenght);
 }
@@ -99,58 +212,38 @@ void SamplesBuffer::append(const SamplesBuffer &other)
     set(other, 0, other.frameLenght, internalOffset);
 }
 
-float *SamplesBuffer::getSamplesArray(unsigned int channel) const
-{
-    Q_ASSERT(channel < samples.size());
-
-    return const_cast<float *>(&(samples[channel][0]));
-}
-
 void SamplesBuffer::applyGain(float gainFactor, float boostFactor)
 {
     const float scaleFactor = gainFactor * boostFactor;
-    for (unsigned int c = 0; c < channels; ++c) {
-        for (unsigned int i = 0; i < frameLenght; ++i)
-            samples[c][i] *= scaleFactor;
-    }
+    const simd::Kernels &kernels = simd::kernels();
+    for (unsigned int c = 0; c < channels; ++c)
+        kernels.scale(getSamplesArray(c), frameLenght, scaleFactor);
 }
 
 void SamplesBuffer::fadeOut(int fadeFrameLenght, float endGain)
 {
     uint lenght = std::min(fadeFrameLenght, (int)frameLenght);
     float gainStep = (1 - endGain)/lenght;
-    for (unsigned int c = 0; c < channels; ++c) {
-        float gain = 1;
-        for (unsigned int s = 0; s < lenght; ++s) {
-            samples[c][s] *= gain;
-            gain -= gainStep;
-        }
-    }
+    const simd::Kernels &kernels = simd::kernels();
+    for (unsigned int c = 0; c < channels; ++c)
+        kernels.ramp(getSamplesArray(c), lenght, 1.0f, -gainStep);
 }
 
 void SamplesBuffer::fadeIn(int fadeFrameLenght, float beginGain)
 {
     uint lenght = std::min(fadeFrameLenght, (int)frameLenght);
     float gainStep = (1 - beginGain)/lenght;
-    for (unsigned int c = 0; c < channels; ++c) {
-        float gain = beginGain;
-        for (unsigned int s = 0; s < lenght; ++s) {
-            samples[c][s] *= gain;
-            gain += gainStep;
-        }
-    }
+    const simd::Kernels &kernels = simd::kernels();
+    for (unsigned int c = 0; c < channels; ++c)
+        kernels.ramp(getSamplesArray(c), lenght, beginGain, gainStep);
 }
 
 void SamplesBuffer::fade(float beginGain, float endGain)
 {
     float gainStep = (endGain - beginGain)/frameLenght;
-    for (unsigned int c = 0; c < channels; ++c) {
-        float gain = beginGain;
-        for (unsigned int s = 0; s < frameLenght; ++s) {
-            samples[c][s] *= gain;
-            gain += gainStep;
-        }
-    }
+    const simd::Kernels &kernels = simd::kernels();
+    for (unsigned int c = 0; c < channels; ++c)
+        kernels.ramp(getSamplesArray(c), frameLenght, beginGain, gainStep);
 }
 
 void SamplesBuffer::applyGain(float gainFactor, float leftGain, float rightGain, float boostFactor)
@@ -159,10 +252,7 @@ void SamplesBuffer::applyGain(float gainFactor, float leftGain, float rightGain,
         float commonGain = gainFactor * boostFactor;
         float finalLeftGain = commonGain * leftGain;
         float finalRightGain = commonGain * rightGain;
-        for (unsigned int i = 0; i < frameLenght; ++i) {
-            samples[0][i] *= finalLeftGain;
-            samples[1][i] *= finalRightGain;
-        }
+        simd::kernels().scaleStereo(getSamplesArray(0), getSamplesArray(1), frameLenght, finalLeftGain, finalRightGain);
     }
     else {
         applyGain(gainFactor, boostFactor);
@@ -176,31 +266,19 @@ void SamplesBuffer::zero()
 
     const uint bytesToProcess = frameLenght * sizeof(float);
     for (unsigned int c = 0; c < channels; ++c) {
-        Q_ASSERT(samples[c].size() >= frameLenght);
-        memset(&(samples[c][0]), 0, bytesToProcess);
+        Q_ASSERT(initializedFrames >= frameLenght);
+        memset(getSamplesArray(c), 0, bytesToProcess);
     }
 }
 
 AudioPeak SamplesBuffer::computePeak()
 {
-    float abs; // max peak absolute value
     float maxPeaks[2] = {0};// left and right peaks
-	unsigned maxChan = isMono() ? 1 : channels; // don't loop and mul/add twice if only one channel
+    unsigned maxChan = isMono() ? 1 : std::min(channels, 2u); // don't loop and mul/add twice if only one channel
 
+    const simd::Kernels &kernels = simd::kernels();
     for (unsigned int c = 0; c < maxChan; ++c) {
-        float maxPeak = 0;
-		const std::vector<float>& chanSamples = samples[c]; // optimize costly stl vector access out of the inner loop
-        for (unsigned int i = 0; i < frameLenght; ++i) {
-            // max peak
-            abs = chanSamples[i]; // access inner std:svector array only once, use it for square value below
-			if(abs<0) abs = -abs; // std::fabs is very slow, just negate if needed
-
-            if (abs > maxPeak) maxPeak = abs;
-
-            // rms running squared sum
-            squaredSums[c] += abs * abs; // squaring every sample and summing
-        }
-		maxPeaks[c] = maxPeak;
+        maxPeaks[c] = kernels.peakAndSquaredSum(getSamplesArray(c), frameLenght, &squaredSums[c]);
         summedSamples += frameLenght;
     }
 
@@ -228,58 +306,48 @@ int SamplesBuffer::computeRmsWindowSize(int sampleRate, int windowTimeInMs)
 
 void SamplesBuffer::add(const SamplesBuffer &buffer, int internalWriteOffset)
 {
-	const uint framesToProcess = std::min(static_cast<uint>(frameLenght), buffer.getFrameLenght());
+    const uint framesToProcess = std::min(static_cast<uint>(frameLenght), buffer.getFrameLenght());
+    if (!framesToProcess)
+        return;
 
-    if (buffer.channels >= channels) {
-        for (unsigned int c = 0; c < channels; ++c) {
-	        auto& chanSamples = samples[c]; // save costly loop access to vector sub float array
-			const auto& bufChanSamples = buffer.samples[c]; // save costly loop access to vector sub float array
+    Q_ASSERT(framesToProcess + internalWriteOffset <= initializedFrames);
 
-            for (unsigned int s = 0; s < framesToProcess; ++s) {
-                Q_ASSERT(s + internalWriteOffset < chanSamples.size());
-                chanSamples[s + internalWriteOffset] += bufChanSamples[s];
-            }
-        }
+    const simd::Kernels &kernels = simd::kernels();
+    if (buffer.channels >= channels) {
+        for (unsigned int c = 0; c < channels; ++c)
+            kernels.mixAdd(getSamplesArray(c) + internalWriteOffset, buffer.getSamplesArray(c), framesToProcess);
     }
     else { // samples is stereo and buffer is mono
-	    auto& chanSamples0 = samples[0]; // save costly loop access to vector sub float array
-	    auto& chanSamples1 = samples[1]; // save costly loop access to vector sub float array
-		const auto& bufChanSamples0 = buffer.samples[0]; // save costly loop access to vector sub float array
-
-        for (unsigned int s = 0; s < framesToProcess; ++s) {
-            Q_ASSERT(s + internalWriteOffset < chanSamples0.size());
-            Q_ASSERT(s + internalWriteOffset < chanSamples1.size());
-	        const auto monoBufferSampleAtIndex  = bufChanSamples0[s];
-            chanSamples0[s + internalWriteOffset] += monoBufferSampleAtIndex;
-            chanSamples1[s + internalWriteOffset] += monoBufferSampleAtIndex;
-        }
+        kernels.mixAddMonoToStereo(getSamplesArray(0) + internalWriteOffset,
+                                   getSamplesArray(1) + internalWriteOffset,
+                                   buffer.getSamplesArray(0), framesToProcess);
     }
 }
 
 void SamplesBuffer::add(uint channel, float *samples, uint samplesToAdd)
 {
-    Q_ASSERT(channel < channels && channels == this->samples.size());
-    Q_ASSERT(samplesToAdd <= frameLenght && samplesToAdd <= this->samples[channel].size());
+    Q_ASSERT(channel < channels && channels <= allocatedChannels);
+    Q_ASSERT(samplesToAdd <= frameLenght && samplesToAdd <= initializedFrames);
 
-    void *dest = &(this->samples[channel][0]);
+    void *dest = getSamplesArray(channel);
     const uint bytesToCopy = std::min(static_cast<uint>(frameLenght), samplesToAdd) * sizeof(float);
     memcpy(dest, samples, bytesToCopy);
 }
 
 void SamplesBuffer::add(uint channel, uint sampleIndex, float sampleValue)
 {
-    Q_ASSERT(channel < channels && channels == samples.size());
-    Q_ASSERT(sampleIndex < samples[channel].size());
+    Q_ASSERT(channel < channels && channels <= allocatedChannels);
+    Q_ASSERT(sampleIndex < initializedFrames);
 
-    samples[channel][sampleIndex] += sampleValue;
+    getSamplesArray(channel)[sampleIndex] += sampleValue;
 }
 
 void SamplesBuffer::set(uint channel, uint sampleIndex, float sampleValue)
 {
-    Q_ASSERT(channel < channels && channels <= samples.size());
-    Q_ASSERT(sampleIndex < samples[channel].size());
+    Q_ASSERT(channel < channels && channels <= allocatedChannels);
+    Q_ASSERT(sampleIndex < initializedFrames);
 
-    samples[channel][sampleIndex] = sampleValue;
+    getSamplesArray(channel)[sampleIndex] = sampleValue;
 }
 
 void SamplesBuffer::setToMono()
@@ -290,15 +358,18 @@ void SamplesBuffer::setToMono()
 
 void SamplesBuffer::setToStereo()
 {
-    if (this->samples.size() < 2) {
-        size_t channelsToAdd = 2 - this->samples.size();
-        for (uint c = 0; c < channelsToAdd; ++c)
-            samples.push_back(std::vector<float>(frameLenght));
+    if (allocatedChannels < 2) {
+        const unsigned int firstNewChannel = allocatedChannels;
+        if (channelStride > 0) {
+            reallocate(2, channelStride);
+            for (uint c = firstNewChannel; c < 2; ++c)
+                std::memset(getSamplesArray(c), 0, initializedFrames * sizeof(float));
+        }
+        else {
+            allocatedChannels = 2; // nothing allocated yet
+        }
     }
 
-    for (unsigned int c = 0; c < samples.size(); ++c)
-        samples[c].resize(frameLenght);
-
     this->channels = 2;
 }
 
@@ -310,9 +381,9 @@ void SamplesBuffer::set(const SamplesBuffer &buffer)
 float SamplesBuffer::get(uint channel, uint sampleIndex) const
 {
     Q_ASSERT(channel < channels);
-    Q_ASSERT(sampleIndex < samples[channel].capacity());
+    Q_ASSERT(sampleIndex < channelStride);
 
-    return samples[channel][sampleIndex];
+    return getSamplesArray(channel)[sampleIndex];
 }
 
 void SamplesBuffer::setFrameLenght(unsigned int newFrameLenght)
@@ -320,13 +391,29 @@ void SamplesBuffer::setFrameLenght(unsigned int newFrameLenght)
     if (newFrameLenght == frameLenght)
         return;
 
-    if (newFrameLenght > frameLenght) {
-        for (unsigned int c = 0; c < channels; ++c)
-            samples[c].resize(newFrameLenght);
+    if (newFrameLenght > initializedFrames) {
+        if (newFrameLenght > channelStride) // grow like std::vector to keep append() amortized
+            reallocate(allocatedChannels, std::max(newFrameLenght, channelStride * 2));
+
+        const uint bytesToZero = (newFrameLenght - initializedFrames) * sizeof(float);
+        for (unsigned int c = 0; c < allocatedChannels; ++c)
+            std::memset(getSamplesArray(c) + initializedFrames, 0, bytesToZero);
+
+        initializedFrames = newFrameLenght;
     }
     this->frameLenght = newFrameLenght;
 }
 
+void SamplesBuffer::reserve(unsigned int frames)
+{
+    if (frames <= initializedFrames)
+        return;
+
+    const unsigned int currentFrameLenght = frameLenght;
+    setFrameLenght(frames);
+    frameLenght = currentFrameLenght;
+}
+
 void SamplesBuffer::set(const SamplesBuffer &buffer, int bufferChannelOffset, int channelsToCopy)
 {
     if (buffer.channels == 0 || channels == 0)
@@ -362,7 +449,7 @@ void SamplesBuffer::set(const SamplesBuffer &buffer, uint bufferOffset, uint sam
 
     if (channels == buffer.channels) {// channels number are equal
         for (unsigned int c = 0; c < channels; ++c) {
-            std::memcpy(&(samples[c][internalOffset]), &(buffer.samples[c][bufferOffset]), bytesToProcess);
+            std::memcpy(getSamplesArray(c) + internalOffset, buffer.getSamplesArray(c) + bufferOffset, bytesToProcess);
         }
     }
     else { // different number of channels
@@ -370,22 +457,19 @@ void SamplesBuffer::set(const SamplesBuffer &buffer, uint bufferOffset, uint sam
             if (!buffer.isMono()) {
                 int channelsToCopy = qMin(channels, buffer.channels);
                 for (int c = 0; c < channelsToCopy; ++c) {
-                    Q_ASSERT(internalOffset < samples[c].size());
-                    Q_ASSERT(bufferOffset < buffer.samples[c].size());
-                    Q_ASSERT(bufferOffset + framesToProcess < buffer.samples[c].size());
-                    Q_ASSERT(internalOffset + framesToProcess < samples[c].size());
-                    std::memcpy(&(samples[c][internalOffset]), &(buffer.samples[c][bufferOffset]), bytesToProcess);
+                    Q_ASSERT(internalOffset + framesToProcess <= initializedFrames);
+                    Q_ASSERT(bufferOffset + framesToProcess <= buffer.initializedFrames);
+                    std::memcpy(getSamplesArray(c) + internalOffset, buffer.getSamplesArray(c) + bufferOffset, bytesToProcess);
                 }
             } else {
-                std::memcpy(&(samples[0][internalOffset]), &(buffer.samples[0][bufferOffset]), bytesToProcess);
-                std::memcpy(&(samples[1][internalOffset]), &(buffer.samples[0][bufferOffset]), bytesToProcess);
+                std::memcpy(getSamplesArray(0) + internalOffset, buffer.getSamplesArray(0) + bufferOffset, bytesToProcess);
+                std::memcpy(getSamplesArray(1) + internalOffset, buffer.getSamplesArray(0) + bufferOffset, bytesToProcess);
             }
         } else { // this buffer is mono, but the buffer in parameter is not! Mix down the stereo samples in one mono sample value.
-            for (unsigned int s = 0; s < framesToProcess; ++s) {
-                const int index = s + bufferOffset;
-                float v = (buffer.samples[0][index] + buffer.samples[1][index])/2.0f;
-                samples[0][s + internalOffset] = v;
-            }
+            simd::kernels().downMixToMono(getSamplesArray(0) + internalOffset,
+                                          buffer.getSamplesArray(0) + bufferOffset,
+                                          buffer.getSamplesArray(1) + bufferOffset,
+                                          framesToProcess);
         }
     }
 }
@@ -23,13 +23,21 @@ private:
     int rmsWindowSize; // how many samples until have enough data to compute rms?
     float lastRmsValues[2];
 
-    std::vector<std::vector<float>> samples;
+    // all channels live in one 32 bytes aligned planar block, channel 'c' starts at data + c * channelStride
+    float *data;
+    unsigned int allocatedChannels;
+    unsigned int channelStride; // allocated frames per channel, always a multiple of simd::FLOATS_PER_ALIGNMENT
+    unsigned int initializedFrames; // frames zeroed or written in every channel, behaves like std::vector::size()
+
+    void reallocate(unsigned int newChannels, unsigned int minimumFrames);
 
 public:
     explicit SamplesBuffer(unsigned int channels);
     explicit SamplesBuffer(unsigned int channels, unsigned int frameLenght);
     SamplesBuffer(const SamplesBuffer &other);
+    SamplesBuffer(SamplesBuffer &&other);
     SamplesBuffer &operator=(const SamplesBuffer &other);
+    SamplesBuffer &operator=(SamplesBuffer &&other);
     ~SamplesBuffer();
 
     void setRmsWindowSize(int samples);
@@ -80,6 +88,9 @@ public:
     unsigned int getFrameLenght() const;
     void setFrameLenght(unsigned int newFrameLenght);
 
+    // preallocate (and zero) memory for 'frames', so setFrameLenght() will not allocate in the audio thread
+    void reserve(unsigned int frames);
+
     int getChannels() const;
 
     bool isEmpty() const;
@@ -111,6 +122,13 @@ inline unsigned int SamplesBuffer::getFrameLenght() const
     return frameLenght;
 }
 
+inline float *SamplesBuffer::getSamplesArray(unsigned int channel) const
+{
+    Q_ASSERT(channel < allocatedChannels || !data);
+
+    return data + channel * channelStride;
+}
+
 } // namespace
 
 #endif // SAMPLESBUFFER_H
@@ -0,0 +1,68 @@
+#include "SamplesRingBuffer.h"
+
+#include <algorithm>
+
+using audio::SamplesRingBuffer;
+using audio::SamplesBuffer;
+
+SamplesRingBuffer::SamplesRingBuffer(unsigned int channels, unsigned int capacity) :
+    buffer(channels, capacity),
+    capacity(capacity),
+    readPosition(0),
+    writePosition(0),
+    availableFrames(0)
+{
+    Q_ASSERT(capacity > 0);
+}
+
+unsigned int SamplesRingBuffer::write(const SamplesBuffer &samples, unsigned int offset, unsigned int frames)
+{
+    if (offset >= samples.getFrameLenght())
+        return 0;
+
+    frames = std::min(frames, samples.getFrameLenght() - offset);
+    frames = std::min(frames, getFreeFrames());
+
+    // two copies at most, the second one when the write cursor wraps around
+    unsigned int firstPart = std::min(frames, capacity - writePosition);
+    buffer.set(samples, offset, firstPart, writePosition);
+    if (firstPart < frames)
+        buffer.set(samples, offset + firstPart, frames - firstPart, 0);
+
+    writePosition = (writePosition + frames) % capacity;
+    availableFrames += frames;
+
+    return frames;
+}
+
+unsigned int SamplesRingBuffer::read(SamplesBuffer &out, unsigned int outOffset, unsigned int frames)
+{
+    if (outOffset >= out.getFrameLenght())
+        return 0;
+
+    frames = std::min(frames, out.getFrameLenght() - outOffset);
+    frames = std::min(frames, availableFrames);
+
+    unsigned int firstPart = std::min(frames, capacity - readPosition);
+    out.set(buffer, readPosition, firstPart, outOffset);
+    if (firstPart < frames)
+        out.set(buffer, 0, frames - firstPart, outOffset + firstPart);
+
+    discard(frames);
+
+    return frames;
+}
+
+void SamplesRingBuffer::discard(unsigned int frames)
+{
+    frames = std::min(frames, availableFrames);
+
+    readPosition = (readPosition + frames) % capacity;
+    availableFrames -= frames;
+}
+
+void SamplesRingBuffer::clear()
+{
+    readPosition = writePosition = 0;
+    availableFrames = 0;
+}
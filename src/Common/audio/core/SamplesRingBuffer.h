@@ -0,0 +1,81 @@
+#ifndef SAMPLES_RING_BUFFER_H
+#define SAMPLES_RING_BUFFER_H
+
+#include "SamplesBuffer.h"
+
+namespace audio {
+
+/**
+ * Fixed capacity planar FIFO of samples. The memory is allocated in the constructor, write() and
+ * read() just move the cursors, so no allocations or front erases happen in the audio thread.
+ * Not thread safe, the owner must serialize the access.
+ */
+class SamplesRingBuffer
+{
+public:
+    SamplesRingBuffer(unsigned int channels, unsigned int capacity);
+
+    // append up to 'frames' samples from 'samples' (starting in 'offset'), return how many frames fit
+    unsigned int write(const SamplesBuffer &samples, unsigned int offset, unsigned int frames);
+    unsigned int write(const SamplesBuffer &samples);
+
+    // copy up to 'frames' samples to 'out' starting in 'outOffset', return how many frames was readed
+    unsigned int read(SamplesBuffer &out, unsigned int outOffset, unsigned int frames);
+
+    void discard(unsigned int frames);
+    void clear();
+
+    unsigned int getAvailableFrames() const;
+    unsigned int getFreeFrames() const;
+    unsigned int getCapacity() const;
+    int getChannels() const;
+
+    bool isEmpty() const;
+    bool isFull() const;
+
+private:
+    SamplesBuffer buffer;
+    unsigned int capacity;
+    unsigned int readPosition;
+    unsigned int writePosition;
+    unsigned int availableFrames;
+};
+
+inline unsigned int SamplesRingBuffer::write(const SamplesBuffer &samples)
+{
+    return write(samples, 0, samples.getFrameLenght());
+}
+
+inline unsigned int SamplesRingBuffer::getAvailableFrames() const
+{
+    return availableFrames;
+}
+
+inline unsigned int SamplesRingBuffer::getFreeFrames() const
+{
+    return capacity - availableFrames;
+}
+
+inline unsigned int SamplesRingBuffer::getCapacity() const
+{
+    return capacity;
+}
+
+inline int SamplesRingBuffer::getChannels() const
+{
+    return buffer.getChannels();
+}
+
+inline bool SamplesRingBuffer::isEmpty() const
+{
+    return availableFrames == 0;
+}
+
+inline bool SamplesRingBuffer::isFull() const
+{
+    return availableFrames == capacity;
+}
+
+} // namespace
+
+#endif // SAMPLES_RING_BUFFER_H
@@ -0,0 +1,771 @@
+#include "SimdKernels.h"
+
+#include <cstdlib>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define SIMD_HAS_SSE2
+    #include <emmintrin.h>
+    #if defined(__GNUC__) || defined(__clang__)
+        #define SIMD_HAS_AVX2
+        #define AVX2_TARGET __attribute__((target("avx2")))
+        #include <immintrin.h>
+    #elif defined(_MSC_VER)
+        #define SIMD_HAS_AVX2
+        #define AVX2_TARGET
+        #include <immintrin.h>
+        #include <intrin.h>
+    #endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #define SIMD_HAS_NEON
+    #include <arm_neon.h>
+#endif
+
+namespace audio
+{
+
+namespace simd
+{
+
+float *alignedAlloc(std::size_t floats)
+{
+    if (!floats)
+        return nullptr;
+
+    // over allocate and keep the original pointer just before the aligned block
+    const std::size_t bytes = floats * sizeof(float) + ALIGNMENT + sizeof(void *);
+    void *raw = std::malloc(bytes);
+    if (!raw)
+        return nullptr;
+
+    std::uintptr_t address = reinterpret_cast<std::uintptr_t>(raw) + sizeof(void *);
+    address = (address + ALIGNMENT - 1) & ~static_cast<std::uintptr_t>(ALIGNMENT - 1);
+
+    void **aligned = reinterpret_cast<void **>(address);
+    aligned[-1] = raw;
+
+    return reinterpret_cast<float *>(aligned);
+}
+
+void alignedFree(float *ptr)
+{
+    if (ptr)
+        std::free(reinterpret_cast<void **>(ptr)[-1]);
+}
+
+unsigned int alignedStride(unsigned int frames)
+{
+    return (frames + FLOATS_PER_ALIGNMENT - 1) & ~(FLOATS_PER_ALIGNMENT - 1);
+}
+
+// ----------------------------------------------------------------------------
+
+namespace scalar
+{
+
+void scale(float *samples, unsigned int frames, float gain)
+{
+    for (unsigned int i = 0; i < frames; ++i)
+        samples[i] *= gain;
+}
+
+void scaleStereo(float *left, float *right, unsigned int frames, float leftGain, float rightGain)
+{
+    for (unsigned int i = 0; i < frames; ++i) {
+        left[i] *= leftGain;
+        right[i] *= rightGain;
+    }
+}
+
+void ramp(float *samples, unsigned int frames, float beginGain, float gainStep)
+{
+    for (unsigned int i = 0; i < frames; ++i)
+        samples[i] *= beginGain + i * gainStep;
+}
+
+void mixAdd(float *dest, const float *source, unsigned int frames)
+{
+    for (unsigned int i = 0; i < frames; ++i)
+        dest[i] += source[i];
+}
+
+void mixAddMonoToStereo(float *left, float *right, const float *source, unsigned int frames)
+{
+    for (unsigned int i = 0; i < frames; ++i) {
+        const float sample = source[i];
+        left[i] += sample;
+        right[i] += sample;
+    }
+}
+
+void downMixToMono(float *dest, const float *left, const float *right, unsigned int frames)
+{
+    for (unsigned int i = 0; i < frames; ++i)
+        dest[i] = (left[i] + right[i]) * 0.5f;
+}
+
+float peakAndSquaredSum(const float *samples, unsigned int frames, float *squaredSum)
+{
+    float peak = 0;
+    float sum = 0;
+    for (unsigned int i = 0; i < frames; ++i) {
+        float abs = samples[i];
+        if (abs < 0)
+            abs = -abs; // std::fabs is very slow, just negate if needed
+
+        if (abs > peak)
+            peak = abs;
+
+        sum += abs * abs;
+    }
+    *squaredSum += sum;
+    return peak;
+}
+
+float dotProduct(const float *a, const float *b, unsigned int frames)
+{
+    float sum = 0;
+    for (unsigned int i = 0; i < frames; ++i)
+        sum += a[i] * b[i];
+
+    return sum;
+}
+
+void int16ToFloat(float *dest, const std::int16_t *source, unsigned int count, float scale)
+{
+    for (unsigned int i = 0; i < count; ++i)
+        dest[i] = source[i] * scale;
+}
+
+void int32ToFloat(float *dest, const std::int32_t *source, unsigned int count, float scale)
+{
+    for (unsigned int i = 0; i < count; ++i)
+        dest[i] = source[i] * scale;
+}
+
+void deinterleaveStereo(float *left, float *right, const float *interleaved, unsigned int frames)
+{
+    for (unsigned int i = 0; i < frames; ++i) {
+        left[i] = interleaved[i * 2];
+        right[i] = interleaved[i * 2 + 1];
+    }
+}
+
+} // namespace scalar
+
+// ----------------------------------------------------------------------------
+
+#ifdef SIMD_HAS_SSE2
+
+namespace sse2
+{
+
+inline float horizontalSum(__m128 v)
+{
+    __m128 shuffled = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 sums = _mm_add_ps(v, shuffled);
+    shuffled = _mm_movehl_ps(shuffled, sums);
+    sums = _mm_add_ss(sums, shuffled);
+    return _mm_cvtss_f32(sums);
+}
+
+inline float horizontalMax(__m128 v)
+{
+    __m128 shuffled = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 maxs = _mm_max_ps(v, shuffled);
+    shuffled = _mm_movehl_ps(shuffled, maxs);
+    maxs = _mm_max_ss(maxs, shuffled);
+    return _mm_cvtss_f32(maxs);
+}
+
+void scale(float *samples, unsigned int frames, float gain)
+{
+    const __m128 g = _mm_set1_ps(gain);
+    unsigned int i = 0;
+    for (; i + 4 <= frames; i += 4)
+        _mm_storeu_ps(samples + i, _mm_mul_ps(_mm_loadu_ps(samples + i), g));
+
+    scalar::scale(samples + i, frames - i, gain);
+}
+
+void scaleStereo(float *left, float *right, unsigned int frames, float leftGain, float rightGain)
+{
+    const __m128 gl = _mm_set1_ps(leftGain);
+    const __m128 gr = _mm_set1_ps(rightGain);
+    unsigned int i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        _mm_storeu_ps(left + i, _mm_mul_ps(_mm_loadu_ps(left + i), gl));
+        _mm_storeu_ps(right + i, _mm_mul_ps(_mm_loadu_ps(right + i), gr));
+    }
+
+    scalar::scaleStereo(left + i, right + i, frames - i, leftGain, rightGain);
+}
+
+void ramp(float *samples, unsigned int frames, float beginGain, float gainStep)
+{
+    const __m128 begin = _mm_set1_ps(beginGain);
+    const __m128 step = _mm_set1_ps(gainStep);
+    const __m128 four = _mm_set1_ps(4.0f);
+    __m128 index = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+    unsigned int i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        const __m128 gain = _mm_add_ps(begin, _mm_mul_ps(index, step));
+        _mm_storeu_ps(samples + i, _mm_mul_ps(_mm_loadu_ps(samples + i), gain));
+        index = _mm_add_ps(index, four);
+    }
+
+    scalar::ramp(samples + i, frames - i, beginGain + i * gainStep, gainStep);
+}
+
+void mixAdd(float *dest, const float *source, unsigned int frames)
+{
+    unsigned int i = 0;
+    for (; i + 4 <= frames; i += 4)
+        _mm_storeu_ps(dest + i, _mm_add_ps(_mm_loadu_ps(dest + i), _mm_loadu_ps(source + i)));
+
+    scalar::mixAdd(dest + i, source + i, frames - i);
+}
+
+void mixAddMonoToStereo(float *left, float *right, const float *source, unsigned int frames)
+{
+    unsigned int i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        const __m128 s = _mm_loadu_ps(source + i);
+        _mm_storeu_ps(left + i, _mm_add_ps(_mm_loadu_ps(left + i), s));
+        _mm_storeu_ps(right + i, _mm_add_ps(_mm_loadu_ps(right + i), s));
+    }
+
+    scalar::mixAddMonoToStereo(left + i, right + i, source + i, frames - i);
+}
+
+void downMixToMono(float *dest, const float *left, const float *right, unsigned int frames)
+{
+    const __m128 half = _mm_set1_ps(0.5f);
+    unsigned int i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        const __m128 sum = _mm_add_ps(_mm_loadu_ps(left + i), _mm_loadu_ps(right + i));
+        _mm_storeu_ps(dest + i, _mm_mul_ps(sum, half));
+    }
+
+    scalar::downMixToMono(dest + i, left + i, right + i, frames - i);
+}
+
+float peakAndSquaredSum(const float *samples, unsigned int frames, float *squaredSum)
+{
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    __m128 peaks = _mm_setzero_ps();
+    __m128 sums = _mm_setzero_ps();
+    unsigned int i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        const __m128 abs = _mm_and_ps(_mm_loadu_ps(samples + i), absMask);
+        peaks = _mm_max_ps(peaks, abs);
+        sums = _mm_add_ps(sums, _mm_mul_ps(abs, abs));
+    }
+
+    float sum = horizontalSum(sums);
+    float peak = scalar::peakAndSquaredSum(samples + i, frames - i, &sum);
+    const float vectorPeak = horizontalMax(peaks);
+    *squaredSum += sum;
+    return vectorPeak > peak ? vectorPeak : peak;
+}
+
+float dotProduct(const float *a, const float *b, unsigned int frames)
+{
+    __m128 sums = _mm_setzero_ps();
+    unsigned int i = 0;
+    for (; i + 4 <= frames; i += 4)
+        sums = _mm_add_ps(sums, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+
+    return horizontalSum(sums) + scalar::dotProduct(a + i, b + i, frames - i);
+}
+
+void int16ToFloat(float *dest, const std::int16_t *source, unsigned int count, float scale)
+{
+    const __m128 s = _mm_set1_ps(scale);
+    unsigned int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i));
+        // sign extension to 32 bits: the 16 bits are moved to the high half and shifted back
+        const __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16);
+        const __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16);
+        _mm_storeu_ps(dest + i, _mm_mul_ps(_mm_cvtepi32_ps(low), s));
+        _mm_storeu_ps(dest + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(high), s));
+    }
+
+    scalar::int16ToFloat(dest + i, source + i, count - i, scale);
+}
+
+void int32ToFloat(float *dest, const std::int32_t *source, unsigned int count, float scale)
+{
+    const __m128 s = _mm_set1_ps(scale);
+    unsigned int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i));
+        _mm_storeu_ps(dest + i, _mm_mul_ps(_mm_cvtepi32_ps(samples), s));
+    }
+
+    scalar::int32ToFloat(dest + i, source + i, count - i, scale);
+}
+
+void deinterleaveStereo(float *left, float *right, const float *interleaved, unsigned int frames)
+{
+    unsigned int i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        const __m128 first = _mm_loadu_ps(interleaved + i * 2);      // L0 R0 L1 R1
+        const __m128 second = _mm_loadu_ps(interleaved + i * 2 + 4); // L2 R2 L3 R3
+        _mm_storeu_ps(left + i, _mm_shuffle_ps(first, second, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(right + i, _mm_shuffle_ps(first, second, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+
+    scalar::deinterleaveStereo(left + i, right + i, interleaved + i * 2, frames - i);
+}
+
+} // namespace sse2
+
+#endif // SIMD_HAS_SSE2
+
+// ----------------------------------------------------------------------------
+
+#ifdef SIMD_HAS_AVX2
+
+namespace avx2
+{
+
+AVX2_TARGET inline float horizontalSum(__m256 v)
+{
+    const __m128 sum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    __m128 shuffled = _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 sums = _mm_add_ps(sum, shuffled);
+    shuffled = _mm_movehl_ps(shuffled, sums);
+    sums = _mm_add_ss(sums, shuffled);
+    return _mm_cvtss_f32(sums);
+}
+
+AVX2_TARGET inline float horizontalMax(__m256 v)
+{
+    const __m128 max = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    __m128 shuffled = _mm_shuffle_ps(max, max, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 maxs = _mm_max_ps(max, shuffled);
+    shuffled = _mm_movehl_ps(shuffled, maxs);
+    maxs = _mm_max_ss(maxs, shuffled);
+    return _mm_cvtss_f32(maxs);
+}
+
+AVX2_TARGET void scale(float *samples, unsigned int frames, float gain)
+{
+    const __m256 g = _mm256_set1_ps(gain);
+    unsigned int i = 0;
+    for (; i + 8 <= frames; i += 8)
+        _mm256_storeu_ps(samples + i, _mm256_mul_ps(_mm256_loadu_ps(samples + i), g));
+
+    sse2::scale(samples + i, frames - i, gain);
+}
+
+AVX2_TARGET void scaleStereo(float *left, float *right, unsigned int frames, float leftGain, float rightGain)
+{
+    const __m256 gl = _mm256_set1_ps(leftGain);
+    const __m256 gr = _mm256_set1_ps(rightGain);
+    unsigned int i = 0;
+    for (; i + 8 <= frames; i += 8) {
+        _mm256_storeu_ps(left + i, _mm256_mul_ps(_mm256_loadu_ps(left + i), gl));
+        _mm256_storeu_ps(right + i, _mm256_mul_ps(_mm256_loadu_ps(right + i), gr));
+    }
+
+    sse2::scaleStereo(left + i, right + i, frames - i, leftGain, rightGain);
+}
+
+AVX2_TARGET void ramp(float *samples, unsigned int frames, float beginGain, float gainStep)
+{
+    const __m256 begin = _mm256_set1_ps(beginGain);
+    const __m256 step = _mm256_set1_ps(gainStep);
+    const __m256 eight = _mm256_set1_ps(8.0f);
+    __m256 index = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+    unsigned int i = 0;
+    for (; i + 8 <= frames; i += 8) {
+        const __m256 gain = _mm256_add_ps(begin, _mm256_mul_ps(index, step));
+        _mm256_storeu_ps(samples + i, _mm256_mul_ps(_mm256_loadu_ps(samples + i), gain));
+        index = _mm256_add_ps(index, eight);
+    }
+
+    sse2::ramp(samples + i, frames - i, beginGain + i * gainStep, gainStep);
+}
+
+AVX2_TARGET void mixAdd(float *dest, const float *source, unsigned int frames)
+{
+    unsigned int i = 0;
+    for (; i + 8 <= frames; i += 8)
+        _mm256_storeu_ps(dest + i, _mm256_add_ps(_mm256_loadu_ps(dest + i), _mm256_loadu_ps(source + i)));
+
+    sse2::mixAdd(dest + i, source + i, frames - i);
+}
+
+AVX2_TARGET void mixAddMonoToStereo(float *left, float *right, const float *source, unsigned int frames)
+{
+    unsigned int i = 0;
+    for (; i + 8 <= frames; i += 8) {
+        const __m256 s = _mm256_loadu_ps(source + i);
+        _mm256_storeu_ps(left + i, _mm256_add_ps(_mm256_loadu_ps(left + i), s));
+        _mm256_storeu_ps(right + i, _mm256_add_ps(_mm256_loadu_ps(right + i), s));
+    }
+
+    sse2::mixAddMonoToStereo(left + i, right + i, source + i, frames - i);
+}
+
+AVX2_TARGET void downMixToMono(float *dest, const float *left, const float *right, unsigned int frames)
+{
+    const __m256 half = _mm256_set1_ps(0.5f);
+    unsigned int i = 0;
+    for (; i + 8 <= frames; i += 8) {
+        const __m256 sum = _mm256_add_ps(_mm256_loadu_ps(left + i), _mm256_loadu_ps(right + i));
+        _mm256_storeu_ps(dest + i, _mm256_mul_ps(sum, half));
+    }
+
+    sse2::downMixToMono(dest + i, left + i, right + i, frames - i);
+}
+
+AVX2_TARGET float peakAndSquaredSum(const float *samples, unsigned int frames, float *squaredSum)
+{
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    __m256 peaks = _mm256_setzero_ps();
+    __m256 sums = _mm256_setzero_ps();
+    unsigned int i = 0;
+    for (; i + 8 <= frames; i += 8) {
+        const __m256 abs = _mm256_and_ps(_mm256_loadu_ps(samples + i), absMask);
+        peaks = _mm256_max_ps(peaks, abs);
+        sums = _mm256_add_ps(sums, _mm256_mul_ps(abs, abs));
+    }
+
+    float sum = horizontalSum(sums);
+    float peak = sse2::peakAndSquaredSum(samples + i, frames - i, &sum);
+    const float vectorPeak = horizontalMax(peaks);
+    *squaredSum += sum;
+    return vectorPeak > peak ? vectorPeak : peak;
+}
+
+AVX2_TARGET float dotProduct(const float *a, const float *b, unsigned int frames)
+{
+    __m256 sums = _mm256_setzero_ps();
+    unsigned int i = 0;
+    for (; i + 8 <= frames; i += 8)
+        sums = _mm256_add_ps(sums, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+
+    return horizontalSum(sums) + sse2::dotProduct(a + i, b + i, frames - i);
+}
+
+AVX2_TARGET void int16ToFloat(float *dest, const std::int16_t *source, unsigned int count, float scale)
+{
+    const __m256 s = _mm256_set1_ps(scale);
+    unsigned int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i samples = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i)));
+        _mm256_storeu_ps(dest + i, _mm256_mul_ps(_mm256_cvtepi32_ps(samples), s));
+    }
+
+    sse2::int16ToFloat(dest + i, source + i, count - i, scale);
+}
+
+AVX2_TARGET void int32ToFloat(float *dest, const std::int32_t *source, unsigned int count, float scale)
+{
+    const __m256 s = _mm256_set1_ps(scale);
+    unsigned int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i samples = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(source + i));
+        _mm256_storeu_ps(dest + i, _mm256_mul_ps(_mm256_cvtepi32_ps(samples), s));
+    }
+
+    sse2::int32ToFloat(dest + i, source + i, count - i, scale);
+}
+
+AVX2_TARGET void deinterleaveStereo(float *left, float *right, const float *interleaved, unsigned int frames)
+{
+    unsigned int i = 0;
+    for (; i + 8 <= frames; i += 8) {
+        const __m256 first = _mm256_loadu_ps(interleaved + i * 2);      // L0 R0 L1 R1 | L2 R2 L3 R3
+        const __m256 second = _mm256_loadu_ps(interleaved + i * 2 + 8); // L4 R4 L5 R5 | L6 R6 L7 R7
+        // the shuffle works inside the 128 bits lanes (L0 L1 L4 L5 | L2 L3 L6 L7), the permute fix the order
+        const __m256 lefts = _mm256_shuffle_ps(first, second, _MM_SHUFFLE(2, 0, 2, 0));
+        const __m256 rights = _mm256_shuffle_ps(first, second, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm256_storeu_ps(left + i, _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(lefts), _MM_SHUFFLE(3, 1, 2, 0))));
+        _mm256_storeu_ps(right + i, _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(rights), _MM_SHUFFLE(3, 1, 2, 0))));
+    }
+
+    sse2::deinterleaveStereo(left + i, right + i, interleaved + i * 2, frames - i);
+}
+
+bool isSupported()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+
+    __cpuid(info, 1);
+    const bool osUsesXSave = (info[2] & (1 << 27)) != 0;
+    const bool cpuHasAvx = (info[2] & (1 << 28)) != 0;
+    if (!osUsesXSave || !cpuHasAvx)
+        return false;
+
+    if ((_xgetbv(0) & 0x6) != 0x6) // OS is saving YMM registers?
+        return false;
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+} // namespace avx2
+
+#endif // SIMD_HAS_AVX2
+
+// ----------------------------------------------------------------------------
+
+#ifdef SIMD_HAS_NEON
+
+namespace neon
+{
+
+inline float horizontalSum(float32x4_t v)
+{
+    float32x2_t sum = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+    sum = vpadd_f32(sum, sum);
+    return vget_lane_f32(sum, 0);
+}
+
+inline float horizontalMax(float32x4_t v)
+{
+    float32x2_t max = vmax_f32(vget_low_f32(v), vget_high_f32(v));
+    max = vpmax_f32(max, max);
+    return vget_lane_f32(max, 0);
+}
+
+void scale(float *samples, unsigned int frames, float gain)
+{
+    const float32x4_t g = vdupq_n_f32(gain);
+    unsigned int i = 0;
+    for (; i + 4 <= frames; i += 4)
+        vst1q_f32(samples + i, vmulq_f32(vld1q_f32(samples + i), g));
+
+    scalar::scale(samples + i, frames - i, gain);
+}
+
+void scaleStereo(float *left, float *right, unsigned int frames, float leftGain, float rightGain)
+{
+    const float32x4_t gl = vdupq_n_f32(leftGain);
+    const float32x4_t gr = vdupq_n_f32(rightGain);
+    unsigned int i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        vst1q_f32(left + i, vmulq_f32(vld1q_f32(left + i), gl));
+        vst1q_f32(right + i, vmulq_f32(vld1q_f32(right + i), gr));
+    }
+
+    scalar::scaleStereo(left + i, right + i, frames - i, leftGain, rightGain);
+}
+
+void ramp(float *samples, unsigned int frames, float beginGain, float gainStep)
+{
+    static const float firstIndexes[4] = {0.0f, 1.0f, 2.0f, 3.0f};
+    const float32x4_t begin = vdupq_n_f32(beginGain);
+    const float32x4_t step = vdupq_n_f32(gainStep);
+    const float32x4_t four = vdupq_n_f32(4.0f);
+    float32x4_t index = vld1q_f32(firstIndexes);
+    unsigned int i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        const float32x4_t gain = vmlaq_f32(begin, index, step);
+        vst1q_f32(samples + i, vmulq_f32(vld1q_f32(samples + i), gain));
+        index = vaddq_f32(index, four);
+    }
+
+    scalar::ramp(samples + i, frames - i, beginGain + i * gainStep, gainStep);
+}
+
+void mixAdd(float *dest, const float *source, unsigned int frames)
+{
+    unsigned int i = 0;
+    for (; i + 4 <= frames; i += 4)
+        vst1q_f32(dest + i, vaddq_f32(vld1q_f32(dest + i), vld1q_f32(source + i)));
+
+    scalar::mixAdd(dest + i, source + i, frames - i);
+}
+
+void mixAddMonoToStereo(float *left, float *right, const float *source, unsigned int frames)
+{
+    unsigned int i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        const float32x4_t s = vld1q_f32(source + i);
+        vst1q_f32(left + i, vaddq_f32(vld1q_f32(left + i), s));
+        vst1q_f32(right + i, vaddq_f32(vld1q_f32(right + i), s));
+    }
+
+    scalar::mixAddMonoToStereo(left + i, right + i, source + i, frames - i);
+}
+
+void downMixToMono(float *dest, const float *left, const float *right, unsigned int frames)
+{
+    const float32x4_t half = vdupq_n_f32(0.5f);
+    unsigned int i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        const float32x4_t sum = vaddq_f32(vld1q_f32(left + i), vld1q_f32(right + i));
+        vst1q_f32(dest + i, vmulq_f32(sum, half));
+    }
+
+    scalar::downMixToMono(dest + i, left + i, right + i, frames - i);
+}
+
+float peakAndSquaredSum(const float *samples, unsigned int frames, float *squaredSum)
+{
+    float32x4_t peaks = vdupq_n_f32(0.0f);
+    float32x4_t sums = vdupq_n_f32(0.0f);
+    unsigned int i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        const float32x4_t abs = vabsq_f32(vld1q_f32(samples + i));
+        peaks = vmaxq_f32(peaks, abs);
+        sums = vmlaq_f32(sums, abs, abs);
+    }
+
+    float sum = horizontalSum(sums);
+    float peak = scalar::peakAndSquaredSum(samples + i, frames - i, &sum);
+    const float vectorPeak = horizontalMax(peaks);
+    *squaredSum += sum;
+    return vectorPeak > peak ? vectorPeak : peak;
+}
+
+float dotProduct(const float *a, const float *b, unsigned int frames)
+{
+    float32x4_t sums = vdupq_n_f32(0.0f);
+    unsigned int i = 0;
+    for (; i + 4 <= frames; i += 4)
+        sums = vmlaq_f32(sums, vld1q_f32(a + i), vld1q_f32(b + i));
+
+    return horizontalSum(sums) + scalar::dotProduct(a + i, b + i, frames - i);
+}
+
+void int16ToFloat(float *dest, const std::int16_t *source, unsigned int count, float scale)
+{
+    unsigned int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const int16x8_t samples = vld1q_s16(source + i);
+        vst1q_f32(dest + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(samples))), scale));
+        vst1q_f32(dest + i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(samples))), scale));
+    }
+
+    scalar::int16ToFloat(dest + i, source + i, count - i, scale);
+}
+
+void int32ToFloat(float *dest, const std::int32_t *source, unsigned int count, float scale)
+{
+    unsigned int i = 0;
+    for (; i + 4 <= count; i += 4)
+        vst1q_f32(dest + i, vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(source + i)), scale));
+
+    scalar::int32ToFloat(dest + i, source + i, count - i, scale);
+}
+
+void deinterleaveStereo(float *left, float *right, const float *interleaved, unsigned int frames)
+{
+    unsigned int i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        const float32x4x2_t samples = vld2q_f32(interleaved + i * 2);
+        vst1q_f32(left + i, samples.val[0]);
+        vst1q_f32(right + i, samples.val[1]);
+    }
+
+    scalar::deinterleaveStereo(left + i, right + i, interleaved + i * 2, frames - i);
+}
+
+} // namespace neon
+
+#endif // SIMD_HAS_NEON
+
+// ----------------------------------------------------------------------------
+
+const Kernels &scalarKernels()
+{
+    static const Kernels kernels = {
+        "scalar",
+        scalar::scale,
+        scalar::scaleStereo,
+        scalar::ramp,
+        scalar::mixAdd,
+        scalar::mixAddMonoToStereo,
+        scalar::downMixToMono,
+        scalar::peakAndSquaredSum,
+        scalar::dotProduct,
+        scalar::int16ToFloat,
+        scalar::int32ToFloat,
+        scalar::deinterleaveStereo
+    };
+    return kernels;
+}
+
+static const Kernels &detectKernels()
+{
+#ifdef SIMD_HAS_AVX2
+    if (avx2::isSupported()) {
+        static const Kernels kernels = {
+            "AVX2",
+            avx2::scale,
+            avx2::scaleStereo,
+            avx2::ramp,
+            avx2::mixAdd,
+            avx2::mixAddMonoToStereo,
+            avx2::downMixToMono,
+            avx2::peakAndSquaredSum,
+            avx2::dotProduct,
+            avx2::int16ToFloat,
+            avx2::int32ToFloat,
+            avx2::deinterleaveStereo
+        };
+        return kernels;
+    }
+#endif
+
+#ifdef SIMD_HAS_SSE2
+    static const Kernels kernels = {
+        "SSE2",
+        sse2::scale,
+        sse2::scaleStereo,
+        sse2::ramp,
+        sse2::mixAdd,
+        sse2::mixAddMonoToStereo,
+        sse2::downMixToMono,
+        sse2::peakAndSquaredSum,
+        sse2::dotProduct,
+        sse2::int16ToFloat,
+        sse2::int32ToFloat,
+        sse2::deinterleaveStereo
+    };
+    return kernels;
+#elif defined(SIMD_HAS_NEON)
+    static const Kernels kernels = {
+        "NEON",
+        neon::scale,
+        neon::scaleStereo,
+        neon::ramp,
+        neon::mixAdd,
+        neon::mixAddMonoToStereo,
+        neon::downMixToMono,
+        neon::peakAndSquaredSum,
+        neon::dotProduct,
+        neon::int16ToFloat,
+        neon::int32ToFloat,
+        neon::deinterleaveStereo
+    };
+    return kernels;
+#else
+    return scalarKernels();
+#endif
+}
+
+const Kernels &kernels()
+{
+    static const Kernels &selected = detectKernels(); // thread safe initialization in C++11
+    return selected;
+}
+
+} // namespace simd
+
+} // namespace audio
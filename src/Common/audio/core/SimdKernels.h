@@ -0,0 +1,75 @@
+#ifndef SIMD_KERNELS_H
+#define SIMD_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace audio
+{
+
+namespace simd
+{
+
+/** Alignment (in bytes) used by the planar sample storage. 32 bytes is the AVX register size. */
+static const std::size_t ALIGNMENT = 32;
+
+/** How many floats fit in one ALIGNMENT block. Channel strides are rounded up to this. */
+static const unsigned int FLOATS_PER_ALIGNMENT = ALIGNMENT / sizeof(float);
+
+float *alignedAlloc(std::size_t floats);
+void alignedFree(float *ptr);
+
+/** Round 'frames' up to the next multiple of FLOATS_PER_ALIGNMENT */
+unsigned int alignedStride(unsigned int frames);
+
+/**
+ * Table of the sample processing kernels used by SamplesBuffer. All functions are
+ * safe with unaligned pointers, the aligned storage just makes them faster.
+ */
+struct Kernels
+{
+    const char *name;
+
+    // samples[i] *= gain
+    void (*scale)(float *samples, unsigned int frames, float gain);
+
+    // left[i] *= leftGain, right[i] *= rightGain (gain with pan in one pass)
+    void (*scaleStereo)(float *left, float *right, unsigned int frames, float leftGain, float rightGain);
+
+    // samples[i] *= beginGain + i * gainStep
+    void (*ramp)(float *samples, unsigned int frames, float beginGain, float gainStep);
+
+    // dest[i] += source[i]
+    void (*mixAdd)(float *dest, const float *source, unsigned int frames);
+
+    // left[i] += source[i], right[i] += source[i] (mono to stereo up-mix)
+    void (*mixAddMonoToStereo)(float *left, float *right, const float *source, unsigned int frames);
+
+    // dest[i] = (left[i] + right[i]) * 0.5 (stereo to mono down-mix)
+    void (*downMixToMono)(float *dest, const float *left, const float *right, unsigned int frames);
+
+    // returns max(abs(samples[i])) and accumulates sum(samples[i]^2) in 'squaredSum'
+    float (*peakAndSquaredSum)(const float *samples, unsigned int frames, float *squaredSum);
+
+    // returns sum(a[i] * b[i]) (FIR filters)
+    float (*dotProduct)(const float *a, const float *b, unsigned int frames);
+
+    // dest[i] = source[i] * scale (integer PCM to float, 'count' samples in any channel layout)
+    void (*int16ToFloat)(float *dest, const std::int16_t *source, unsigned int count, float scale);
+    void (*int32ToFloat)(float *dest, const std::int32_t *source, unsigned int count, float scale);
+
+    // left[i] = interleaved[i * 2], right[i] = interleaved[i * 2 + 1]
+    void (*deinterleaveStereo)(float *left, float *right, const float *interleaved, unsigned int frames);
+};
+
+/** Plain C++ kernels, always available. */
+const Kernels &scalarKernels();
+
+/** Best kernels for the running CPU (AVX2, SSE2, NEON or scalar), detected once. */
+const Kernels &kernels();
+
+} // namespace simd
+
+} // namespace audio
+
+#endif // SIMD_KERNELS_H
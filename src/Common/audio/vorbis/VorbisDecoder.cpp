@@ -15,7 +15,11 @@ using vorbis::Decoder;
 Decoder::Decoder() :
       internalBuffer(2, 4096),
       initialized(false),
-      vorbisInput()
+      pendingInput(32),
+      currentInputPosition(0),
+      inputBytesAdded(0),
+      inputBytesConsumed(0),
+      inputComplete(true)
 {
     vorbisFile.vi = nullptr;
 }
@@ -55,13 +59,32 @@ int Decoder::getSampleRate() const
 
 //+++++++++++++++++++++++++++++++++++++++++++
 size_t Decoder::consumeTo(void *oggOutBuffer, size_t bytesToConsume){
-    size_t len = qMin( bytesToConsume, (size_t)vorbisInput.size());
-    if (len > 0) {
-        memcpy(oggOutBuffer, vorbisInput.data(), len);
-        vorbisInput.remove(0, (uint)len);
+    char *out = static_cast<char *>(oggOutBuffer);
+    size_t consumed = 0;
+    while (consumed < bytesToConsume) {
+        if (currentInputPosition >= currentInput.size()) { // current chunk consumed, moving to the next one
+            currentInputPosition = 0;
+            if (!pendingInput.try_dequeue(currentInput)) {
+                currentInput.clear();
+                break;
+            }
+            continue;
+        }
+
+        size_t len = qMin(bytesToConsume - consumed, (size_t)(currentInput.size() - currentInputPosition));
+        memcpy(out + consumed, currentInput.constData() + currentInputPosition, len);
+        currentInputPosition += (int)len;
+        consumed += len;
     }
 
-    return len;
+    inputBytesConsumed += consumed;
+
+    return consumed;
+}
+
+qint64 Decoder::getAvailableInputBytes() const
+{
+    return inputBytesAdded.load(std::memory_order_acquire) - inputBytesConsumed;
 }
 
 //vorbisfile read callback
@@ -87,13 +110,16 @@ const audio::SamplesBuffer &Decoder::decode(int maxSamplesToDecode)
 
     static const int MIN_BUFFER_SIZE = 8192;
 
-    if (!initialized && vorbisInput.size() >= MIN_BUFFER_SIZE) {
+    // loaded before reading, all the input was added when a complete input is exhausted
+    bool complete = inputComplete.load(std::memory_order_acquire);
+
+    if (!initialized && (getAvailableInputBytes() >= MIN_BUFFER_SIZE || (complete && getAvailableInputBytes() > 0))) {
 
         initialize();
     }
 
     if (!initialized) {
-        //qDebug() << "Not initialized, input size: " << vorbisInput.size();
+        //qDebug() << "Not initialized, input size: " << getAvailableInputBytes();
         return audio::SamplesBuffer::ZERO_BUFFER;
     }
 
@@ -123,7 +149,7 @@ const audio::SamplesBuffer &Decoder::decode(int maxSamplesToDecode)
     else {
         internalBuffer.zero();
         //qDebug() << "FINISHED EOF";
-        finished = true; // when ov_read_float return 0 is EOF
+        finished = complete; // when ov_read_float return 0 is EOF, or the streamed input is waiting for more data
     }
 
     return internalBuffer;
@@ -131,17 +157,32 @@ const audio::SamplesBuffer &Decoder::decode(int maxSamplesToDecode)
 
 void Decoder::setInputData(const QByteArray &vorbisData)
 {
-    vorbisInput.clear();
-    vorbisInput.append(vorbisData);
+    QByteArray discarded;
+    while (pendingInput.try_dequeue(discarded))
+        ; // nothing
+
+    currentInput = vorbisData; // implicitly shared, no copy
+    currentInputPosition = 0;
+    inputBytesConsumed = 0;
+    inputBytesAdded.store(vorbisData.size(), std::memory_order_release);
     //qDebug() << "Input data setted to " << vorbisData.left(32);
 }
 
 void Decoder::addInputData(const QByteArray &vorbisData)
 {
-    vorbisInput.append(vorbisData);
+    if (vorbisData.isEmpty())
+        return;
+
+    pendingInput.enqueue(vorbisData);
+    inputBytesAdded.fetch_add(vorbisData.size(), std::memory_order_release);
     //qDebug() << vorbisData.size() << " bytes appended";
 }
 
+void Decoder::setInputComplete(bool complete)
+{
+    inputComplete.store(complete, std::memory_order_release);
+}
+
 bool Decoder::initialize()
 {
     //qDebug() << "trying to initialize initialized: " << initialized;
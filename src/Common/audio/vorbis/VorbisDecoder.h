@@ -3,7 +3,9 @@
 
 #include <vorbis/vorbisfile.h>
 #include "audio/core/SamplesBuffer.h"
+#include "audio/readerwriterqueue.h"
 #include <QByteArray>
+#include <atomic>
 
 namespace vorbis {
 
@@ -26,10 +28,18 @@ public:
 
     bool isInitialized() const;
 
+    // setInputData() must be called before the decoding starts, addInputData() can be called
+    // (from one producer thread) while another thread is decoding, no locks are required
     void setInputData(const QByteArray &vorbisData);
 
     void addInputData(const QByteArray &vorbisData);
 
+    // a streamed input (not complete) is never finished when the available input is consumed, decode()
+    // returns an empty buffer while waiting for more input. The input is complete by default.
+    void setInputComplete(bool complete);
+
+    qint64 getAvailableInputBytes() const;
+
     bool initialize();
 
     bool isFinished() const { return finished; }
@@ -41,7 +51,15 @@ private:
     audio::SamplesBuffer internalBuffer;
     OggVorbis_File vorbisFile;
     bool initialized;
-    QByteArray vorbisInput;
+
+    // encoded chunks are consumed using a read cursor, avoiding erase the front of a big QByteArray
+    moodycamel::ReaderWriterQueue<QByteArray> pendingInput;
+    QByteArray currentInput;
+    int currentInputPosition;
+    std::atomic<qint64> inputBytesAdded;
+    qint64 inputBytesConsumed;
+    std::atomic<bool> inputComplete;
+
     static size_t readOgg(void *oggOutBuffer, size_t size, size_t nmemb, void *decoderInstance);
 
     size_t consumeTo(void *oggOutBuffer, size_t bytesToConsume);
@@ -0,0 +1,51 @@
+#include "FileReader.h"
+
+using audio::FileReader;
+using audio::SamplesBuffer;
+
+bool FileReader::read(const QString &filePath, SamplesBuffer &outBuffer, quint32 &sampleRate)
+{
+    if (!open(filePath))
+        return false;
+
+    sampleRate = getSampleRate();
+
+    if (getChannels() == 1)
+        outBuffer.setToMono();
+    else
+        outBuffer.setToStereo();
+
+    const uint maxFrames = outBuffer.getFrameLenght(); // zero = no limit
+    const quint64 totalFrames = getTotalFrames();
+    uint decodedFrames = 0;
+
+    if (totalFrames > 0) { // the size is known, decoding directly in the final buffer
+        const uint framesToDecode = maxFrames > 0 ? qMin(static_cast<quint64>(maxFrames), totalFrames) : static_cast<uint>(totalFrames);
+        outBuffer.setFrameLenght(framesToDecode);
+        while (decodedFrames < framesToDecode) {
+            const uint frames = readFrames(outBuffer, decodedFrames, framesToDecode - decodedFrames);
+            if (!frames)
+                break;
+
+            decodedFrames += frames;
+        }
+    }
+    else {
+        const uint CHUNK_SIZE = 16384;
+        while (maxFrames == 0 || decodedFrames < maxFrames) {
+            const uint framesToDecode = maxFrames > 0 ? qMin(CHUNK_SIZE, maxFrames - decodedFrames) : CHUNK_SIZE;
+            outBuffer.setFrameLenght(decodedFrames + framesToDecode); // growing like a std::vector
+            const uint frames = readFrames(outBuffer, decodedFrames, framesToDecode);
+            if (!frames)
+                break;
+
+            decodedFrames += frames;
+        }
+    }
+
+    outBuffer.setFrameLenght(decodedFrames);
+
+    close();
+
+    return true;
+}
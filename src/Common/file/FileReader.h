@@ -10,8 +10,22 @@ class FileReader
 {
 
 public:
-    virtual bool read(const QString &filePath, SamplesBuffer& outBuffer, quint32 &sampleRate) = 0;
     virtual ~FileReader(){}
+
+    // Decode the entire file. When 'outBuffer' is not empty only outBuffer.getFrameLenght() frames are decoded.
+    virtual bool read(const QString &filePath, SamplesBuffer& outBuffer, quint32 &sampleRate);
+
+    // Streaming interface: open() parses the file headers and readFrames() decodes the next frames, so
+    // the callers can use the first samples before the entire file is decoded.
+    virtual bool open(const QString &filePath) = 0;
+    virtual void close() = 0;
+
+    // decode up to 'maxFrames' frames in 'outBuffer' (starting in 'outOffset'), returns the decoded frames or zero in the end of file
+    virtual uint readFrames(SamplesBuffer &outBuffer, uint outOffset, uint maxFrames) = 0;
+
+    virtual quint32 getSampleRate() const = 0;
+    virtual int getChannels() const = 0;
+    virtual quint64 getTotalFrames() const = 0; // zero when unknown before decode the entire file (compressed formats)
 };
 
 } // namespace
@@ -20,6 +20,42 @@ public:
 
         return false;
     }
+
+    inline bool open(const QString &filePath) override
+    {
+        Q_UNUSED(filePath)
+
+        return false;
+    }
+
+    inline void close() override
+    {
+
+    }
+
+    inline uint readFrames(audio::SamplesBuffer &outBuffer, uint outOffset, uint maxFrames) override
+    {
+        Q_UNUSED(outBuffer)
+        Q_UNUSED(outOffset)
+        Q_UNUSED(maxFrames)
+
+        return 0;
+    }
+
+    inline quint32 getSampleRate() const override
+    {
+        return 0;
+    }
+
+    inline int getChannels() const override
+    {
+        return 0;
+    }
+
+    inline quint64 getTotalFrames() const override
+    {
+        return 0;
+    }
 };
 
 std::unique_ptr<FileReader> FileReaderFactory::createFileReader(const QString &filePath)
@@ -1,41 +1,122 @@
 #include "Mp3FileReader.h"
 #include "audio/Mp3Decoder.h"
 
-#include <QFile>
 #include <QDebug>
+#include <cstring>
 
 using audio::Mp3FileReader;
 using audio::SamplesBuffer;
 
-bool Mp3FileReader::read(const QString &filePath, SamplesBuffer &outBuffer, quint32 &sampleRate)
+Mp3FileReader::Mp3FileReader() :
+    encodedData(nullptr),
+    encodedSize(0),
+    encodedPosition(0),
+    decodedSamples(2),
+    decodedPosition(0),
+    sampleRate(0),
+    channels(0)
 {
+
+}
+
+Mp3FileReader::~Mp3FileReader()
+{
+    close();
+}
+
+bool Mp3FileReader::open(const QString &filePath)
+{
+    close();
+
     // Open the mp3 file
-    QFile audioFile(filePath);
-    if (!audioFile.open(QFile::ReadOnly)) {
+    file.setFileName(filePath);
+    if (!file.open(QFile::ReadOnly)) {
         qCritical() << "Failed to open mp3 file ..." << filePath;
         return false;
     }
 
-    audio::Mp3DecoderMiniMp3 decoder;
-    QByteArray encodedData = audioFile.readAll();
-
-    const quint64 totalBytesToProcess = encodedData.size();
-    uint bytesProcessed = 0;
-    const static int MAX_BYTES_PER_DECODING = 2048;         // chunks maxsize is 2048 bytes
+    encodedSize = file.size();
+    encodedData = reinterpret_cast<const char *>(file.map(0, encodedSize));
+    if (!encodedData) { // some file systems can't map files
+        fileContent = file.readAll();
+        encodedData = fileContent.constData();
+    }
 
-    SamplesBuffer bufferedSamples(2);
+    decoder.reset(new audio::Mp3DecoderMiniMp3());
 
-    while (bytesProcessed < totalBytesToProcess) { // split in chunks to avoid a very large decoded buffer
-        int bytesToProcess = std::min((int)(totalBytesToProcess - bytesProcessed), MAX_BYTES_PER_DECODING);
-        const auto &decodedBuffer = decoder.decode(encodedData.data() + bytesProcessed, bytesToProcess);
-        // +++++++++++++++++  PROCESS DECODED SAMPLES ++++++++++++++++
-        bufferedSamples.append(decodedBuffer);
-        bytesProcessed += bytesToProcess;
+    // the sample rate and channels are known after the first decoded frames
+    if (!decodeNextChunk()) {
+        qCritical() << "Error loading " << filePath << ", no mp3 frames decoded!";
+        close();
+        return false;
     }
 
-    sampleRate = decoder.getSampleRate();
-    outBuffer.setFrameLenght(bufferedSamples.getFrameLenght());
-    outBuffer.set(bufferedSamples);
+    sampleRate = decoder->getSampleRate();
+    channels = decodedSamples.getChannels();
 
     return true;
 }
+
+void Mp3FileReader::close()
+{
+    decoder.reset();
+
+    if (file.isOpen())
+        file.close(); // the mapped memory is released when the file is closed
+
+    fileContent.clear();
+    encodedData = nullptr;
+    encodedSize = 0;
+    encodedPosition = 0;
+    decodedSamples.setFrameLenght(0);
+    decodedPosition = 0;
+    sampleRate = 0;
+    channels = 0;
+}
+
+bool Mp3FileReader::decodeNextChunk()
+{
+    const static quint64 MAX_BYTES_PER_DECODING = 2048; // split in chunks to avoid a very large decoded buffer
+
+    while (encodedPosition < encodedSize) {
+        const int bytesToProcess = static_cast<int>(qMin(encodedSize - encodedPosition, MAX_BYTES_PER_DECODING));
+
+        // the decoder is copying the input bytes, the mapped memory is not changed
+        const SamplesBuffer &decodedBuffer = decoder->decode(const_cast<char *>(encodedData + encodedPosition), bytesToProcess);
+        encodedPosition += bytesToProcess;
+
+        if (!decodedBuffer.isEmpty()) {
+            decodedSamples = decodedBuffer;
+            decodedPosition = 0;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+uint Mp3FileReader::readFrames(SamplesBuffer &outBuffer, uint outOffset, uint maxFrames)
+{
+    if (!decoder || outOffset >= outBuffer.getFrameLenght())
+        return 0;
+
+    maxFrames = qMin(maxFrames, outBuffer.getFrameLenght() - outOffset);
+
+    uint framesRead = 0;
+    while (framesRead < maxFrames) {
+        if (decodedPosition >= decodedSamples.getFrameLenght() && !decodeNextChunk())
+            break; // end of file
+
+        const uint frames = qMin(maxFrames - framesRead, decodedSamples.getFrameLenght() - decodedPosition);
+        for (int c = 0; c < outBuffer.getChannels(); ++c) {
+            const int sourceChannel = qMin(c, decodedSamples.getChannels() - 1);
+            std::memcpy(outBuffer.getSamplesArray(c) + outOffset + framesRead,
+                        decodedSamples.getSamplesArray(sourceChannel) + decodedPosition, frames * sizeof(float));
+        }
+
+        decodedPosition += frames;
+        framesRead += frames;
+    }
+
+    return framesRead;
+}
@@ -3,16 +3,61 @@
 
 #include "FileReader.h"
 
+#include <QFile>
+#include <QByteArray>
+#include <memory>
+
 namespace audio {
 
+class Mp3Decoder;
+
 class Mp3FileReader : public FileReader
 {
 
 public:
-    bool read(const QString &filePath, audio::SamplesBuffer &outBuffer, quint32 &sampleRate) override;
+    Mp3FileReader();
+    ~Mp3FileReader();
+
+    bool open(const QString &filePath) override;
+    void close() override;
+    uint readFrames(SamplesBuffer &outBuffer, uint outOffset, uint maxFrames) override;
+
+    quint32 getSampleRate() const override;
+    int getChannels() const override;
+    quint64 getTotalFrames() const override;
+
+private:
+    QFile file;
+    QByteArray fileContent; // used only when the file can't be mapped
+    const char *encodedData; // mapped file
+    quint64 encodedSize;
+    quint64 encodedPosition;
+
+    std::unique_ptr<Mp3Decoder> decoder;
+    SamplesBuffer decodedSamples; // decoded but not readed yet
+    uint decodedPosition;
+
+    quint32 sampleRate;
+    int channels;
 
+    bool decodeNextChunk();
 };
 
+inline quint32 Mp3FileReader::getSampleRate() const
+{
+    return sampleRate;
+}
+
+inline int Mp3FileReader::getChannels() const
+{
+    return channels;
+}
+
+inline quint64 Mp3FileReader::getTotalFrames() const
+{
+    return 0; // unknown, mp3 files can use variable bit rate
+}
+
 } // namespace
 
 #endif // MP3FILEREADER_H
@@ -1,42 +1,92 @@
 #include "OggFileReader.h"
 #include <QDebug>
-#include <QFile>
-#include <QFileInfo>
+#include <cstring>
 #include "audio/vorbis/VorbisDecoder.h"
 
 using audio::OggFileReader;
 using audio::SamplesBuffer;
 
-bool OggFileReader::read(const QString &filePath, SamplesBuffer &outBuffer, quint32 &sampleRate)
+OggFileReader::OggFileReader()
 {
+
+}
+
+OggFileReader::~OggFileReader()
+{
+    close();
+}
+
+bool OggFileReader::open(const QString &filePath)
+{
+    close();
+
     // Open the ogg file
-    QFile oggFile(filePath);
-    if (!oggFile.open(QFile::ReadOnly)) {
+    file.setFileName(filePath);
+    if (!file.open(QFile::ReadOnly)) {
         qWarning() << "Failed to open OGG file ..." << filePath;
         return false;
     }
 
-    vorbis::Decoder decoder;
-    decoder.setInputData(oggFile.readAll());
-    decoder.initialize(); // read the ogg headers from file
-    sampleRate = decoder.getSampleRate();
-    if (decoder.isMono())
-        outBuffer.setToMono();
+    const qint64 fileSize = file.size();
+    const uchar *mappedData = file.map(0, fileSize);
+    if (mappedData)
+        fileContent = QByteArray::fromRawData(reinterpret_cast<const char *>(mappedData), fileSize); // no copy
     else
-        outBuffer.setToStereo();
-
-    // decode and append decoded data in 'outBuffer'
-    int decodedFrames = 0;
-    const int MAX_SAMPLES_PER_DECODE = 1024;
-    do
-    {
-        const auto &decodedBuffer = decoder.decode(MAX_SAMPLES_PER_DECODE);
-        decodedFrames = decodedBuffer.getFrameLenght();
-        if (!decodedBuffer.isEmpty()) {
-            outBuffer.append(decodedBuffer);
-        }
+        fileContent = file.readAll(); // some file systems can't map files
+
+    decoder.reset(new vorbis::Decoder());
+    decoder->setInputData(fileContent);
+    if (!decoder->initialize()) { // read the ogg headers from file
+        qWarning() << "Error loading " << filePath << ", invalid OGG file!";
+        close();
+        return false;
     }
-    while(decodedFrames > 0);
 
     return true;
 }
+
+void OggFileReader::close()
+{
+    decoder.reset(); // releasing the reference to the mapped data before unmap
+
+    fileContent.clear();
+
+    if (file.isOpen())
+        file.close(); // the mapped memory is released when the file is closed
+}
+
+quint32 OggFileReader::getSampleRate() const
+{
+    return decoder ? decoder->getSampleRate() : 0;
+}
+
+int OggFileReader::getChannels() const
+{
+    return decoder ? decoder->getChannels() : 0;
+}
+
+uint OggFileReader::readFrames(SamplesBuffer &outBuffer, uint outOffset, uint maxFrames)
+{
+    if (!decoder || outOffset >= outBuffer.getFrameLenght())
+        return 0;
+
+    maxFrames = qMin(maxFrames, outBuffer.getFrameLenght() - outOffset);
+
+    const uint MAX_SAMPLES_PER_DECODE = 4096;
+    uint framesRead = 0;
+    while (framesRead < maxFrames) {
+        const auto &decodedBuffer = decoder->decode(qMin(maxFrames - framesRead, MAX_SAMPLES_PER_DECODE));
+        const uint frames = decodedBuffer.getFrameLenght();
+        if (!frames)
+            break; // end of file
+
+        for (int c = 0; c < outBuffer.getChannels(); ++c) { // the decoded buffer is always stereo
+            std::memcpy(outBuffer.getSamplesArray(c) + outOffset + framesRead,
+                        decodedBuffer.getSamplesArray(qMin(c, 1)), frames * sizeof(float));
+        }
+
+        framesRead += frames;
+    }
+
+    return framesRead;
+}
@@ -3,16 +3,42 @@
 
 #include "FileReader.h"
 
+#include <QFile>
+#include <QByteArray>
+#include <memory>
+
+namespace vorbis {
+class Decoder;
+}
+
 namespace audio {
 
 class OggFileReader : public FileReader
 {
 
 public:
-    bool read(const QString &filePath, audio::SamplesBuffer &outBuffer, quint32 &sampleRate) override;
+    OggFileReader();
+    ~OggFileReader();
+
+    bool open(const QString &filePath) override;
+    void close() override;
+    uint readFrames(SamplesBuffer &outBuffer, uint outOffset, uint maxFrames) override;
 
+    quint32 getSampleRate() const override;
+    int getChannels() const override;
+    quint64 getTotalFrames() const override;
+
+private:
+    QFile file;
+    QByteArray fileContent; // the mapped file (not copied) or the entire file when the mapping is not possible
+    std::unique_ptr<vorbis::Decoder> decoder;
 };
 
+inline quint64 OggFileReader::getTotalFrames() const
+{
+    return 0; // unknown, the vorbis decoder can't seek in the input data
+}
+
 } // namespace
 
 #endif // OGGFILEREADER_H
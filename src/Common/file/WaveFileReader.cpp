@@ -1,222 +1,239 @@
 #include "WaveFileReader.h"
+#include "audio/core/SimdKernels.h"
+
 #include <QDebug>
-#include <QFile>
-#include <QFileInfo>
-#include <cmath>
 #include <QtEndian>
-#include <QDataStream>
-#include <memory>
+#include <cstring>
 
 using audio::SamplesBuffer;
 using audio::WaveFileReader;
 
-class SampleExtractor
-{
+namespace {
 
-public:
-    explicit SampleExtractor(QDataStream *stream) :
-        stream(stream)
-    {
-    }
-    
-    virtual ~SampleExtractor()
-    {
-        
-    }
+const quint16 WAVE_FORMAT_PCM = 1;
+const quint16 WAVE_FORMAT_IEEE_FLOAT = 3;
+const quint16 WAVE_FORMAT_EXTENSIBLE = 0xFFFE;
 
-    virtual float nextSample() = 0;
+inline quint16 readUInt16(const uchar *data)
+{
+    return qFromLittleEndian<quint16>(data);
+}
 
-protected:
-    QDataStream *stream;
-};
+inline quint32 readUInt32(const uchar *data)
+{
+    return qFromLittleEndian<quint32>(data);
+}
 
-class SampleExtractor16Bits : public SampleExtractor
+inline bool chunkIdIs(const uchar *data, const char *id)
 {
-    public:
+    return std::memcmp(data, id, 4) == 0;
+}
 
-        explicit SampleExtractor16Bits(QDataStream *stream)
-            :SampleExtractor(stream)
-        {
+} // namespace
 
-        }
+WaveFileReader::WaveFileReader() :
+    samplesData(nullptr),
+    format(Int16),
+    channels(0),
+    sampleRate(0),
+    totalFrames(0),
+    currentFrame(0)
+{
 
-        float nextSample() override
-        {
-            qint16 sampleValue;
-            *stream >> sampleValue;
-            return sampleValue / 32767.0f;
-        }
-};
+}
 
-class SampleExtractor32Bits : public SampleExtractor
+WaveFileReader::~WaveFileReader()
 {
-    public:
-        explicit SampleExtractor32Bits(QDataStream *stream)
-            :SampleExtractor(stream)
-        {
+    close();
+}
 
-        }
+bool WaveFileReader::open(const QString &filePath)
+{
+    close();
 
-        float nextSample() override
-        {
-            char buffer[4];
-            stream->readRawData(buffer, 4);
+    file.setFileName(filePath);
+    if (!file.open(QFile::ReadOnly)) {
+        qCritical() << "Failed to open WAV file ..." << filePath;
+        return false;
+    }
 
-            float sample = 0;
-            memcpy(&sample, &buffer, sizeof(sample));
-            return sample;
-        }
-};
+    const quint64 fileSize = file.size();
+    const uchar *data = file.map(0, fileSize);
+    if (!data) { // some file systems can't map files
+        fileContent = file.readAll();
+        data = reinterpret_cast<const uchar *>(fileContent.constData());
+    }
 
-class SampleExtractor24Bits : public SampleExtractor
-{
-    public:
-        explicit SampleExtractor24Bits(QDataStream *stream)
-            :SampleExtractor(stream)
-        {
+    if (!data || !parseHeaders(data, fileSize)) {
+        qCritical() << "Error loading " << filePath << ", invalid or unsupported WAV file!";
+        close();
+        return false;
+    }
 
-        }
+    return true;
+}
 
-        float nextSample() override
-        {
-            char buffer[3];
-            stream->readRawData(buffer, 3);
-            return ((buffer[0] & 0xFF) | ((buffer[1] & 0xFF) << 8) | (buffer[2] << 16)) / 8388606.0F;
-        }
-};
+void WaveFileReader::close()
+{
+    if (file.isOpen())
+        file.close(); // the mapped memory is released when the file is closed
+
+    fileContent.clear();
+    samplesData = nullptr;
+    channels = 0;
+    sampleRate = 0;
+    totalFrames = 0;
+    currentFrame = 0;
+}
 
-class SampleExtractor8Bits : public SampleExtractor
+bool WaveFileReader::parseHeaders(const uchar *data, quint64 size)
 {
-    public:
-        explicit SampleExtractor8Bits(QDataStream *stream)
-            :SampleExtractor(stream)
-        {
+    if (size < 12 || !chunkIdIs(data, "RIFF") || !chunkIdIs(data + 8, "WAVE"))
+        return false;
 
+    quint16 formatTag = 0;
+    quint16 bitsPerSample = 0;
+    bool formatFound = false;
+
+    quint64 position = 12;
+    while (position + 8 <= size) {
+        const uchar *chunk = data + position;
+        const quint64 chunkSize = readUInt32(chunk + 4);
+        const uchar *chunkData = chunk + 8;
+        const quint64 availableBytes = size - position - 8;
+
+        if (chunkIdIs(chunk, "fmt ") && chunkSize >= 16 && availableBytes >= 16) {
+            formatTag = readUInt16(chunkData);
+            channels = readUInt16(chunkData + 2);
+            sampleRate = readUInt32(chunkData + 4);
+            bitsPerSample = readUInt16(chunkData + 14);
+            if (formatTag == WAVE_FORMAT_EXTENSIBLE && chunkSize >= 26 && availableBytes >= 26)
+                formatTag = readUInt16(chunkData + 24); // first bytes of the sub format GUID
+
+            formatFound = true;
         }
-
-        float nextSample() override
-        {
-            qint8 byte;
-            *stream >> byte;
-            return byte / 127.0;
+        else if (chunkIdIs(chunk, "data")) {
+            if (!formatFound)
+                return false;
+
+            if (formatTag == WAVE_FORMAT_IEEE_FLOAT && bitsPerSample == 32)
+                format = Float32;
+            else if (formatTag == WAVE_FORMAT_PCM && bitsPerSample == 8)
+                format = Int8;
+            else if (formatTag == WAVE_FORMAT_PCM && bitsPerSample == 16)
+                format = Int16;
+            else if (formatTag == WAVE_FORMAT_PCM && bitsPerSample == 24)
+                format = Int24;
+            else if (formatTag == WAVE_FORMAT_PCM && bitsPerSample == 32)
+                format = Int32;
+            else {
+                qCritical() << "Can't handle WAV files using format" << formatTag << "and" << bitsPerSample << "bits per sample!";
+                return false;
+            }
+
+            if (channels == 0)
+                return false;
+
+            const quint64 dataSize = qMin(chunkSize, availableBytes); // truncated files are accepted
+            samplesData = chunkData;
+            totalFrames = dataSize / (channels * (bitsPerSample / 8));
+            currentFrame = 0;
+            return true;
         }
-};
 
-class NullSampleExtractor : public SampleExtractor
-{
-    public:
-        NullSampleExtractor()
-            :SampleExtractor(nullptr)
-        {
-        }
+        position += 8 + chunkSize + (chunkSize & 1); // chunks are word aligned
+    }
 
-        float nextSample() override
-        {
-            return 0.0;
-        }
-};
+    return false;
+}
 
-class SampleExtractorFactory
+void WaveFileReader::convertBlock(const uchar *source, uint samples)
 {
-public:
-    static std::unique_ptr<SampleExtractor> createExtractor(QDataStream *stream, quint8 bitsPerSample)
-    {
-        switch (bitsPerSample/8) {
-            case 1: return std::unique_ptr<SampleExtractor8Bits>(new SampleExtractor8Bits(stream));
-            case 2: return std::unique_ptr<SampleExtractor16Bits>(new SampleExtractor16Bits(stream));
-            case 3: return std::unique_ptr<SampleExtractor24Bits>(new SampleExtractor24Bits(stream));
-            case 4: return std::unique_ptr<SampleExtractor32Bits>(new SampleExtractor32Bits(stream));
-        }
-        qCritical() << "Can't create a SampleExtractor to handle " << bitsPerSample << " bits per sample!";
-        return std::unique_ptr<NullSampleExtractor>(new NullSampleExtractor());
+    // WAV samples are little endian, like all platforms supported by Jamtaba
+    const audio::simd::Kernels &kernels = audio::simd::kernels();
+    float *dest = convertedSamples.data();
+
+    // the chunks are aligned in 2 bytes only, the integers are copied if not naturally aligned
+    if ((format == Int16 || format == Int32) && reinterpret_cast<quintptr>(source) % (format == Int16 ? 2 : 4)) {
+        std::memcpy(unpackedSamples.data(), source, samples * (format == Int16 ? 2 : 4));
+        source = reinterpret_cast<const uchar *>(unpackedSamples.data());
     }
-};
 
-bool WaveFileReader::read(const QString &filePath, audio::SamplesBuffer &outBuffer, quint32 &sampleRate)
-{
-    // Open the wave file
-    QFile wavFile(filePath);
-    if (!wavFile.open(QFile::ReadOnly)) {
-        qCritical() << "Failed to open WAV file ..." << filePath;
-        return false; // Done, out buffer is not changed
+    switch (format) {
+    case Int8: // unsigned, 128 is the zero
+        for (uint s = 0; s < samples; ++s)
+            dest[s] = (static_cast<int>(source[s]) - 128) / 128.0f;
+        break;
+    case Int16:
+        kernels.int16ToFloat(dest, reinterpret_cast<const std::int16_t *>(source), samples, 1.0f / 32768.0f);
+        break;
+    case Int24: {
+        qint32 *unpacked = unpackedSamples.data();
+        for (uint s = 0; s < samples; ++s) {
+            const uchar *bytes = source + s * 3;
+            unpacked[s] = static_cast<qint32>((static_cast<quint32>(bytes[0]) << 8) | (static_cast<quint32>(bytes[1]) << 16) | (static_cast<quint32>(bytes[2]) << 24));
+        }
+        kernels.int32ToFloat(dest, unpacked, samples, 1.0f / 2147483648.0f);
+        break;
     }
-
-    // Read in the whole thing
-    QByteArray wavFileContent = wavFile.readAll();
-
-    // Define the header components
-    char fileType[4];
-    quint32 fileSize;
-    char waveName[4];
-    char fmtName[3];
-    quint32 fmtLength;
-    quint16 fmtType;
-    quint16 channels;
-    quint32 sampleRateXBitsPerSampleXChanngelsDivEight;
-    quint16 bitsPerSampleXChannelsDivEightPointOne;
-    quint16 bitsPerSample;
-    char dataHeader[4];
-    quint32 dataSize = 0;
-
-    // Create a data stream to analyze the data
-    QDataStream stream(&wavFileContent, QIODevice::ReadOnly);
-    stream.setByteOrder(QDataStream::LittleEndian);
-
-    // Now pop off the appropriate data into each header field defined above
-    stream.readRawData((char *)fileType, 4); // "RIFF"
-    if (QString::fromLocal8Bit(fileType, 4) != "RIFF") {
-        qCritical() << "Error loading " << filePath << ", 'RIFF' chunk not founded!";
-        return false;
+    case Int32:
+        kernels.int32ToFloat(dest, reinterpret_cast<const std::int32_t *>(source), samples, 1.0f / 2147483648.0f);
+        break;
+    case Float32:
+        std::memcpy(dest, source, samples * sizeof(float));
+        break;
     }
+}
 
-    stream >> fileSize; // File Size
-
-    stream.readRawData((char *)waveName, 4); // "WAVE"
-    if (QString::fromLocal8Bit(waveName, 4) != "WAVE") {
-        qCritical() << "Error loading " << filePath << ", 'WAVE' chunk not founded!";
-        return false;
-    }
+uint WaveFileReader::readFrames(SamplesBuffer &outBuffer, uint outOffset, uint maxFrames)
+{
+    if (!samplesData || currentFrame >= totalFrames)
+        return 0;
 
-    stream.readRawData((char *)fmtName, 4); // "fmt"
-    if (QString::fromLocal8Bit(fmtName, 4) != "fmt ") {
-        qCritical() << "Error loading " << filePath << ", 'fmt' chunk not founded!";
-        return false;
-    }
+    const uint outChannels = outBuffer.getChannels();
+    if (outChannels == 0 || outOffset >= outBuffer.getFrameLenght())
+        return 0;
 
-    stream >> fmtLength;  // Format length
-    stream >> fmtType;    // Format type
-    stream >> channels;   // Number of channels
-    stream >> sampleRate; // Sample rate
-    stream >> sampleRateXBitsPerSampleXChanngelsDivEight; // (Sample Rate * BitsPerSample * Channels) / 8
-    stream >> bitsPerSampleXChannelsDivEightPointOne; // (BitsPerSample * Channels) / 8.1
-    stream >> bitsPerSample; // Bits per sample
-    while (QString::fromLocal8Bit(dataHeader, 4) != "data" && !stream.atEnd()) {
-        stream.readRawData((char *)dataHeader, 4); // "data" header
-        stream >> dataSize; // Data Size
-        if (QString::fromLocal8Bit(dataHeader, 4) != "data")
-            stream.skipRawData(dataSize);
-    }
+    maxFrames = qMin(maxFrames, outBuffer.getFrameLenght() - outOffset);
+    const uint framesToRead = static_cast<uint>(qMin(static_cast<quint64>(maxFrames), totalFrames - currentFrame));
 
-    uint samples = dataSize / channels / (bitsPerSample/ 8);
+    const uint bytesPerSample = format == Int8 ? 1 : (format == Int16 ? 2 : (format == Int24 ? 3 : 4));
+    const uint bytesPerFrame = bytesPerSample * channels;
+    const uint framesPerBlock = qMax(BLOCK_SAMPLES / channels, 1u);
 
-    if (channels == 1)
-        outBuffer.setToMono();
-    else
-        outBuffer.setToStereo();
+    convertedSamples.resize(framesPerBlock * channels);
+    if (format != Int8 && format != Float32)
+        unpackedSamples.resize(framesPerBlock * channels);
 
-    if (outBuffer.getFrameLenght() > 0) // load only outBuffer.frameLenght samples?
-        samples = qMin(samples, outBuffer.getFrameLenght());
+    const audio::simd::Kernels &kernels = audio::simd::kernels();
 
-    outBuffer.setFrameLenght(samples);
+    uint framesRead = 0;
+    while (framesRead < framesToRead) {
+        const uint frames = qMin(framesPerBlock, framesToRead - framesRead);
+        convertBlock(samplesData + (currentFrame + framesRead) * bytesPerFrame, frames * channels);
 
-    // Now pull out the data
-    std::unique_ptr<SampleExtractor> sampleExtractor = SampleExtractorFactory::createExtractor(&stream, bitsPerSample);
-    for (uint s = 0; s < samples; ++s) {
-        for (int c = 0; c < channels; ++c) {
-            float sample = sampleExtractor->nextSample();
-            outBuffer.set(c, s, sample);
+        const float *interleaved = convertedSamples.data();
+        const uint offset = outOffset + framesRead;
+        if (channels == 1) {
+            for (uint c = 0; c < outChannels; ++c)
+                std::memcpy(outBuffer.getSamplesArray(c) + offset, interleaved, frames * sizeof(float));
+        }
+        else if (channels == 2 && outChannels == 2) {
+            kernels.deinterleaveStereo(outBuffer.getSamplesArray(0) + offset, outBuffer.getSamplesArray(1) + offset, interleaved, frames);
+        }
+        else { // using the first channels
+            for (uint c = 0; c < outChannels; ++c) {
+                float *out = outBuffer.getSamplesArray(c) + offset;
+                const uint sourceChannel = qMin(c, static_cast<uint>(channels - 1));
+                for (uint f = 0; f < frames; ++f)
+                    out[f] = interleaved[f * channels + sourceChannel];
+            }
         }
+
+        framesRead += frames;
     }
 
-    return true;
+    currentFrame += framesRead;
+
+    return framesRead;
 }
@@ -3,16 +3,75 @@
 
 #include "FileReader.h"
 
+#include <QFile>
+#include <QByteArray>
+#include <vector>
+
 namespace audio {
 
+/**
+ * The file is memory mapped (no copy of the entire file in memory) and the samples are converted in
+ * blocks using the SIMD kernels, deinterleaving directly to the planar SamplesBuffer.
+ */
 class WaveFileReader : public FileReader
 {
 
 public:
-    bool read(const QString &filePath, audio::SamplesBuffer &outBuffer, quint32 &sampleRate) override;
+    WaveFileReader();
+    ~WaveFileReader();
+
+    bool open(const QString &filePath) override;
+    void close() override;
+    uint readFrames(SamplesBuffer &outBuffer, uint outOffset, uint maxFrames) override;
+
+    quint32 getSampleRate() const override;
+    int getChannels() const override;
+    quint64 getTotalFrames() const override;
+
+private:
+    enum SampleFormat
+    {
+        Int8,
+        Int16,
+        Int24,
+        Int32,
+        Float32
+    };
+
+    QFile file;
+    QByteArray fileContent; // used only when the file can't be mapped
+    const uchar *samplesData; // first byte in 'data' chunk
+
+    SampleFormat format;
+    quint16 channels;
+    quint32 sampleRate;
+    quint64 totalFrames;
+    quint64 currentFrame;
+
+    std::vector<float> convertedSamples; // interleaved block
+    std::vector<qint32> unpackedSamples; // 24 bits samples are unpacked before the conversion, not aligned samples are copied here
 
+    bool parseHeaders(const uchar *data, quint64 size);
+    void convertBlock(const uchar *source, uint samples);
+
+    static const uint BLOCK_SAMPLES = 8192;
 };
 
+inline quint32 WaveFileReader::getSampleRate() const
+{
+    return sampleRate;
+}
+
+inline int WaveFileReader::getChannels() const
+{
+    return channels;
+}
+
+inline quint64 WaveFileReader::getTotalFrames() const
+{
+    return totalFrames;
+}
+
 } // namespace
 
-#endif // AUDIOFILEREADER_H
+#endif // WAVEFILEREADER_H
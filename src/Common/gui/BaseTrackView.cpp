@@ -36,7 +36,8 @@ BaseTrackView::BaseTrackView(MainController *mainController, long trackID) :
     trackID(trackID),
     activated(true),
     narrowed(false),
-    tintColor(Qt::black)
+    tintColor(Qt::black),
+    meterSlot(-1)
 {
     createLayoutStructure();
     setupVerticalLayout();
@@ -216,7 +217,10 @@ void BaseTrackView::updateGuiElements()
     if (!mainController)
         return;
 
-    auto peak = mainController->getTrackPeak(getTrackID());
+    if (meterSlot < 0)
+        meterSlot = mainController->getTrackMeterSlot(getTrackID());
+
+    auto peak = muteButton->isChecked() ? audio::AudioPeak() : mainController->getMeterPeak(meterSlot);
     if (peak.getMaxPeak() > maxPeak.getMaxPeak()) {
         maxPeak.update(peak);
     }
@@ -125,6 +125,7 @@ protected:
 private:
     static QMap<long, BaseTrackView *> trackViews;
     audio::AudioPeak maxPeak;
+    int meterSlot; // cached to avoid a track lookup in each frame
 
 protected slots:
     virtual void toggleMuteStatus();
@@ -30,7 +30,8 @@ LooperWindow::LooperWindow(QWidget *parent, MainController *mainController) :
     ui(new Ui::LooperWindow),
     mainController(mainController),
     looper(nullptr),
-    currentBeat(-1)
+    currentBeat(-1),
+    loopLoader(nullptr)
 {
     setWindowFlags(windowFlags() & ~Qt::WindowContextHelpButtonHint); // remove help/question marker
 
@@ -483,7 +484,7 @@ void LooperWindow::updateControls()
         ui->buttonRec->setEnabled(looper->canRecord());
 
         ui->buttonPlay->setChecked(looper->isPlaying());
-        bool canEnablePlayButton = !looper->isWaitingToRecord() && !looper->isRecording();
+        bool canEnablePlayButton = !looper->isWaitingToRecord() && !looper->isRecording() && !looper->isLoading();
         ui->buttonPlay->setEnabled(canEnablePlayButton);
 
         ui->comboBoxPlayMode->setEnabled(looper->isPlaying() || looper->isStopped());
@@ -494,7 +495,7 @@ void LooperWindow::updateControls()
         ui->saveButton->setEnabled(looper->canSave());
         ui->loadButton->setEnabled(looper->isStopped());
 
-        ui->resetButton->setEnabled(looper->isStopped() || looper->isPlaying());
+        ui->resetButton->setEnabled((looper->isStopped() || looper->isPlaying()) && !looper->isLoading());
 
         // update playing and recording options
         updateOptions<Looper::PlayingOption>(ui->groupBoxPlaying->layout());
@@ -597,7 +598,7 @@ void LooperWindow::setMaxLayerComboBoxValuesAvailability(int valuesToDisable)
 
 void LooperWindow::updateMaxLayersControls()
 {
-    ui->maxLayersComboBox->setEnabled(looper->isStopped() || looper->isPlaying());
+    ui->maxLayersComboBox->setEnabled((looper->isStopped() || looper->isPlaying()) && !looper->isLoading());
     ui->labelMaxLayers->setEnabled(ui->maxLayersComboBox->isEnabled());
     int currentMaxLayersValue = (ui->maxLayersComboBox->currentIndex() + 1);
     if (currentMaxLayersValue != looper->getLayers()) {
@@ -625,6 +626,8 @@ void LooperWindow::deleteWavePanels()
 
 LooperWindow::~LooperWindow()
 {
+    delete loopLoader; // waiting the running decoding tasks
+
     delete ui;
 
     deleteWavePanels();
@@ -997,24 +1000,47 @@ void LooperWindow::updateLayersControls()
     }
 }
 
+void LooperWindow::handleLoopLayerLoaded()
+{
+    updateLayersControls(); // update layers pan and gain after loading a layer
+
+    update();
+}
+
+void LooperWindow::handleLoopLoadingProgress(int loadedLayers, int totalLayers)
+{
+    ui->loopNameLabel->setText(tr("Loading %1/%2 ...").arg(loadedLayers).arg(totalLayers));
+}
+
+void LooperWindow::handleLoopLoadingFinished(const QString &loopName)
+{
+    updateModeComboBox();
+
+    ui->loopNameLabel->setText(loopName);
+
+    update();
+
+    if (loopLoader)
+        loopLoader->deleteLater();
+}
+
 void LooperWindow::loadLoopInfo(const QString &loopDir, const LoopInfo &loopInfo)
 {
     if (loopInfo.isValid()) {
 
         ui->loopNameLabel->setText("");
 
-        LoopLoader loader(loopDir);
-        uint currentSampleRate = mainController->getSampleRate();
-        quint32 samplesPerInterval = mainController->getNinjamController()->getSamplesPerInterval();
-        loader.load(loopInfo, looper, currentSampleRate, samplesPerInterval);
+        delete loopLoader; // canceling the previous loading, if any
 
-        updateLayersControls(); // update layers pan and gain after loading a loop
+        // the layers are decoded in parallel and installed in the looper as they are ready
+        loopLoader = new LoopLoader(loopDir, this);
+        connect(loopLoader, &LoopLoader::layerLoaded, this, &LooperWindow::handleLoopLayerLoaded);
+        connect(loopLoader, &LoopLoader::progressChanged, this, &LooperWindow::handleLoopLoadingProgress);
+        connect(loopLoader, &LoopLoader::loadingFinished, this, &LooperWindow::handleLoopLoadingFinished);
 
-        updateModeComboBox();
-
-        ui->loopNameLabel->setText(loopInfo.getName());
-
-        update();
+        uint currentSampleRate = mainController->getSampleRate();
+        quint32 samplesPerInterval = mainController->getNinjamController()->getSamplesPerInterval();
+        loopLoader->loadAsync(loopInfo, looper, currentSampleRate, samplesPerInterval);
     }
     else {
         qCritical() << "Can't load loop " << loopInfo.getName() << " in " << loopDir;
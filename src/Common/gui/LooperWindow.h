@@ -9,6 +9,7 @@
 #include <QPushButton>
 #include <QLabel>
 #include <QTimer>
+#include <QPointer>
 
 #include "looper/Looper.h"
 #include "looper/LooperPersistence.h"
@@ -69,6 +70,10 @@ private slots:
 
     void showSaveDialogs();
 
+    void handleLoopLayerLoaded();
+    void handleLoopLoadingProgress(int loadedLayers, int totalLayers);
+    void handleLoopLoadingFinished(const QString &loopName);
+
 private:
     Ui::LooperWindow *ui;
     Looper *looper;
@@ -207,6 +212,8 @@ private:
     int currentBeat;
 
     QColor tintColor;
+
+    QPointer<audio::LoopLoader> loopLoader; // loading layers in background
 };
 
 Q_DECLARE_METATYPE(audio::Looper::RecordingOption)
@@ -2083,6 +2083,8 @@ void MainWindow::timerEvent(QTimerEvent *)
     if (!mainController)
         return;
 
+    mainController->updateMeters(); // all peaks are read in one pass
+
     // update local input track peaks
     for (TrackGroupView *channel : localGroupChannels)
         channel->updateGuiElements();
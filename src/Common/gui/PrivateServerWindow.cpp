@@ -231,6 +231,14 @@ void PrivateServerWindow::timerEvent(QTimerEvent *)
     quint64 upload = server->getUploadTransferRate() / 1024 * 8;
     ui->labelDownloadValue->setText(QString::number(download));
     ui->labelUploadValue->setText(QString::number(upload));
+
+    // slow clients statistics
+    quint64 queuedKBytes = server->getQueuedBytes() / 1024;
+    quint64 deepestQueue = server->getDeepestClientQueue() / 1024;
+    ui->labelUploadValue->setToolTip(tr("Queued: %1 KB (slowest client: %2 KB)\nDropped intervals: %3")
+                                     .arg(queuedKBytes)
+                                     .arg(deepestQueue)
+                                     .arg(server->getDroppedIntervals()));
 }
 
 void PrivateServerWindow::changeEvent(QEvent *ev)
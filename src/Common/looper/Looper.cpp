@@ -299,6 +299,9 @@ void Looper::startRecording()
 
 void Looper::toggleRecording()
 {
+    if (loading)
+        return;
+
     if (isRecording() || isWaitingToRecord()) {
         play(); // auto play when recording is finished (rec button is pressed)
     }
@@ -317,6 +320,9 @@ void Looper::toggleRecording()
 
 void Looper::togglePlay()
 {
+    if (loading)
+        return;
+
     if (isPlaying()) {
         if (isWaitingToStopInNextInterval())
             stop();
@@ -336,6 +342,9 @@ void Looper::stop()
 
 void Looper::play()
 {
+    if (loading)
+        return; // the loaded layers are not installed yet
+
     setState(new PlayingState(this));
 
     if (mode == Looper::Sequence && focusedLayerIndex >= 0) {
@@ -496,6 +505,9 @@ void Looper::mixToBuffer(SamplesBuffer &samples)
 
     AudioPeak peakAfterMix = samples.computePeak();
 
+    for (quint8 l = 0; l < MAX_LOOP_LAYERS; ++l)
+        layers[l]->publishPeaks();
+
     // always update intervalPosition to keep the execution in sync when 'play' is pressed
     if (intervalLenght)
         intervalPosition = (intervalPosition + samplesToProcess) % intervalLenght;
@@ -580,6 +592,9 @@ void Looper::setState(LooperState *newState)
  */
 bool Looper::canRecord() const
 {
+    if (loading)
+        return false;
+
     if (mode != Looper::SelectedLayer)
         return getFirstUnlockedLayerIndex() >= 0;
 
@@ -139,7 +139,8 @@ public:
     uint getIntervalLenght() const;
 
     void setChanged(bool changed);
-    void setLoading(bool loading);
+    void setLoading(bool loading); // play and record are rejected while the loop layers are installed
+    bool isLoading() const;
 
     bool isWaitingToStopInNextInterval() const;
     void waitToStopInNextInterval();
@@ -244,6 +245,13 @@ inline QString Looper::getLoopName() const
 inline void Looper::setLoading(bool loading)
 {
     this->loading = loading;
+
+    emit stateChanged(); // enable/disable the looper controls
+}
+
+inline bool Looper::isLoading() const
+{
+    return loading;
 }
 
 inline bool Looper::isWaitingToStopInNextInterval() const
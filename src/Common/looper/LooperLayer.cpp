@@ -3,17 +3,397 @@
 
 #include <cstring>
 #include <cmath>
+#include <atomic>
 #include <QDebug>
-
-#include <QDebug>
+#include <QThread>
 
 using audio::LooperLayer;
 using audio::SamplesBuffer;
 
+/**
+ * Min/max mip-map of the layer samples. Level 0 stores one min/max pair per BLOCK_SIZE samples and each
+ * level above merges two entries of the level below, so any zoom is served from the nearest level.
+ *
+ * The writer (audio thread) updates only the entries touched by append/overdub in the back buffer and
+ * publishes it swapping the buffers. The reader (GUI thread) flags the front buffer while reading, the
+ * writer never swaps a flagged buffer (the publication is postponed to the next block, see
+ * publishPending). After a swap the entries changed since the previous swap are copied to the new back
+ * buffer, so both buffers are equal again.
+ *
+ * When the layer is resized the writer only requests a new storage. The storage is allocated by the
+ * reader (in the next getPeaks) and installed by the writer when the front buffer is not flagged, so the
+ * audio thread never allocates or waits the GUI. The replaced storages are deleted by the reader.
+ */
+class LooperLayer::PeaksPyramid
+{
+public:
+    PeaksPyramid() :
+        storage(new Storage(0)),
+        neededSamples(0),
+        state(0),
+        requestedSamples(0),
+        preparedStorage(nullptr),
+        retiredStorages(nullptr),
+        swapPending(false),
+        hasPending(false),
+        pendingFrom(0),
+        pendingTo(0)
+    {
+
+    }
+
+    ~PeaksPyramid()
+    {
+        deleteRetiredStorages();
+        delete preparedStorage.load();
+        delete storage;
+    }
+
+    // writer, called when the channels are reallocated. The storage is replaced later (see installPreparedStorage)
+    void resize(uint totalSamples)
+    {
+        neededSamples = totalSamples;
+        requestedSamples.store(storage->totalSamples == totalSamples ? 0 : totalSamples);
+    }
+
+    // writer, all samples were zeroed
+    void clear()
+    {
+        if (storage->levelSizes.empty())
+            return;
+
+        Levels &back = getBackBuffer();
+        std::fill(back.peaks.begin(), back.peaks.end(), MinMax());
+        back.availableSamples = 0;
+
+        addPending(0, storage->levelSizes[0] - 1);
+        publish();
+    }
+
+    // writer, the samples in [from, to) were changed
+    void update(const float *left, const float *right, uint availableSamples, uint from, uint to)
+    {
+        if (installPreparedStorage(left, right, availableSamples))
+            return; // all entries computed
+
+        if (storage->levelSizes.empty() || from >= to)
+            return;
+
+        const uint firstBlock = qMin(from / BLOCK_SIZE, storage->levelSizes[0] - 1);
+        const uint lastBlock = qMin((to - 1) / BLOCK_SIZE, storage->levelSizes[0] - 1);
+
+        Levels &back = getBackBuffer();
+        back.availableSamples = availableSamples;
+        computeEntries(*storage, back, left, right, firstBlock, lastBlock);
+
+        addPending(firstBlock, lastBlock);
+        publish();
+    }
+
+    // writer, called in every audio block. Publish the postponed swap and install the prepared storage.
+    void publishPending(const float *left, const float *right, uint availableSamples)
+    {
+        if (installPreparedStorage(left, right, availableSamples))
+            return;
+
+        if (swapPending)
+            publish();
+    }
+
+    // reader, 'samplesPerPeak' abs peaks per returned value
+    std::vector<float> getPeaks(uint samplesPerPeak)
+    {
+        std::vector<float> peaks;
+
+        prepareStorage(); // the reader is allocating, not the audio thread
+
+        if (!samplesPerPeak)
+            return peaks;
+
+        int currentState = acquireFront();
+
+        const Storage &current = *storage;
+        const Levels &front = current.buffers[currentState & FRONT_INDEX];
+        const uint availableSamples = qMin(front.availableSamples, current.totalSamples);
+        if (availableSamples && !current.levelSizes.empty()) {
+
+            // the nearest level with blocks not bigger than 'samplesPerPeak'
+            uint level = 0;
+            while (level + 1 < current.levelSizes.size() && (static_cast<quint64>(BLOCK_SIZE) << (level + 1)) <= samplesPerPeak)
+                level++;
+
+            const quint64 blockSize = static_cast<quint64>(BLOCK_SIZE) << level;
+            const MinMax *entries = &(front.peaks[current.levelOffsets[level]]);
+            const quint64 lastEntry = current.levelSizes[level] - 1;
+
+            peaks.reserve((availableSamples + samplesPerPeak - 1) / samplesPerPeak);
+            for (quint64 from = 0; from < availableSamples; from += samplesPerPeak) {
+                const quint64 to = qMin(from + samplesPerPeak, static_cast<quint64>(availableSamples));
+                const quint64 firstEntry = qMin(from / blockSize, lastEntry);
+                const quint64 limit = qMin((to - 1) / blockSize, lastEntry);
+                float maxPeak = 0;
+                for (quint64 e = firstEntry; e <= limit; ++e)
+                    maxPeak = qMax(maxPeak, qMax(entries[e].max, -entries[e].min));
+
+                peaks.push_back(maxPeak);
+            }
+        }
+
+        state.fetch_and(~READING);
+
+        return peaks;
+    }
+
+private:
+    struct MinMax
+    {
+        MinMax() : min(0), max(0) {}
+
+        float min;
+        float max;
+    };
+
+    struct Levels
+    {
+        std::vector<MinMax> peaks; // all levels, level 0 first
+        uint availableSamples;
+    };
+
+    // the buffers and their layout (same layout in both buffers)
+    struct Storage
+    {
+        explicit Storage(uint totalSamples) :
+            totalSamples(totalSamples),
+            nextRetired(nullptr)
+        {
+            uint entries = 0;
+            uint levelSize = (totalSamples + BLOCK_SIZE - 1) / BLOCK_SIZE;
+            while (levelSize > 0) {
+                levelOffsets.push_back(entries);
+                levelSizes.push_back(levelSize);
+                entries += levelSize;
+                if (levelSize == 1)
+                    break;
+
+                levelSize = (levelSize + 1) / 2;
+            }
+
+            for (auto &buffer : buffers) {
+                buffer.peaks.assign(entries, MinMax());
+                buffer.availableSamples = 0;
+            }
+        }
+
+        Levels buffers[2];
+        uint totalSamples;
+        std::vector<uint> levelOffsets;
+        std::vector<uint> levelSizes;
+
+        Storage *nextRetired;
+    };
+
+    Storage *storage; // replaced by the writer only when the reader is not using it
+    uint neededSamples; // writer
+
+    // front buffer index and reader/writer flags
+    mutable std::atomic<int> state;
+
+    // storage hand-off, the reader allocates and deletes the storages
+    std::atomic<uint> requestedSamples; // zero if the storage size is right
+    std::atomic<Storage *> preparedStorage;
+    std::atomic<Storage *> retiredStorages; // lock-free stack
+
+    bool swapPending; // the back buffer is newer than the front buffer
+
+    // level 0 entries changed in the back buffer since the last swap (inclusive range)
+    bool hasPending;
+    uint pendingFrom;
+    uint pendingTo;
+
+    static const uint BLOCK_SIZE = 64; // samples per level 0 entry
+
+    static const int FRONT_INDEX = 1;
+    static const int READING = 2;
+    static const int EXCLUSIVE = 4;
+
+    inline Levels &getBackBuffer()
+    {
+        return storage->buffers[(state.load() & FRONT_INDEX) ^ 1]; // only the writer change the front index
+    }
+
+    static void computeEntries(Storage &storage, Levels &buffer, const float *left, const float *right, uint firstBlock, uint lastBlock)
+    {
+        MinMax *level0 = &(buffer.peaks[0]);
+        for (uint block = firstBlock; block <= lastBlock; ++block) {
+            const uint from = block * BLOCK_SIZE;
+            const uint to = qMin(from + BLOCK_SIZE, qMin(buffer.availableSamples, storage.totalSamples));
+            MinMax entry;
+            for (uint s = from; s < to; ++s) {
+                entry.min = qMin(entry.min, qMin(left[s], right[s]));
+                entry.max = qMax(entry.max, qMax(left[s], right[s]));
+            }
+            level0[block] = entry;
+        }
+
+        // merge the changed entries in the upper levels
+        for (uint level = 1; level < storage.levelSizes.size(); ++level) {
+            firstBlock /= 2;
+            lastBlock /= 2;
+            const MinMax *below = &(buffer.peaks[storage.levelOffsets[level - 1]]);
+            const uint belowSize = storage.levelSizes[level - 1];
+            MinMax *entries = &(buffer.peaks[storage.levelOffsets[level]]);
+            for (uint e = firstBlock; e <= lastBlock; ++e) {
+                MinMax entry = below[e * 2];
+                if (e * 2 + 1 < belowSize) {
+                    entry.min = qMin(entry.min, below[e * 2 + 1].min);
+                    entry.max = qMax(entry.max, below[e * 2 + 1].max);
+                }
+                entries[e] = entry;
+            }
+        }
+    }
+
+    void addPending(uint firstBlock, uint lastBlock)
+    {
+        if (!hasPending) {
+            pendingFrom = firstBlock;
+            pendingTo = lastBlock;
+        }
+        else {
+            pendingFrom = qMin(pendingFrom, firstBlock);
+            pendingTo = qMax(pendingTo, lastBlock);
+        }
+        hasPending = true;
+    }
+
+    void publish()
+    {
+        swapPending = true;
+
+        int currentState = state.load();
+        if (currentState & READING)
+            return; // the reader is using the front buffer, try again in the next block
+
+        if (!state.compare_exchange_strong(currentState, currentState ^ FRONT_INDEX))
+            return;
+
+        swapPending = false;
+
+        // the new front is immutable now, bring the old front (the new back) up to date
+        const Levels &front = storage->buffers[(currentState & FRONT_INDEX) ^ 1];
+        Levels &back = storage->buffers[currentState & FRONT_INDEX];
+        back.availableSamples = front.availableSamples;
+
+        if (!hasPending)
+            return;
+
+        uint from = pendingFrom;
+        uint to = pendingTo;
+        for (uint level = 0; level < storage->levelSizes.size(); ++level) {
+            const uint offset = storage->levelOffsets[level];
+            std::copy(front.peaks.begin() + offset + from, front.peaks.begin() + offset + to + 1, back.peaks.begin() + offset + from);
+            from /= 2;
+            to /= 2;
+        }
+
+        hasPending = false;
+    }
+
+    // writer, return true if the prepared storage was installed (all entries computed)
+    bool installPreparedStorage(const float *left, const float *right, uint availableSamples)
+    {
+        if (storage->totalSamples == neededSamples || !preparedStorage.load())
+            return false;
+
+        Storage *prepared = preparedStorage.exchange(nullptr);
+        if (!prepared)
+            return false;
+
+        if (prepared->totalSamples != neededSamples) { // outdated, the reader will prepare another one
+            retire(prepared);
+            return false;
+        }
+
+        int currentState = state.load();
+        if ((currentState & READING) || !state.compare_exchange_strong(currentState, currentState | EXCLUSIVE)) {
+            Storage *expected = nullptr;
+            if (!preparedStorage.compare_exchange_strong(expected, prepared)) // try again in the next block
+                retire(prepared);
+
+            return false;
+        }
+
+        Storage *previous = storage;
+        storage = prepared;
+
+        if (!storage->levelSizes.empty() && availableSamples) {
+            Levels &first = storage->buffers[0];
+            first.availableSamples = availableSamples;
+            computeEntries(*storage, first, left, right, 0, storage->levelSizes[0] - 1);
+            storage->buffers[1] = first; // no reallocation, the sizes are the same
+        }
+
+        hasPending = false;
+        swapPending = false;
+        requestedSamples.store(0);
+
+        state.fetch_and(~EXCLUSIVE);
+
+        retire(previous);
+
+        return true;
+    }
+
+    void retire(Storage *retiredStorage)
+    {
+        Storage *head = retiredStorages.load();
+        do {
+            retiredStorage->nextRetired = head;
+        } while (!retiredStorages.compare_exchange_weak(head, retiredStorage));
+    }
+
+    // reader
+    void prepareStorage()
+    {
+        deleteRetiredStorages();
+
+        const uint samples = requestedSamples.load();
+        if (!samples || preparedStorage.load())
+            return;
+
+        Storage *newStorage = new Storage(samples);
+        Storage *expected = nullptr;
+        if (!preparedStorage.compare_exchange_strong(expected, newStorage))
+            delete newStorage;
+    }
+
+    void deleteRetiredStorages()
+    {
+        Storage *retiredStorage = retiredStorages.exchange(nullptr);
+        while (retiredStorage) {
+            Storage *next = retiredStorage->nextRetired;
+            delete retiredStorage;
+            retiredStorage = next;
+        }
+    }
+
+    int acquireFront() const
+    {
+        forever {
+            int currentState = state.load();
+            if (!(currentState & EXCLUSIVE) && state.compare_exchange_weak(currentState, currentState | READING))
+                return currentState;
+
+            QThread::yieldCurrentThread(); // the writer is installing a new storage
+        }
+    }
+};
+
+// ++++++++++++++++++++++++++++++++++++++++++++++++++++
+
 LooperLayer::LooperLayer() :
-    lastSamplesPerPeak(0),
+    peaksPyramid(new PeaksPyramid()),
     availableSamples(0),
-    lastCacheComputationSample(0),
     lastCycleLenght(0),
     locked(false),
     gain(1.0),
@@ -48,9 +428,7 @@ void LooperLayer::zero()
     std::fill(rightChannel.begin(), rightChannel.end(), static_cast<float>(0));
 
     availableSamples = 0;
-    lastSamplesPerPeak = 0;
-    lastCacheComputationSample = 0;
-    peaksCache.clear();
+    peaksPyramid->clear();
 }
 
 void LooperLayer::setSamples(const SamplesBuffer &samples)
@@ -75,18 +453,7 @@ void LooperLayer::setSamples(const SamplesBuffer &samples)
 
     availableSamples = samplesToCopy;
 
-
-    // rebuild peaks cache
-    lastCacheComputationSample = 0;
-    peaksCache.clear();
-
-    if (lastSamplesPerPeak) {
-        while (availableSamples - lastCacheComputationSample >= lastSamplesPerPeak) { // enough samples to cache a new max peak?
-            peaksCache.push_back(computeMaxPeak(lastCacheComputationSample, lastSamplesPerPeak));
-            lastCacheComputationSample += lastSamplesPerPeak;
-        }
-    }
-
+    peaksPyramid->update(&(leftChannel[0]), &(rightChannel[0]), availableSamples, 0, availableSamples);
 }
 
 void LooperLayer::setPan(float pan)
@@ -115,12 +482,11 @@ void LooperLayer::setGain(float gain)
 
 void LooperLayer::prepareForNewCycle(uint samplesInNewCycle, bool isOverdubbing)
 {
+    Q_UNUSED(isOverdubbing); // the peaks are updated where the samples are overdubbed, no cache position to reset
+
     if (samplesInNewCycle > lastCycleLenght)
         resize(samplesInNewCycle);
 
-    if (isOverdubbing)
-        lastCacheComputationSample = 0; // reset max peak cache position to compute overdub peaks correctly
-
     lastCycleLenght = samplesInNewCycle;
 }
 
@@ -145,20 +511,7 @@ void LooperLayer::overdub(const SamplesBuffer &samples, uint samplesToMix, uint
     if (availableSamples < startPosition + samplesToMix)
         availableSamples = startPosition + samplesToMix;
 
-    // build peaks cache when overdubbing
-    if (lastSamplesPerPeak) {
-        const uint position = startPosition + samplesToMix;
-        while (position - lastCacheComputationSample >= lastSamplesPerPeak) { // enough samples to cache a new max peak?
-            const int peakIndex = (position/lastSamplesPerPeak) - 1;
-            float lastPeak = computeMaxPeak(lastCacheComputationSample, lastSamplesPerPeak);
-            if (peakIndex >= 0 && static_cast<uint>(peakIndex) < peaksCache.size())
-                peaksCache[peakIndex] = lastPeak;
-            else
-                peaksCache.push_back(lastPeak);
-
-            lastCacheComputationSample += lastSamplesPerPeak;
-        }
-    }
+    peaksPyramid->update(&(leftChannel[0]), &(rightChannel[0]), availableSamples, startPosition, startPosition + samplesToMix);
 }
 
 void LooperLayer::mixTo(SamplesBuffer &outBuffer, uint samplesToMix, uint intervalPosition, float looperMainGain)
@@ -202,16 +555,7 @@ void LooperLayer::append(const SamplesBuffer &samples, uint samplesToAppend, uin
 
     //Q_ASSERT(availableSamples <= leftChannel.capacity());
 
-    // build peaks cache
-    if (lastSamplesPerPeak) {
-        if (lastCacheComputationSample < startPosition - lastSamplesPerPeak)
-            lastCacheComputationSample = startPosition;
-
-        while ((startPosition + samplesToAppend) - lastCacheComputationSample >= lastSamplesPerPeak && lastCacheComputationSample  < leftChannel.size()) { // enough samples to cache a new max peak?
-            peaksCache.push_back(computeMaxPeak(lastCacheComputationSample, lastSamplesPerPeak));
-            lastCacheComputationSample += lastSamplesPerPeak;
-        }
-    }
+    peaksPyramid->update(&(leftChannel[0]), &(rightChannel[0]), availableSamples, startPosition, startPosition + toAppend);
 }
 
 float LooperLayer::computeMaxPeak(uint from, uint samplesPerPeak) const
@@ -231,27 +575,25 @@ float LooperLayer::computeMaxPeak(uint from, uint samplesPerPeak) const
     return maxPeak;
 }
 
-std::vector<float> LooperLayer::getSamplesPeaks(uint samplesPerPeak)
+std::vector<float> LooperLayer::getSamplesPeaks(uint samplesPerPeak) const
 {
-    if (lastSamplesPerPeak == samplesPerPeak && !peaksCache.empty()) { // cache hit?
-        return peaksCache;
-    }
+    return peaksPyramid->getPeaks(samplesPerPeak);
+}
 
-    // compute all peaks
-    peaksCache.clear();
-    if (samplesPerPeak) {
-        for (uint i = 0; i < availableSamples; i += samplesPerPeak) {
-            float maxPeak = computeMaxPeak(i, samplesPerPeak);
-            peaksCache.push_back(maxPeak);
-        }
-        lastSamplesPerPeak = samplesPerPeak;
-    }
+void LooperLayer::publishPeaks()
+{
+    if (leftChannel.empty())
+        return;
 
-    return peaksCache;
+    peaksPyramid->publishPending(&(leftChannel[0]), &(rightChannel[0]), availableSamples);
 }
 
 void LooperLayer::resize(quint32 samplesPerCycle)
 {
+    const size_t previousSize = leftChannel.size();
+    const uint initialAvailableSamples = availableSamples;
+    bool samplesCopied = false;
+
     if (samplesPerCycle > leftChannel.capacity())
         leftChannel.resize(samplesPerCycle);
 
@@ -259,7 +601,6 @@ void LooperLayer::resize(quint32 samplesPerCycle)
         rightChannel.resize(samplesPerCycle);
 
     if (availableSamples && samplesPerCycle > availableSamples) { // need copy samples?
-        uint initialAvailableSamples = availableSamples;
         uint totalSamplesToCopy = samplesPerCycle - initialAvailableSamples;
         while (totalSamplesToCopy > 0){
             const uint samplesToCopy = qMin(totalSamplesToCopy, initialAvailableSamples);
@@ -272,8 +613,14 @@ void LooperLayer::resize(quint32 samplesPerCycle)
 
         Q_ASSERT(availableSamples == samplesPerCycle);
 
-        peaksCache.clear(); // invalidate peaks cache
+        samplesCopied = true;
     }
+
+    if (leftChannel.size() != previousSize)
+        peaksPyramid->resize(leftChannel.size()); // the new pyramid storage is allocated in the GUI thread
+
+    if (samplesCopied)
+        peaksPyramid->update(&(leftChannel[0]), &(rightChannel[0]), availableSamples, initialAvailableSamples, availableSamples);
 }
 
 SamplesBuffer LooperLayer::getAllSamples() const
@@ -2,6 +2,7 @@
 #define _AUDIO_LOOPER_LAYER_
 
 #include <vector>
+#include <memory>
 #include <QtGlobal>
 
 namespace audio {
@@ -37,7 +38,11 @@ public:
 
     float computeMaxPeak(uint from, uint samplesPerPeak) const;
 
-    std::vector<float> getSamplesPeaks(uint samplesPerPeak);
+    // Called from the GUI thread, never blocks the audio thread. The peaks are served from a min/max
+    // pyramid updated while recording/overdubbing, the cost is proportional to the returned peaks.
+    std::vector<float> getSamplesPeaks(uint samplesPerPeak) const;
+
+    void publishPeaks(); // audio thread, called in every block to publish the peaks postponed while the GUI was reading
 
     SamplesBuffer getAllSamples() const;
 
@@ -65,10 +70,10 @@ private:
     std::vector<float> leftChannel;
     std::vector<float> rightChannel;
 
-    std::vector<float> peaksCache;
-    uint lastSamplesPerPeak;
+    class PeaksPyramid;
+    std::unique_ptr<PeaksPyramid> peaksPyramid;
+
     uint availableSamples;
-    uint lastCacheComputationSample;
     uint lastCycleLenght;
     bool locked;
 
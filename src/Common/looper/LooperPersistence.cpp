@@ -3,13 +3,17 @@
 #include "file/WaveFileWriter.h"
 #include "audio/vorbis/VorbisEncoder.h"
 #include "file/FileReaderFactory.h"
-#include "audio/SamplesBufferResampler.h"
+#include "audio/Resampler.h"
 #include "Utils.h"
 
 #include <QtConcurrent/QtConcurrent>
+#include <QFutureWatcher>
 #include <QJsonDocument>
 #include <QFileInfo>
 
+#include <memory>
+#include <cmath>
+
 using audio::LoopInfo;
 using audio::LoopSaver;
 using audio::LoopLoader;
@@ -159,10 +163,111 @@ void LoopSaver::saveSamplesToDisk(const QString &savePath, const QString &loopFi
 
 // ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 
-LoopLoader::LoopLoader(const QString &loadPath) :
-    loadPath(loadPath)
+QHash<QString, LoopLoader::CachedLoopInfo> LoopLoader::loopsInfoCache;
+QMutex LoopLoader::loopsInfoCacheMutex;
+
+LoopLoader::LoopLoader(const QString &loadPath, QObject *parent) :
+    QObject(parent),
+    loadPath(loadPath),
+    pendingLayers(0),
+    loadedLayers(0),
+    canceled(false)
+{
+    threadPool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1)); // leaving one core to audio thread
+}
+
+LoopLoader::~LoopLoader()
+{
+    canceled = true;
+    threadPool.clear(); // discarding the layers not started yet
+    threadPool.waitForDone();
+
+    if (isLoading() && looper)
+        looper->setLoading(false);
+}
+
+void LoopLoader::loadAsync(const LoopInfo &loopInfo, Looper *looper, uint currentSampleRate, quint32 samplesPerInterval)
+{
+    if (!loopInfo.isValid() || !looper || isLoading())
+        return;
+
+    this->looper = looper;
+    currentLoop = loopInfo;
+    canceled = false;
+    loadedLayers = 0;
+
+    looper->setChanged(false);
+    looper->setLoading(true);
+
+    looper->stop();
+    looper->setMode(static_cast<Looper::Mode>(loopInfo.getLooperMode()));
+    looper->setLayers(loopInfo.getLayersCount());
+
+    const QString loopName = loopInfo.getName();
+    const bool audioIsEncoded = loopInfo.audioIsEncoded();
+    const QList<LoopLayerInfo> layersInfo = loopInfo.getLayersInfo();
+
+    pendingLayers = layersInfo.size();
+    emit progressChanged(0, pendingLayers);
+
+    for (quint8 layer = 0; layer < layersInfo.size(); ++layer) {
+        // the decoded samples are shared between the worker thread and the watcher (running in loader thread)
+        std::shared_ptr<SamplesBuffer> samples(new SamplesBuffer(2, samplesPerInterval));
+        const QString path(loadPath);
+
+        auto watcher = new QFutureWatcher<bool>(this);
+        const LoopLayerInfo layerInfo = layersInfo.at(layer);
+        connect(watcher, &QFutureWatcher<bool>::finished, this, [=]() {
+            if (watcher->result())
+                installLayer(layer, *samples, layerInfo);
+
+            watcher->deleteLater();
+            finishLayer();
+        });
+
+        watcher->setFuture(QtConcurrent::run(&threadPool, [=]() {
+            return LoopLoader::loadLoopLayerSamples(path, loopName, layer, audioIsEncoded, currentSampleRate, *samples);
+        }));
+    }
+}
+
+void LoopLoader::installLayer(quint8 layerIndex, const SamplesBuffer &samples, const LoopLayerInfo &layerInfo)
+{
+    if (canceled || !looper)
+        return;
+
+    looper->setLayerSamples(layerIndex, samples);
+    looper->setLayerLockedState(layerIndex, layerInfo.locked);
+    looper->setLayerGain(layerIndex, Utils::linearGainToPower(layerInfo.gain));
+    looper->setLayerPan(layerIndex, layerInfo.pan);
+
+    emit layerLoaded(layerIndex);
+}
+
+void LoopLoader::finishLayer()
 {
+    loadedLayers++;
+    pendingLayers--;
+
+    if (!canceled)
+        emit progressChanged(loadedLayers, loadedLayers + pendingLayers);
+
+    if (pendingLayers > 0)
+        return;
+
+    if (looper) {
+        looper->setLoading(false);
+        if (!canceled)
+            looper->setLoopName(currentLoop.getName());
+    }
 
+    if (!canceled)
+        emit loadingFinished(currentLoop.getName());
+}
+
+void LoopLoader::cancel()
+{
+    canceled = true; // the layers decoded after this point are discarded
 }
 
 void LoopLoader::load(LoopInfo loopInfo, Looper *looper, uint currentSampleRate, quint32 samplesPerInterval)
@@ -197,27 +302,44 @@ void LoopLoader::load(LoopInfo loopInfo, Looper *looper, uint currentSampleRate,
 
 bool LoopLoader::loadAudioFile(const QString &filePath, uint currentSampleRate, SamplesBuffer &out)
 {
-    QFile audioFile(filePath);
-    if (!audioFile.open(QFile::ReadOnly)) {
-        qCritical() << "Error loading loop layer samples, can't open " << filePath << audioFile.errorString();
+    auto fileReader = FileReaderFactory::createFileReader(filePath);
+    if (!fileReader->open(filePath)) {
+        qCritical() << "Error loading loop layer samples, can't open " << filePath;
         out.setFrameLenght(0);
         return false;
     }
 
-    auto fileReader = FileReaderFactory::createFileReader(filePath);
-    quint32 audioFileSampleRate = 0;
-    if (!fileReader->read(filePath, out, audioFileSampleRate))
-        return false;
+    const quint32 audioFileSampleRate = fileReader->getSampleRate();
+    fileReader->close();
 
+    quint32 sampleRate = 0;
     bool needResample = audioFileSampleRate > 0 && currentSampleRate != audioFileSampleRate;
-    if (needResample) {
-        SamplesBufferResampler resampler;
-        uint desiredLenght = currentSampleRate/static_cast<float>(audioFileSampleRate) * out.getFrameLenght();
-        const SamplesBuffer resampledBuffer = resampler.resample(out, desiredLenght);
-        out.setFrameLenght(desiredLenght);
-        out.set(resampledBuffer);
+    if (!needResample) // decoding directly in the output buffer
+        return fileReader->read(filePath, out, sampleRate);
+
+    // 'out' lenght is the limit in the current sample rate, decoding only the needed frames in the file sample rate
+    const uint maxLenght = out.getFrameLenght();
+    const double ratio = currentSampleRate/static_cast<double>(audioFileSampleRate);
+    SamplesBuffer originalBuffer(2, maxLenght > 0 ? static_cast<uint>(std::ceil(maxLenght / ratio)) : 0);
+    if (!fileReader->read(filePath, originalBuffer, sampleRate)) {
+        out.setFrameLenght(0);
+        return false;
     }
 
+    uint desiredLenght = static_cast<uint>(ratio * originalBuffer.getFrameLenght());
+    if (maxLenght > 0)
+        desiredLenght = qMin(desiredLenght, maxLenght);
+
+    if (originalBuffer.isMono())
+        out.setToMono();
+    else
+        out.setToStereo();
+
+    out.setFrameLenght(desiredLenght);
+    for (int c = 0; c < out.getChannels(); ++c) // offline resampling, no latency
+        PolyphaseResampler::resample(originalBuffer.getSamplesArray(c), originalBuffer.getFrameLenght(),
+                                     out.getSamplesArray(c), desiredLenght);
+
     return true;
 }
 
@@ -243,13 +365,38 @@ QList<LoopInfo> LoopLoader::loadLoopsInfo(const QString &loadPath, quint32 bpmTo
     QDir loadDir(loadPath);
     QDir::Filters filters = QDir::NoDotAndDotDot | QDir::Files;
     QFileInfoList fileInfoList = loadDir.entryInfoList(QStringList("*.json"), filters);
+
+    QMutexLocker locker(&loopsInfoCacheMutex);
+
+    QSet<QString> existingFiles;
     for (const QFileInfo &fileInfo : fileInfoList) {
         QString loopFilePath = fileInfo.absoluteFilePath();
-        LoopInfo loopInfo = LoopLoader::loadLoopInfo(loopFilePath);
+        existingFiles.insert(loopFilePath);
+
+        // only the new or modified json files are parsed
+        auto cached = loopsInfoCache.find(loopFilePath);
+        if (cached == loopsInfoCache.end() || cached->lastModified != fileInfo.lastModified() || cached->size != fileInfo.size()) {
+            CachedLoopInfo info;
+            info.lastModified = fileInfo.lastModified();
+            info.size = fileInfo.size();
+            info.loopInfo = LoopLoader::loadLoopInfo(loopFilePath);
+            cached = loopsInfoCache.insert(loopFilePath, info);
+        }
+
+        const LoopInfo &loopInfo = cached->loopInfo;
         if (loopInfo.isValid() && loopInfo.getBpm() == bpmToMatch)
             allInfos.append(loopInfo);
     }
 
+    // removing deleted files from cache
+    const QString dirPath = loadDir.absolutePath();
+    for (auto it = loopsInfoCache.begin(); it != loopsInfoCache.end();) {
+        if (QFileInfo(it.key()).absolutePath() == dirPath && !existingFiles.contains(it.key()))
+            it = loopsInfoCache.erase(it);
+        else
+            ++it;
+    }
+
     return allInfos;
 }
 
@@ -4,6 +4,12 @@
 #include <QString>
 #include <QSet>
 #include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QThreadPool>
+#include <QDateTime>
+#include <QHash>
+#include <QMutex>
 
 namespace audio {
 
@@ -109,24 +115,65 @@ inline QList<LoopLayerInfo> LoopInfo::getLayersInfo() const
 
 // +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++=
 
-class LoopLoader
+class LoopLoader : public QObject
 {
+    Q_OBJECT
 
 public:
-    explicit LoopLoader(const QString &loadPath);
+    explicit LoopLoader(const QString &loadPath, QObject *parent = nullptr);
+    ~LoopLoader();
+
+    // blocking, all layers are decoded in the calling thread
     void load(LoopInfo loopInfo, Looper *looper, uint currentSampleRate, quint32 samplesPerInterval);
 
+    // Each layer is decoded in a background thread (in parallel) and installed in the looper (in
+    // the loader thread) when ready. Progress is reported using the signals below.
+    void loadAsync(const LoopInfo &loopInfo, Looper *looper, uint currentSampleRate, quint32 samplesPerInterval);
+
+    void cancel(); // the layers not installed yet are discarded
+    bool isLoading() const;
+
     static LoopInfo loadLoopInfo(const QString &loopFilePath);
     static QList<LoopInfo> loadLoopsInfo(const QString &loadPath, quint32 bpmToMatch);
     static bool loadAudioFile(const QString &filePath, uint currentSampleRate, SamplesBuffer &out);
 
     static bool loadLoopLayerSamples(const QString &loadPath, const QString &loopName, quint8 layerIndex, bool audioIsEncoded, uint currentSampleRate, SamplesBuffer &out);
 
+signals:
+    void layerLoaded(quint8 layerIndex);
+    void progressChanged(int loadedLayers, int totalLayers);
+    void loadingFinished(const QString &loopName);
+
 private:
     QString loadPath;
 
+    QThreadPool threadPool; // decoding layers
+    QPointer<Looper> looper; // looper used in loadAsync()
+    LoopInfo currentLoop;
+    int pendingLayers;
+    int loadedLayers;
+    bool canceled;
+
+    void installLayer(quint8 layerIndex, const SamplesBuffer &samples, const LoopLayerInfo &layerInfo);
+    void finishLayer();
+
+    // loops metadata (json) parsed before, reloaded only when the file is changed
+    struct CachedLoopInfo
+    {
+        QDateTime lastModified;
+        qint64 size;
+        LoopInfo loopInfo;
+    };
+
+    static QHash<QString, CachedLoopInfo> loopsInfoCache; // json file path => metadata
+    static QMutex loopsInfoCacheMutex;
 };
 
+inline bool LoopLoader::isLoading() const
+{
+    return pendingLayers > 0;
+}
+
 } // namespace
 
 #endif
@@ -2,6 +2,9 @@
 #include "log/Logging.h"
 #include "MidiMessage.h"
 
+#include <algorithm>
+#include <chrono>
+
 using midi::MidiDriver;
 
 MidiDriver::MidiDriver()
@@ -27,6 +30,47 @@ void MidiDriver::setInputDevicesStatus(const QList<bool> &statuses)
     this->inputDevicesEnabledStatuses = statuses;
 }
 
+qint64 MidiDriver::getHostTime()
+{
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+void MidiDriver::computeFrameOffsets(std::vector<MidiMessage> &messages, qint64 blockStartTime, uint blockFrames, int sampleRate)
+{
+    if (blockFrames == 0 || sampleRate <= 0)
+        return;
+
+    const qint64 blockDuration = static_cast<qint64>(blockFrames) * 1000000 / sampleRate;
+    const qint64 previousBlockStart = blockStartTime - blockDuration;
+
+    for (auto &message : messages) {
+        qint64 offset = 0; // messages without timestamp are played in the block start
+        if (message.getTimestamp() > 0)
+            offset = (message.getTimestamp() - previousBlockStart) * sampleRate / 1000000;
+
+        message.setFrameOffset(static_cast<quint32>(qBound(static_cast<qint64>(0), offset, static_cast<qint64>(blockFrames - 1))));
+    }
+
+    // insertion sort, the messages from different devices are interleaved. Not allocating in audio thread.
+    for (size_t i = 1; i < messages.size(); ++i) {
+        for (size_t j = i; j > 0 && messages[j - 1].getFrameOffset() > messages[j].getFrameOffset(); --j)
+            std::swap(messages[j - 1], messages[j]);
+    }
+}
+
+void MidiDriver::sliceMessages(const std::vector<MidiMessage> &blockMessages, uint sliceStart, uint sliceFrames, std::vector<MidiMessage> &outMessages)
+{
+    const uint sliceEnd = sliceStart + sliceFrames;
+    outMessages.clear();
+    for (const auto &message : blockMessages) {
+        if (message.getFrameOffset() >= sliceStart && message.getFrameOffset() < sliceEnd) {
+            outMessages.push_back(message);
+            outMessages.back().setFrameOffset(message.getFrameOffset() - sliceStart);
+        }
+    }
+}
+
 bool MidiDriver::deviceIsGloballyEnabled(int deviceIndex) const
 {
     if (deviceIndex >= 0 && deviceIndex < inputDevicesEnabledStatuses.size())
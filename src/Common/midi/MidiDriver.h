@@ -27,12 +27,25 @@ public:
     virtual int getMaxInputDevices() const = 0;
 
     virtual QString getInputDeviceName(uint index) const = 0;
-    virtual std::vector<MidiMessage> getBuffer() = 0;
+    // append the received messages in outBuffer. Called by the audio thread, never allocating: the messages are appended while outBuffer has capacity.
+    virtual void getBuffer(std::vector<MidiMessage> &outBuffer) = 0;
 
     virtual bool deviceIsGloballyEnabled(int deviceIndex) const;
     int getFirstGloballyEnableInputDevice() const;
     virtual void setInputDevicesStatus(const QList<bool> &statuses);
 
+    static qint64 getHostTime(); // monotonic clock in microseconds, used in the messages timestamps
+
+    /**
+        Convert the messages timestamps in sample offsets inside the audio block starting in 'blockStartTime'.
+        The messages received in the previous block are played with the same relative timing (one block of
+        constant latency, instead of a jitter of one block). The messages are sorted by offset.
+    */
+    static void computeFrameOffsets(std::vector<MidiMessage> &messages, qint64 blockStartTime, uint blockFrames, int sampleRate);
+
+    // copy the messages inside a part of the audio block (splitted in the interval end), the offsets are relative to the part start
+    static void sliceMessages(const std::vector<MidiMessage> &blockMessages, uint sliceStart, uint sliceFrames, std::vector<MidiMessage> &outMessages);
+
 protected:
     QList<bool> inputDevicesEnabledStatuses; // store the globally enabled midi input devices
 };
@@ -68,9 +81,9 @@ class NullMidiDriver : public MidiDriver
         return "";
     }
 
-    inline std::vector<MidiMessage> getBuffer() override
+    inline void getBuffer(std::vector<MidiMessage> &outBuffer) override
     {
-        return std::vector<MidiMessage>();
+        Q_UNUSED(outBuffer);
     }
 };
 
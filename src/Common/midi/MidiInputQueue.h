@@ -0,0 +1,65 @@
+#ifndef MIDI_INPUT_QUEUE_H
+#define MIDI_INPUT_QUEUE_H
+
+#include "MidiMessage.h"
+#include "audio/readerwriterqueue.h"
+
+#include <atomic>
+#include <vector>
+
+namespace midi {
+
+/**
+ * Lock free queue of the messages received from one MIDI device. The producer is the MIDI driver
+ * thread, the consumer is the audio thread. All slots are allocated in the constructor, so the
+ * messages are dropped (and counted) when the audio thread is not consuming.
+ */
+class MidiInputQueue
+{
+public:
+    explicit MidiInputQueue(int capacity = DEFAULT_CAPACITY);
+
+    bool enqueue(const MidiMessage &message); // MIDI thread, return false if the message was dropped
+
+    // audio thread, append the messages in outBuffer while outBuffer has capacity. The other messages are kept for the next block.
+    void dequeue(std::vector<MidiMessage> &outBuffer);
+
+    int takeDroppedMessages(); // the dropped messages since the last call
+
+    static const int DEFAULT_CAPACITY = 1024;
+
+private:
+    moodycamel::ReaderWriterQueue<MidiMessage> messages;
+    std::atomic<int> droppedMessages;
+};
+
+inline MidiInputQueue::MidiInputQueue(int capacity) :
+    messages(capacity),
+    droppedMessages(0)
+{
+}
+
+inline bool MidiInputQueue::enqueue(const MidiMessage &message)
+{
+    if (messages.try_enqueue(message)) // never allocating
+        return true;
+
+    droppedMessages++;
+    return false;
+}
+
+inline void MidiInputQueue::dequeue(std::vector<MidiMessage> &outBuffer)
+{
+    MidiMessage message;
+    while (outBuffer.size() < outBuffer.capacity() && messages.try_dequeue(message))
+        outBuffer.push_back(message);
+}
+
+inline int MidiInputQueue::takeDroppedMessages()
+{
+    return droppedMessages.exchange(0);
+}
+
+} // namespace
+
+#endif // MIDI_INPUT_QUEUE_H
@@ -4,9 +4,11 @@
 
 using midi::MidiMessage;
 
-MidiMessage::MidiMessage(qint32 data, int sourceID) :
+MidiMessage::MidiMessage(qint32 data, int sourceID, qint64 timestamp) :
     data(data),
-    sourceID(sourceID)
+    sourceID(sourceID),
+    timestamp(timestamp),
+    frameOffset(0)
 {
 
 }
@@ -17,13 +19,13 @@ MidiMessage::MidiMessage() :
 
 }
 
-MidiMessage MidiMessage::fromVector(std::vector<unsigned char> vector, qint32 deviceIndex)
+MidiMessage MidiMessage::fromVector(const std::vector<unsigned char> &vector, qint32 deviceIndex, qint64 timestamp)
 {
     int msgData = 0;
     msgData |= vector.at(0);
     msgData |= vector.at(1) << 8;
     msgData |= vector.at(2) << 16;
-    return MidiMessage(msgData, deviceIndex);
+    return MidiMessage(msgData, deviceIndex, timestamp);
 }
 
 MidiMessage MidiMessage::fromArray(const char array[4], qint32 deviceIndex)
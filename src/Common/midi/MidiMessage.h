@@ -10,10 +10,10 @@ class MidiMessage
 {
 
 public:
-    MidiMessage(qint32 data, int sourceID);
+    MidiMessage(qint32 data, int sourceID, qint64 timestamp = 0);
     MidiMessage();
 
-    static MidiMessage fromVector(std::vector<unsigned char> vector, qint32 sourceID);
+    static MidiMessage fromVector(const std::vector<unsigned char> &vector, qint32 sourceID, qint64 timestamp = 0);
     static MidiMessage fromArray(const char array[4], qint32 sourceID=-1);
 
     int getChannel() const;
@@ -36,11 +36,39 @@ public:
 
     bool isControl() const;
 
+    qint64 getTimestamp() const;
+    void setTimestamp(qint64 timestamp);
+
+    quint32 getFrameOffset() const;
+    void setFrameOffset(quint32 frameOffset);
+
 private:
     qint32 data;
     int sourceID; // the id of the midi device generating the message.
+    qint64 timestamp; // host time (MidiDriver::getHostTime) when the message was received, 0 if unknown
+    quint32 frameOffset; // sample position inside the current audio block
 };
 
+inline qint64 MidiMessage::getTimestamp() const
+{
+    return timestamp;
+}
+
+inline void MidiMessage::setTimestamp(qint64 timestamp)
+{
+    this->timestamp = timestamp;
+}
+
+inline quint32 MidiMessage::getFrameOffset() const
+{
+    return frameOffset;
+}
+
+inline void MidiMessage::setFrameOffset(quint32 frameOffset)
+{
+    this->frameOffset = frameOffset;
+}
+
 inline int MidiMessage::getChannel() const
 {
     return data & 0x0000000F;
@@ -2,11 +2,57 @@
 #include "RtMidi.h"
 
 #include "MidiMessage.h"
+#include "MidiInputQueue.h"
 #include "log/Logging.h"
 
 using midi::RtMidiDriver;
 using midi::MidiMessage;
 
+// RtMidi is calling the callback in his own thread (one thread per stream), the messages are consumed by the audio thread
+class RtMidiDriver::InputStream
+{
+public:
+    explicit InputStream(int deviceIndex) :
+        deviceIndex(deviceIndex)
+    {
+        rtMidi.setCallback(&InputStream::messageReceived, this);
+    }
+
+    inline midi::MidiInputQueue &getMessages()
+    {
+        return messages;
+    }
+
+    inline RtMidiIn &getRtMidi()
+    {
+        return rtMidi;
+    }
+
+private:
+    static void messageReceived(double deltaTime, std::vector<unsigned char> *bytes, void *userData)
+    {
+        Q_UNUSED(deltaTime); // the callback is called when the message arrives, the host clock is more precise than the RtMidi deltas
+
+        auto stream = static_cast<InputStream *>(userData);
+        if (!bytes || !stream)
+            return;
+
+        if (bytes->size() != 3) { // Jamtaba is handling only the 3 bytes common midi messages. Uncommon midi messages will be ignored.
+            qWarning() << "A midi message containing " << bytes->size() << " bytes was received!";
+            return;
+        }
+
+        // never allocating, the message is lost if the audio thread is not consuming
+        stream->messages.enqueue(MidiMessage::fromVector(*bytes, stream->deviceIndex, MidiDriver::getHostTime()));
+    }
+
+    const int deviceIndex;
+    midi::MidiInputQueue messages;
+    RtMidiIn rtMidi; // declared last, the RtMidi thread is stopped before the queue is destroyed
+};
+
+// ++++++++++++++++++++++++++++++++++++++++++++++++++++
+
 RtMidiDriver::RtMidiDriver(const QList<bool> &deviceStatuses){
 
     qCDebug(jtMidi) << "Initializing rtmidi...";
@@ -43,9 +89,8 @@ void RtMidiDriver::setInputDevicesStatus(const QList<bool> &statuses){
     }
 
     MidiDriver::setInputDevicesStatus(validStatuses);
-    for (int s = 0; s < validStatuses.size(); ++s) {
-        midiStreams.append(new RtMidiIn());
-    }
+    for (int s = 0; s < validStatuses.size(); ++s)
+        midiStreams.append(new InputStream(s));
 }
 
 void RtMidiDriver::start(const QList<bool> &deviceStatuses){
@@ -60,7 +105,7 @@ void RtMidiDriver::start(const QList<bool> &deviceStatuses){
 
     for(int deviceIndex=0; deviceIndex < inputDevicesEnabledStatuses.size(); deviceIndex++) {
         if(deviceIndex < midiStreams.size()){
-            RtMidiIn* stream = midiStreams.at(deviceIndex);
+            RtMidiIn* stream = &midiStreams.at(deviceIndex)->getRtMidi();
             if(stream && inputDevicesEnabledStatuses.at(deviceIndex)){//device is globally enabled?
                 if(!stream->isPortOpen()){
                     try{
@@ -82,9 +127,13 @@ void RtMidiDriver::start(const QList<bool> &deviceStatuses){
 
 void RtMidiDriver::stop(){
     qCDebug(jtMidi) << "Stopping RtMidiDriver (closing " << midiStreams.size() << " streams)";
-    foreach (RtMidiIn* stream, midiStreams) {
+    foreach (InputStream* stream, midiStreams) {
         if(stream){
-            stream->closePort();
+            stream->getRtMidi().closePort();
+
+            int droppedMessages = stream->getMessages().takeDroppedMessages();
+            if (droppedMessages > 0)
+                qCWarning(jtMidi) << droppedMessages << "MIDI messages dropped, the audio thread was not consuming!";
         }
     }
    qCDebug(jtMidi) << "RtMidiDriver stoped!";
@@ -97,10 +146,10 @@ void RtMidiDriver::release(){
 
     qCDebug(jtMidi) << "Releasing RtMidiDriver";
 
-    foreach (RtMidiIn* stream, midiStreams) {
+    foreach (InputStream* stream, midiStreams) {
         if(stream){
-            if(stream->isPortOpen()){
-                stream->closePort();
+            if(stream->getRtMidi().isPortOpen()){
+                stream->getRtMidi().closePort();
             }
             delete stream;
         }
@@ -115,33 +164,11 @@ QString RtMidiDriver::getInputDeviceName(uint index) const{
     return "";
 }
 
-void RtMidiDriver::consumeMessagesFromStream(RtMidiIn *stream, int deviceIndex, std::vector<midi::MidiMessage> &outBuffer)
+void RtMidiDriver::getBuffer(std::vector<midi::MidiMessage> &outBuffer)
 {
-    //qCDebug(jtMidi) << "consuming messages from stream - RtMidiDriver";
-    std::vector<unsigned char> messageBytes;
-    do{
-        messageBytes.clear();
-        stream->getMessage(&messageBytes);
-        if (messageBytes.size() == 3) { // Jamtaba is handling only the 3 bytes common midi messages. Uncommon midi messages will be ignored.
-            outBuffer.push_back(midi::MidiMessage::fromVector(messageBytes, deviceIndex));
-        }
-        else{
-            if (!messageBytes.empty())
-                qWarning() << "A midi message containing " << messageBytes.size() << " bytes was received!";
-        }
-    }
-    while(!messageBytes.empty());
-}
-
-std::vector<MidiMessage> RtMidiDriver::getBuffer()
-{
-    std::vector<midi::MidiMessage> buffer;
-    int deviceIndex = 0;
-    for (auto stream : midiStreams) {
-        consumeMessagesFromStream(stream, deviceIndex, buffer);
-        deviceIndex++;
-    }
-    return buffer;
+    // lock free, the messages were enqueued by the RtMidi callbacks
+    for (auto stream : midiStreams)
+        stream->getMessages().dequeue(outBuffer);
 }
 
 bool RtMidiDriver::hasInputDevices() const{
@@ -21,12 +21,12 @@ public:
     bool hasInputDevices() const override;
     int getMaxInputDevices() const override;
     QString getInputDeviceName(uint index) const override;
-    std::vector<midi::MidiMessage> getBuffer() override;
+    void getBuffer(std::vector<midi::MidiMessage> &outBuffer) override;
 
 private:
-    QList<RtMidiIn *> midiStreams;
+    class InputStream;
 
-    void consumeMessagesFromStream(RtMidiIn *stream, int deviceIndex, std::vector<MidiMessage> &outBuffer);
+    QList<InputStream *> midiStreams;
 
 };
 }
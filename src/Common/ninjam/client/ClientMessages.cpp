@@ -247,28 +247,47 @@ void ClientKeepAlive::printDebug(QDebug &dbg) const
 
 //+++++++++++++++++
 
+ClientSetUserMask::ClientSetUserMask() :
+    ClientMessage(MessageType::ClientSetUserMask, 0)
+{
+
+}
+
 ClientSetUserMask::ClientSetUserMask(const QString &userName, quint32 channelsMask) :
-    ClientMessage(MessageType::ClientSetUserMask, 0),
-    userName(userName),
-    channelsMask(channelsMask)
+    ClientMessage(MessageType::ClientSetUserMask, 0)
 {
-    payload = 4; // 4 bytes (int) flag
-    payload += userName.size() + 1;
+    addUserMask(userName, channelsMask);
 }
 
-ClientSetUserMask ClientSetUserMask::from(QIODevice *device, quint32 payload)
+void ClientSetUserMask::addUserMask(const QString &userName, quint32 channelsMask)
 {
-    Q_UNUSED(payload)
+    if (usersMasks.contains(userName))
+        payload -= 4 + userName.toUtf8().size() + 1;
+
+    usersMasks.insert(userName, channelsMask);
+
+    payload += 4; // 4 bytes (int) flag
+    payload += userName.toUtf8().size() + 1;
+}
 
+ClientSetUserMask ClientSetUserMask::from(QIODevice *device, quint32 payload)
+{
     QDataStream stream(device);
     stream.setByteOrder(QDataStream::LittleEndian);
 
-    QString userName(ninjam::extractString(stream));
-    quint32 channelsMask;
+    // the message is a list of (user name, channels mask) pairs
+    ClientSetUserMask msg;
+    quint32 bytesReaded = 0;
+    while (bytesReaded < payload && !stream.atEnd()) {
+        QString userName(ninjam::extractString(stream));
+        quint32 channelsMask = 0;
+        stream >> channelsMask;
 
-    stream >> channelsMask;
+        bytesReaded += userName.toUtf8().size() + 1 + 4;
+        msg.addUserMask(userName, channelsMask);
+    }
 
-    return ClientSetUserMask(userName, channelsMask);
+    return msg;
 }
 
 void ClientSetUserMask::serializeTo(QIODevice *device) const
@@ -281,17 +300,19 @@ void ClientSetUserMask::serializeTo(QIODevice *device) const
 
     //++++++++++++  END HEADER ++++++++++++
 
-    ninjam::serializeString(userName, stream);
-    stream << channelsMask;
+    for (auto userName : usersMasks.keys()) {
+        ninjam::serializeString(userName, stream);
+        stream << usersMasks[userName];
+    }
 }
 
 void ClientSetUserMask::printDebug(QDebug &dbg) const
 {
-    dbg << "SEND ClientSetUserMask{ userName="
-        << userName
-        << " flag="
-        << channelsMask
-        << '}';
+    dbg << "SEND ClientSetUserMask{";
+    for (auto userName : usersMasks.keys())
+        dbg << " userName=" << userName << " flag=" << usersMasks[userName];
+
+    dbg << '}';
 }
 
 //+++++++++++++++++++++++++++++
@@ -7,6 +7,7 @@
 #include <QStringList>
 #include <QDebug>
 #include <QIODevice>
+#include <QMap>
 #include "ninjam/Ninjam.h"
 #include "ninjam/client/Types.h"
 
@@ -119,9 +120,18 @@ public:
     void serializeTo(QIODevice *device) const override;
     void printDebug(QDebug &dbg) const override;
 
+    void addUserMask(const QString &userName, quint32 channelsMask);
+
+    // one message can contain many users, the key is the user full name
+    inline const QMap<QString, quint32> &getUsersMasks() const
+    {
+        return usersMasks;
+    }
+
 private:
-    QString userName;
-    quint32 channelsMask;
+    ClientSetUserMask();
+
+    QMap<QString, quint32> usersMasks;
 };
 
 // +++++++++++++++++++++++++++
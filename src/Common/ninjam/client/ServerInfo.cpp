@@ -23,6 +23,11 @@ ServerInfo::ServerInfo(const QString &host, quint16 port, quint8 maxChannels, qu
 {
 }
 
+ServerInfo::ServerInfo() :
+    ServerInfo(QString(), 0, 0)
+{
+}
+
 ServerInfo::~ServerInfo()
 {
 }
@@ -99,6 +104,15 @@ User ServerInfo::getUser(const QString &userFullName) const
     return User("");
 }
 
+const User *ServerInfo::findUser(const QString &userFullName) const
+{
+    auto user = users.constFind(userFullName);
+    if (user != users.constEnd())
+        return &user.value();
+
+    return nullptr;
+}
+
 QList<User> ServerInfo::getUsers() const
 {
     return users.values();
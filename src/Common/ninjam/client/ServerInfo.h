@@ -3,6 +3,7 @@
 
 #include <QMap>
 #include <QString>
+#include <QMetaType>
 #include "User.h"
 
 namespace ninjam
@@ -17,6 +18,7 @@ namespace client
 
     public:
         ServerInfo(const QString &host, quint16 port, quint8 maxChannels, quint8 maxUsers = 0);
+        ServerInfo(); // necessary to use ServerInfo in queued signals
 
         ~ServerInfo();
 
@@ -27,6 +29,9 @@ namespace client
 
         User getUser(const QString &userFullName) const;
 
+        // return nullptr if the user is not in server. The pointer is valid until the users are changed.
+        const User *findUser(const QString &userFullName) const;
+
         inline void setStreamUrl(const QString &streamUrl)
         {
             this->streamUrl = streamUrl;
@@ -161,4 +166,6 @@ namespace client
 
 } // ninjam ns
 
+Q_DECLARE_METATYPE(ninjam::client::ServerInfo)
+
 #endif
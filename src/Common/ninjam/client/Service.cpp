@@ -10,6 +10,8 @@
 #include <QDataStream>
 #include <QDateTime>
 #include <QTcpSocket>
+#include <QThread>
+#include <QTimer>
 
 using namespace ninjam::client;
 
@@ -27,16 +29,22 @@ class Service::Download
 {
 
 public:
-    Download(const QString &userFullName, quint8 channelIndex, const QByteArray &GUID, bool audio = true) :
+    Download(const QString &userFullName, quint8 channelIndex, const QByteArray &GUID, NetworkUsageMeasurer *measurer, bool audio = true) :
         channelIndex(channelIndex),
         userFullName(userFullName),
         GUID(GUID),
+        downloadedBytes(0),
+        measurer(measurer),
         containsAudio(audio)
     {
 
     }
 
-    Download() // this constructor is necessary to use Download in a QMap without pointers
+    Download() : // this constructor is necessary to use Download in a QHash without pointers
+        channelIndex(0),
+        downloadedBytes(0),
+        measurer(nullptr),
+        containsAudio(true)
     {
         //
     }
@@ -51,9 +59,18 @@ public:
         return containsAudio;
     }
 
+    // the received chunks are implicitly shared with the network messages, the bytes are copied only once in takeEncodedData()
     inline void appendEncodedData(const QByteArray &data)
     {
-        this->vorbisData.append(data);
+        chunks.append(data);
+        downloadedBytes += data.size();
+        if (measurer)
+            measurer->addTransferedBytes(data.size());
+    }
+
+    inline bool isEmpty() const
+    {
+        return chunks.isEmpty();
     }
 
     inline quint8 getChannelIndex() const
@@ -71,16 +88,31 @@ public:
         return GUID;
     }
 
-    inline QByteArray getEncodedData() const
+    QByteArray takeEncodedData() // the full interval, the download is empty after this call
     {
-        return vorbisData;
+        QByteArray encodedData;
+        if (chunks.size() == 1) {
+            encodedData = chunks.first(); // no copy at all
+        }
+        else {
+            encodedData.reserve(downloadedBytes);
+            for (const QByteArray &chunk : chunks)
+                encodedData.append(chunk);
+        }
+
+        chunks.clear();
+        downloadedBytes = 0;
+
+        return encodedData;
     }
 
 private:
     quint8 channelIndex;
     QString userFullName;
     QByteArray GUID; // Global Unique ID
-    QByteArray vorbisData;
+    QList<QByteArray> chunks; // encoded data
+    int downloadedBytes;
+    NetworkUsageMeasurer *measurer; // resolved in interval begin, avoiding the lookups in every received chunk
     bool containsAudio; // audio or video?
 };
 
@@ -90,17 +122,43 @@ Service::Service() :
     lastSendTime(0),
     initialized(false),
     socket(nullptr),
+    networkThread(nullptr),
     messagesHandler(new ServerMessagesHandler(this)),
-    serverKeepAlivePeriod(30)
+    serverKeepAlivePeriod(30),
+    sendBuffer(this), // child object, moved to network thread together with the service
+    flushTimer(new QTimer(this)),
+    queuedBytes(0),
+    sentBytes(0)
 {
+    sendBuffer.buffer().reserve(MAX_COALESCED_BYTES); // the reserved capacity is reused after every flush
+    sendBuffer.open(QIODevice::WriteOnly);
 
+    flushTimer->setSingleShot(true);
+    flushTimer->setInterval(MAX_SEND_DELAY);
+    connect(flushTimer, &QTimer::timeout, this, &Service::flushSendBuffer);
 }
 
 Service::~Service()
+{
+    if (networkThread) {
+        // the socket is closed in the thread where it lives, and the service is moved back to this thread
+        QMetaObject::invokeMethod(this, "detachFromNetworkThread", Qt::BlockingQueuedConnection, Q_ARG(QThread *, QThread::currentThread()));
+
+        networkThread->quit();
+        networkThread->wait();
+        delete networkThread;
+    }
+
+    closeSocket();
+}
+
+void Service::closeSocket()
 {
     if(!socket)
         return;
 
+    flushSendBuffer();
+
     disconnect(socket, SIGNAL(readyRead()), this, SLOT(handleAllReceivedMessages()));
     disconnect(socket, SIGNAL(error(QAbstractSocket::SocketError)), this, SLOT(handleSocketError(QAbstractSocket::SocketError)));
     disconnect(socket, SIGNAL(disconnected()), this, SLOT(handleSocketDisconnection()));
@@ -110,6 +168,65 @@ Service::~Service()
         socket->disconnectFromHost();
 }
 
+void Service::startNetworkThread()
+{
+    if (networkThread)
+        return;
+
+    // the signals are queued when the receivers are living in other threads
+    qRegisterMetaType<User>();
+    qRegisterMetaType<UserChannel>();
+    qRegisterMetaType<ServerInfo>();
+
+    networkThread = new QThread();
+    networkThread->setObjectName("NINJAM network");
+    moveToThread(networkThread); // the socket is created later, in the network thread
+    networkThread->start(QThread::HighPriority);
+}
+
+void Service::detachFromNetworkThread(QThread *targetThread)
+{
+    executePendingCalls(); // the last calls (disconnect from server, for example)
+
+    closeSocket();
+    delete socket;
+    socket = nullptr;
+
+    flushTimer->stop();
+
+    moveToThread(targetThread);
+}
+
+void Service::runInServiceThread(const std::function<void()> &call)
+{
+    if (QThread::currentThread() == thread()) {
+        call();
+        return;
+    }
+
+    bool needSchedule = false;
+    {
+        QMutexLocker locker(&pendingCallsMutex);
+        needSchedule = pendingCalls.isEmpty(); // only one scheduled execution for all pending calls
+        pendingCalls.enqueue(call);
+    }
+
+    if (needSchedule)
+        QMetaObject::invokeMethod(this, "executePendingCalls", Qt::QueuedConnection);
+}
+
+void Service::executePendingCalls()
+{
+    QQueue<std::function<void()>> calls;
+    {
+        QMutexLocker locker(&pendingCallsMutex);
+        calls.swap(pendingCalls);
+    }
+
+    for (const auto &call : calls)
+        call();
+}
+
 void Service::setupSocketSignals()
 {
     Q_ASSERT(socket);
@@ -119,26 +236,47 @@ void Service::setupSocketSignals()
     connect(socket, SIGNAL(connected()), this, SLOT(handleSocketConnection()));
 
     connect(socket, &QTcpSocket::bytesWritten, [&](quint64 bytesWritten){
+        QMutexLocker locker(&mutex);
         totalUploadMeasurer.addTransferedBytes(bytesWritten);
+
+        sentBytes += bytesWritten;
+        if (uploadScheduler.bytesSent(sentBytes, socket->bytesToWrite(), QDateTime::currentMSecsSinceEpoch()) && uploadScheduler.lastIntervalWasLate())
+            qCWarning(jtNinjamProtocol) << "Interval uploaded" << -uploadScheduler.getUploadHeadroom() << "ms after the deadline!";
     });
 }
 
 void Service::sendIntervalPart(const QByteArray &GUID, const QByteArray &encodedData, bool isLastPart)
 {
-    if (!initialized)
-        return;
+    runInServiceThread([=]() {
+        if (!initialized)
+            return;
+
+        auto msg = UploadIntervalWrite(GUID, encodedData, isLastPart);
+        sendMessageToServer(msg);
 
-    auto msg = UploadIntervalWrite(GUID, encodedData, isLastPart);
-    sendMessageToServer(msg);
+        if (isLastPart) {
+            // the other users will play this interval in the next interval, this is the upload deadline
+            qint64 deadline = QDateTime::currentMSecsSinceEpoch() + static_cast<qint64>(getIntervalPeriod());
+
+            {
+                QMutexLocker locker(&mutex);
+                uploadScheduler.intervalFinished(queuedBytes, deadline); // registered before the bytes are written in socket
+            }
+
+            flushSendBuffer(); // the interval end is not delayed
+        }
+    });
 }
 
 void Service::sendIntervalBegin(const QByteArray &GUID, quint8 channelIndex, bool isAudioInterval)
 {
-    if (!initialized)
-        return;
+    runInServiceThread([=]() {
+        if (!initialized)
+            return;
 
-    auto msg = UploadIntervalBegin(GUID, channelIndex, isAudioInterval);
-    sendMessageToServer(msg);
+        auto msg = UploadIntervalBegin(GUID, channelIndex, isAudioInterval);
+        sendMessageToServer(msg);
+    });
 }
 
 // +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
@@ -155,13 +293,22 @@ void Service::handleAllReceivedMessages()
 
     qint64 bytesProcessed = bytesAvailable - (bytesAvailable - socket->bytesAvailable());
 
+    QMutexLocker locker(&mutex);
     totalDownloadMeasurer.addTransferedBytes(bytesProcessed);
 }
 
 void Service::clear()
 {
+    flushTimer->stop();
+    sendBuffer.seek(0);
+    sendBuffer.buffer().resize(0); // discarding the messages not sended
+
+    QMutexLocker locker(&mutex);
     initialized = false;
     currentServer.reset();
+    queuedBytes = 0;
+    sentBytes = 0;
+    uploadScheduler.reset();
 }
 
 void Service::handleSocketError(QAbstractSocket::SocketError e)
@@ -212,6 +359,7 @@ QStringList Service::buildBotNamesList()
 
 QString Service::getConnectedUserName() const
 {
+    QMutexLocker locker(&mutex);
     if (initialized)
         return userName;
     qCritical() << "not initialized, newUserName is not available!";
@@ -220,49 +368,93 @@ QString Service::getConnectedUserName() const
 
 float Service::getIntervalPeriod() const
 {
+    QMutexLocker locker(&mutex);
     if (currentServer)
         return 60000.0f / currentServer->getBpm() * currentServer->getBpi();
 
     return 0.0f;
 }
 
+QSharedPointer<ServerInfo> Service::getCurrentServer() const
+{
+    QMutexLocker locker(&mutex);
+    if (currentServer)
+        return QSharedPointer<ServerInfo>::create(*currentServer);
+
+    return QSharedPointer<ServerInfo>();
+}
+
 void Service::voteToChangeBPI(quint16 newBPI)
 {
     QString text = "!vote bpi " + QString::number(newBPI);
-    sendMessageToServer(ClientToServerChatMessage::buildPublicMessage(text));
+    runInServiceThread([=]() {
+        sendMessageToServer(ClientToServerChatMessage::buildPublicMessage(text));
+    });
 }
 
 void Service::voteToChangeBPM(quint16 newBPM)
 {
     QString text = "!vote bpm " + QString::number(newBPM);
-    sendMessageToServer(ClientToServerChatMessage::buildPublicMessage(text));
+    runInServiceThread([=]() {
+        sendMessageToServer(ClientToServerChatMessage::buildPublicMessage(text));
+    });
 }
 
 void Service::sendPrivateChatMessage(const QString &message, const QString &destinationUser)
 {
-    sendMessageToServer(ClientToServerChatMessage::buildPrivateMessage(message, destinationUser));
+    runInServiceThread([=]() {
+        sendMessageToServer(ClientToServerChatMessage::buildPrivateMessage(message, destinationUser));
+    });
 }
 
 void Service::sendPublicChatMessage(const QString &message)
 {
-    sendMessageToServer(ClientToServerChatMessage::buildPublicMessage(message));
+    runInServiceThread([=]() {
+        sendMessageToServer(ClientToServerChatMessage::buildPublicMessage(message));
+    });
 }
 
 void Service::sendAdminCommand(const QString &message)
 {
-    auto msg = ClientToServerChatMessage::buildAdminMessage(message);
-    sendMessageToServer(msg);
+    runInServiceThread([=]() {
+        auto msg = ClientToServerChatMessage::buildAdminMessage(message);
+        sendMessageToServer(msg);
+    });
 }
 
-void Service::sendMessageToServer(const ClientMessage &message)
+void Service::sendMessageToServer(const ClientMessage &message, bool flushNow)
 {
     if (!socket)
         return;
 
-    message.serializeTo(socket);
+    const qint64 initialPosition = sendBuffer.pos();
+    message.serializeTo(&sendBuffer);
+
+    {
+        QMutexLocker locker(&mutex);
+        queuedBytes += sendBuffer.pos() - initialPosition;
+    }
 
-    socket->flush();
     lastSendTime = QDateTime::currentMSecsSinceEpoch();
+
+    if (flushNow || sendBuffer.size() >= MAX_COALESCED_BYTES)
+        flushSendBuffer();
+    else if (!flushTimer->isActive())
+        flushTimer->start(); // the small messages (voice chat) are written together in the deadline
+}
+
+void Service::flushSendBuffer()
+{
+    flushTimer->stop();
+
+    if (!socket || sendBuffer.size() == 0)
+        return;
+
+    socket->write(sendBuffer.data());
+    socket->flush();
+
+    sendBuffer.seek(0);
+    sendBuffer.buffer().resize(0); // keeping the reserved capacity
 }
 
 bool Service::needSendKeepAlive() const
@@ -277,6 +469,7 @@ void Service::process(const UserInfoChangeNotifyMessage &msg)
 
     for (const User &user : msg.getUsers()) {
         if (!currentServer->containsUser(user)) {
+            QMutexLocker locker(&mutex);
             currentServer->addUser(user);
         }
 
@@ -291,17 +484,22 @@ void Service::process(const UserInfoChangeNotifyMessage &msg)
 
 void Service::setChannelReceiveStatus(const QString &userFullName, quint8 channelIndex, bool receiveChannel)
 {
-    if (currentServer->containsUser(userFullName)) {
-        currentServer->updateUserChannelReceiveStatus(userFullName, channelIndex, receiveChannel);
+    runInServiceThread([=]() {
+        if (currentServer && currentServer->containsUser(userFullName)) {
+            {
+                QMutexLocker locker(&mutex);
+                currentServer->updateUserChannelReceiveStatus(userFullName, channelIndex, receiveChannel);
+            }
 
-        User user = currentServer->getUser(userFullName);
-        quint32 channelsMask = 0;
-        for (const UserChannel &channel : user.getChannels()) {
-            if (channel.isActive() || (channel.getIndex() == channelIndex && receiveChannel))
-                channelsMask |= 1 << channel.getIndex();
+            const User *user = currentServer->findUser(userFullName);
+            quint32 channelsMask = 0;
+            for (const UserChannel &channel : user->getChannels()) {
+                if (channel.isActive() || (channel.getIndex() == channelIndex && receiveChannel))
+                    channelsMask |= 1 << channel.getIndex();
+            }
+            sendMessageToServer(ClientSetUserMask(userFullName, channelsMask));
         }
-        sendMessageToServer(ClientSetUserMask(userFullName, channelsMask));
-    }
+    });
 }
 
 void Service::process(const DownloadIntervalBegin &msg)
@@ -310,39 +508,55 @@ void Service::process(const DownloadIntervalBegin &msg)
         quint8 channelIndex = msg.getChannelIndex();
         QString userFullName = msg.getUserName();
         QByteArray GUID = msg.getGUID();
-        downloads.insert(GUID, Download(userFullName, channelIndex, GUID, msg.isAudio()));
+
+        // QMap nodes are not moved when new keys are inserted, the pointer is valid while the service is alive
+        QMutexLocker locker(&mutex);
+        NetworkUsageMeasurer *measurer = &channelDownloadMeasurers[userFullName][channelIndex];
+        downloads.insert(GUID, Download(userFullName, channelIndex, GUID, measurer, msg.isAudio()));
     }
 }
 
 void Service::process(const DownloadIntervalWrite &msg)
 {
-    if (downloads.contains(msg.getGUID())) {
-        Download &download = downloads[msg.getGUID()];
-
-        bool isFirstPart = download.getEncodedData().isEmpty();
+    auto downloadIterator = downloads.find(msg.getGUID());
+    if (downloadIterator != downloads.end()) {
+        Download &download = downloadIterator.value();
 
-        download.appendEncodedData(msg.getEncodedData());
+        const QByteArray encodedData = msg.getEncodedData();
+        bool isFirstPart = download.isEmpty();
 
-        auto &measurer = channelDownloadMeasurers[download.getUserFullName()][download.getChannelIndex()];
-        auto bytesReceived = msg.getEncodedData().size();
-        measurer.addTransferedBytes(bytesReceived);
+        {
+            QMutexLocker locker(&mutex); // the download measurer is readed in other threads
+            download.appendEncodedData(encodedData);
+        }
 
-        User user = currentServer->getUser(download.getUserFullName());
+        const User *user = currentServer ? currentServer->findUser(download.getUserFullName()) : nullptr;
+        if (!user) {
+            if (msg.downloadIsComplete())
+                downloads.erase(downloadIterator);
+            return;
+        }
 
+        const quint8 channelIndex = download.getChannelIndex();
         if (download.isAudio()) {
-            if (user.getChannel(download.getChannelIndex()).isActive()) {
-                if (msg.downloadIsComplete()) {
-                    emit audioIntervalDownloading(user, download.getChannelIndex(), msg.getEncodedData(), isFirstPart, true); // the last chunk
-                    emit audioIntervalCompleted(user, download.getChannelIndex(), download.getEncodedData()); // full interval
-                    downloads.remove(msg.getGUID());
+            const bool channelIsActive = user->channelIsActive(channelIndex);
+            if (msg.downloadIsComplete()) {
+                const QByteArray fullInterval = download.takeEncodedData();
+                downloads.erase(downloadIterator); // erasing before emit, the slots can change the downloads
+
+                if (channelIsActive) {
+                    emit audioIntervalDownloading(*user, channelIndex, encodedData, isFirstPart, true); // the last chunk
+                    emit audioIntervalCompleted(*user, channelIndex, fullInterval); // full interval, shared (not copied) with the receivers
                 }
-                else
-                    emit audioIntervalDownloading(user, download.getChannelIndex(), msg.getEncodedData(), isFirstPart, false);
-             }
+            }
+            else if (channelIsActive) {
+                emit audioIntervalDownloading(*user, channelIndex, encodedData, isFirstPart, false);
+            }
         }
         else if (msg.downloadIsComplete()) { // download is video
-            emit videoIntervalCompleted(user, download.getEncodedData());
-            downloads.remove(msg.getGUID());
+            const QByteArray fullInterval = download.takeEncodedData();
+            downloads.erase(downloadIterator);
+            emit videoIntervalCompleted(*user, fullInterval);
         }
     } else {
         qCritical() << "GUID is not in map!";
@@ -359,40 +573,51 @@ void Service::process(const AuthChallengeMessage &msg)
     ClientAuthUserMessage msgAuthUser(userName, msg.getChallenge(),
                                       msg.getProtocolVersion(), password);
     sendMessageToServer(msgAuthUser);
+
+    QMutexLocker locker(&mutex);
     serverLicence = msg.getLicenceAgreement();
     serverKeepAlivePeriod = msg.getServerKeepAlivePeriod();
 }
 
 void Service::sendNewChannelsListToServer(const QList<ChannelMetadata> &channels)
 {
-    this->channels = channels;
+    runInServiceThread([=]() {
+        this->channels = channels;
 
-    ClientSetChannel msg;
-    for (auto channelMetadata : channels) {
-        msg.addChannel(channelMetadata.name, ClientSetChannel::toFlags(channelMetadata.voiceChatActivated));
-    }
+        ClientSetChannel msg;
+        for (auto channelMetadata : channels) {
+            msg.addChannel(channelMetadata.name, ClientSetChannel::toFlags(channelMetadata.voiceChatActivated));
+        }
 
-    sendMessageToServer(msg);
+        sendMessageToServer(msg);
+    });
 }
 
 void Service::sendRemovedChannelIndex(int removedChannelIndex)
 {
-    Q_ASSERT(removedChannelIndex >= 0 && removedChannelIndex < channels.size());
+    runInServiceThread([=]() {
+        Q_ASSERT(removedChannelIndex >= 0 && removedChannelIndex < channels.size());
 
-    channels.removeAt(removedChannelIndex);
+        channels.removeAt(removedChannelIndex);
 
-    // send only remaining channels to server, the removed channel will be excluded in the clients
-    sendNewChannelsListToServer(channels);
+        // send only remaining channels to server, the removed channel will be excluded in the clients
+        sendNewChannelsListToServer(channels);
+    });
 }
 
 void Service::process(const AuthReplyMessage &msg)
 {
     if (msg.userIsAuthenticated() && socket) {
-        userName = msg.getNewUserName(); // replace the user name with the (possible) new name generated by the ninjam server
+        {
+            QMutexLocker locker(&mutex);
+            userName = msg.getNewUserName(); // replace the user name with the (possible) new name generated by the ninjam server
+        }
         sendMessageToServer(ClientSetChannel(channels));
         quint8 serverMaxChannels = msg.getMaxChannels();
         QString serverIp = socket->peerName();
         quint16 serverPort = socket->peerPort();
+
+        QMutexLocker locker(&mutex);
         currentServer.reset(new ServerInfo(serverIp, serverPort, serverMaxChannels));
     }
     // when user is not authenticated the socketErrorSlot is called and dispatch an error signal
@@ -402,7 +627,15 @@ void Service::startServerConnection(const QString &serverIp, int serverPort,
                                     const QString &userName, const QList<ChannelMetadata> &channels,
                                     const QString &password)
 {
+    runInServiceThread([=]() {
+        connectToServer(serverIp, serverPort, userName, channels, password);
+    });
+}
 
+void Service::connectToServer(const QString &serverIp, int serverPort,
+                              const QString &userName, const QList<ChannelMetadata> &channels,
+                              const QString &password)
+{
     clear(); // reset some internal state
 
     if (!socket) {
@@ -414,7 +647,10 @@ void Service::startServerConnection(const QString &serverIp, int serverPort,
     }
     Q_ASSERT(socket);
 
-    this->userName = userName;
+    {
+        QMutexLocker locker(&mutex);
+        this->userName = userName;
+    }
     this->password = password;
     this->channels = channels;
 
@@ -427,18 +663,27 @@ void Service::startServerConnection(const QString &serverIp, int serverPort,
 
 void Service::disconnectFromServer(bool emitDisconnectedSignal)
 {
-    if (socket && socket->isOpen()) {
-        qCDebug(jtNinjamProtocol) << "disconnecting from " << socket->peerName();
-        if (!emitDisconnectedSignal)
-            socket->blockSignals(true); // avoid generate events when disconnecting/exiting
-        socket->disconnectFromHost();
-    }
+    runInServiceThread([=]() {
+        if (socket && socket->isOpen()) {
+            flushSendBuffer();
+            qCDebug(jtNinjamProtocol) << "disconnecting from " << socket->peerName();
+            if (!emitDisconnectedSignal)
+                socket->blockSignals(true); // avoid generate events when disconnecting/exiting
+            socket->disconnectFromHost();
+        }
+    });
 }
 
 void Service::setBpm(quint16 newBpm)
 {
     Q_ASSERT(currentServer);
-    if (currentServer->setBpm(newBpm) && initialized)
+    bool bpmChanged = false;
+    {
+        QMutexLocker locker(&mutex);
+        bpmChanged = currentServer->setBpm(newBpm);
+    }
+
+    if (bpmChanged && initialized)
         emit serverBpmChanged(currentServer->getBpm());
 }
 
@@ -446,7 +691,13 @@ void Service::setBpi(quint16 bpi)
 {
     Q_ASSERT(currentServer);
     quint16 lastBpi = currentServer->getBpi();
-    if (currentServer->setBpi(bpi) && initialized)
+    bool bpiChanged = false;
+    {
+        QMutexLocker locker(&mutex);
+        bpiChanged = currentServer->setBpi(bpi);
+    }
+
+    if (bpiChanged && initialized)
         emit serverBpiChanged(currentServer->getBpi(), lastBpi);
 }
 
@@ -458,18 +709,27 @@ void Service::handleUserChannels(const User &remoteUser)
     for (const UserChannel &serverChannel : remoteUser.getChannels()) {
         if (serverChannel.isActive()) {
             if (!localUser.hasChannel(serverChannel.getIndex())) {
-                currentServer->addUserChannel(remoteUser.getFullName(), serverChannel);
+                {
+                    QMutexLocker locker(&mutex);
+                    currentServer->addUserChannel(remoteUser.getFullName(), serverChannel);
+                }
                 emit userChannelCreated(localUser, serverChannel);
             } else { // check for channel updates
                 if (localUser.hasChannels()) {
                     if (channelIsOutdate(localUser, serverChannel)) {
-                        currentServer->updateUserChannel(remoteUser.getFullName(), serverChannel);
+                        {
+                            QMutexLocker locker(&mutex);
+                            currentServer->updateUserChannel(remoteUser.getFullName(), serverChannel);
+                        }
                         emit userChannelUpdated(localUser, serverChannel);
                     }
                 }
             }
         } else {
-            currentServer->removeUserChannel(remoteUser.getFullName(), serverChannel);
+            {
+                QMutexLocker locker(&mutex);
+                currentServer->removeUserChannel(remoteUser.getFullName(), serverChannel);
+            }
             emit userChannelRemoved(localUser, serverChannel);
         }
     }
@@ -496,8 +756,10 @@ void Service::process(const ServerToClientChatMessage &msg)
     case ChatCommandType::JOIN:
     {
         QString userName = msg.getArguments().at(0);
-        if (currentServer)
+        if (currentServer) {
+            QMutexLocker locker(&mutex);
             currentServer->addUser(User(userName));
+        }
         emit userEntered(User(userName));
         break;
     }
@@ -511,8 +773,10 @@ void Service::process(const ServerToClientChatMessage &msg)
     case ChatCommandType::PART:
     {
         QString userLeavingTheServer = msg.getArguments().at(0);
-        if (currentServer)
+        if (currentServer) {
+            QMutexLocker locker(&mutex);
             currentServer->removeUser(userLeavingTheServer);
+        }
         emit userExited(User(userLeavingTheServer));
         break;
     }
@@ -529,6 +793,8 @@ void Service::process(const ServerToClientChatMessage &msg)
             return;
 
         QString topicText = msg.getArguments().at(1);
+
+        QMutexLocker locker(&mutex);
         currentServer->setTopic(topicText);
 
         if (!initialized) {
@@ -536,10 +802,13 @@ void Service::process(const ServerToClientChatMessage &msg)
 
             // server licence is received when the hand shake with server is started
             currentServer->setLicence(serverLicence);
+            locker.unlock();
+
             emit connectedInServer(*currentServer);
             emit serverTopicMessageReceived(topicText);
         }
         else {
+            locker.unlock();
             emit serverTopicMessageReceived(topicText);
         }
         break;
@@ -575,11 +844,37 @@ QTcpSocket * Service::createSocket()
 
 QString Service::getCurrentServerLicence() const
 {
+    QMutexLocker locker(&mutex);
     return serverLicence;
 }
 
 long Service::getDownloadTransferRate(const QString userFullName, quint8 channelIndex) const
 {
+    QMutexLocker locker(&mutex);
     const auto &measurer = channelDownloadMeasurers[userFullName][channelIndex];
     return measurer.getTransferRate();
 }
+
+long Service::getTotalDownloadTransferRate() const
+{
+    QMutexLocker locker(&mutex);
+    return totalDownloadMeasurer.getTransferRate();
+}
+
+qint64 Service::getUploadHeadroom() const
+{
+    QMutexLocker locker(&mutex);
+    return uploadScheduler.getUploadHeadroom();
+}
+
+long Service::getTotalUploadTransferRate() const
+{
+    QMutexLocker locker(&mutex);
+    return totalUploadMeasurer.getTransferRate();
+}
+
+int Service::getUploadChunkSize(qint64 msToIntervalEnd, bool voiceChatActivated) const
+{
+    QMutexLocker locker(&mutex);
+    return uploadScheduler.getChunkSize(msToIntervalEnd, voiceChatActivated);
+}
@@ -3,13 +3,24 @@
 
 #include "log/Logging.h"
 #include "ninjam/Ninjam.h"
+#include "UploadScheduler.h"
 
 #include <QtGlobal>
 #include <QScopedPointer>
 #include <QTcpSocket>
 #include <QByteArray>
+#include <QHash>
 #include <QDataStream>
 #include <QStringList>
+#include <QMutex>
+#include <QQueue>
+#include <QSharedPointer>
+#include <QBuffer>
+
+#include <functional>
+
+class QThread;
+class QTimer;
 
 namespace ninjam
 {
@@ -47,6 +58,11 @@ namespace client
         ~Service();
         static bool isBotName(const QString &userName);
 
+        // Move the socket I/O and the messages parsing to a dedicated thread, so GUI stalls are not
+        // delaying the downloads and keep alives. The public functions can be called from any thread
+        // (they are executed in the network thread) and the signals are emitted in the network thread.
+        void startNetworkThread();
+
         void sendPublicChatMessage(const QString &message);
         void sendPrivateChatMessage(const QString &message, const QString &destinationUser);
         void sendAdminCommand(const QString &message);
@@ -71,13 +87,15 @@ namespace client
         void voteToChangeBPM(quint16 newBPM);
         void voteToChangeBPI(quint16 newBPI);
 
-        inline ServerInfo *getCurrentServer() const { return currentServer.data(); }
+        QSharedPointer<ServerInfo> getCurrentServer() const; // a copy, null if not connected
 
         static QStringList getBotNamesList();
 
         long getTotalUploadTransferRate() const;
+        int getUploadChunkSize(qint64 msToIntervalEnd, bool voiceChatActivated) const; // adapted to the measured uplink rate and headroom
         long getTotalDownloadTransferRate() const;
         long getDownloadTransferRate(const QString userFullName, quint8 channelIndex) const;
+        qint64 getUploadHeadroom() const; // ms between the last uploaded byte of an interval and the deadline (next interval end)
 
     signals:
         void userChannelCreated(const User &user, const UserChannel &channel);
@@ -117,6 +135,9 @@ namespace client
         void handleSocketDisconnection();
         void handleSocketConnection();
 
+        void executePendingCalls();
+        void detachFromNetworkThread(QThread *targetThread);
+
     private:
         QScopedPointer<ServerMessagesHandler> messagesHandler;
 
@@ -124,6 +145,15 @@ namespace client
 
         QTcpSocket* socket;
 
+        QThread *networkThread;
+
+        // calls from other threads, executed in the network thread (in order)
+        QMutex pendingCallsMutex;
+        QQueue<std::function<void()>> pendingCalls;
+        void runInServiceThread(const std::function<void()> &call);
+
+        mutable QMutex mutex; // protecting the data read by other threads (server infos, user name, licence and transfer rates)
+
         static const QStringList botNames;
         static QStringList buildBotNamesList();
 
@@ -142,7 +172,20 @@ namespace client
         NetworkUsageMeasurer totalDownloadMeasurer;
         QMap<QString, QMap<quint8, NetworkUsageMeasurer>> channelDownloadMeasurers; // using userFullName as key in first QMap and channel ID as key in second map
 
-        void sendMessageToServer(const ClientMessage &message);
+        // the messages are coalesced in one socket write, flushed when the buffer is full or in MAX_SEND_DELAY
+        QBuffer sendBuffer;
+        QTimer *flushTimer;
+        quint64 queuedBytes; // total bytes sended to socket
+        quint64 sentBytes; // total bytes written by socket in the network
+        UploadScheduler uploadScheduler;
+
+        static const int MAX_SEND_DELAY = 5; // ms
+        static const int MAX_COALESCED_BYTES = 8192;
+
+        void sendMessageToServer(const ClientMessage &message, bool flushNow = false);
+        void flushSendBuffer();
+        void connectToServer(const QString &serverIp, int serverPort, const QString &userName,
+                             const QList<ChannelMetadata> &channels, const QString &password);
         void handleUserChannels(const User &remoteUser);
         bool channelIsOutdate(const User &user, const UserChannel &serverChannel);
 
@@ -150,26 +193,17 @@ namespace client
         void setBpi(quint16 newBpi);
 
         class Download; // using a nested class here. This class is for internal purpouses only.
-        QMap<QByteArray, Download> downloads; // using GUID as key
+        QHash<QByteArray, Download> downloads; // using GUID as key
 
         bool needSendKeepAlive() const;
 
         void clear();
 
         void setupSocketSignals();
+        void closeSocket();
 
     };
 
-    inline long Service::getTotalDownloadTransferRate() const
-    {
-        return totalDownloadMeasurer.getTransferRate();
-    }
-
-    inline long Service::getTotalUploadTransferRate() const
-    {
-        return totalUploadMeasurer.getTransferRate();
-    }
-
     inline QStringList Service::getBotNamesList()
     {
         return botNames;
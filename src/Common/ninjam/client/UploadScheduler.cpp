@@ -0,0 +1,98 @@
+#include "UploadScheduler.h"
+
+using ninjam::client::UploadScheduler;
+
+UploadScheduler::UploadScheduler() :
+    lastHeadroom(0),
+    backlogSampled(false),
+    lastSentBytes(0),
+    lastBacklog(0),
+    lastSampleTime(0),
+    measuredBytes(0),
+    measuredTime(0),
+    saturated(true),
+    uplinkRate(0)
+{
+
+}
+
+int UploadScheduler::getChunkSize(long uplinkBytesPerSecond, qint64 msToIntervalEnd, bool voiceChatActivated)
+{
+    if (voiceChatActivated)
+        return 1; // sending all small packets, the service is coalescing the writes
+
+    if (uplinkBytesPerSecond <= 0)
+        return DEFAULT_CHUNK_SIZE;
+
+    // a quarter of the remaining interval time, so the data is not accumulated in the interval end
+    qint64 maxDelay = qBound(static_cast<qint64>(0), msToIntervalEnd / 4, static_cast<qint64>(MAX_CHUNK_DELAY));
+
+    qint64 chunkSize = uplinkBytesPerSecond * maxDelay / 1000;
+
+    return static_cast<int>(qBound(static_cast<qint64>(MIN_CHUNK_SIZE), chunkSize, static_cast<qint64>(MAX_CHUNK_SIZE)));
+}
+
+int UploadScheduler::getChunkSize(qint64 msToIntervalEnd, bool voiceChatActivated) const
+{
+    if (lastIntervalWasLate() && !voiceChatActivated)
+        return MIN_CHUNK_SIZE; // the uplink is not keeping up, the data is sent as soon as possible
+
+    return getChunkSize(uplinkRate, msToIntervalEnd, voiceChatActivated);
+}
+
+void UploadScheduler::intervalFinished(quint64 lastBytePosition, qint64 deadline)
+{
+    FinishedInterval interval;
+    interval.lastBytePosition = lastBytePosition;
+    interval.deadline = deadline;
+    finishedIntervals.enqueue(interval);
+}
+
+bool UploadScheduler::bytesSent(quint64 totalSentBytes, qint64 socketBacklog, qint64 now)
+{
+    if (backlogSampled) {
+        measuredBytes += totalSentBytes - lastSentBytes;
+        measuredTime += now - lastSampleTime;
+        if (lastBacklog <= 0 || socketBacklog <= 0)
+            saturated = false; // the socket was waiting for data in some moment
+    }
+
+    backlogSampled = true;
+    lastSentBytes = totalSentBytes;
+    lastBacklog = socketBacklog;
+    lastSampleTime = now;
+
+    if (measuredTime >= UPLINK_MEASURE_PERIOD) {
+        long measuredRate = static_cast<long>(measuredBytes * 1000 / measuredTime);
+        if (saturated || (uplinkRate > 0 && measuredRate > uplinkRate))
+            uplinkRate = measuredRate; // a lower bound is used only to increase a measured rate
+
+        measuredBytes = 0;
+        measuredTime = 0;
+        saturated = true;
+    }
+
+    bool intervalSent = false;
+    while (!finishedIntervals.isEmpty() && totalSentBytes >= finishedIntervals.head().lastBytePosition) {
+        FinishedInterval interval = finishedIntervals.dequeue();
+        lastHeadroom = interval.deadline - now;
+        intervalSent = true;
+    }
+
+    return intervalSent;
+}
+
+void UploadScheduler::reset()
+{
+    finishedIntervals.clear();
+    lastHeadroom = 0;
+
+    backlogSampled = false;
+    lastSentBytes = 0;
+    lastBacklog = 0;
+    lastSampleTime = 0;
+    measuredBytes = 0;
+    measuredTime = 0;
+    saturated = true;
+    uplinkRate = 0;
+}
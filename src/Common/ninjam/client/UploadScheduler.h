@@ -0,0 +1,88 @@
+#ifndef UPLOAD_SCHEDULER_H
+#define UPLOAD_SCHEDULER_H
+
+#include <QtGlobal>
+#include <QQueue>
+
+namespace ninjam
+{
+
+namespace client
+{
+    /**
+        Decide how many encoded bytes are accumulated before send an interval part and measure the
+        upload headroom. The last byte of an interval must be sent before the end of the next interval
+        (when the other users will play it), the headroom is the time left when the last byte was sent.
+
+        The uplink rate is measured by the socket backlog (the bytes not written in the network yet):
+        while the backlog is not empty the socket is draining at the uplink speed. When the backlog
+        is empty the uplink is faster than Jamtaba is writing, the measured rate is a lower bound.
+    */
+
+    class UploadScheduler
+    {
+
+    public:
+        UploadScheduler();
+
+        // Chunks are big when the uplink is fast and the interval end is far, and small when the uplink
+        // is slow or the interval is ending, avoiding a big backlog in the interval end.
+        static int getChunkSize(long uplinkBytesPerSecond, qint64 msToIntervalEnd, bool voiceChatActivated);
+
+        // using the measured uplink rate, the chunks are minimal when the last interval was late
+        int getChunkSize(qint64 msToIntervalEnd, bool voiceChatActivated) const;
+
+        void intervalFinished(quint64 lastBytePosition, qint64 deadline); // position in the bytes stream sended to server
+
+        // 'socketBacklog' is the amount of bytes waiting in the socket after the write, return true when the last byte of an interval was sent
+        bool bytesSent(quint64 totalSentBytes, qint64 socketBacklog, qint64 now);
+
+        inline long getUplinkRate() const // bytes per second, zero if not measured yet
+        {
+            return uplinkRate;
+        }
+
+        inline qint64 getUploadHeadroom() const // milliseconds, negative when the last interval was late
+        {
+            return lastHeadroom;
+        }
+
+        inline bool lastIntervalWasLate() const
+        {
+            return lastHeadroom < 0;
+        }
+
+        void reset();
+
+        static const int MIN_CHUNK_SIZE = 512;
+        static const int MAX_CHUNK_SIZE = 16384;
+        static const int DEFAULT_CHUNK_SIZE = 4096; // used when the uplink rate is not measured yet
+        static const int MAX_CHUNK_DELAY = 250; // ms, max time accumulating data before send
+        static const int UPLINK_MEASURE_PERIOD = 500; // ms draining the socket backlog to compute the uplink rate
+
+    private:
+        struct FinishedInterval
+        {
+            quint64 lastBytePosition;
+            qint64 deadline;
+        };
+
+        QQueue<FinishedInterval> finishedIntervals; // intervals with bytes waiting in the socket
+        qint64 lastHeadroom;
+
+        bool backlogSampled;
+        quint64 lastSentBytes;
+        qint64 lastBacklog;
+        qint64 lastSampleTime;
+
+        quint64 measuredBytes; // accumulated until UPLINK_MEASURE_PERIOD
+        qint64 measuredTime;
+        bool saturated; // the backlog was never empty in the measure period
+        long uplinkRate;
+    };
+
+} // ns
+
+} // ns
+
+#endif // UPLOAD_SCHEDULER_H
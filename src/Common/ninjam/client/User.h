@@ -2,6 +2,7 @@
 #define USER_H
 
 #include <QMap>
+#include <QMetaType>
 #include "UserChannel.h"
 
 namespace ninjam
@@ -48,6 +49,12 @@ namespace client
 
         UserChannel getChannel(quint8 index) const;
 
+        inline bool channelIsActive(quint8 index) const // avoid copy the channel
+        {
+            auto channel = channels.constFind(index);
+            return channel != channels.constEnd() && channel->isActive();
+        }
+
         inline QString getIp() const
         {
             return ip;
@@ -88,4 +95,6 @@ namespace client
 
 } // ns
 
+Q_DECLARE_METATYPE(ninjam::client::User)
+
 #endif
@@ -3,6 +3,7 @@
 
 #include <QtGlobal>
 #include <QString>
+#include <QMetaType>
 
 namespace ninjam
 {
@@ -99,4 +100,6 @@ namespace client
 } // ns
 } // ns
 
+Q_DECLARE_METATYPE(ninjam::client::UserChannel)
+
 #endif // USERCHANNEL_H
@@ -6,6 +6,7 @@
 #include <QNetworkInterface>
 #include <QDateTime>
 #include <QTcpServer>
+#include <QBuffer>
 
 #include "ninjam/Ninjam.h"
 #include "ninjam/client/ServerMessages.h"
@@ -64,10 +65,35 @@ AdminCommand getAdminCommand(const QString &cmd)
     return AdminCommand::Invalid;
 }
 
+// Serialize the message only once, the same bytes are written in all recipient sockets (each
+// socket copies them in its own write buffer, but the message is not serialized again).
+template <class Message>
+QByteArray serialize(const Message &msg)
+{
+    QByteArray bytes;
+    QBuffer buffer(&bytes);
+    buffer.open(QIODevice::WriteOnly);
+    msg.to(&buffer);
+
+    return bytes;
+}
+
+// the server is sending the client keep alive message (same bytes), the client messages are using serializeTo()
+static QByteArray serialize(const ClientKeepAlive &msg)
+{
+    QByteArray bytes;
+    QBuffer buffer(&bytes);
+    buffer.open(QIODevice::WriteOnly);
+    msg.serializeTo(&buffer);
+
+    return bytes;
+}
+
 RemoteUser::RemoteUser() :
     lastKeepAliveReceived(QDateTime::currentMSecsSinceEpoch()),
     currentHeader(MessageHeader()),
-    receivedServerInfos(false)
+    receivedServerInfos(false),
+    queuedBytes(0)
 {
 
 }
@@ -107,6 +133,60 @@ void RemoteUser::setLastKeepAliveToNow()
     lastKeepAliveReceived = QDateTime::currentMSecsSinceEpoch();
 }
 
+void RemoteUser::setChannelsMask(const QString &userFullName, quint32 channelsMask)
+{
+    if (channelsMask)
+        subscriptions.insert(userFullName, channelsMask);
+    else
+        subscriptions.remove(userFullName);
+
+    // stop relaying the intervals in unsubscribed channels
+    for (quint8 channelIndex = 0; channelIndex < 32; ++channelIndex) {
+        if (!(channelsMask & (1u << channelIndex)))
+            cancelDownload(userFullName, channelIndex);
+    }
+}
+
+bool RemoteUser::isSubscribedTo(const QString &userFullName, quint8 channelIndex) const
+{
+    if (channelIndex >= 32)
+        return false;
+
+    return subscriptions.value(userFullName, 0) & (1u << channelIndex);
+}
+
+void RemoteUser::removeSubscriptions(const QString &userFullName)
+{
+    subscriptions.remove(userFullName);
+
+    auto iterator = downloads.begin();
+    while (iterator != downloads.end()) {
+        if (iterator.value().uploaderFullName == userFullName)
+            iterator = downloads.erase(iterator);
+        else
+            ++iterator;
+    }
+}
+
+void RemoteUser::startDownload(const QByteArray &GUID, const QString &uploaderFullName, quint8 channelIndex)
+{
+    cancelDownload(uploaderFullName, channelIndex); // a new interval replace the previous one in the same channel
+
+    downloads.insert(GUID, { uploaderFullName, channelIndex });
+}
+
+void RemoteUser::cancelDownload(const QString &uploaderFullName, quint8 channelIndex)
+{
+    auto iterator = downloads.begin();
+    while (iterator != downloads.end()) {
+        const Download &download = iterator.value();
+        if (download.uploaderFullName == uploaderFullName && download.channelIndex == channelIndex)
+            iterator = downloads.erase(iterator);
+        else
+            ++iterator;
+    }
+}
+
 // -------------------------------------------------------------
 
 Voting::Voting(QObject *parent) :
@@ -196,6 +276,8 @@ Server::Server() :
     maxChannels(2),
     maxUsers(4),
     keepAlivePeriod(30),
+    maxQueuedBytesPerClient(1024 * 1024), // some seconds of audio for a full room
+    droppedIntervals(0),
     votingSettings({0.6, 10000}) // 60% for threshold, 60 seconds to vote expiration
 {
     connect(&tcpServer, &QTcpServer::newConnection, this, &Server::handleNewConnection);
@@ -207,6 +289,29 @@ Server::~Server()
     shutdown();
 }
 
+void Server::setMaxQueuedBytesPerClient(qint64 maxBytes)
+{
+    maxQueuedBytesPerClient = qMax(static_cast<qint64>(0), maxBytes);
+}
+
+qint64 Server::getQueuedBytes() const
+{
+    qint64 queuedBytes = 0;
+    for (auto i = remoteUsers.cbegin(); i != remoteUsers.cend(); ++i)
+        queuedBytes += i.value().getQueuedBytes();
+
+    return queuedBytes;
+}
+
+qint64 Server::getDeepestClientQueue() const
+{
+    qint64 deepestQueue = 0;
+    for (auto i = remoteUsers.cbegin(); i != remoteUsers.cend(); ++i)
+        deepestQueue = qMax(deepestQueue, i.value().getQueuedBytes());
+
+    return deepestQueue;
+}
+
 void Server::bpiVotingIncremented(quint16 votingValue, quint16 currentVotes, quint16 requiredVotes, quint64 expirationTime)
 {
     //[voting system] leading candidate: 1/3 votes for 8 BPI [each vote expires in 20s]
@@ -304,8 +409,12 @@ void Server::handleNewConnection()
     connect(socket, static_cast<void (QTcpSocket::*)(QAbstractSocket::SocketError)>(&QAbstractSocket::error), this, &Server::handleClientSocketError);
     connect(socket, &QIODevice::readyRead, this, &Server::processReceivedBytes);
 
-    connect(socket, &QTcpSocket::bytesWritten, [&](qint64 bytes){
+    connect(socket, &QTcpSocket::bytesWritten, this, [this, socket](qint64 bytes){
         totalUploadMeasurer.addTransferedBytes(bytes);
+
+        auto iterator = remoteUsers.find(socket);
+        if (iterator != remoteUsers.end())
+            iterator.value().removeQueuedBytes(bytes);
     });
 
     remoteUsers.insert(socket, RemoteUser());
@@ -322,7 +431,20 @@ void Server::sendAuthChallenge(QTcpSocket *device)
         serverCapabilities |= 1; // when server has licence the first bit is set.
 
     auto msg = AuthChallengeMessage(challenge, licence, serverCapabilities, protocolVersion);
-    msg.to(device);
+    send(device, serialize(msg));
+}
+
+void Server::send(QTcpSocket *socket, const QByteArray &bytes)
+{
+    auto iterator = remoteUsers.find(socket);
+    if (iterator != remoteUsers.end())
+        send(socket, iterator.value(), bytes);
+}
+
+void Server::send(QTcpSocket *socket, RemoteUser &user, const QByteArray &bytes)
+{
+    socket->write(bytes);
+    user.addQueuedBytes(bytes.size());
 }
 
 void Server::processClientAuthUserMessage(QTcpSocket *socket, const MessageHeader &header)
@@ -338,13 +460,13 @@ void Server::processClientAuthUserMessage(QTcpSocket *socket, const MessageHeade
     remoteUsers[socket].setFullName(newUserName);
 
     AuthReplyMessage authReply(flag, newUserName, maxChannels);
-    authReply.to(socket);
+    send(socket, serialize(authReply));
 
     if (authReply.userIsAuthenticated()) {
-        auto msg = ServerToClientChatMessage::buildUserJoinMessage(newUserName);
-        for (auto skt : remoteUsers.keys()) {
-            if (skt != socket)
-                msg.to(skt);
+        auto bytes = serialize(ServerToClientChatMessage::buildUserJoinMessage(newUserName));
+        for (auto i = remoteUsers.begin(); i != remoteUsers.end(); ++i) {
+            if (i.key() != socket)
+                send(i.key(), i.value(), bytes);
         }
 
         emit userEntered(newUserName);
@@ -390,10 +512,10 @@ void Server::sendServerInitialInfosTo(QTcpSocket *socket)
 {
     // send server config change
     auto configChange = ConfigChangeNotifyMessage(bpm, bpi);
-    configChange.to(socket);
+    send(socket, serialize(configChange));
 
     auto topicMessage = ServerToClientChatMessage::buildTopicMessage(topic);
-    topicMessage.to(socket);
+    send(socket, serialize(topicMessage));
 }
 
 void Server::processClientSetChannel(QTcpSocket *socket, const ninjam::MessageHeader &header)
@@ -446,7 +568,7 @@ void Server::sendConnectedUsersTo(QTcpSocket *socket)
         }
     }
 
-    msg.to(socket);
+    send(socket, serialize(msg));
 }
 
 void Server::broadcastUserChanges(const QString userFullName, const QList<UserChannel> &userChannels)
@@ -456,10 +578,10 @@ void Server::broadcastUserChanges(const QString userFullName, const QList<UserCh
     for (int c = 0; c < userChannels.size(); ++c)
         msg.addUserChannel(userFullName, userChannels.at(c));
 
-    for (auto socket : remoteUsers.keys()) {
-        if (remoteUsers[socket].getFullName() != userFullName) {
-            msg.to(socket);
-        }
+    auto bytes = serialize(msg);
+    for (auto i = remoteUsers.begin(); i != remoteUsers.end(); ++i) {
+        if (i.value().getFullName() != userFullName)
+            send(i.key(), i.value(), bytes);
     }
 }
 
@@ -472,11 +594,35 @@ void Server::processUploadIntervalBegin(QTcpSocket *senderSocket, const MessageH
     auto senderFullName = remoteUsers[senderSocket].getFullName();
 
     auto downloadMsg = DownloadIntervalBegin::from(msg, senderFullName);
-
-    for (auto socket : remoteUsers.keys()) {
-        if (socket != senderSocket) {
-            downloadMsg.to(socket);
+    auto channelIndex = downloadMsg.getChannelIndex();
+
+    QByteArray bytes; // serialized only if somebody is subscribed
+    for (auto i = remoteUsers.begin(); i != remoteUsers.end(); ++i) {
+        if (i.key() == senderSocket)
+            continue;
+
+        RemoteUser &user = i.value();
+        if (!user.isSubscribedTo(senderFullName, channelIndex))
+            continue; // this user is not receiving this channel
+
+        if (user.getQueuedBytes() > maxQueuedBytesPerClient) {
+            // Slow client, the entire interval is dropped instead of growing the socket buffer. The
+            // writes are not relayed too, the GUID is not in the user downloads. NINJAM clients are
+            // tolerating lost intervals.
+            user.cancelDownload(senderFullName, channelIndex);
+            ++droppedIntervals;
+            continue;
         }
+
+        if (bytes.isEmpty())
+            bytes = serialize(downloadMsg);
+
+        send(i.key(), user, bytes);
+
+        if (downloadMsg.isComplete()) // empty interval, no writes
+            user.cancelDownload(senderFullName, channelIndex);
+        else
+            user.startDownload(downloadMsg.getGUID(), senderFullName, channelIndex);
     }
 }
 
@@ -487,19 +633,32 @@ void Server::processUploadIntervalWrite(QTcpSocket *senderSocket, const MessageH
 
     // parsing the DownloadIntervalWrite directly, because the message is identical to UploadIntervaWrite
     auto downloadMsg = DownloadIntervalWrite::from(senderSocket, header.getPayload());
+    auto GUID = downloadMsg.getGUID();
 
-    for (auto socket : remoteUsers.keys()) {
-        if (socket != senderSocket) {
-            downloadMsg.to(socket);
-        }
+    QByteArray bytes; // serialized only if somebody is downloading this interval
+    for (auto i = remoteUsers.begin(); i != remoteUsers.end(); ++i) {
+        if (i.key() == senderSocket)
+            continue;
+
+        RemoteUser &user = i.value();
+        if (!user.isDownloading(GUID))
+            continue; // the DownloadIntervalBegin was not relayed to this user
+
+        if (bytes.isEmpty())
+            bytes = serialize(downloadMsg);
+
+        send(i.key(), user, bytes);
+
+        if (downloadMsg.downloadIsComplete())
+            user.finishDownload(GUID);
     }
 }
 
 void Server::broadcastVotingSystemMessage(const QString &message)
 {
-    auto msg = ServerToClientChatMessage::buildVoteSystemMessage(message);
-    for (auto socket : remoteUsers.keys())
-        msg.to(socket);
+    auto bytes = serialize(ServerToClientChatMessage::buildVoteSystemMessage(message));
+    for (auto i = remoteUsers.begin(); i != remoteUsers.end(); ++i)
+        send(i.key(), i.value(), bytes);
 }
 
 void Server::broadcastPublicChatMessage(const ClientToServerChatMessage &receivedMessage, const QString &userFullName)
@@ -507,10 +666,9 @@ void Server::broadcastPublicChatMessage(const ClientToServerChatMessage &receive
     Q_ASSERT(receivedMessage.isPublicMessage());
 
     QString messageText = receivedMessage.getArguments().at(0);
-    auto msg = ServerToClientChatMessage::buildPublicMessage(userFullName, messageText);
-    for (auto s : remoteUsers.keys()) {
-        msg.to(s);
-    }
+    auto bytes = serialize(ServerToClientChatMessage::buildPublicMessage(userFullName, messageText));
+    for (auto i = remoteUsers.begin(); i != remoteUsers.end(); ++i)
+        send(i.key(), i.value(), bytes);
 }
 
 void Server::sendPrivateMessage(const QString &sender, const ClientToServerChatMessage &receivedMessage)
@@ -522,10 +680,9 @@ void Server::sendPrivateMessage(const QString &sender, const ClientToServerChatM
     QString text = receivedMessage.getArguments().at(1);
 
     auto msg = ServerToClientChatMessage::buildPrivateMessage(sender, text);
-    for (auto s : remoteUsers.keys()) {
-        const RemoteUser &user = remoteUsers[s];
-        if (user.getFullName() == destinationUserName) {
-            msg.to(s);
+    for (auto i = remoteUsers.begin(); i != remoteUsers.end(); ++i) {
+        if (i.value().getFullName() == destinationUserName) {
+            send(i.key(), i.value(), serialize(msg));
             break;
         }
     }
@@ -536,10 +693,9 @@ void Server::setTopic(const QString &newTopic)
     if (newTopic != topic) {
         topic = newTopic;
 
-        auto msg = ServerToClientChatMessage::buildTopicMessage(newTopic);
-        for (auto socket : remoteUsers.keys()) {
-            msg.to(socket);
-        }
+        auto bytes = serialize(ServerToClientChatMessage::buildTopicMessage(newTopic));
+        for (auto i = remoteUsers.begin(); i != remoteUsers.end(); ++i)
+            send(i.key(), i.value(), bytes);
     }
 }
 
@@ -548,10 +704,9 @@ void Server::setBpi(quint16 newBpi)
     if (newBpi != bpi && newBpi > 0) {
         bpi = newBpi;
 
-        auto msg = ConfigChangeNotifyMessage(bpm, bpi);
-        for (auto socket : remoteUsers.keys()) {
-            msg.to(socket);
-        }
+        auto bytes = serialize(ConfigChangeNotifyMessage(bpm, bpi));
+        for (auto i = remoteUsers.begin(); i != remoteUsers.end(); ++i)
+            send(i.key(), i.value(), bytes);
     }
 }
 
@@ -560,10 +715,9 @@ void Server::setBpm(quint16 newBpm)
     if (newBpm != bpm && newBpm > 0) {
         bpm = newBpm;
 
-        auto msg = ConfigChangeNotifyMessage(bpm, bpi);
-        for (auto socket : remoteUsers.keys()) {
-            msg.to(socket);
-        }
+        auto bytes = serialize(ConfigChangeNotifyMessage(bpm, bpi));
+        for (auto i = remoteUsers.begin(); i != remoteUsers.end(); ++i)
+            send(i.key(), i.value(), bytes);
     }
 }
 
@@ -706,8 +860,7 @@ void Server::updateKeepAliveInfos()
                 disconnectClient(socket);
             }
             else {
-                ClientKeepAlive msg;
-                msg.serializeTo(socket);
+                send(socket, serialize(ClientKeepAlive()));
             }
         }
     }
@@ -717,6 +870,13 @@ void Server::processClientSetUserMask(QTcpSocket *socket, const ninjam::MessageH
 {
     auto msg = ClientSetUserMask::from(socket, header.getPayload());
 
+    if (!remoteUsers.contains(socket))
+        return;
+
+    RemoteUser &user = remoteUsers[socket];
+    const auto &usersMasks = msg.getUsersMasks();
+    for (auto userFullName : usersMasks.keys())
+        user.setChannelsMask(userFullName, usersMasks[userFullName]);
 }
 
 void Server::processReceivedBytes()
@@ -826,12 +986,13 @@ void Server::disconnectClient(QTcpSocket *socket)
         QString userFullName = user.getFullName();
 
         // send the PART message and deactivate all user channels
-        auto msg = UserInfoChangeNotifyMessage::buildDeactivationMessage(user);
-        auto partMsg = ServerToClientChatMessage::buildUserPartMessage(userFullName);
-        for (auto skt : remoteUsers.keys()) {
-            if (skt != socket) {
-                partMsg.to(skt);
-                msg.to(skt);
+        auto bytes = serialize(UserInfoChangeNotifyMessage::buildDeactivationMessage(user));
+        auto partBytes = serialize(ServerToClientChatMessage::buildUserPartMessage(userFullName));
+        for (auto i = remoteUsers.begin(); i != remoteUsers.end(); ++i) {
+            if (i.key() != socket) {
+                send(i.key(), i.value(), partBytes);
+                send(i.key(), i.value(), bytes);
+                i.value().removeSubscriptions(userFullName);
             }
         }
 
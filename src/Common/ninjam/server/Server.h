@@ -5,6 +5,8 @@
 #include <QTcpSocket>
 #include <QObject>
 #include <QList>
+#include <QHash>
+#include <QMap>
 #include <QTimer>
 
 #include "ninjam/Ninjam.h"
@@ -46,12 +48,65 @@ public:
         receivedServerInfos = true;
     }
 
+    // channels subscribed using ClientSetUserMask
+    void setChannelsMask(const QString &userFullName, quint32 channelsMask);
+    bool isSubscribedTo(const QString &userFullName, quint8 channelIndex) const;
+    void removeSubscriptions(const QString &userFullName);
+
+    // intervals relayed to this user, only the writes for these GUIDs are relayed
+    void startDownload(const QByteArray &GUID, const QString &uploaderFullName, quint8 channelIndex);
+    void cancelDownload(const QString &uploaderFullName, quint8 channelIndex);
+    bool isDownloading(const QByteArray &GUID) const;
+    void finishDownload(const QByteArray &GUID);
+
+    // bytes written in the socket but not sent to the network yet
+    void addQueuedBytes(qint64 bytes);
+    void removeQueuedBytes(qint64 bytes);
+    qint64 getQueuedBytes() const;
+
 private:
     MessageHeader currentHeader;
     quint64 lastKeepAliveReceived;
     bool receivedServerInfos;
+
+    QMap<QString, quint32> subscriptions; // user full name => channels mask
+
+    struct Download
+    {
+        QString uploaderFullName;
+        quint8 channelIndex;
+    };
+
+    QHash<QByteArray, Download> downloads; // GUID => download
+
+    qint64 queuedBytes;
 };
 
+inline void RemoteUser::addQueuedBytes(qint64 bytes)
+{
+    queuedBytes += bytes;
+}
+
+inline void RemoteUser::removeQueuedBytes(qint64 bytes)
+{
+    queuedBytes = qMax(static_cast<qint64>(0), queuedBytes - bytes);
+}
+
+inline qint64 RemoteUser::getQueuedBytes() const
+{
+    return queuedBytes;
+}
+
+inline bool RemoteUser::isDownloading(const QByteArray &GUID) const
+{
+    return downloads.contains(GUID);
+}
+
+inline void RemoteUser::finishDownload(const QByteArray &GUID)
+{
+    downloads.remove(GUID);
+}
+
 inline void RemoteUser::setCurrentHeader(MessageHeader header)
 {
     currentHeader = header;
@@ -119,6 +174,15 @@ public:
     quint64 getDownloadTransferRate() const;
     quint64 getUploadTransferRate() const;
 
+    // Slow consumers: when a client queue is bigger than this limit the new intervals are
+    // not relayed to this client (whole intervals are dropped, never partial intervals).
+    void setMaxQueuedBytesPerClient(qint64 maxBytes);
+    qint64 getMaxQueuedBytesPerClient() const;
+
+    qint64 getQueuedBytes() const; // sum of all client queues
+    qint64 getDeepestClientQueue() const;
+    quint64 getDroppedIntervals() const;
+
 signals:
     void serverStarted();
     void errorStartingServer(const QString &errorMessage);
@@ -160,6 +224,9 @@ private:
     NetworkUsageMeasurer totalUploadMeasurer;
     NetworkUsageMeasurer totalDownloadMeasurer;
 
+    qint64 maxQueuedBytesPerClient;
+    quint64 droppedIntervals;
+
     struct VotingSettings
     {
         qreal trheshold;
@@ -194,6 +261,10 @@ private:
 
     void sendServerInitialInfosTo(QTcpSocket *socket);
 
+    // all writes are passing here. The same serialized bytes are shared by all recipients.
+    void send(QTcpSocket *socket, const QByteArray &bytes);
+    void send(QTcpSocket *socket, RemoteUser &user, const QByteArray &bytes);
+
     void sendPrivateMessage(const QString &sender, const ClientToServerChatMessage &receivedMessage);
     void processAdminCommand(const QString &cmd);
     void setTopic(const QString &newTopic);
@@ -219,6 +290,16 @@ inline quint64 Server::getUploadTransferRate() const
     return totalUploadMeasurer.getTransferRate();
 }
 
+inline qint64 Server::getMaxQueuedBytesPerClient() const
+{
+    return maxQueuedBytesPerClient;
+}
+
+inline quint64 Server::getDroppedIntervals() const
+{
+    return droppedIntervals;
+}
+
 inline quint8 Server::getMaxChannels() const
 {
     return maxChannels;
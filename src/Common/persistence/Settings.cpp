@@ -542,7 +542,8 @@ void WindowSettings::write(QJsonObject &out) const
 // +++++++++++++++++++++++++++++++++++++++
 
 VstSettings::VstSettings() :
-    SettingsObject("VST")
+    SettingsObject("VST"),
+    usingBridge(false)
 {
     qCDebug(jtSettings) << "VstSettings ctor";
 }
@@ -569,6 +570,8 @@ void VstSettings::write(QJsonObject &out) const
         BlackedArray.append(blackVst);
 
     out["BlackListPlugins"] = BlackedArray;
+
+    out["useBridge"] = usingBridge;
 }
 
 void VstSettings::read(const QJsonObject &in)
@@ -596,6 +599,8 @@ void VstSettings::read(const QJsonObject &in)
             blackedPlugins.append(cacheArray.at(x).toString());
     }
 
+    usingBridge = getValueFromJson(in, "useBridge", false); // plugins are loaded in Jamtaba process by default
+
     qCDebug(jtSettings) << "VstSettings: foldersToScan " << foldersToScan
                         << "; cachedPlugins " << cachedPlugins
                         << "; blackedPlugins " << blackedPlugins;
@@ -921,6 +926,16 @@ QStringList Settings::getVstScanFolders() const
     return vstSettings.foldersToScan;
 }
 
+bool Settings::isUsingVstBridge() const
+{
+    return vstSettings.usingBridge;
+}
+
+void Settings::setUsingVstBridge(bool usingBridge)
+{
+    vstSettings.usingBridge = usingBridge;
+}
+
 QStringList Settings::getBlackListedPlugins() const
 {
     qCDebug(jtSettings) << "Settings getVstScanFolders";
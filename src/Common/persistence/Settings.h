@@ -145,6 +145,7 @@ public:
     QStringList cachedPlugins;
     QStringList foldersToScan;
     QStringList blackedPlugins; // vst in blackbox....
+    bool usingBridge; // hosting the plugins in VstBridge processes
 };
 
 class AudioUnitSettings  : public SettingsObject
@@ -509,6 +510,9 @@ public:
     void removeVstScanPath(const QString &path);
     QStringList getVstScanFolders() const;
 
+    bool isUsingVstBridge() const;
+    void setUsingVstBridge(bool usingBridge);
+
     QStringList getRecentEmojis() const;
     void setRecentEmojis(const QStringList &emojis);
 
@@ -1,13 +1,201 @@
 #include "JamRecorder.h"
 #include <QDateTime>
 #include <QDebug>
-#include <QtConcurrent/QtConcurrent>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QFile>
 #include "../log/Logging.h"
 
 using namespace recorder;
 
 const quint8 JamRecorder::VIDEO_CHANNEL_KEY = 255;
 
+// ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+class JamRecorder::IOThread : public QThread
+{
+public:
+    IOThread();
+    ~IOThread();
+
+    void writeFile(const QString &path, const QByteArray &data);
+
+    // only the last jam snapshot is writed, the previous pending snapshots are discarded
+    void writeProject(JamMetadataWriter *writer, const Jam &jam);
+
+    void flush(); // block until all pending files and the pending project are writed
+
+protected:
+    void run() override;
+
+private:
+    struct FileWrite
+    {
+        QString path;
+        QByteArray data;
+    };
+
+    QMutex mutex;
+    QWaitCondition wakeUp; // new writes, flush or stop requests
+    QWaitCondition writesFinished; // waking up flush() and the writers waiting for queue space
+
+    QQueue<FileWrite> pendingFiles;
+    qint64 pendingBytes;
+
+    std::unique_ptr<Jam> pendingProject;
+    JamMetadataWriter *projectWriter;
+    qint64 lastProjectWrite;
+
+    bool writing; // writing outside the lock
+    bool flushRequested;
+    bool stopRequested;
+
+    bool projectWriteIsDue() const;
+    static void write(const FileWrite &file);
+
+    static const qint64 MAX_PENDING_BYTES = 32 * 1024 * 1024; // the producers are waiting when the queue is full
+    static const qint64 PROJECT_WRITE_PERIOD = 10000; // milliseconds
+};
+
+JamRecorder::IOThread::IOThread() :
+    pendingBytes(0),
+    projectWriter(nullptr),
+    lastProjectWrite(0),
+    writing(false),
+    flushRequested(false),
+    stopRequested(false)
+{
+    setObjectName("JamRecorder I/O");
+    start(QThread::LowPriority);
+}
+
+JamRecorder::IOThread::~IOThread()
+{
+    {
+        QMutexLocker locker(&mutex);
+        stopRequested = true; // pending writes are finished before stop
+        wakeUp.wakeOne();
+    }
+
+    wait();
+}
+
+void JamRecorder::IOThread::writeFile(const QString &path, const QByteArray &data)
+{
+    QMutexLocker locker(&mutex);
+
+    // bounded queue: a very slow disk will slow down the producer instead of eat all the memory
+    while (!pendingFiles.isEmpty() && pendingBytes + data.size() > MAX_PENDING_BYTES)
+        writesFinished.wait(&mutex);
+
+    pendingFiles.enqueue({ path, data });
+    pendingBytes += data.size();
+
+    wakeUp.wakeOne();
+}
+
+void JamRecorder::IOThread::writeProject(JamMetadataWriter *writer, const Jam &jam)
+{
+    QMutexLocker locker(&mutex);
+
+    pendingProject.reset(new Jam(jam)); // cheap copy, the Jam maps are implicitly shared
+    projectWriter = writer;
+
+    wakeUp.wakeOne();
+}
+
+void JamRecorder::IOThread::flush()
+{
+    QMutexLocker locker(&mutex);
+
+    flushRequested = true;
+    wakeUp.wakeOne();
+
+    while (writing || !pendingFiles.isEmpty() || pendingProject)
+        writesFinished.wait(&mutex);
+
+    flushRequested = false;
+}
+
+bool JamRecorder::IOThread::projectWriteIsDue() const
+{
+    if (!pendingProject)
+        return false;
+
+    if (flushRequested || stopRequested)
+        return true;
+
+    return QDateTime::currentMSecsSinceEpoch() - lastProjectWrite >= PROJECT_WRITE_PERIOD;
+}
+
+void JamRecorder::IOThread::write(const FileWrite &file)
+{
+    QFile outputFile(file.path);
+    if (!outputFile.open(QFile::WriteOnly)) {
+        qCritical() << "can't open file " << file.path;
+        return;
+    }
+
+    outputFile.write(file.data.constData(), file.data.size());
+}
+
+void JamRecorder::IOThread::run()
+{
+    QMutexLocker locker(&mutex);
+
+    forever {
+        bool projectIsDue = projectWriteIsDue();
+        if (pendingFiles.isEmpty() && !projectIsDue) {
+            if (stopRequested)
+                break;
+
+            if (pendingProject) { // sleep until the project write is due
+                qint64 elapsed = QDateTime::currentMSecsSinceEpoch() - lastProjectWrite;
+                wakeUp.wait(&mutex, static_cast<unsigned long>(qMax(static_cast<qint64>(1), PROJECT_WRITE_PERIOD - elapsed)));
+            }
+            else {
+                wakeUp.wait(&mutex);
+            }
+
+            continue;
+        }
+
+        // batch: all pending writes are taken at once, the producers are not blocked while the disk is working
+        QQueue<FileWrite> files;
+        files.swap(pendingFiles);
+
+        std::unique_ptr<Jam> project;
+        JamMetadataWriter *writer = projectWriter;
+        if (projectIsDue)
+            project = std::move(pendingProject);
+
+        writing = true;
+        locker.unlock();
+
+        qint64 writedBytes = 0;
+        for (const FileWrite &file : files) {
+            write(file);
+            writedBytes += file.data.size();
+        }
+
+        if (project && writer)
+            writer->write(*project);
+
+        locker.relock();
+
+        writing = false;
+        pendingBytes -= writedBytes;
+        if (project)
+            lastProjectWrite = QDateTime::currentMSecsSinceEpoch();
+
+        writesFinished.wakeAll();
+    }
+}
+
+// ++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
 JamAudioFile::JamAudioFile(const QString &path, uint intervalIndex) :
     path(path),
     intervalIndex(intervalIndex)
@@ -129,12 +317,7 @@ QString JamRecorder::getNewJamName()
 
 void JamRecorder::writeEncodedFile(const QByteArray& encodedData, const QString &path)
 {
-    QFile audioFile(path);
-    if (!audioFile.open(QFile::WriteOnly)) {
-        qCritical() << "can't open file " << path;
-        return;
-    }
-    audioFile.write(encodedData.data(), encodedData.size());
+    ioThread->writeFile(path, encodedData); // the file is writed in background
 }
 
 QString JamRecorder::buildVideoFileName(const QString &userName, int currentInterval, const QString &fileExtension)
@@ -152,7 +335,8 @@ JamRecorder::JamRecorder(JamMetadataWriter* jamMetadataWritter) :
     jam(nullptr),
     jamMetadataWritter(jamMetadataWritter),
     globalIntervalIndex(0),
-    running(false)
+    running(false),
+    ioThread(new IOThread())
 {
     //this->recordingActivated = true;//just to test
     qCDebug(jtJamRecorder) << "Creating JamRecorder!";
@@ -181,7 +365,7 @@ void JamRecorder::appendLocalUserAudio(const QByteArray &encodedAudio, quint8 ch
         QString audioFileName = buildAudioFileName(localUserName, channelIndex, interval.getIntervalIndex());
         QString audioFilePath = jamMetadataWritter->getAudioAbsolutePath(audioFileName);
         QByteArray encodedData(interval.getEncodedData());
-        QtConcurrent::run(this, &JamRecorder::writeEncodedFile, encodedData, audioFilePath);
+        writeEncodedFile(encodedData, audioFilePath);
         jam->addAudioFile(localUserName, channelIndex, audioFilePath, interval.getIntervalIndex());
         interval.clear();
     }
@@ -211,7 +395,7 @@ void JamRecorder::appendLocalUserVideo(const QByteArray &encodedVideo, bool isFi
         QString videoFilePath = jamMetadataWritter->getVideoAbsolutePath(videoFileName);
 
         if (!videoFilePath.isEmpty()) // some recorders (like ClipSort) can't save videos
-            QtConcurrent::run(this, &JamRecorder::writeEncodedFile, encodedData, videoFilePath);
+            writeEncodedFile(encodedData, videoFilePath);
 
         videoInterval.clear();
     }
@@ -229,7 +413,7 @@ void JamRecorder::addRemoteUserAudio(const QString &userName, const QByteArray &
     int intervalIndex = globalIntervalIndex;
     QString audioFileName = buildAudioFileName(userName, channelIndex, intervalIndex);
     QString audioFilePath = jamMetadataWritter->getAudioAbsolutePath(audioFileName);
-    QtConcurrent::run(this, &JamRecorder::writeEncodedFile, encodedAudio, audioFilePath);
+    writeEncodedFile(encodedAudio, audioFilePath);
     jam->addAudioFile(userName, channelIndex, audioFilePath, intervalIndex);
 }
 
@@ -297,6 +481,7 @@ void JamRecorder::stopRecording()
 {
     if (running) {
         writeProjectFile();
+        ioThread->flush(); // the metadata writer can't be used in the I/O thread after this point (setJamDir)
         this->running = false;
         this->globalIntervalIndex = 0;
         this->localUserIntervals.clear();
@@ -307,7 +492,7 @@ void JamRecorder::stopRecording()
 void JamRecorder::writeProjectFile()
 {
     if (jamMetadataWritter && jam) {
-        jamMetadataWritter->write(*jam);
+        ioThread->writeProject(jamMetadataWritter.get(), *jam); // coalesced, not writed in every interval
     }
 }
 
@@ -263,6 +263,13 @@ private:
     QMap<quint8, LocalNinjamInterval> localUserIntervals; // storing encoded data for audio and video intervals
     static const quint8 VIDEO_CHANNEL_KEY;
 
+    /**
+        All disk writes (encoded files and project files) are done in order by a single thread. The project
+        file writes are coalesced, at most one rewrite every few seconds.
+     */
+    class IOThread;
+    std::unique_ptr<IOThread> ioThread; // declared after jamMetadataWritter, so is destroyed (and drained) first
+
     QString getNewJamName();
 
     void writeEncodedFile(const QByteArray &encodedData, const QString &path);
@@ -0,0 +1,141 @@
+#include "PluginScanCache.h"
+
+#include "persistence/CacheHeader.h"
+#include "log/Logging.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QSaveFile>
+
+using vst::PluginScanCache;
+
+namespace {
+
+qint64 getLastModified(const QFileInfo &file)
+{
+    return file.lastModified().toMSecsSinceEpoch();
+}
+
+} // namespace
+
+QDataStream &operator<<(QDataStream &stream, const PluginScanCache::Entry &entry)
+{
+    return stream << entry.size << entry.lastModified << entry.validPlugin << entry.name << entry.manufacturer;
+}
+
+QDataStream &operator>>(QDataStream &stream, PluginScanCache::Entry &entry)
+{
+    return stream >> entry.size >> entry.lastModified >> entry.validPlugin >> entry.name >> entry.manufacturer;
+}
+
+PluginScanCache::Entry::Entry() :
+    size(-1),
+    lastModified(-1),
+    validPlugin(false)
+{
+
+}
+
+PluginScanCache::PluginScanCache(const QString &filePath) :
+    filePath(filePath)
+{
+
+}
+
+bool PluginScanCache::load()
+{
+    entries.clear();
+
+    QFile cacheFile(filePath);
+    if (!cacheFile.open(QFile::ReadOnly))
+        return false; // first scan, no cache file yet
+
+    QDataStream stream(&cacheFile);
+
+    CacheHeader cacheHeader;
+    stream >> cacheHeader;
+    if (!cacheHeader.isValid(REVISION)) {
+        qCritical() << "Invalid cache header when loading the VST scan cache.";
+        return false;
+    }
+
+    stream >> entries;
+    if (stream.status() != QDataStream::Ok) {
+        qCritical() << "Corrupted VST scan cache file!";
+        entries.clear();
+        return false;
+    }
+
+    qCDebug(jtStandalonePluginFinder) << "VST scan cache items loaded from file:" << entries.size();
+
+    return true;
+}
+
+bool PluginScanCache::save() const
+{
+    QSaveFile cacheFile(filePath); // the old cache is preserved if Jamtaba crash while saving
+    if (!cacheFile.open(QFile::WriteOnly)) {
+        qCritical() << "Can't open the VST scan cache file in" << filePath;
+        return false;
+    }
+
+    QDataStream stream(&cacheFile);
+    stream << CacheHeader(REVISION);
+    stream << entries;
+
+    return cacheFile.commit();
+}
+
+bool PluginScanCache::isUpToDate(const QFileInfo &file) const
+{
+    auto iterator = entries.constFind(file.absoluteFilePath());
+    if (iterator == entries.constEnd())
+        return false;
+
+    return iterator->size == file.size() && iterator->lastModified == getLastModified(file);
+}
+
+PluginScanCache::Entry PluginScanCache::getEntry(const QString &path) const
+{
+    return entries.value(path);
+}
+
+void PluginScanCache::update(const QFileInfo &file, bool validPlugin, const QString &name, const QString &manufacturer)
+{
+    Entry entry;
+    entry.size = file.size();
+    entry.lastModified = getLastModified(file);
+    entry.validPlugin = validPlugin;
+    entry.name = name;
+    entry.manufacturer = manufacturer;
+
+    entries.insert(file.absoluteFilePath(), entry);
+}
+
+void PluginScanCache::remove(const QString &path)
+{
+    entries.remove(path);
+}
+
+void PluginScanCache::clear()
+{
+    entries.clear();
+}
+
+int PluginScanCache::removeMissingFiles()
+{
+    int removedEntries = 0;
+    auto iterator = entries.begin();
+    while (iterator != entries.end()) {
+        if (QFileInfo::exists(iterator.key())) {
+            ++iterator;
+        }
+        else {
+            iterator = entries.erase(iterator);
+            ++removedEntries;
+        }
+    }
+
+    return removedEntries;
+}
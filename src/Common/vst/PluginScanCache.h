@@ -0,0 +1,58 @@
+#ifndef VST_PLUGIN_SCAN_CACHE_H
+#define VST_PLUGIN_SCAN_CACHE_H
+
+#include <QFileInfo>
+#include <QHash>
+#include <QString>
+
+namespace vst {
+
+/**
+ * Persistent index of the scanned plugin files. The entries are keyed by path and fingerprinted
+ * with the file size and modification time, so unchanged files are never loaded again in the
+ * next scans. Files that are not valid plugins are stored too.
+ */
+class PluginScanCache
+{
+public:
+    struct Entry
+    {
+        Entry();
+
+        qint64 size;
+        qint64 lastModified; // msecs since epoch
+        bool validPlugin;
+        QString name;
+        QString manufacturer;
+    };
+
+    explicit PluginScanCache(const QString &filePath);
+
+    bool load();
+    bool save() const;
+
+    bool isUpToDate(const QFileInfo &file) const; // cached and not changed since the last scan
+    Entry getEntry(const QString &path) const;
+
+    void update(const QFileInfo &file, bool validPlugin, const QString &name = QString(), const QString &manufacturer = QString());
+    void remove(const QString &path);
+    void clear();
+    int removeMissingFiles(); // the deleted or moved plugin files, returns the removed entries count
+
+    int getSize() const;
+
+    static const quint32 REVISION = 1;
+
+private:
+    QString filePath;
+    QHash<QString, Entry> entries;
+};
+
+inline int PluginScanCache::getSize() const
+{
+    return entries.size();
+}
+
+} // namespace
+
+#endif // VST_PLUGIN_SCAN_CACHE_H
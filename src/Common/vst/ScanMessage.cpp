@@ -0,0 +1,73 @@
+#include "ScanMessage.h"
+
+#include <QDataStream>
+#include <QtEndian>
+
+using vst::ScanMessage;
+
+ScanMessage::ScanMessage(Type type, const QString &path, const QString &name, const QString &manufacturer) :
+    type(type),
+    path(path),
+    name(name),
+    manufacturer(manufacturer)
+{
+
+}
+
+QByteArray ScanMessage::serialize() const
+{
+    QByteArray payload;
+    QDataStream payloadStream(&payload, QIODevice::WriteOnly);
+    payloadStream << static_cast<quint8>(type) << path << name << manufacturer;
+
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream << MAGIC << static_cast<quint32>(payload.size());
+    data.append(payload);
+
+    return data;
+}
+
+bool ScanMessage::parse(QByteArray &buffer, ScanMessage &message)
+{
+    static const int HEADER_SIZE = 8; // magic + payload size
+
+    forever {
+        // discarding the garbage before the magic
+        char magicBytes[4];
+        qToBigEndian(MAGIC, reinterpret_cast<uchar *>(magicBytes));
+        int magicIndex = buffer.indexOf(QByteArray::fromRawData(magicBytes, 4));
+        if (magicIndex < 0) {
+            buffer = buffer.right(3); // a partial magic can be in the end
+            return false;
+        }
+
+        if (magicIndex > 0)
+            buffer.remove(0, magicIndex);
+
+        if (buffer.size() < HEADER_SIZE)
+            return false;
+
+        quint32 payloadSize = qFromBigEndian<quint32>(reinterpret_cast<const uchar *>(buffer.constData() + 4));
+        if (payloadSize > MAX_PAYLOAD_SIZE) { // not a real header, just garbage with the magic bytes
+            buffer.remove(0, 1);
+            continue;
+        }
+
+        if (static_cast<quint32>(buffer.size()) < HEADER_SIZE + payloadSize)
+            return false;
+
+        QDataStream stream(buffer.mid(HEADER_SIZE, static_cast<int>(payloadSize)));
+        quint8 type;
+        stream >> type >> message.path >> message.name >> message.manufacturer;
+
+        buffer.remove(0, HEADER_SIZE + static_cast<int>(payloadSize));
+
+        if (stream.status() != QDataStream::Ok || type < ScanStarted || type > NotAPlugin)
+            continue; // corrupted payload, try the next message
+
+        message.type = static_cast<Type>(type);
+
+        return true;
+    }
+}
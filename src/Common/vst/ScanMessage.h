@@ -0,0 +1,69 @@
+#ifndef VST_SCAN_MESSAGE_H
+#define VST_SCAN_MESSAGE_H
+
+#include <QByteArray>
+#include <QString>
+
+namespace vst {
+
+/**
+ * Binary message written by the VstScanner processes (one message per scanned plugin event).
+ *
+ * Each message is framed as [MAGIC][payload size][payload], the magic is used to resync the
+ * stream if some plugin writes garbage in the scanner output.
+ */
+class ScanMessage
+{
+public:
+    enum Type : quint8 {
+        Invalid = 0,
+        ScanStarted = 1,    // the scanner is loading 'path'
+        PluginFounded = 2,  // 'path' is a valid plugin, name and manufacturer are filled
+        NotAPlugin = 3      // 'path' was loaded (no crash) but is not a valid plugin
+    };
+
+    ScanMessage(Type type = Invalid, const QString &path = QString(), const QString &name = QString(), const QString &manufacturer = QString());
+
+    Type getType() const;
+    QString getPath() const;
+    QString getName() const;
+    QString getManufacturer() const;
+
+    QByteArray serialize() const;
+
+    // consume the first complete message in 'buffer', return false if more bytes are necessary
+    static bool parse(QByteArray &buffer, ScanMessage &message);
+
+    static const quint32 MAGIC = 0x4A54534D; // 'JTSM'
+    static const quint32 MAX_PAYLOAD_SIZE = 64 * 1024;
+
+private:
+    Type type;
+    QString path;
+    QString name;
+    QString manufacturer;
+};
+
+inline ScanMessage::Type ScanMessage::getType() const
+{
+    return type;
+}
+
+inline QString ScanMessage::getPath() const
+{
+    return path;
+}
+
+inline QString ScanMessage::getName() const
+{
+    return name;
+}
+
+inline QString ScanMessage::getManufacturer() const
+{
+    return manufacturer;
+}
+
+} // namespace
+
+#endif // VST_SCAN_MESSAGE_H
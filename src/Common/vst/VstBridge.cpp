@@ -0,0 +1,427 @@
+#include "VstBridge.h"
+
+#include "audio/core/AudioNodeProcessor.h"
+#include "log/Logging.h"
+
+#include <QElapsedTimer>
+
+#include <cstring>
+#include <new>
+
+#if defined(Q_OS_LINUX)
+    #include <linux/futex.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+    #include <ctime>
+#elif defined(Q_OS_WIN)
+    #include <windows.h>
+    #include <string>
+#endif
+
+using vst::BridgeChannel;
+using vst::BridgeClient;
+using vst::BridgeServer;
+using audio::SamplesBuffer;
+
+namespace {
+
+#if defined(Q_OS_LINUX)
+// not using FUTEX_PRIVATE_FLAG, the word is shared between processes
+inline long futex(std::atomic<quint32> *word, int operation, quint32 value, const timespec *timeout)
+{
+    return syscall(SYS_futex, reinterpret_cast<quint32 *>(word), operation, value, timeout, nullptr, 0);
+}
+#endif
+
+} // namespace
+
+BridgeChannel::BridgeChannel(const QString &key) :
+    sharedMemory(key),
+    block(nullptr),
+    requestEvent(nullptr)
+{
+
+}
+
+BridgeChannel::~BridgeChannel()
+{
+#ifdef Q_OS_WIN
+    if (requestEvent)
+        CloseHandle(static_cast<HANDLE>(requestEvent));
+#endif
+
+    if (sharedMemory.isAttached())
+        sharedMemory.detach();
+}
+
+bool BridgeChannel::create()
+{
+    if (!sharedMemory.create(sizeof(Block))) {
+        qCritical() << "Can't create the VST bridge shared memory:" << sharedMemory.errorString();
+        return false;
+    }
+
+    block = new (sharedMemory.data()) Block(); // all fields zeroed
+    block->magic = MAGIC;
+
+    return openRequestEvent(true);
+}
+
+bool BridgeChannel::attach()
+{
+    if (!sharedMemory.attach() || sharedMemory.size() < static_cast<int>(sizeof(Block))) {
+        qCritical() << "Can't attach the VST bridge shared memory:" << sharedMemory.errorString();
+        return false;
+    }
+
+    auto sharedBlock = static_cast<Block *>(sharedMemory.data());
+    if (sharedBlock->magic != MAGIC) {
+        qCritical() << "Invalid VST bridge shared memory!";
+        return false;
+    }
+
+    block = sharedBlock;
+
+    return openRequestEvent(false);
+}
+
+bool BridgeChannel::openRequestEvent(bool create)
+{
+#ifdef Q_OS_WIN
+    std::wstring name = QString("Local\\%1-request").arg(sharedMemory.nativeKey()).toStdWString();
+    requestEvent = create ? CreateEventW(nullptr, FALSE, FALSE, name.c_str()) // auto reset
+                          : OpenEventW(EVENT_MODIFY_STATE | SYNCHRONIZE, FALSE, name.c_str());
+    if (!requestEvent) {
+        qCritical() << "Can't open the VST bridge event!";
+        block = nullptr;
+        return false;
+    }
+#else
+    Q_UNUSED(create);
+#endif
+
+    return true;
+}
+
+void BridgeChannel::notifyRequest()
+{
+#if defined(Q_OS_LINUX)
+    futex(&block->requestSequence, FUTEX_WAKE, 1, nullptr);
+#elif defined(Q_OS_WIN)
+    SetEvent(static_cast<HANDLE>(requestEvent));
+#endif
+    // macOS has no futex, the bridge is polling
+}
+
+bool BridgeChannel::waitRequest(quint32 lastSequence, int timeoutInMs)
+{
+    if (block->requestSequence.load() != lastSequence)
+        return true;
+
+#if defined(Q_OS_LINUX)
+    timespec timeout;
+    timeout.tv_sec = timeoutInMs / 1000;
+    timeout.tv_nsec = (timeoutInMs % 1000) * 1000000L;
+    futex(&block->requestSequence, FUTEX_WAIT, lastSequence, &timeout); // returns immediately if the sequence changed
+#elif defined(Q_OS_WIN)
+    WaitForSingleObject(static_cast<HANDLE>(requestEvent), static_cast<DWORD>(timeoutInMs));
+#else
+    QElapsedTimer timer;
+    timer.start();
+    while (block->requestSequence.load() == lastSequence && timer.elapsed() < timeoutInMs)
+        QThread::usleep(100);
+#endif
+
+    return block->requestSequence.load() != lastSequence;
+}
+
+// ++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+BridgeClient::BridgeClient(BridgeChannel &channel) :
+    channel(channel),
+    inputFifo(BridgeChannel::MAX_CHANNELS, BridgeChannel::MAX_FRAMES * 2), // one staged block + one callback
+    outputFifo(BridgeChannel::MAX_CHANNELS, BridgeChannel::MAX_FRAMES * 3), // latency + one block + one callback
+    requestBuffer(BridgeChannel::MAX_CHANNELS, BridgeChannel::MAX_FRAMES),
+    replyBuffer(BridgeChannel::MAX_CHANNELS, BridgeChannel::MAX_FRAMES),
+    requestFrames(BridgeChannel::MAX_FRAMES),
+    lastRequest(0),
+    waitingReply(false),
+    missedInThisCallback(false),
+    consecutiveMisses(0),
+    watchdogTriggered(false),
+    missedBlocks(0)
+{
+    stagedMidi.reserve(BridgeChannel::MAX_MIDI_EVENTS * 2);
+
+    reset(0);
+}
+
+void BridgeClient::reset(uint latency)
+{
+    latency = qMin(latency, static_cast<uint>(BridgeChannel::MAX_FRAMES));
+    requestFrames = latency > 0 ? latency : static_cast<uint>(BridgeChannel::MAX_FRAMES);
+
+    inputFifo.clear();
+    stagedMidi.clear();
+
+    outputFifo.clear();
+    replyBuffer.setToStereo();
+    replyBuffer.setFrameLenght(latency);
+    replyBuffer.zero();
+    outputFifo.write(replyBuffer); // the first 'latency' frames are silence
+
+    auto block = channel.getBlock();
+    lastRequest = block ? block->requestSequence.load() : 0;
+    waitingReply = false;
+    consecutiveMisses = 0;
+    watchdogTriggered = false;
+}
+
+void BridgeClient::registerMiss()
+{
+    if (missedInThisCallback)
+        return; // one miss per callback
+
+    missedInThisCallback = true;
+    missedBlocks++;
+
+    if (++consecutiveMisses >= MAX_CONSECUTIVE_MISSES)
+        watchdogTriggered = true;
+}
+
+bool BridgeClient::replyIsAvailable() const
+{
+    return channel.getBlock()->replySequence.load(std::memory_order_acquire) == lastRequest;
+}
+
+void BridgeClient::receiveReply()
+{
+    auto block = channel.getBlock();
+
+    const uint frames = requestBuffer.getFrameLenght();
+    replyBuffer.setFrameLenght(frames);
+    if (requestBuffer.isMono())
+        replyBuffer.setToMono();
+    else
+        replyBuffer.setToStereo();
+
+    for (int c = 0; c < replyBuffer.getChannels(); ++c)
+        std::memcpy(replyBuffer.getSamplesArray(c), block->output[c], frames * sizeof(float));
+
+    outputFifo.write(replyBuffer);
+    waitingReply = false;
+    consecutiveMisses = 0;
+}
+
+void BridgeClient::passRequestInput()
+{
+    outputFifo.write(requestBuffer); // keeping the latency constant
+    waitingReply = false;
+}
+
+void BridgeClient::stageInput(const SamplesBuffer &in, uint frames, const std::vector<midi::MidiMessage> &midiBuffer)
+{
+    const uint stagedFrames = inputFifo.getAvailableFrames();
+
+    for (const auto &message : midiBuffer) {
+        if (stagedMidi.size() >= stagedMidi.capacity())
+            break; // never allocating
+
+        BridgeChannel::MidiEvent event;
+        event.data = message.getStatus() | (message.getData1() << 8) | (message.getData2() << 16);
+        event.frameOffset = stagedFrames + message.getFrameOffset();
+        stagedMidi.push_back(event);
+    }
+
+    inputFifo.write(in, 0, frames);
+}
+
+void BridgeClient::takeRequestInput(int channels)
+{
+    if (channels == 1)
+        requestBuffer.setToMono();
+    else
+        requestBuffer.setToStereo();
+
+    requestBuffer.setFrameLenght(requestFrames);
+    inputFifo.read(requestBuffer, 0, requestFrames);
+}
+
+void BridgeClient::discardStagedMidi(uint frames)
+{
+    size_t kept = 0;
+    for (const auto &event : stagedMidi) {
+        if (event.frameOffset >= frames) {
+            stagedMidi[kept] = event;
+            stagedMidi[kept].frameOffset -= frames;
+            kept++;
+        }
+    }
+
+    stagedMidi.resize(kept);
+}
+
+void BridgeClient::sendRequest()
+{
+    auto block = channel.getBlock();
+
+    const uint frames = requestBuffer.getFrameLenght();
+    const int channels = requestBuffer.getChannels();
+    for (int c = 0; c < channels; ++c)
+        std::memcpy(block->input[c], requestBuffer.getSamplesArray(c), frames * sizeof(float));
+
+    quint32 midiEvents = 0;
+    for (const auto &event : stagedMidi) {
+        if (event.frameOffset < frames && midiEvents < static_cast<quint32>(BridgeChannel::MAX_MIDI_EVENTS))
+            block->midiEvents[midiEvents++] = event;
+    }
+
+    block->frames = frames;
+    block->channels = static_cast<quint32>(channels);
+    block->midiEventsCount = midiEvents;
+
+    block->requestSequence.store(++lastRequest, std::memory_order_release);
+    channel.notifyRequest();
+
+    waitingReply = true;
+}
+
+void BridgeClient::process(const SamplesBuffer &in, SamplesBuffer &out, const std::vector<midi::MidiMessage> &midiBuffer)
+{
+    if (!channel.isValid() || in.getChannels() == 0)
+        return;
+
+    const uint frames = qMin(out.getFrameLenght(), static_cast<uint>(BridgeChannel::MAX_FRAMES));
+    const int channels = qBound(1, out.getChannels(), static_cast<int>(BridgeChannel::MAX_CHANNELS));
+
+    missedInThisCallback = false;
+
+    // the block sent before is received when the output is available or needed
+    if (waitingReply) {
+        if (replyIsAvailable()) {
+            receiveReply();
+        }
+        else if (outputFifo.getAvailableFrames() < frames) { // deadline missed, the bridge is still rendering (or crashed)
+            registerMiss();
+            passRequestInput();
+        }
+    }
+
+    stageInput(in, frames, midiBuffer);
+
+    while (inputFifo.getAvailableFrames() >= requestFrames) { // one host block is staged
+        if (waitingReply) { // the next request is ready before the previous reply
+            if (replyIsAvailable()) {
+                receiveReply();
+            }
+            else {
+                registerMiss();
+                passRequestInput();
+            }
+        }
+
+        takeRequestInput(channels);
+
+        bool bridgeIsIdle = replyIsAvailable();
+        if (bridgeIsIdle && !watchdogTriggered) {
+            sendRequest();
+        }
+        else {
+            if (!bridgeIsIdle)
+                registerMiss(); // still rendering an old block
+
+            passRequestInput();
+        }
+
+        discardStagedMidi(requestFrames);
+    }
+
+    uint readedFrames = outputFifo.read(out, 0, frames);
+    if (readedFrames < frames) { // only if the latency is smaller than the block
+        for (int c = 0; c < out.getChannels(); ++c)
+            std::memset(out.getSamplesArray(c) + readedFrames, 0, (frames - readedFrames) * sizeof(float));
+    }
+}
+
+// ++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+BridgeServer::BridgeServer(BridgeChannel &channel, audio::AudioNodeProcessor &processor) :
+    channel(channel),
+    processor(processor),
+    inputBuffer(BridgeChannel::MAX_CHANNELS, BridgeChannel::MAX_FRAMES),
+    outputBuffer(BridgeChannel::MAX_CHANNELS, BridgeChannel::MAX_FRAMES),
+    stopRequested(false)
+{
+    midiBuffer.reserve(BridgeChannel::MAX_MIDI_EVENTS * 2); // plugins can append generated messages
+
+    setObjectName("VST bridge server");
+}
+
+BridgeServer::~BridgeServer()
+{
+    stop();
+}
+
+void BridgeServer::stop()
+{
+    stopRequested = true;
+    wait();
+}
+
+void BridgeServer::run()
+{
+    if (!channel.isValid())
+        return;
+
+    auto block = channel.getBlock();
+    quint32 lastSequence = block->requestSequence.load();
+
+    while (!stopRequested.load()) {
+        if (!channel.waitRequest(lastSequence, 100)) // timeout to check the stop flag
+            continue;
+
+        lastSequence = block->requestSequence.load(std::memory_order_acquire);
+
+        processRequest();
+
+        block->replySequence.store(lastSequence, std::memory_order_release);
+    }
+}
+
+void BridgeServer::processRequest()
+{
+    auto block = channel.getBlock();
+
+    const uint frames = qMin(block->frames, static_cast<quint32>(BridgeChannel::MAX_FRAMES));
+    const int channels = static_cast<int>(qBound(1u, block->channels, static_cast<quint32>(BridgeChannel::MAX_CHANNELS)));
+
+    if (channels == 1) {
+        inputBuffer.setToMono();
+        outputBuffer.setToMono();
+    }
+    else {
+        inputBuffer.setToStereo();
+        outputBuffer.setToStereo();
+    }
+
+    inputBuffer.setFrameLenght(frames);
+    outputBuffer.setFrameLenght(frames);
+
+    for (int c = 0; c < channels; ++c)
+        std::memcpy(inputBuffer.getSamplesArray(c), block->input[c], frames * sizeof(float));
+
+    outputBuffer.set(inputBuffer); // like in AudioNode, the plugin output starts with the input samples (VSTis are adding)
+
+    midiBuffer.clear();
+    const quint32 midiEvents = qMin(block->midiEventsCount, static_cast<quint32>(BridgeChannel::MAX_MIDI_EVENTS));
+    for (quint32 m = 0; m < midiEvents; ++m) {
+        midiBuffer.push_back(midi::MidiMessage(block->midiEvents[m].data, -1));
+        midiBuffer.back().setFrameOffset(block->midiEvents[m].frameOffset);
+    }
+
+    if (!processor.isBypassed())
+        processor.process(inputBuffer, outputBuffer, midiBuffer);
+
+    for (int c = 0; c < channels; ++c)
+        std::memcpy(block->output[c], outputBuffer.getSamplesArray(c), frames * sizeof(float));
+}
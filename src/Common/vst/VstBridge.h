@@ -0,0 +1,190 @@
+#ifndef VST_BRIDGE_H
+#define VST_BRIDGE_H
+
+#include <QSharedMemory>
+#include <QThread>
+
+#include <atomic>
+#include <vector>
+
+#include "audio/core/AudioDriver.h"
+#include "audio/core/SamplesBuffer.h"
+#include "audio/core/SamplesRingBuffer.h"
+#include "midi/MidiMessage.h"
+
+namespace audio {
+class AudioNodeProcessor;
+}
+
+namespace vst {
+
+/**
+ * Shared memory block between Jamtaba and a VstBridge process hosting a plugin (out of process).
+ *
+ * Only one request is processed at time: Jamtaba writes the input samples and midi events and
+ * increments requestSequence, the bridge process renders the block and publishes the same sequence
+ * in replySequence. The audio thread never waits, it just wakes up the bridge (a futex in Linux).
+ */
+class BridgeChannel
+{
+public:
+    static const int MAX_CHANNELS = 2;
+    static const int MAX_FRAMES = audio::MaxBufferSize;
+    static const int MAX_MIDI_EVENTS = 64;
+
+    struct MidiEvent
+    {
+        qint32 data; // status, data1 and data2 bytes, like in MidiMessage
+        quint32 frameOffset;
+    };
+
+    struct Block
+    {
+        quint32 magic;
+        std::atomic<quint32> requestSequence; // written by Jamtaba, the futex word
+        std::atomic<quint32> replySequence; // written by the bridge process
+        quint32 frames;
+        quint32 channels;
+        quint32 midiEventsCount;
+        MidiEvent midiEvents[MAX_MIDI_EVENTS];
+        float input[MAX_CHANNELS][MAX_FRAMES];
+        float output[MAX_CHANNELS][MAX_FRAMES];
+    };
+
+    explicit BridgeChannel(const QString &key);
+    ~BridgeChannel();
+
+    bool create(); // Jamtaba side
+    bool attach(); // bridge process side
+
+    bool isValid() const;
+    QString getKey() const;
+    QString getErrorString() const;
+
+    Block *getBlock() const;
+
+    void notifyRequest(); // called by the audio thread, never blocks
+    bool waitRequest(quint32 lastSequence, int timeoutInMs); // return true if a new request is available
+
+    static const quint32 MAGIC = 0x4A544252; // 'JTBR'
+
+private:
+    Q_DISABLE_COPY(BridgeChannel)
+
+    bool openRequestEvent(bool create);
+
+    QSharedMemory sharedMemory;
+    Block *block;
+    void *requestEvent; // Windows only, futex is used in Linux
+};
+
+inline BridgeChannel::Block *BridgeChannel::getBlock() const
+{
+    return block;
+}
+
+inline bool BridgeChannel::isValid() const
+{
+    return block != nullptr;
+}
+
+inline QString BridgeChannel::getKey() const
+{
+    return sharedMemory.key();
+}
+
+inline QString BridgeChannel::getErrorString() const
+{
+    return sharedMemory.errorString();
+}
+
+// ++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+/**
+ * Jamtaba side of the bridge, used in the audio thread. The input is accumulated until one host block
+ * ('latency' frames) is available, so the split blocks processed by NinjamController are sent in only
+ * one request. The request is received when its output is needed, so the bridged plugin output is
+ * delayed by a constant latency (one host block). If the bridge process is late (or crashed) the input
+ * samples are passed through, and after some consecutive missed deadlines the watchdog bypass the plugin.
+ */
+class BridgeClient
+{
+public:
+    explicit BridgeClient(BridgeChannel &channel);
+
+    void reset(uint latency); // not called in the audio thread
+
+    void process(const audio::SamplesBuffer &in, audio::SamplesBuffer &out, const std::vector<midi::MidiMessage> &midiBuffer);
+
+    bool isWatchdogTriggered() const;
+    quint32 getMissedBlocks() const;
+
+    static const int MAX_CONSECUTIVE_MISSES = 8;
+
+private:
+    Q_DISABLE_COPY(BridgeClient)
+
+    void stageInput(const audio::SamplesBuffer &in, uint frames, const std::vector<midi::MidiMessage> &midiBuffer);
+    void takeRequestInput(int channels); // move one host block from the staged input to 'requestBuffer'
+    void sendRequest();
+    void discardStagedMidi(uint frames);
+    bool replyIsAvailable() const;
+    void receiveReply();
+    void passRequestInput(); // the request input is used as output, like a bypassed plugin
+    void registerMiss();
+
+    BridgeChannel &channel;
+    audio::SamplesRingBuffer inputFifo; // the staged input, not sent yet
+    audio::SamplesRingBuffer outputFifo; // the bridged output, delayed by 'latency' frames
+    audio::SamplesBuffer requestBuffer; // the input of the last request
+    audio::SamplesBuffer replyBuffer;
+    std::vector<BridgeChannel::MidiEvent> stagedMidi; // frame offsets are relative to the staged input
+    uint requestFrames; // one host block
+    quint32 lastRequest;
+    bool waitingReply;
+    bool missedInThisCallback;
+    int consecutiveMisses;
+    std::atomic<bool> watchdogTriggered;
+    std::atomic<quint32> missedBlocks;
+};
+
+inline bool BridgeClient::isWatchdogTriggered() const
+{
+    return watchdogTriggered.load();
+}
+
+inline quint32 BridgeClient::getMissedBlocks() const
+{
+    return missedBlocks.load();
+}
+
+// ++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+/**
+ * Bridge process side: a real time thread waiting for requests and rendering them with the hosted plugin.
+ */
+class BridgeServer : public QThread
+{
+public:
+    BridgeServer(BridgeChannel &channel, audio::AudioNodeProcessor &processor);
+    ~BridgeServer();
+
+    void stop();
+
+protected:
+    void run() override;
+
+private:
+    void processRequest();
+
+    BridgeChannel &channel;
+    audio::AudioNodeProcessor &processor;
+    audio::SamplesBuffer inputBuffer;
+    audio::SamplesBuffer outputBuffer;
+    std::vector<midi::MidiMessage> midiBuffer;
+    std::atomic<bool> stopRequested;
+};
+
+} // namespace
+
+#endif // VST_BRIDGE_H
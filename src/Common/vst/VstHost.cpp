@@ -11,6 +11,13 @@
 
 using vst::VstHost;
 
+namespace {
+
+// each plugin is pointing to your own buffer while processing, the nodes can be rendered in parallel
+thread_local std::vector<midi::MidiMessage> *midiOutputBuffer = nullptr;
+
+} // namespace
+
 QScopedPointer<VstHost> VstHost::hostInstance;
 
 VstHost *VstHost::getInstance()
@@ -56,11 +63,9 @@ void VstHost::setPlayingFlag(bool playing)
         clearVstTimeInfoFlags();
 }
 
-std::vector<midi::MidiMessage> VstHost::pullReceivedMidiMessages()
+void VstHost::setMidiOutputBuffer(std::vector<midi::MidiMessage> *outBuffer)
 {
-    std::vector<midi::MidiMessage> messages(receivedMidiMessages);
-    receivedMidiMessages.clear();
-    return messages;
+    midiOutputBuffer = outBuffer;
 }
 
 void VstHost::setPositionInSamples(int intervalPosition)
@@ -192,12 +197,12 @@ long VSTCALLBACK VstHost::hostCallback(AEffect *effect, long opcode, long index,
     case audioMasterProcessEvents:    // 8 - receiving midi events generated by vst plugins
     {
         VstEvents *vstEvents = (VstEvents *)ptr;
-        if (vstEvents) {
+        if (vstEvents && midiOutputBuffer) { // messages sended outside the plugin process call (GUI thread) are discarded
             for (int i = 0; i < vstEvents->numEvents; ++i) {
                 if (vstEvents->events[i]->type == kVstMidiType) {
                     VstMidiEvent *vstMidiEvent = (VstMidiEvent *)vstEvents->events[i];
-                    auto msg = midi::MidiMessage::fromArray(vstMidiEvent->midiData);
-                    hostInstance->receivedMidiMessages.push_back(msg);
+                    if (midiOutputBuffer->size() < midiOutputBuffer->capacity()) // never allocating in the audio thread
+                        midiOutputBuffer->push_back(midi::MidiMessage::fromArray(vstMidiEvent->midiData));
                 }
             }
         }
@@ -30,14 +30,15 @@ public:
         return blockSize;
     }
 
-    std::vector<midi::MidiMessage> pullReceivedMidiMessages() override;
-
     void setSampleRate(int sampleRate) override;
     void setBlockSize(int blockSize) override;
     void setTempo(int bpm) override;
     void setPlayingFlag(bool playing) override;
     void setPositionInSamples(int intervalPosition) override;
 
+    // the messages generated by the plugins processed in the current thread are appended in 'outBuffer' (nullptr = discarded)
+    static void setMidiOutputBuffer(std::vector<midi::MidiMessage> *outBuffer);
+
 protected:
     static long VSTCALLBACK hostCallback(AEffect *effect, long opcode, long index, long value,
                                          void *ptr, float opt);
@@ -2,6 +2,7 @@
 #include "MainControllerPlugin.h"
 #include "NinjamControllerPlugin.h"
 #include "log/Logging.h"
+#include "audio/core/AudioDriver.h"
 #include <QApplication>
 
 // anti troll scheme to avoid multiple connections in ninjam servers
@@ -21,6 +22,9 @@ JamTabaPlugin::JamTabaPlugin(quint8 inputChannels, quint8 outputChannels) :
     hostWasPlayingInLastAudioCallBack(false)
 {
     qCDebug(jtVstPlugin) << "Base Plugin constructor...";
+
+    inputBuffer.reserve(audio::MaxBufferSize);
+    outputBuffer.reserve(audio::MaxBufferSize);
 }
 
 JamTabaPlugin::~JamTabaPlugin ()
@@ -46,6 +50,7 @@ void JamTabaPlugin::initialize()
             qCDebug(jtVstPlugin)<< "Creating controller!";
             controller.reset(createPluginMainController(settings, this));
             controller->setSampleRate(getSampleRate());
+            controller->setAudioBuffersLayout(inputBuffer.getChannels(), outputBuffer.getChannels(), audio::MaxBufferSize);
             controller->start();
 
             qCDebug(jtVstPlugin)<< "Controller started!";
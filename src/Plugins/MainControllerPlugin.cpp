@@ -6,7 +6,7 @@
 #include "log/Logging.h"
 
 MainControllerPlugin::MainControllerPlugin(const Settings &settings, JamTabaPlugin *plugin) :
-    MainController(settings),
+    MainController(settings, 0), // the DAW is scheduling the threads, no render workers inside the plugin
     plugin(plugin)
 {
     qCDebug(jtCore) << "Creating MainControllerVST instance!";
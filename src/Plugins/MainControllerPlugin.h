@@ -65,15 +65,10 @@ public:
 
     Preset loadPreset(const QString &name) override;
 
-    inline std::vector<midi::MidiMessage> pullMidiMessagesFromPlugins() override
-    {
-        return std::vector<midi::MidiMessage>(); // empty buffer
-    }
-
 protected:
-    inline std::vector<midi::MidiMessage> pullMidiMessagesFromDevices() override
+    inline void pullMidiMessagesFromDevices(std::vector<midi::MidiMessage> &outBuffer) override
     {
-        return std::vector<midi::MidiMessage>(); // empty buffer
+        Q_UNUSED(outBuffer); // no midi devices in plugin version
     }
 
     JamTabaPlugin *plugin;
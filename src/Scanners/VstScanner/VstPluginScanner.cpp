@@ -6,10 +6,37 @@
 #include "VstPluginChecker.h"
 #include "log/Logging.h"
 
-#include <QDataStream>
-#include <QDirIterator>
 #include <QLibrary>
 
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+#ifdef Q_OS_WIN
+    #include <io.h>
+    #include <fcntl.h>
+#else
+    #include <unistd.h>
+#endif
+
+namespace {
+
+// stdout is redirected to stderr, return a descriptor to the original stdout
+int redirectStandardOutput()
+{
+#ifdef Q_OS_WIN
+    int outputDescriptor = _dup(_fileno(stdout));
+    _dup2(_fileno(stderr), _fileno(stdout));
+    _setmode(outputDescriptor, _O_BINARY); // no '\n' translation in the binary messages
+#else
+    int outputDescriptor = dup(fileno(stdout));
+    dup2(fileno(stderr), fileno(stdout));
+#endif
+    return outputDescriptor;
+}
+
+} // namespace
+
 VstPluginScanner::VstPluginScanner()
     : BaseScanner()
 {
@@ -43,66 +70,45 @@ audio::PluginDescriptor VstPluginScanner::getPluginDescriptor(const QFileInfo &p
 
 void VstPluginScanner::scan()
 {
-    if (foldersToScan.isEmpty()) {
-        qCInfo(jtStandalonePluginFinder) << "Folders to scan is empty!";
-        return;
-    } else {
-        qCDebug(jtStandalonePluginFinder) << "Folders to scan: " << foldersToScan;
-    }
+    /**
+     The plugin paths are received in the standard input, one per line. Jamtaba is sending the next path
+     after receive the result for the previous one, so if some plugin crash this process only the remaining
+     paths are sended to a new scanner process.
+    */
 
-    writeToProcessOutput("JT-Scanner-Starting");
-    for (const QString &scanFolder : foldersToScan)
-    {
-        QDirIterator folderIterator(scanFolder, QDir::AllEntries | QDir::NoDotAndDotDot | QDir::NoSymLinks, QDirIterator::Subdirectories);
-        while (folderIterator.hasNext())
-        {
-            folderIterator.next(); // point to next file inside current folder
-            QFileInfo pluginFileInfo(folderIterator.filePath());
-
-            if (!skipList.contains(pluginFileInfo.absoluteFilePath()))
-            {
-                if (canScan(pluginFileInfo)) {
-                    writeToProcessOutput("JT-Scanner-Scanning: "+ pluginFileInfo.absoluteFilePath());
-                    auto descriptor = getPluginDescriptor(pluginFileInfo);
-                    if (descriptor.isValid())
-                        writeToProcessOutput("JT-Scanner-Scan-Finished: " + descriptor.getPath());
-                }
-            }
-        }
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        QString pluginPath = QString::fromStdString(line).trimmed();
+        if (pluginPath.isEmpty())
+            continue;
+
+        writeMessage(vst::ScanMessage(vst::ScanMessage::ScanStarted, pluginPath));
+
+        auto descriptor = getPluginDescriptor(QFileInfo(pluginPath));
+        if (descriptor.isValid())
+            writeMessage(vst::ScanMessage(vst::ScanMessage::PluginFounded, pluginPath, descriptor.getName(), descriptor.getManufacturer()));
+        else
+            writeMessage(vst::ScanMessage(vst::ScanMessage::NotAPlugin, pluginPath));
     }
-    writeToProcessOutput("JT-Scanner-Finished");
 }
 
-
-bool VstPluginScanner::canScan(const QFileInfo &pluginFileInfo) const
+void VstPluginScanner::writeMessage(const vst::ScanMessage &message)
 {
-    /**
-      In Mac VST plugins are bundles, in windows these plugins are DLLs.
-    */
-
-    return pluginFileInfo.isBundle() || pluginFileInfo.suffix() == "dll";
+    output.write(message.serialize());
+    output.flush();
 }
 
 void VstPluginScanner::initialize(int argc, char *argv[])
 {
+    Q_UNUSED(argc)
+    Q_UNUSED(argv)
+
     /**
-     The first arg is always the executable path. We need at least the folders strinb (2nd arg).
-     The blacklist can be empty.
+     Some plugins are writing in stdout when loaded. The original stdout is duplicated to write the binary
+     messages and the stdout is redirected to stderr, so the plugins garbage is not mixed with the messages.
     */
 
-    qCInfo(jtStandalonePluginFinder) << "Initializing scan folders list and blackList!";
-
-    if (argc < 2)
-        return;
-
-    QString foldersString = QString::fromUtf8(argv[1]);
-
-    if (!foldersString.isEmpty())
-        this->foldersToScan = foldersString.split(";"); // the folders are separated using ';'
-
-    if (argc > 2) { // we have a black list string?
-        QString skipListString = QString::fromUtf8(argv[2]);
-        if (!skipListString.isEmpty())
-            this->skipList = skipListString.split(";");
-    }
+    std::fflush(stdout);
+    if (!output.open(redirectStandardOutput(), QIODevice::WriteOnly | QIODevice::Unbuffered, QFileDevice::AutoCloseHandle))
+        qCritical() << "Can't open the VstScanner output!";
 }
@@ -2,6 +2,9 @@
 #define VSTPLUGINSCANNER_H
 
 #include "BaseScanner.h"
+#include "vst/ScanMessage.h"
+
+#include <QFile>
 
 class VstPluginScanner : public BaseScanner
 {
@@ -10,13 +13,12 @@ public:
     VstPluginScanner();
 
 private:
-    bool canScan(const QFileInfo &pluginFileInfo) const;
-
-    QStringList foldersToScan;
-    QStringList skipList; // contain blackListed and cached plugins
+    QFile output; // the original stdout, the plugins are writing in stderr
 
     void initialize(int argc, char *argv[]) override;
 
+    void writeMessage(const vst::ScanMessage &message);
+
     audio::PluginDescriptor getPluginDescriptor(const QFileInfo &pluginFile);
 
 protected:
@@ -27,11 +27,6 @@ AudioUnitHost::AudioUnitHost()
 
 }
 
-std::vector<midi::MidiMessage> AudioUnitHost::pullReceivedMidiMessages()
-{
-    return std::vector<midi::MidiMessage>();
-}
-
 void AudioUnitHost::setSampleRate(int sampleRate)
 {
     if (sampleRate != this->sampleRate)
@@ -17,8 +17,6 @@ public:
     int getSampleRate() const override;
     int getBufferSize() const override;
 
-    std::vector<midi::MidiMessage> pullReceivedMidiMessages() override;
-
     void setSampleRate(int sampleRate) override;
     void setBlockSize(int blockSize) override;
     void setTempo(int bpm) override;
@@ -5,6 +5,7 @@
 #include "audio/PortAudioDriver.h"
 #include "audio/core/LocalInputNode.h"
 #include "vst/VstPlugin.h"
+#include "vst/BridgedVstPlugin.h"
 #include "vst/VstHost.h"
 #include "vst/VstPluginFinder.h"
 #include "audio/core/PluginDescriptor.h"
@@ -155,6 +156,9 @@ void MainControllerStandalone::clearPluginsCache()
 {
     settings.clearVstCache();
 
+    if (vstPluginFinder)
+        vstPluginFinder->clearScanCache(); // the plugins cached as invalid are loaded again
+
     #ifdef Q_OS_MAC
     settings.clearAudioUnitCache();
     #endif
@@ -292,6 +296,9 @@ void MainControllerStandalone::setBufferSize(int newBufferSize)
     for (auto host : hosts)
         host->setBlockSize(newBufferSize);
 
+    for (auto inputNode : inputTracks)
+        inputNode->setProcessorsBlockSize(newBufferSize); // the bridged plugins latency is one block
+
     audioDriver->setBufferSize(newBufferSize);
     settings.setBufferSize(newBufferSize);
 }
@@ -546,6 +553,16 @@ audio::Plugin *MainControllerStandalone::createPluginInstance(
     else if (descriptor.isVST())
     {
         auto host = vst::VstHost::getInstance();
+        if (settings.isUsingVstBridge() && !vst::BridgedVstPlugin::getBridgeExecutablePath().isEmpty())
+        {
+            auto bridgedPlugin = new vst::BridgedVstPlugin(host, descriptor.getPath()); // running in a separated process
+            if (bridgedPlugin->load(descriptor.getPath()))
+                return bridgedPlugin;
+
+            delete bridgedPlugin;
+            qCWarning(jtStandaloneVstPlugin) << "Loading" << descriptor.getName() << "without VstBridge";
+        }
+
         auto vstPlugin = new vst::VstPlugin(host, descriptor.getPath());
         if (vstPlugin->load(descriptor.getPath()))
             return vstPlugin;
@@ -752,26 +769,10 @@ void MainControllerStandalone::quit()
     application->quit();
 }
 
-std::vector<midi::MidiMessage> MainControllerStandalone::pullMidiMessagesFromPlugins()
-{
-    // return midi messages created by vst and AU plugins, not by midi controllers.
-    std::vector<midi::MidiMessage> receivedMidiMessages;
-    for (auto host : hosts)
-    {
-        std::vector<midi::MidiMessage> pulledMessages = host->pullReceivedMidiMessages();
-        receivedMidiMessages.insert(receivedMidiMessages.end(),
-                                    pulledMessages.begin(), pulledMessages.end());
-    }
-
-    return receivedMidiMessages;
-}
-
-std::vector<midi::MidiMessage> MainControllerStandalone::pullMidiMessagesFromDevices()
+void MainControllerStandalone::pullMidiMessagesFromDevices(std::vector<midi::MidiMessage> &outBuffer)
 {
-    if (!midiDriver)
-        return std::vector<midi::MidiMessage>();
-
-    return midiDriver->getBuffer();
+    if (midiDriver)
+        midiDriver->getBuffer(outBuffer);
 }
 
 bool MainControllerStandalone::isUsingNullAudioDriver() const
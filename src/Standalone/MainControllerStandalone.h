@@ -113,8 +113,6 @@ namespace controller
         Plugin *addPlugin(quint32 inputTrackIndex, quint32 pluginSlotIndex,
                           const PluginDescriptor &descriptor);
 
-        std::vector<midi::MidiMessage> pullMidiMessagesFromPlugins() override;
-
     public slots:
         void setSampleRate(int newSampleRate) override;
         void setBufferSize(int newBufferSize);
@@ -144,7 +142,7 @@ namespace controller
 
         void setupNinjamControllerSignals() override;
 
-        std::vector<midi::MidiMessage> pullMidiMessagesFromDevices() override;
+        void pullMidiMessagesFromDevices(std::vector<midi::MidiMessage> &outBuffer) override;
 
     protected slots:
         void updateBpm(int newBpm) override;
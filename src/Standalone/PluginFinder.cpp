@@ -5,6 +5,21 @@
 using audio::PluginFinder;
 using audio::PluginDescriptor;
 
+PluginFinder::~PluginFinder()
+{
+    //
+}
+
+void PluginFinder::handleScanningStart(const QString &scannedLine)
+{
+    Q_UNUSED(scannedLine); // the text lines are not used by all finders
+}
+
+void PluginFinder::handleScanningFinished(const QString &scannedLine)
+{
+    Q_UNUSED(scannedLine);
+}
+
 void PluginFinder::finishScan()
 {
     QProcess::ExitStatus exitStatus = scanProcess.exitStatus();
@@ -16,8 +16,10 @@ class PluginFinder : public QObject
     Q_OBJECT
 
 public:
-    void scan(const QStringList &foldersToScan = QStringList(), const QStringList &skipList = QStringList());
-    void cancel();
+    virtual ~PluginFinder();
+
+    virtual void scan(const QStringList &foldersToScan = QStringList(), const QStringList &skipList = QStringList());
+    virtual void cancel();
 
 protected:
     QProcess scanProcess;
@@ -27,8 +29,8 @@ protected:
 
     void handleProcessError(const QString &lastScannedPlugin);
 
-    virtual void handleScanningStart(const QString &scannedLine) = 0;
-    virtual void handleScanningFinished(const QString &scannedLine) = 0;
+    virtual void handleScanningStart(const QString &scannedLine);
+    virtual void handleScanningFinished(const QString &scannedLine);
 
      QString buildCommaSeparatedString(const QStringList &list) const;
 
@@ -0,0 +1,230 @@
+#include "BridgedVstPlugin.h"
+
+#include "vst/VstHost.h"
+#include "vst/Utils.h"
+#include "log/Logging.h"
+
+#include <QApplication>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QPoint>
+
+#include <atomic>
+
+using vst::BridgedVstPlugin;
+
+namespace {
+
+QString createSharedMemoryKey()
+{
+    static std::atomic<int> instances(0);
+    return QString("JamtabaVstBridge-%1-%2").arg(QCoreApplication::applicationPid()).arg(instances++);
+}
+
+} // namespace
+
+BridgedVstPlugin::BridgedVstPlugin(VstHost *host, const QString &pluginPath) :
+    audio::Plugin(vst::utils::createDescriptor(nullptr, pluginPath)),
+    host(host),
+    channel(createSharedMemoryKey()),
+    client(channel),
+    path(pluginPath),
+    virtualInstrument(false),
+    started(false),
+    failureReported(false)
+{
+    bridgeProcess.setProcessChannelMode(QProcess::ForwardedErrorChannel); // the bridge log messages are showed in Jamtaba log
+}
+
+BridgedVstPlugin::~BridgedVstPlugin()
+{
+    qCDebug(jtVstPlugin) << "Closing the VstBridge process for" << getName();
+
+    if (bridgeProcess.state() != QProcess::NotRunning) {
+        bridgeProcess.write("quit\n");
+        if (!bridgeProcess.waitForFinished(1000))
+            bridgeProcess.kill();
+    }
+}
+
+QString BridgedVstPlugin::getBridgeExecutablePath()
+{
+    QString bridgeExePath = QApplication::applicationDirPath() + "/VstBridge"; // the VstBridge and Jamtaba2 executables are in the same folder, like the VstScanner
+#ifdef Q_OS_WIN
+    bridgeExePath += ".exe";
+#endif
+    if (QFile(bridgeExePath).exists())
+        return bridgeExePath;
+
+    qCritical() << "VstBridge executable not founded in" << bridgeExePath;
+    return "";
+}
+
+bool BridgedVstPlugin::load(const QString &path)
+{
+    QString bridgeExePath = getBridgeExecutablePath();
+    if (bridgeExePath.isEmpty() || !host)
+        return false;
+
+    if (!channel.create())
+        return false;
+
+    QStringList arguments;
+    arguments << path << channel.getKey() << QString::number(host->getSampleRate()) << QString::number(host->getBufferSize());
+
+    bridgeProcess.start(bridgeExePath, arguments);
+
+    QString reply;
+    if (!bridgeProcess.waitForStarted() || !readReply(reply, LOAD_TIMEOUT) || !reply.startsWith("JT-Bridge-Loaded: ")) {
+        qCritical() << "Can't load" << path << "in VstBridge process" << reply;
+        return false;
+    }
+
+    // JT-Bridge-Loaded: synth;name;vendor
+    QString pluginInfo = reply.mid(QString("JT-Bridge-Loaded: ").size());
+    virtualInstrument = pluginInfo.section(';', 0, 0) == "1";
+    name = pluginInfo.section(';', 1, 1);
+    descriptor = audio::PluginDescriptor(name, audio::PluginDescriptor::VST_Plugin, pluginInfo.section(';', 2), path);
+
+    this->path = path;
+
+    qCDebug(jtVstPlugin) << getName() << "loaded in VstBridge process";
+
+    return true;
+}
+
+bool BridgedVstPlugin::readReply(QString &reply, int timeout) const
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    forever {
+        while (bridgeProcess.canReadLine()) {
+            QString line = QString::fromUtf8(bridgeProcess.readLine()).trimmed();
+            if (line.startsWith("JT-Bridge-")) { // plugins can write some garbage in stdout
+                reply = line;
+                return !line.startsWith("JT-Bridge-Error");
+            }
+        }
+
+        int remainingTime = timeout - static_cast<int>(timer.elapsed());
+        if (remainingTime <= 0 || !bridgeProcess.waitForReadyRead(remainingTime))
+            return false;
+    }
+}
+
+bool BridgedVstPlugin::sendCommand(const QString &command, QString *reply, int timeout) const
+{
+    if (bridgeProcess.state() != QProcess::Running)
+        return false;
+
+    bridgeProcess.write(command.toUtf8() + '\n');
+
+    QString commandReply;
+    bool succeeded = readReply(commandReply, timeout);
+    if (!succeeded)
+        qCritical() << "VstBridge command" << command.left(32) << "failed for" << getName() << commandReply;
+
+    if (reply)
+        *reply = commandReply;
+
+    return succeeded;
+}
+
+void BridgedVstPlugin::start()
+{
+    if (!sendCommand("start"))
+        return;
+
+    started = false; // the next audio callbacks skip the client while it is reset
+    client.reset(static_cast<uint>(host->getBufferSize())); // one block of latency
+    started = true;
+}
+
+void BridgedVstPlugin::resume()
+{
+    sendCommand("resume");
+}
+
+void BridgedVstPlugin::suspend()
+{
+    sendCommand("suspend");
+}
+
+void BridgedVstPlugin::setSampleRate(int newSampleRate)
+{
+    sendCommand(QString("sampleRate %1").arg(newSampleRate));
+}
+
+void BridgedVstPlugin::setBlockSize(int newBlockSize)
+{
+    if (!sendCommand(QString("blockSize %1").arg(newBlockSize)))
+        return;
+
+    bool wasStarted = started.exchange(false); // the audio driver is stopped, but the audio callbacks skip the client anyway
+    client.reset(static_cast<uint>(newBlockSize)); // the latency follows the host block
+    started = wasStarted;
+}
+
+void BridgedVstPlugin::setBypass(bool state)
+{
+    Plugin::setBypass(state);
+    sendCommand(QString("bypass %1").arg(state ? 1 : 0));
+}
+
+bool BridgedVstPlugin::isVirtualInstrument() const
+{
+    return virtualInstrument;
+}
+
+QByteArray BridgedVstPlugin::getSerializedData() const
+{
+    QString reply;
+    if (sendCommand("getState", &reply) && reply.startsWith("JT-Bridge-State: "))
+        return QByteArray::fromBase64(reply.mid(QString("JT-Bridge-State: ").size()).toLatin1());
+
+    return QByteArray(); // empty byte array
+}
+
+void BridgedVstPlugin::restoreFromSerializedData(const QByteArray &dataToRestore)
+{
+    if (!dataToRestore.isEmpty())
+        sendCommand("restoreState " + QString::fromLatin1(dataToRestore.toBase64()));
+}
+
+void BridgedVstPlugin::openEditor(const QPoint &centerOfScreen)
+{
+    sendCommand(QString("openEditor %1 %2").arg(centerOfScreen.x()).arg(centerOfScreen.y())); // the editor window is owned by the bridge process
+}
+
+void BridgedVstPlugin::closeEditor()
+{
+    sendCommand("closeEditor");
+
+    audio::Plugin::closeEditor();
+}
+
+void BridgedVstPlugin::updateGui()
+{
+    // the bridge process is updating the editor, just reporting the failures here (GUI thread)
+    if (failureReported)
+        return;
+
+    if (bridgeProcess.state() == QProcess::NotRunning) {
+        qCCritical(jtVstPlugin) << "The VstBridge process hosting" << getName() << "finished, the plugin is bypassed!";
+        failureReported = true;
+    }
+    else if (client.isWatchdogTriggered()) {
+        qCCritical(jtVstPlugin) << getName() << "missed" << client.getMissedBlocks() << "audio blocks, the plugin is bypassed!";
+        failureReported = true;
+    }
+}
+
+void BridgedVstPlugin::process(const audio::SamplesBuffer &in, audio::SamplesBuffer &outBuffer, std::vector<midi::MidiMessage> &midiBuffer)
+{
+    if (isBypassed() || !started)
+        return;
+
+    client.process(in, outBuffer, midiBuffer); // never blocking, the output is delayed by one block
+}
@@ -0,0 +1,74 @@
+#ifndef BRIDGED_VST_PLUGIN_H
+#define BRIDGED_VST_PLUGIN_H
+
+#include "audio/core/Plugins.h"
+#include "vst/VstBridge.h"
+
+#include <QProcess>
+
+#include <atomic>
+
+namespace vst {
+
+class VstHost;
+
+/**
+ * VST plugin hosted in a VstBridge process, so a crashing or stalling plugin can't stop Jamtaba.
+ * The audio is exchanged using shared memory (adding one block of latency), the other plugin calls
+ * are text commands written in the bridge process input, like the VstScanner output lines.
+ */
+class BridgedVstPlugin : public audio::Plugin
+{
+public:
+    BridgedVstPlugin(vst::VstHost *host, const QString &pluginPath);
+    ~BridgedVstPlugin();
+
+    bool load(const QString &path);
+
+    void process(const audio::SamplesBuffer &in, audio::SamplesBuffer &outBuffer, std::vector<midi::MidiMessage> &midiBuffer) override;
+    void openEditor(const QPoint &centerOfScreen) override;
+    void closeEditor() override;
+
+    inline QString getPath() const override
+    {
+        return path;
+    }
+
+    QByteArray getSerializedData() const override;
+    void restoreFromSerializedData(const QByteArray &dataToRestore) override;
+
+    void start() override;
+    void updateGui() override;
+    void setSampleRate(int newSampleRate) override;
+    void setBlockSize(int newBlockSize) override;
+    void setBypass(bool state) override;
+
+    bool isVirtualInstrument() const override;
+
+    static QString getBridgeExecutablePath();
+
+protected:
+    void resume() override;
+    void suspend() override;
+
+private:
+    bool sendCommand(const QString &command, QString *reply = nullptr, int timeout = COMMAND_TIMEOUT) const;
+    bool readReply(QString &reply, int timeout) const;
+
+    vst::VstHost *host;
+    mutable QProcess bridgeProcess;
+    BridgeChannel channel;
+    BridgeClient client; // declared after the channel
+
+    QString path;
+    bool virtualInstrument;
+    std::atomic<bool> started; // written in the GUI thread, read in the audio thread
+    bool failureReported;
+
+    static const int COMMAND_TIMEOUT = 5000;
+    static const int LOAD_TIMEOUT = 30000; // some plugins are really slow to load
+};
+
+} // namespace
+
+#endif // BRIDGED_VST_PLUGIN_H
@@ -49,6 +49,8 @@ VstPlugin::VstPlugin(VstHost* host, const QString &pluginPath) :
         vstMidiEvents.events[i] = (VstEvent*)(new VstMidiEvent);
     }
 
+    generatedMidiMessages.reserve(MAX_MIDI_EVENTS); // not allocating in the audio thread
+
     assert(host);
 
 }
@@ -85,6 +87,12 @@ bool VstPlugin::canGenerateMidiMessages() const
     return returnValue >= 0;
 }
 
+void VstPlugin::pullGeneratedMidiMessages(std::vector<midi::MidiMessage> &outBuffer)
+{
+    outBuffer.insert(outBuffer.end(), generatedMidiMessages.begin(), generatedMidiMessages.end());
+    generatedMidiMessages.clear();
+}
+
 bool VstPlugin::isVirtualInstrument() const
 {
     if (!effect) {
@@ -146,6 +154,9 @@ void VstPlugin::start()
     internalOutputBuffer.reset(new audio::SamplesBuffer(effect->numOutputs, hostBufferSize));
     internalInputBuffer.reset(new audio::SamplesBuffer(effect->numInputs, hostBufferSize));
 
+    vstInputArray.resize(static_cast<size_t>(internalInputBuffer->getChannels()));
+    vstOutputArray.resize(static_cast<size_t>(internalOutputBuffer->getChannels()));
+
     long ver = effect->dispatcher(effect, effGetVstVersion, 0, 0, NULL, 0);// EffGetVstVersion();
     qCDebug(jtVstPlugin) << "Starting " << getName() << " version " << ver;
 
@@ -178,6 +189,18 @@ void VstPlugin::setSampleRate(int newSampleRate)
     }
 }
 
+void VstPlugin::setBlockSize(int newBlockSize)
+{
+    if (!effect || !started)
+        return;
+
+    // the audio driver is stopped, the internal buffers are not used in audio thread
+    internalOutputBuffer.reset(new audio::SamplesBuffer(effect->numOutputs, newBlockSize));
+    internalInputBuffer.reset(new audio::SamplesBuffer(effect->numInputs, newBlockSize));
+
+    effect->dispatcher(effect, effSetBlockSize, 0, newBlockSize, NULL, 0.0f);
+}
+
 VstPlugin::~VstPlugin()
 {
     qCDebug(jtVstPlugin) << getName() << " VSt plugin destructor Thread:" << QThread::currentThreadId();
@@ -211,16 +234,17 @@ void VstPlugin::unload()
     }
 }
 
-void VstPlugin::fillVstEventsList(const std::vector<midi::MidiMessage> &midiBuffer)
+void VstPlugin::fillVstEventsList(const std::vector<midi::MidiMessage> &midiBuffer, int blockFrames)
 {
     int midiMessages = qMin((int)midiBuffer.size(), (int)MAX_MIDI_EVENTS);
     this->vstMidiEvents.numEvents = midiMessages;
     for (int m = 0; m < midiMessages; ++m) {
-        auto message = midiBuffer.at(m);
+        const auto &message = midiBuffer.at(m);
         VstMidiEvent* vstEvent = (VstMidiEvent*)vstMidiEvents.events[m];
         vstEvent->type = kVstMidiType;
-        vstEvent->byteSize = sizeof(vstEvent);
-        vstEvent->deltaFrames = vstEvent->reserved1 = vstEvent->reserved2 = 0;
+        vstEvent->byteSize = sizeof(VstMidiEvent);
+        vstEvent->deltaFrames = qBound(0, static_cast<int>(message.getFrameOffset()), qMax(blockFrames - 1, 0)); // sample accurate
+        vstEvent->reserved1 = vstEvent->reserved2 = 0;
         vstEvent->midiData[0] = message.getStatus();
         vstEvent->midiData[1] = message.getData1();
         vstEvent->midiData[2] = message.getData2();
@@ -242,8 +266,11 @@ void VstPlugin::process(const audio::SamplesBuffer &in, audio::SamplesBuffer &ou
         turnedOn = true;
     }
 
+    generatedMidiMessages.clear();
+    VstHost::setMidiOutputBuffer(&generatedMidiMessages); // the midi events sended by the plugin in this thread
+
     if (wantMidi) {
-        fillVstEventsList(midiBuffer); // translate midiBuffer messages in VstEvents
+        fillVstEventsList(midiBuffer, outBuffer.getFrameLenght()); // translate midiBuffer messages in VstEvents
         effect->dispatcher(effect, effProcessEvents, 0, 0, (void*)&vstMidiEvents, 0);
     }
 
@@ -255,9 +282,6 @@ void VstPlugin::process(const audio::SamplesBuffer &in, audio::SamplesBuffer &ou
     int inChannels = internalInputBuffer->getChannels();
     int outChannels = internalOutputBuffer->getChannels();
 
-    std::vector<float *> vstOutputArray(outChannels);
-    std::vector<float *> vstInputArray(inChannels);
-
     for (int c = 0; c < inChannels; ++c)
         vstInputArray[c] = internalInputBuffer->getSamplesArray(c);
 
@@ -269,6 +293,8 @@ void VstPlugin::process(const audio::SamplesBuffer &in, audio::SamplesBuffer &ou
         effect->processReplacing(effect, vstInputArray.data(), vstOutputArray.data(), sampleFrames);
     }
 
+    VstHost::setMidiOutputBuffer(nullptr);
+
     /**
         VSTs are processing input samples and replacing the output buffer with these processed samples.
         VSTis are generating output samples directly, without touch the input buffer, and this make sense.
@@ -47,6 +47,8 @@ public:
 
     void setSampleRate(int newSampleRate) override;
 
+    void setBlockSize(int newBlockSize) override;
+
     void setBypass(bool state) override;
 
     static QDialog *getPluginEditorWindow(const QString &pluginName);
@@ -55,6 +57,8 @@ public:
 
     bool canGenerateMidiMessages() const override;
 
+    void pullGeneratedMidiMessages(std::vector<midi::MidiMessage> &outBuffer) override;
+
     inline quint32 getPluginID() const { return effect->resvd1; }
 
 protected:
@@ -70,6 +74,9 @@ private:
     std::unique_ptr<audio::SamplesBuffer> internalOutputBuffer;
     std::unique_ptr<audio::SamplesBuffer> internalInputBuffer;
 
+    std::vector<float *> vstInputArray; // allocated in start(), not in the audio thread
+    std::vector<float *> vstOutputArray;
+
     vst::VstHost *host;
 
     bool wantMidi;
@@ -81,7 +88,7 @@ private:
 
     bool loaded;
 
-    void fillVstEventsList(const std::vector<midi::MidiMessage> &midiBuffer);
+    void fillVstEventsList(const std::vector<midi::MidiMessage> &midiBuffer, int blockFrames);
 
     template<int N>
     struct VSTEventBlock
@@ -93,6 +100,8 @@ private:
 
     VSTEventBlock<MAX_MIDI_EVENTS> vstMidiEvents;
 
+    std::vector<midi::MidiMessage> generatedMidiMessages; // filled by VstHost when the plugin send midi events in process()
+
     static QMap<QString, QDialog *> editorsWindows;
 
 }; // class
@@ -1,27 +1,63 @@
 #include "VstPluginFinder.h"
 
 #include <QApplication>
-#include <QLibraryInfo>
+#include <QDir>
+#include <QLibrary>
+#include <QSet>
+#include <QThread>
+#include <QTimer>
 
+#include "vst/ScanMessage.h"
+#include "Configurator.h"
 #include "log/Logging.h"
 
 using audio::VSTPluginFinder;
+using vst::ScanMessage;
 
-VSTPluginFinder::VSTPluginFinder()
+namespace {
+
+const int MAX_SCAN_PROCESSES = 4;
+
+QString getScanCacheFilePath()
+{
+    return Configurator::getInstance()->getCacheDir().absoluteFilePath("vst_scan_cache.bin");
+}
+
+} // namespace
+
+class VSTPluginFinder::ScanProcess : public QProcess
 {
-    //
+public:
+    QByteArray receivedData; // incomplete messages
+    QString currentPlugin; // sended to scanner, but not finished yet
+    QTimer timeoutTimer; // restarted for each plugin
+};
+
+// ++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+VSTPluginFinder::VSTPluginFinder() :
+    scanCache(getScanCacheFilePath()),
+    scanning(false)
+{
+    scanCache.load();
 }
 
 VSTPluginFinder::~VSTPluginFinder()
 {
-    //
+    for (auto process : scanProcesses) {
+        process->disconnect(this);
+        process->kill();
+        process->waitForFinished(1000);
+        delete process;
+    }
+
+    if (scanning)
+        scanCache.save();
 }
 
-audio::PluginDescriptor VSTPluginFinder::getPluginDescriptor(const QFileInfo &f)
+int VSTPluginFinder::getMaxScanProcesses()
 {
-    QString name = audio::PluginDescriptor::getVstPluginNameFromPath(f.absoluteFilePath());
-    auto category = audio::PluginDescriptor::VST_Plugin;
-    return audio::PluginDescriptor(name, category, f.absoluteFilePath());
+    return qBound(1, QThread::idealThreadCount(), MAX_SCAN_PROCESSES);
 }
 
 QString VSTPluginFinder::getScannerExecutablePath() const
@@ -38,28 +74,219 @@ QString VSTPluginFinder::getScannerExecutablePath() const
     return "";
 }
 
-void VSTPluginFinder::handleScanningStart(const QString &scannedLine)
+QStringList VSTPluginFinder::findPluginFiles(const QStringList &foldersToScan, const QStringList &skipList) const
+{
+    QStringList pluginFiles;
+    QSet<QString> skippedFiles = skipList.toSet();
+
+    QStringList folders(foldersToScan);
+    while (!folders.isEmpty()) {
+        QDir folder(folders.takeFirst());
+        for (const QFileInfo &fileInfo : folder.entryInfoList(QDir::AllEntries | QDir::NoDotAndDotDot | QDir::NoSymLinks)) {
+            QString filePath = fileInfo.absoluteFilePath();
+            if (fileInfo.isDir() && !fileInfo.isBundle()) {
+                folders.append(filePath);
+                continue;
+            }
+
+            // just checking the file names here, the VstScanner is checking the binaries (VstPluginChecker).
+            // The bundles are not visited, the helper libraries inside the bundles are not plugins.
+            bool isCandidate = fileInfo.isBundle() || (fileInfo.isFile() && QLibrary::isLibrary(filePath));
+            if (isCandidate && !skippedFiles.contains(filePath)) {
+                pluginFiles.append(filePath);
+                skippedFiles.insert(filePath); // avoid duplicated files in nested scan folders
+            }
+        }
+    }
+
+    return pluginFiles;
+}
+
+void VSTPluginFinder::scan(const QStringList &foldersToScan, const QStringList &skipList)
 {
-    QStringList parts = scannedLine.split(": ");
-    if (parts.size() < 2) {
-        qCritical() << "Missing parts in scanned line: " << scannedLine;
+    if (scanning) {
+        qCritical() << "VST scan is already running!";
         return;
     }
 
-    QString pluginPath = parts.at(1);
-    lastScannedPlugin = pluginPath;// store the plugin path, if the scanner process crash we can add this bad plugin in the black list
-    emit pluginScanStarted(pluginPath);
+    if (getScannerExecutablePath().isEmpty())
+        return; // scanner executable not found!
+
+    scanning = true;
+    badPlugins.clear();
+    pendingPlugins.clear();
+
+    emit scanStarted();
+
+    int removedEntries = scanCache.removeMissingFiles();
+    if (removedEntries > 0)
+        qCDebug(jtStandalonePluginFinder) << removedEntries << "missing files removed from the VST scan cache";
+
+    // the unchanged files are not loaded again
+    for (const QString &pluginPath : findPluginFiles(foldersToScan, skipList)) {
+        if (scanCache.isUpToDate(QFileInfo(pluginPath))) {
+            auto entry = scanCache.getEntry(pluginPath);
+            if (entry.validPlugin)
+                emit pluginScanFinished(entry.name, pluginPath);
+        }
+        else {
+            pendingPlugins.append(pluginPath);
+        }
+    }
+
+    int processes = qMin(getMaxScanProcesses(), pendingPlugins.size());
+
+    qCDebug(jtStandalonePluginFinder) << "Scanning" << pendingPlugins.size() << "VST files using" << processes << "scanner processes";
+
+    for (int i = 0; i < processes; ++i)
+        startScanProcess();
+
+    if (scanProcesses.isEmpty())
+        finishParallelScan(); // nothing changed since the last scan
 }
 
-void VSTPluginFinder::handleScanningFinished(const QString &scannedLine)
+void VSTPluginFinder::startScanProcess()
 {
-    QStringList parts = scannedLine.split(": ");
-    if (parts.size() < 2) {
-        qCritical() << "Missing parts in scanned line: " << scannedLine;
+    auto process = new ScanProcess();
+    process->setProcessChannelMode(QProcess::ForwardedErrorChannel); // the scanner log and the plugins garbage
+
+    process->timeoutTimer.setSingleShot(true);
+    process->timeoutTimer.setInterval(PLUGIN_SCAN_TIMEOUT);
+    connect(&process->timeoutTimer, &QTimer::timeout, this, [=]() {
+        qCritical() << "VstScanner is not responding while scanning" << process->currentPlugin;
+        process->kill(); // the current plugin is black listed when the process is finished
+    });
+
+    connect(process, &QProcess::readyReadStandardOutput, this, [=]() {
+        consumeOutput(process);
+    });
+
+    connect(process, static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished), this, [=]() {
+        handleProcessFinished(process);
+    });
+
+    connect(process, static_cast<void (QProcess::*)(QProcess::ProcessError)>(&QProcess::error), this, [=](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart) { // finished() is not emitted
+            qCritical() << error << process->errorString();
+            pendingPlugins.clear(); // avoid starting the scanners again and again
+            process->currentPlugin.clear();
+            handleProcessFinished(process);
+        }
+    });
+
+    scanProcesses.append(process);
+
+    process->start(getScannerExecutablePath());
+
+    qCDebug(jtStandalonePluginFinder) << "Scan process started (PID: " << process->processId() << ")";
+
+    sendNextPlugin(process);
+}
+
+void VSTPluginFinder::sendNextPlugin(ScanProcess *process)
+{
+    process->timeoutTimer.stop();
+
+    if (process->state() == QProcess::NotRunning) { // consuming the last messages of a finished scanner
+        process->currentPlugin.clear();
         return;
     }
 
-    QString pluginPath = parts.at(1);
-    QString pluginName = audio::PluginDescriptor::getVstPluginNameFromPath(pluginPath);
-    emit pluginScanFinished(pluginName, pluginPath);
+    if (pendingPlugins.isEmpty()) {
+        process->currentPlugin.clear();
+        process->closeWriteChannel(); // the scanner will exit
+        return;
+    }
+
+    process->currentPlugin = pendingPlugins.takeFirst();
+    process->write(process->currentPlugin.toUtf8() + '\n');
+    process->timeoutTimer.start();
+}
+
+void VSTPluginFinder::consumeOutput(ScanProcess *process)
+{
+    process->receivedData.append(process->readAllStandardOutput());
+
+    ScanMessage message;
+    while (ScanMessage::parse(process->receivedData, message)) {
+        switch (message.getType()) {
+        case ScanMessage::ScanStarted:
+            emit pluginScanStarted(message.getPath());
+            break;
+
+        case ScanMessage::PluginFounded:
+            scanCache.update(QFileInfo(message.getPath()), true, message.getName(), message.getManufacturer());
+            emit pluginScanFinished(message.getName(), message.getPath());
+            sendNextPlugin(process);
+            break;
+
+        case ScanMessage::NotAPlugin:
+            scanCache.update(QFileInfo(message.getPath()), false); // not loaded again in the next scans
+            sendNextPlugin(process);
+            break;
+
+        default:
+            break;
+        }
+    }
+}
+
+void VSTPluginFinder::handleProcessFinished(ScanProcess *process)
+{
+    if (!scanProcesses.removeOne(process))
+        return;
+
+    process->timeoutTimer.stop();
+
+    consumeOutput(process); // the last messages, written before the crash
+
+    if (!process->currentPlugin.isEmpty()) { // the plugin crashed (or closed) the scanner process
+        qCritical() << "VstScanner finished while scanning" << process->currentPlugin;
+        badPlugins.append(process->currentPlugin);
+    }
+
+    process->deleteLater();
+
+    if (!pendingPlugins.isEmpty())
+        startScanProcess(); // replacing the crashed scanner
+    else if (scanProcesses.isEmpty())
+        finishParallelScan();
+}
+
+void VSTPluginFinder::finishParallelScan()
+{
+    scanning = false;
+    scanCache.save();
+
+    qCDebug(jtStandalonePluginFinder) << "VST scan finished," << badPlugins.size() << "bad plugins";
+
+    emit scanFinished(badPlugins.isEmpty());
+
+    QStringList crashedPlugins(badPlugins);
+    badPlugins.clear();
+    for (const QString &pluginPath : crashedPlugins)
+        emit badPluginDetected(pluginPath); // black listed
+}
+
+void VSTPluginFinder::clearScanCache()
+{
+    if (scanning) {
+        qCritical() << "Can't clear the VST scan cache while scanning!";
+        return;
+    }
+
+    scanCache.clear();
+    scanCache.save();
+}
+
+void VSTPluginFinder::cancel()
+{
+    pendingPlugins.clear();
+
+    for (auto process : scanProcesses) {
+        qCDebug(jtStandalonePluginFinder) << "Terminating scan process!";
+        process->timeoutTimer.stop();
+        process->currentPlugin.clear(); // the plugin is not black listed, the process was killed by Jamtaba
+        process->kill();
+    }
 }
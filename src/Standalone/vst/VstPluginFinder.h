@@ -3,9 +3,14 @@
 
 #include "PluginFinder.h"
 #include "audio/core/PluginDescriptor.h"
+#include "vst/PluginScanCache.h"
 
 namespace audio {
 
+/**
+ * Scanning VST plugins using parallel VstScanner processes. Only new or changed plugin files
+ * are sended to the scanners, the unchanged files are restored from the scan cache.
+ */
 class VSTPluginFinder : public PluginFinder
 {
 
@@ -13,18 +18,34 @@ public:
     VSTPluginFinder();
     virtual ~VSTPluginFinder();
 
+    void scan(const QStringList &foldersToScan = QStringList(), const QStringList &skipList = QStringList()) override;
+    void cancel() override;
+
+    void clearScanCache(); // all plugin files will be loaded again in the next scan
+
 protected:
     QString getScannerExecutablePath() const override;
 
-    void handleScanningStart(const QString &scannedLine) override;
-    void handleScanningFinished(const QString &scannedLine) override;
-
 private:
-    QProcess scanProcess;
-    QString lastScannedPlugin; // used to recover the last plugin path when the scanner process crash
+    class ScanProcess; // a VstScanner process, defined in cpp
+
+    QStringList findPluginFiles(const QStringList &foldersToScan, const QStringList &skipList) const;
+
+    void startScanProcess();
+    void sendNextPlugin(ScanProcess *process);
+    void consumeOutput(ScanProcess *process);
+    void handleProcessFinished(ScanProcess *process);
+    void finishParallelScan();
+
+    static int getMaxScanProcesses();
 
-    audio::PluginDescriptor getPluginDescriptor(const QFileInfo &f);
+    static const int PLUGIN_SCAN_TIMEOUT = 30000; // ms, the hung plugins are black listed
 
+    vst::PluginScanCache scanCache;
+    QStringList pendingPlugins; // waiting for a free scanner process
+    QList<ScanProcess *> scanProcesses;
+    QStringList badPlugins; // crashed the scanner process
+    bool scanning;
 };
 
 } // namespace
@@ -0,0 +1,167 @@
+#include "BridgeProcess.h"
+
+#include "vst/VstPlugin.h"
+#include "vst/VstHost.h"
+#include "log/Logging.h"
+
+#include <QCoreApplication>
+#include <QDialog>
+#include <QPoint>
+
+#include <iostream>
+#include <string>
+
+void CommandReader::run()
+{
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        QString command = QString::fromStdString(line).trimmed();
+        if (command.isEmpty())
+            continue;
+
+        emit commandReceived(command);
+
+        if (command == "quit")
+            return;
+    }
+
+    emit commandReceived("quit"); // Jamtaba closed the pipe (or crashed)
+}
+
+// ++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+BridgeProcess::BridgeProcess()
+{
+    connect(&commandReader, &CommandReader::commandReceived, this, &BridgeProcess::executeCommand); // queued, the commands are executed in main thread
+
+    connect(vst::VstHost::getInstance(), &vst::VstHost::pluginRequestingWindowResize, this, &BridgeProcess::setPluginWindowSize);
+
+    connect(&guiTimer, &QTimer::timeout, this, &BridgeProcess::updateGui);
+}
+
+BridgeProcess::~BridgeProcess()
+{
+    if (server)
+        server->stop();
+
+    commandReader.wait(); // the reader is finished after the 'quit' command
+}
+
+bool BridgeProcess::initialize(int argc, char *argv[])
+{
+    // arguments: plugin path, shared memory key, sample rate, block size
+    if (argc < 5) {
+        writeToProcessOutput("JT-Bridge-Error: invalid arguments");
+        return false;
+    }
+
+    QString pluginPath = QString::fromLocal8Bit(argv[1]);
+    QString sharedMemoryKey = QString::fromLocal8Bit(argv[2]);
+    int sampleRate = QString(argv[3]).toInt();
+    int blockSize = QString(argv[4]).toInt();
+
+    channel.reset(new vst::BridgeChannel(sharedMemoryKey));
+    if (!channel->attach()) {
+        writeToProcessOutput("JT-Bridge-Error: " + channel->getErrorString());
+        return false;
+    }
+
+    auto host = vst::VstHost::getInstance();
+    host->setSampleRate(sampleRate);
+    host->setBlockSize(blockSize);
+
+    plugin.reset(new vst::VstPlugin(host, pluginPath));
+    if (!plugin->load(pluginPath)) {
+        writeToProcessOutput("JT-Bridge-Error: can't load " + pluginPath);
+        return false;
+    }
+
+    server.reset(new vst::BridgeServer(*channel, *plugin));
+
+    auto descriptor = plugin->getDescriptor();
+    writeToProcessOutput(QString("JT-Bridge-Loaded: %1;%2;%3")
+                         .arg(plugin->isVirtualInstrument() ? 1 : 0)
+                         .arg(descriptor.getName())
+                         .arg(descriptor.getManufacturer()));
+
+    commandReader.start();
+    guiTimer.start(30);
+
+    return true;
+}
+
+void BridgeProcess::executeCommand(const QString &command)
+{
+    QString name = command.section(' ', 0, 0);
+    QString arguments = command.section(' ', 1);
+
+    audio::AudioNodeProcessor *processor = plugin.get(); // resume and suspend are protected in VstPlugin
+
+    if (name == "quit") {
+        server->stop();
+        plugin->closeEditor();
+        QCoreApplication::quit();
+        return;
+    }
+
+    if (name == "start") {
+        plugin->start();
+        server->start(QThread::TimeCriticalPriority);
+    }
+    else if (name == "resume") {
+        processor->resume();
+    }
+    else if (name == "suspend") {
+        processor->suspend();
+    }
+    else if (name == "bypass") {
+        plugin->setBypass(arguments.toInt() != 0);
+    }
+    else if (name == "sampleRate") {
+        vst::VstHost::getInstance()->setSampleRate(arguments.toInt());
+        plugin->setSampleRate(arguments.toInt());
+    }
+    else if (name == "blockSize") {
+        vst::VstHost::getInstance()->setBlockSize(arguments.toInt());
+        plugin->setBlockSize(arguments.toInt());
+    }
+    else if (name == "openEditor") {
+        plugin->openEditor(QPoint(arguments.section(' ', 0, 0).toInt(), arguments.section(' ', 1, 1).toInt()));
+    }
+    else if (name == "closeEditor") {
+        plugin->closeEditor();
+    }
+    else if (name == "getState") {
+        writeToProcessOutput("JT-Bridge-State: " + QString::fromLatin1(plugin->getSerializedData().toBase64()));
+        return;
+    }
+    else if (name == "restoreState") {
+        plugin->restoreFromSerializedData(QByteArray::fromBase64(arguments.toLatin1()));
+    }
+    else {
+        writeToProcessOutput("JT-Bridge-Error: unknown command " + name);
+        return;
+    }
+
+    writeToProcessOutput("JT-Bridge-Ok");
+}
+
+void BridgeProcess::setPluginWindowSize(const QString &pluginName, int newWidth, int newHeight)
+{
+    auto pluginEditorWindow = vst::VstPlugin::getPluginEditorWindow(pluginName);
+    if (pluginEditorWindow)
+        pluginEditorWindow->setFixedSize(newWidth, newHeight);
+}
+
+void BridgeProcess::updateGui()
+{
+    if (plugin)
+        plugin->updateGui();
+}
+
+void BridgeProcess::writeToProcessOutput(const QString &string)
+{
+    // same protocol used in BaseScanner, '\n' works better than std::endl when reading the output from QProcess
+    std::cout << '\n' << string.toStdString() << '\n';
+    std::flush(std::cout);
+}
@@ -0,0 +1,59 @@
+#ifndef BRIDGE_PROCESS_H
+#define BRIDGE_PROCESS_H
+
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+
+#include <memory>
+
+#include "vst/VstBridge.h"
+
+namespace vst {
+class VstPlugin;
+}
+
+/**
+ * Reading the commands sended by Jamtaba (one per line) in the standard input.
+ */
+class CommandReader : public QThread
+{
+    Q_OBJECT
+
+signals:
+    void commandReceived(const QString &command);
+
+protected:
+    void run() override;
+};
+
+/**
+ * The VstBridge process: hosting one VST plugin for a BridgedVstPlugin instance running in Jamtaba.
+ */
+class BridgeProcess : public QObject
+{
+    Q_OBJECT
+
+public:
+    BridgeProcess();
+    ~BridgeProcess();
+
+    bool initialize(int argc, char *argv[]);
+
+private slots:
+    void executeCommand(const QString &command);
+    void setPluginWindowSize(const QString &pluginName, int newWidth, int newHeight);
+    void updateGui();
+
+private:
+    void writeToProcessOutput(const QString &string);
+
+    std::unique_ptr<vst::BridgeChannel> channel;
+    std::unique_ptr<vst::VstPlugin> plugin;
+    std::unique_ptr<vst::BridgeServer> server; // declared after the plugin, stopped before deleting the plugin
+
+    CommandReader commandReader;
+    QTimer guiTimer;
+};
+
+#endif // BRIDGE_PROCESS_H
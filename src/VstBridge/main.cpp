@@ -0,0 +1,15 @@
+#include <QApplication>
+
+#include "BridgeProcess.h"
+
+int main(int argc, char *argv[])
+{
+    QApplication application(argc, argv); // plugin editors are hosted in this process
+    application.setQuitOnLastWindowClosed(false);
+
+    BridgeProcess bridge;
+    if (!bridge.initialize(argc, argv))
+        return 1;
+
+    return application.exec();
+}
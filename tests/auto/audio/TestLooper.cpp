@@ -9,6 +9,89 @@
 
 using namespace audio;
 
+void TestLooper::layerPeaks()
+{
+    QFETCH(uint, cycleLenght);
+    QFETCH(uint, bufferSize);
+    QFETCH(uint, samplesPerPeak);
+
+    LooperLayer layer;
+    layer.prepareForNewCycle(cycleLenght, false);
+
+    // the peaks storage is allocated by the reader (GUI thread) and installed in the next audio block
+    QVERIFY(layer.getSamplesPeaks(samplesPerPeak).empty());
+    layer.publishPeaks();
+
+    qsrand(cycleLenght);
+    SamplesBuffer buffer(2, bufferSize);
+
+    // recording
+    for (uint position = 0; position < cycleLenght; position += bufferSize) {
+        for (uint s = 0; s < bufferSize; ++s) {
+            buffer.set(0, s, (qrand() % 2001 - 1000) / 1000.0f);
+            buffer.set(1, s, (qrand() % 2001 - 1000) / 1000.0f);
+        }
+        layer.append(buffer, qMin(bufferSize, cycleLenght - position), position);
+    }
+
+    // overdubbing a louder part in the middle
+    layer.prepareForNewCycle(cycleLenght, true);
+    for (uint s = 0; s < bufferSize; ++s) {
+        buffer.set(0, s, 0.5f);
+        buffer.set(1, s, -0.5f);
+    }
+    const uint overdubPosition = cycleLenght / 3;
+    layer.overdub(buffer, qMin(bufferSize, cycleLenght - overdubPosition), overdubPosition);
+
+    std::vector<float> peaks = layer.getSamplesPeaks(samplesPerPeak);
+    QCOMPARE(static_cast<uint>(peaks.size()), (layer.getAvailableSamples() + samplesPerPeak - 1) / samplesPerPeak);
+
+    for (uint p = 0; p < peaks.size(); ++p) {
+        const float expected = layer.computeMaxPeak(p * samplesPerPeak, samplesPerPeak);
+        if (samplesPerPeak % 64 == 0 && (samplesPerPeak & (samplesPerPeak - 1)) == 0)
+            QCOMPARE(peaks[p], expected); // aligned with the pyramid blocks
+        else
+            QVERIFY(peaks[p] >= expected); // the peaks in the blocks edges can be shared with the neighbor
+    }
+}
+
+void TestLooper::layerPeaksAfterResize()
+{
+    const uint cycleLenght = 10000;
+    const uint samplesPerPeak = 64;
+
+    LooperLayer layer;
+    layer.prepareForNewCycle(cycleLenght, false);
+
+    SamplesBuffer buffer(2, cycleLenght);
+    for (uint s = 0; s < cycleLenght; ++s) {
+        buffer.set(0, s, (s % 100) / 100.0f);
+        buffer.set(1, s, -(s % 50) / 100.0f);
+    }
+    layer.append(buffer, cycleLenght, 0); // recorded before the new peaks storage is available
+
+    QVERIFY(layer.getSamplesPeaks(samplesPerPeak).empty()); // allocating the storage
+    layer.publishPeaks(); // next audio block, all peaks are computed
+
+    std::vector<float> peaks = layer.getSamplesPeaks(samplesPerPeak);
+    QCOMPARE(static_cast<uint>(peaks.size()), (cycleLenght + samplesPerPeak - 1) / samplesPerPeak);
+    for (uint p = 0; p < peaks.size(); ++p)
+        QCOMPARE(peaks[p], layer.computeMaxPeak(p * samplesPerPeak, samplesPerPeak));
+}
+
+void TestLooper::layerPeaks_data()
+{
+    QTest::addColumn<uint>("cycleLenght");
+    QTest::addColumn<uint>("bufferSize");
+    QTest::addColumn<uint>("samplesPerPeak");
+
+    QTest::newRow("Peaks using level 0") << 10000u << 256u << 64u;
+    QTest::newRow("Peaks using upper levels") << 44100u << 128u << 1024u;
+    QTest::newRow("Not aligned buffers") << 44100u << 100u << 2048u;
+    QTest::newRow("Not aligned peaks") << 44100u << 512u << 1000u;
+    QTest::newRow("Peaks smaller than the pyramid blocks") << 1000u << 64u << 10u;
+}
+
 void TestLooper::monitoringWhenPlayLockedAndHearAllAreChecked() // testing second problem described in #823
 {
     const uint cycleLenght = 2;
@@ -310,6 +393,30 @@ void TestLooper::invalidRecordingStart()
     QVERIFY(looper.isStopped());
 }
 
+void TestLooper::playAndRecordWhileLoading()
+{
+    Looper looper;
+    looper.setLayers(4, true);
+
+    looper.setLoading(true); // the layers are installed by the loader
+    QVERIFY(!looper.canRecord());
+
+    looper.toggleRecording();
+    QVERIFY(looper.isStopped());
+
+    looper.togglePlay();
+    QVERIFY(looper.isStopped());
+
+    looper.play();
+    QVERIFY(looper.isStopped());
+
+    looper.setLoading(false);
+    QVERIFY(looper.canRecord());
+
+    looper.togglePlay();
+    QVERIFY(looper.isPlaying());
+}
+
 void TestLooper::invalidRecordingStart_data()
 {
     QTest::addColumn<Looper::Mode>("looperMode");
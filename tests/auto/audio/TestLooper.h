@@ -4,6 +4,7 @@
 #include <QObject>
 #include "audio/core/SamplesBuffer.h"
 #include "looper/Looper.h"
+#include "looper/LooperLayer.h"
 
 class TestLooper: public QObject
 {
@@ -28,6 +29,8 @@ private slots:
     void invalidRecordingStart();
     void invalidRecordingStart_data();
 
+    void playAndRecordWhileLoading();
+
     void waitingToRecordAndHearingPreRecordedMaterial();
     void waitingToRecordAndHearingPreRecordedMaterial_data();
 
@@ -46,6 +49,11 @@ private slots:
     void hearLockedLayersOnlyAfterRecord(); // first problem in issue #823
     void monitoringWhenPlayLockedAndHearAllAreChecked(); // second problem in issue #823
 
+    void layerPeaks();
+    void layerPeaks_data();
+
+    void layerPeaksAfterResize(); // the peaks storage is replaced out of the audio thread
+
 private:
     audio::SamplesBuffer createBuffer(QString comaSeparatedValues);
     void checkExpectedValues(QString comaSeparatedExpectedValues, const audio::SamplesBuffer &buffer);
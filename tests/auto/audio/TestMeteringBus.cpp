@@ -0,0 +1,184 @@
+#include "TestMeteringBus.h"
+
+#include <QTest>
+#include <QThread>
+#include <atomic>
+#include "audio/core/MeteringBus.h"
+
+using audio::MeteringBus;
+using audio::AudioPeak;
+
+namespace {
+
+AudioPeak createPeak(float value)
+{
+    return AudioPeak(value, value, value, value); // all values are equal in a not torn peak
+}
+
+bool isTorn(const AudioPeak &peak)
+{
+    float value = peak.getLeftPeak();
+    return peak.getRightPeak() != value || peak.getLeftRMS() != value || peak.getRightRMS() != value;
+}
+
+const int MAX_VALUE = 1 << 23; // the published values are exact in float
+
+class WriterThread : public QThread
+{
+public:
+    WriterThread(MeteringBus &bus, int slot) :
+        bus(bus),
+        slot(slot),
+        stopRequested(false)
+    {
+    }
+
+    void stop()
+    {
+        stopRequested = true;
+        wait();
+    }
+
+protected:
+    void run() override
+    {
+        int value = 1;
+        while (!stopRequested && value < MAX_VALUE)
+            bus.publish(slot, createPeak(value++));
+    }
+
+private:
+    MeteringBus &bus;
+    int slot;
+    std::atomic<bool> stopRequested;
+};
+
+} // namespace
+
+void TestMeteringBus::slotsAllocation()
+{
+    MeteringBus bus(3);
+
+    QCOMPARE(bus.allocateSlot(), 0);
+    QCOMPARE(bus.allocateSlot(), 1);
+    QCOMPARE(bus.allocateSlot(), 2);
+    QCOMPARE(bus.allocateSlot(), -1); // all slots are in use
+
+    bus.publish(1, createPeak(0.5f));
+    QCOMPARE(bus.read(1).getMaxPeak(), 0.5f);
+
+    bus.releaseSlot(1);
+    QCOMPARE(bus.allocateSlot(), 1);
+    QCOMPARE(bus.read(1).getMaxPeak(), 0.0f); // the peaks from the previous owner are not visible
+
+    // invalid slots are ignored
+    bus.publish(-1, createPeak(1));
+    bus.publish(3, createPeak(1));
+    QCOMPARE(bus.read(-1).getMaxPeak(), 0.0f);
+}
+
+void TestMeteringBus::resetHidesTheLastPeak()
+{
+    MeteringBus bus(1);
+    int slot = bus.allocateSlot();
+
+    bus.publish(slot, createPeak(0.8f));
+    bus.reset(slot);
+    QCOMPARE(bus.read(slot).getMaxPeak(), 0.0f);
+
+    quint64 nextBlock = 0;
+    AudioPeak peaks[MeteringBus::HISTORY_SIZE];
+    QCOMPARE(bus.readHistory(slot, nextBlock, peaks, MeteringBus::HISTORY_SIZE), 0);
+
+    bus.publish(slot, createPeak(0.3f));
+    QCOMPARE(bus.read(slot).getMaxPeak(), 0.3f);
+}
+
+void TestMeteringBus::historyKeepsTheLastBlocks_data()
+{
+    QTest::addColumn<int>("publishedBlocks");
+    QTest::addColumn<int>("maxPeaks");
+    QTest::addColumn<int>("expectedBlocks");
+
+    const int historySize = MeteringBus::HISTORY_SIZE;
+
+    QTest::newRow("No blocks") << 0 << historySize << 0;
+    QTest::newRow("One block") << 1 << historySize << 1;
+    QTest::newRow("Full history") << historySize << historySize << historySize;
+    QTest::newRow("History overflow") << historySize * 3 + 5 << historySize << historySize;
+    QTest::newRow("Reading only the newest blocks") << 10 << 4 << 4;
+}
+
+void TestMeteringBus::historyKeepsTheLastBlocks()
+{
+    QFETCH(int, publishedBlocks);
+    QFETCH(int, maxPeaks);
+    QFETCH(int, expectedBlocks);
+
+    MeteringBus bus(1);
+    int slot = bus.allocateSlot();
+
+    for (int i = 1; i <= publishedBlocks; ++i)
+        bus.publish(slot, createPeak(i));
+
+    quint64 nextBlock = 0;
+    AudioPeak peaks[MeteringBus::HISTORY_SIZE];
+    QCOMPARE(bus.readHistory(slot, nextBlock, peaks, maxPeaks), expectedBlocks);
+    QCOMPARE(nextBlock, static_cast<quint64>(publishedBlocks));
+
+    // the newest blocks, in the publishing order
+    for (int i = 0; i < expectedBlocks; ++i)
+        QCOMPARE(peaks[i].getLeftPeak(), static_cast<float>(publishedBlocks - expectedBlocks + i + 1));
+
+    QCOMPARE(bus.readHistory(slot, nextBlock, peaks, maxPeaks), 0); // nothing new
+}
+
+void TestMeteringBus::maxPeakSinceLastRead()
+{
+    MeteringBus bus(1);
+    int slot = bus.allocateSlot();
+    quint64 nextBlock = 0;
+
+    bus.publish(slot, createPeak(0.2f));
+    bus.publish(slot, createPeak(0.9f)); // a short transient between two GUI frames
+    bus.publish(slot, createPeak(0.1f));
+
+    QCOMPARE(bus.readMaxPeak(slot, nextBlock).getMaxPeak(), 0.9f);
+    QCOMPARE(bus.readMaxPeak(slot, nextBlock).getMaxPeak(), 0.1f); // no new blocks, the last peak is returned
+}
+
+void TestMeteringBus::concurrentReadsAreNotTorn()
+{
+    MeteringBus bus(2);
+    int slot = bus.allocateSlot();
+
+    WriterThread writer(bus, slot);
+    writer.start();
+
+    quint64 nextBlock = 0;
+    AudioPeak peaks[MeteringBus::HISTORY_SIZE];
+    float lastValue = 0;
+    for (int i = 0; i < 200000; ++i) {
+        AudioPeak peak = bus.read(slot);
+        if (isTorn(peak)) {
+            writer.stop();
+            QFAIL("torn peak in read()");
+        }
+
+        int blocks = bus.readHistory(slot, nextBlock, peaks, MeteringBus::HISTORY_SIZE);
+        for (int b = 0; b < blocks; ++b) {
+            // the blocks are sequential, and never older than the blocks in the previous read
+            bool sequential = b == 0 ? peaks[b].getLeftPeak() > lastValue : peaks[b].getLeftPeak() == peaks[b - 1].getLeftPeak() + 1;
+            if (isTorn(peaks[b]) || !sequential) {
+                writer.stop();
+                QFAIL("torn or out of order blocks in readHistory()");
+            }
+        }
+        if (blocks > 0)
+            lastValue = peaks[blocks - 1].getLeftPeak();
+    }
+
+    writer.stop();
+
+    QVERIFY(lastValue > 0); // some blocks were read
+}
@@ -0,0 +1,24 @@
+#ifndef TESTMETERINGBUS_H
+#define TESTMETERINGBUS_H
+
+#include <QObject>
+
+class TestMeteringBus: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void slotsAllocation();
+    void resetHidesTheLastPeak();
+
+    // only the newest HISTORY_SIZE blocks are available
+    void historyKeepsTheLastBlocks();
+    void historyKeepsTheLastBlocks_data();
+
+    void maxPeakSinceLastRead();
+
+    // the audio thread is publishing while the GUI is reading, the peaks can't be torn
+    void concurrentReadsAreNotTorn();
+};
+
+#endif // TESTMETERINGBUS_H
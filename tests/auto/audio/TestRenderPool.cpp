@@ -0,0 +1,62 @@
+#include "TestRenderPool.h"
+
+#include <QTest>
+#include <QThread>
+#include <vector>
+#include "audio/core/RenderPool.h"
+
+using audio::RenderPool;
+
+namespace {
+
+class CountingTask : public RenderPool::Task
+{
+public:
+    explicit CountingTask(int tasks) :
+        executions(tasks, 0)
+    {
+    }
+
+    void process(int index) override
+    {
+        executions[index]++; // each index is processed by only one thread in each run()
+    }
+
+    std::vector<int> executions;
+};
+
+} // namespace
+
+void TestRenderPool::allTasksAreExecutedOnce_data()
+{
+    QTest::addColumn<int>("workers");
+    QTest::addColumn<int>("tasks");
+
+    QTest::newRow("No workers, running in the caller thread") << 0 << 8;
+    QTest::newRow("1 worker, 1 task") << 1 << 1;
+    QTest::newRow("1 worker, 2 tasks") << 1 << 2;
+    QTest::newRow("3 workers, 17 tasks") << 3 << 17;
+    QTest::newRow("3 workers, 64 tasks") << 3 << 64;
+}
+
+void TestRenderPool::allTasksAreExecutedOnce()
+{
+    QFETCH(int, workers);
+    QFETCH(int, tasks);
+
+    RenderPool pool(workers);
+    QCOMPARE(pool.getWorkers(), workers);
+
+    CountingTask task(tasks);
+
+    const int runs = 500;
+    for (int run = 0; run < runs; ++run) {
+        pool.run(task, tasks);
+
+        if (run % 100 == 0)
+            QThread::msleep(5); // give time to workers park
+    }
+
+    for (int i = 0; i < tasks; ++i)
+        QCOMPARE(task.executions[i], runs);
+}
@@ -0,0 +1,16 @@
+#ifndef TESTRENDERPOOL_H
+#define TESTRENDERPOOL_H
+
+#include <QObject>
+
+class TestRenderPool: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    // every task index must be executed exactly one time in each run(), even with late (parked) workers
+    void allTasksAreExecutedOnce();
+    void allTasksAreExecutedOnce_data();
+};
+
+#endif // TESTRENDERPOOL_H
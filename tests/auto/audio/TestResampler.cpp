@@ -0,0 +1,101 @@
+#include "TestResampler.h"
+
+#include <QTest>
+#include <cmath>
+#include <vector>
+#include "audio/Resampler.h"
+
+namespace {
+
+const double PI = 3.14159265358979323846;
+
+std::vector<float> createSine(double frequency, double sampleRate, int frames)
+{
+    std::vector<float> samples(frames);
+    for (int i = 0; i < frames; ++i)
+        samples[i] = std::sin(2 * PI * frequency * i / sampleRate);
+
+    return samples;
+}
+
+} // namespace
+
+void TestResampler::streamingIsContinuousAcrossBlocks()
+{
+    QFETCH(int, quality);
+    QFETCH(int, sourceSampleRate);
+    QFETCH(int, targetSampleRate);
+
+    const double frequency = 1000;
+    const int blockSize = 512;
+    const double ratio = static_cast<double>(sourceSampleRate) / targetSampleRate;
+
+    PolyphaseResampler resampler(static_cast<PolyphaseResampler::Quality>(quality));
+    auto input = createSine(frequency, sourceSampleRate, sourceSampleRate * 2);
+
+    std::vector<float> output;
+    std::vector<float> block(blockSize);
+    int position = 0;
+    double correction = 0;
+    while (position + blockSize * 3 < static_cast<int>(input.size())) {
+        // same rounding correction used by the audio nodes, the input lenght is jittering
+        double exactLenght = blockSize * ratio;
+        int inputLenght = static_cast<int>(exactLenght);
+        correction += exactLenght - inputLenght;
+        if (correction > 1) {
+            inputLenght++;
+            correction--;
+        }
+
+        resampler.process(&input[position], inputLenght, block.data(), blockSize, ratio);
+        output.insert(output.end(), block.begin(), block.end());
+        position += inputLenght;
+    }
+
+    const double latency = resampler.getLatency();
+    double maxError = 0;
+    for (size_t i = blockSize * 4; i < output.size(); ++i) {
+        double expected = std::sin(2 * PI * frequency * (i * ratio - latency) / sourceSampleRate);
+        maxError = std::max(maxError, std::abs(expected - output[i]));
+    }
+
+    QVERIFY2(maxError < 0.001, qPrintable(QString("max error: %1").arg(maxError)));
+}
+
+void TestResampler::streamingIsContinuousAcrossBlocks_data()
+{
+    QTest::addColumn<int>("quality");
+    QTest::addColumn<int>("sourceSampleRate");
+    QTest::addColumn<int>("targetSampleRate");
+
+    QTest::newRow("44100 to 48000, low quality") << static_cast<int>(PolyphaseResampler::LowQuality) << 44100 << 48000;
+    QTest::newRow("44100 to 48000, medium quality") << static_cast<int>(PolyphaseResampler::MediumQuality) << 44100 << 48000;
+    QTest::newRow("44100 to 48000, high quality") << static_cast<int>(PolyphaseResampler::HighQuality) << 44100 << 48000;
+    QTest::newRow("48000 to 44100") << static_cast<int>(PolyphaseResampler::MediumQuality) << 48000 << 44100;
+    QTest::newRow("44100 to 96000") << static_cast<int>(PolyphaseResampler::MediumQuality) << 44100 << 96000;
+}
+
+void TestResampler::oneShotResamplingPreservesDcLevel()
+{
+    std::vector<float> input(4410, 0.5f);
+    std::vector<float> output(4800);
+
+    PolyphaseResampler::resample(input.data(), input.size(), output.data(), output.size());
+
+    for (size_t i = 32; i < output.size() - 32; ++i) // ignoring the zero padded edges
+        QVERIFY(std::abs(output[i] - 0.5f) < 0.0001f);
+}
+
+void TestResampler::downSamplingIsBandLimited()
+{
+    auto input = createSine(20000, 48000, 48000); // above 22050/2
+    std::vector<float> output(22050);
+
+    PolyphaseResampler::resample(input.data(), input.size(), output.data(), output.size());
+
+    float peak = 0;
+    for (size_t i = 32; i < output.size() - 32; ++i)
+        peak = std::max(peak, std::abs(output[i]));
+
+    QVERIFY(peak < 0.001f);
+}
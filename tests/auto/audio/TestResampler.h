@@ -0,0 +1,21 @@
+#ifndef TESTRESAMPLER_H
+#define TESTRESAMPLER_H
+
+#include <QObject>
+
+class TestResampler: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    // a sine resampled in blocks with jittering lenghts must be continuous in the block edges
+    void streamingIsContinuousAcrossBlocks();
+    void streamingIsContinuousAcrossBlocks_data();
+
+    void oneShotResamplingPreservesDcLevel();
+
+    // a tone above the new nyquist frequency must be removed when down sampling
+    void downSamplingIsBandLimited();
+};
+
+#endif // TESTRESAMPLER_H
@@ -2,7 +2,10 @@
 
 #include <QString>
 #include "audio/core/SamplesBuffer.h"
+#include "audio/core/SimdKernels.h"
+#include "audio/core/SamplesRingBuffer.h"
 #include <QTest>
+#include <vector>
 
 using namespace audio;
 
@@ -28,6 +31,221 @@ void TestSamplesBuffer::copy_data()
 
 }
 
+void TestSamplesBuffer::applyGainWithPan()
+{
+    QFETCH(QString, samples);
+    QFETCH(float, leftGain);
+    QFETCH(float, rightGain);
+    QFETCH(QString, expectedLeftSamples);
+    QFETCH(QString, expectedRightSamples);
+
+    SamplesBuffer left = createBuffer(samples);
+    SamplesBuffer stereo(2, left.getFrameLenght());
+    stereo.set(left);
+
+    stereo.applyGain(1.0f, leftGain, rightGain, 1.0f);
+
+    SamplesBuffer right(1, stereo.getFrameLenght());
+    right.set(stereo, 1, 1);
+    left.set(stereo, 0, 1);
+
+    checkExpectedValues(expectedLeftSamples, left);
+    checkExpectedValues(expectedRightSamples, right);
+}
+
+void TestSamplesBuffer::applyGainWithPan_data()
+{
+    QTest::addColumn<QString>("samples");
+    QTest::addColumn<float>("leftGain");
+    QTest::addColumn<float>("rightGain");
+    QTest::addColumn<QString>("expectedLeftSamples");
+    QTest::addColumn<QString>("expectedRightSamples");
+
+    QTest::newRow("Center") << "1,2,3" << 1.0f << 1.0f << "1,2,3" << "1,2,3";
+    QTest::newRow("Hard left") << "1,2,3" << 1.0f << 0.0f << "1,2,3" << "0,0,0";
+    QTest::newRow("Hard right, 9 samples") << "1,2,3,4,5,6,7,8,9" << 0.0f << 0.5f << "0,0,0,0,0,0,0,0,0" << "0.5,1,1.5,2,2.5,3,3.5,4,4.5";
+}
+
+void TestSamplesBuffer::computePeak()
+{
+    QFETCH(QString, samples);
+    QFETCH(float, expectedPeak);
+
+    SamplesBuffer buffer = createBuffer(samples);
+    QCOMPARE(buffer.computePeak().getMaxPeak(), expectedPeak);
+}
+
+void TestSamplesBuffer::computePeak_data()
+{
+    QTest::addColumn<QString>("samples");
+    QTest::addColumn<float>("expectedPeak");
+
+    QTest::newRow("Positive peak") << "0.1,0.5,0.2" << 0.5f;
+    QTest::newRow("Negative peak") << "0.1,-0.7,0.2" << 0.7f;
+    QTest::newRow("Peak in the tail after 8 samples") << "0,0,0,0,0,0,0,0,0.1,-0.9" << 0.9f;
+    QTest::newRow("Silence") << "0,0,0" << 0.0f;
+}
+
+void TestSamplesBuffer::stereoToMonoDownMix()
+{
+    const uint frames = 13; // not multiple of the SIMD width to exercise the tail
+    SamplesBuffer stereo(2, frames);
+    for (uint i = 0; i < frames; ++i) {
+        stereo.set(0, i, i);
+        stereo.set(1, i, -0.5f * i);
+    }
+
+    SamplesBuffer mono(1, frames);
+    mono.set(stereo);
+
+    for (uint i = 0; i < frames; ++i)
+        QCOMPARE(mono.get(0, i), (i - 0.5f * i) / 2.0f);
+}
+
+void TestSamplesBuffer::simdKernelsMatchScalarKernels()
+{
+    QFETCH(int, frames);
+
+    const simd::Kernels &scalar = simd::scalarKernels();
+    const simd::Kernels &vectorized = simd::kernels();
+
+    std::vector<float> source(frames);
+    std::vector<float> samples(frames);
+    for (int i = 0; i < frames; ++i) {
+        source[i] = (i % 17) / 8.0f - 1.0f;
+        samples[i] = ((i * 7) % 13) / 6.0f - 1.0f;
+    }
+
+    std::vector<float> scalarLeft(samples), scalarRight(samples);
+    std::vector<float> simdLeft(samples), simdRight(samples);
+
+    scalar.scaleStereo(scalarLeft.data(), scalarRight.data(), frames, 0.25f, 0.75f);
+    vectorized.scaleStereo(simdLeft.data(), simdRight.data(), frames, 0.25f, 0.75f);
+
+    scalar.mixAddMonoToStereo(scalarLeft.data(), scalarRight.data(), source.data(), frames);
+    vectorized.mixAddMonoToStereo(simdLeft.data(), simdRight.data(), source.data(), frames);
+
+    scalar.downMixToMono(scalarRight.data(), scalarLeft.data(), source.data(), frames);
+    vectorized.downMixToMono(simdRight.data(), simdLeft.data(), source.data(), frames);
+
+    for (int i = 0; i < frames; ++i) {
+        QCOMPARE(simdLeft[i], scalarLeft[i]);
+        QCOMPARE(simdRight[i], scalarRight[i]);
+    }
+
+    scalar.ramp(scalarLeft.data(), frames, 0.0f, 1.0f / frames);
+    vectorized.ramp(simdLeft.data(), frames, 0.0f, 1.0f / frames);
+    for (int i = 0; i < frames; ++i)
+        QVERIFY(qAbs(simdLeft[i] - scalarLeft[i]) < 0.0001f);
+
+    float scalarSquaredSum = 0;
+    float simdSquaredSum = 0;
+    QCOMPARE(vectorized.peakAndSquaredSum(source.data(), frames, &simdSquaredSum),
+             scalar.peakAndSquaredSum(source.data(), frames, &scalarSquaredSum));
+    QVERIFY(qAbs(simdSquaredSum - scalarSquaredSum) <= scalarSquaredSum * 0.0001f);
+
+    const float scalarDotProduct = scalar.dotProduct(source.data(), samples.data(), frames);
+    QVERIFY(qAbs(vectorized.dotProduct(source.data(), samples.data(), frames) - scalarDotProduct) <= 0.0001f * frames);
+
+    // file samples conversion
+    std::vector<std::int16_t> samples16(frames * 2);
+    std::vector<std::int32_t> samples32(frames * 2);
+    for (int i = 0; i < frames * 2; ++i) {
+        samples16[i] = static_cast<std::int16_t>((i * 4099) % 65536 - 32768);
+        samples32[i] = static_cast<std::int32_t>(samples16[i]) * 65536 + i;
+    }
+
+    std::vector<float> scalarConverted(frames * 2), simdConverted(frames * 2);
+    scalar.int16ToFloat(scalarConverted.data(), samples16.data(), frames * 2, 1.0f / 32768.0f);
+    vectorized.int16ToFloat(simdConverted.data(), samples16.data(), frames * 2, 1.0f / 32768.0f);
+    QVERIFY(scalarConverted == simdConverted);
+
+    scalar.int32ToFloat(scalarConverted.data(), samples32.data(), frames * 2, 1.0f / 2147483648.0f);
+    vectorized.int32ToFloat(simdConverted.data(), samples32.data(), frames * 2, 1.0f / 2147483648.0f);
+    QVERIFY(scalarConverted == simdConverted);
+
+    scalar.deinterleaveStereo(scalarLeft.data(), scalarRight.data(), scalarConverted.data(), frames);
+    vectorized.deinterleaveStereo(simdLeft.data(), simdRight.data(), scalarConverted.data(), frames);
+    for (int i = 0; i < frames; ++i) {
+        QCOMPARE(simdLeft[i], scalarConverted[i * 2]);
+        QCOMPARE(simdRight[i], scalarConverted[i * 2 + 1]);
+        QCOMPARE(scalarLeft[i], scalarConverted[i * 2]);
+    }
+}
+
+void TestSamplesBuffer::simdKernelsMatchScalarKernels_data()
+{
+    QTest::addColumn<int>("frames");
+
+    QTest::newRow("1 frame") << 1;
+    QTest::newRow("7 frames") << 7;
+    QTest::newRow("32 frames") << 32;
+    QTest::newRow("67 frames") << 67;
+    QTest::newRow("4096 frames") << 4096;
+}
+
+void TestSamplesBuffer::ringBufferWriteAndRead()
+{
+    QFETCH(int, capacity);
+    QFETCH(QString, firstWrite);
+    QFETCH(int, framesToRead);
+    QFETCH(QString, secondWrite);
+    QFETCH(QString, expectedSamples); // all samples readed after the second write
+
+    SamplesRingBuffer ringBuffer(1, capacity);
+
+    auto first = createBuffer(firstWrite);
+    QCOMPARE(ringBuffer.write(first), first.getFrameLenght());
+
+    SamplesBuffer discarded(1, framesToRead);
+    QCOMPARE(ringBuffer.read(discarded, 0, framesToRead), (uint)framesToRead);
+
+    auto second = createBuffer(secondWrite);
+    QCOMPARE(ringBuffer.write(second), second.getFrameLenght()); // wrapping around
+
+    auto expected = createBuffer(expectedSamples);
+    QCOMPARE(ringBuffer.getAvailableFrames(), expected.getFrameLenght());
+
+    SamplesBuffer out(1, expected.getFrameLenght());
+    QCOMPARE(ringBuffer.read(out, 0, out.getFrameLenght()), expected.getFrameLenght());
+    QVERIFY(ringBuffer.isEmpty());
+
+    checkExpectedValues(expectedSamples, out);
+}
+
+void TestSamplesBuffer::ringBufferWriteAndRead_data()
+{
+    QTest::addColumn<int>("capacity");
+    QTest::addColumn<QString>("firstWrite");
+    QTest::addColumn<int>("framesToRead");
+    QTest::addColumn<QString>("secondWrite");
+    QTest::addColumn<QString>("expectedSamples");
+
+    QTest::newRow("No wrap") << 8 << "1,2,3" << 1 << "4,5" << "2,3,4,5";
+    QTest::newRow("Wrap around") << 4 << "1,2,3" << 2 << "4,5,6" << "3,4,5,6";
+    QTest::newRow("Full") << 4 << "1,2,3,4" << 4 << "5,6,7,8" << "5,6,7,8";
+}
+
+void TestSamplesBuffer::ringBufferIsNotOverflowing()
+{
+    SamplesRingBuffer ringBuffer(2, 4);
+
+    SamplesBuffer samples(1, 6);
+    for (uint i = 0; i < samples.getFrameLenght(); ++i)
+        samples.set(0, i, i + 1);
+
+    QCOMPARE(ringBuffer.write(samples), 4u); // only 4 frames fit
+    QVERIFY(ringBuffer.isFull());
+    QCOMPARE(ringBuffer.write(samples), 0u);
+
+    SamplesBuffer out(2, 8);
+    QCOMPARE(ringBuffer.read(out, 2, 8), 4u); // reading in offset 2, mono samples copied to both channels
+    for (uint i = 0; i < 4; ++i) {
+        QCOMPARE(out.get(0, i + 2), (float)(i + 1));
+        QCOMPARE(out.get(1, i + 2), (float)(i + 1));
+    }
+}
+
 SamplesBuffer TestSamplesBuffer::createBuffer(QString comaSeparatedValues)
 {
     QStringList values;
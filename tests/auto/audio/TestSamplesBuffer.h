@@ -3,6 +3,7 @@
 
 #include <QObject>
 #include "audio/core/SamplesBuffer.h"
+#include "audio/core/SamplesRingBuffer.h"
 
 class TestSamplesBuffer: public QObject
 {
@@ -34,6 +35,24 @@ private slots:
     void copy();
     void copy_data();
 
+    void applyGainWithPan();
+    void applyGainWithPan_data();
+
+    void computePeak();
+    void computePeak_data();
+
+    void stereoToMonoDownMix();
+
+    // SIMD kernels must produce the same results as the plain C++ kernels
+    void simdKernelsMatchScalarKernels();
+    void simdKernelsMatchScalarKernels_data();
+
+    // ring buffer used to store decoded samples
+    void ringBufferWriteAndRead();
+    void ringBufferWriteAndRead_data();
+
+    void ringBufferIsNotOverflowing();
+
 private:
     audio::SamplesBuffer createBuffer(QString comaSeparatedValues);
     void checkExpectedValues(QString comaSeparatedExpectedValues, const audio::SamplesBuffer &buffer);
@@ -11,16 +11,33 @@ VPATH += ../../../src/Common
 
 HEADERS += TestSamplesBuffer.h
 HEADERS += TestLooper.h
+HEADERS += TestResampler.h
+HEADERS += TestRenderPool.h
+HEADERS += TestMeteringBus.h
 HEADERS += audio/core/SamplesBuffer.h
+HEADERS += audio/core/SimdKernels.h
+HEADERS += audio/core/SamplesRingBuffer.h
+HEADERS += audio/core/RenderPool.h
 HEADERS += audio/core/AudioPeak.h
+HEADERS += audio/core/MeteringBus.h
+HEADERS += audio/Resampler.h
 HEADERS += looper/Looper.h
 
 SOURCES += TestSamplesBuffer.cpp
 SOURCES += TestLooper.cpp
+SOURCES += TestResampler.cpp
+SOURCES += TestRenderPool.cpp
+SOURCES += TestMeteringBus.cpp
 SOURCES += audio/core/SamplesBuffer.cpp
+SOURCES += audio/core/SimdKernels.cpp
+SOURCES += audio/core/SamplesRingBuffer.cpp
+SOURCES += audio/core/RenderPool.cpp
 SOURCES += audio/core/AudioPeak.cpp
+SOURCES += audio/core/MeteringBus.cpp
+SOURCES += audio/Resampler.cpp
 SOURCES += looper/Looper.cpp
 SOURCES += looper/LooperStates.cpp
 SOURCES += looper/LooperLayer.cpp
+SOURCES += log/logging.cpp
 
 SOURCES += test_Audio.cpp
@@ -3,15 +3,27 @@
 #include <QtTest>
 #include "TestSamplesBuffer.h"
 #include "TestLooper.h"
+#include "TestResampler.h"
+#include "TestRenderPool.h"
+#include "TestMeteringBus.h"
 
 int main(int argc, char *argv[])
 {
     TestSamplesBuffer testSamplesBuffer;
     TestLooper testLooper;
+    TestResampler testResampler;
+    TestRenderPool testRenderPool;
+    TestMeteringBus testMeteringBus;
 
     int result = QTest::qExec(&testSamplesBuffer, argc, argv);
 
     result |= QTest::qExec(&testLooper, argc, argv);
 
+    result |= QTest::qExec(&testResampler, argc, argv);
+
+    result |= QTest::qExec(&testRenderPool, argc, argv);
+
+    result |= QTest::qExec(&testMeteringBus, argc, argv);
+
     return result;
 }
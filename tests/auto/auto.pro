@@ -9,3 +9,7 @@ SUBDIRS += geo
 SUBDIRS += midi
 SUBDIRS += ninjam
 SUBDIRS += persistence
+SUBDIRS += vst
+
+linux:SUBDIRS += benchmark # needs the static vorbis libs
+linux:SUBDIRS += render # needs the static libs used by Standalone
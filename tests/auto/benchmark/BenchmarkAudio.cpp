@@ -0,0 +1,231 @@
+#include "BenchmarkAudio.h"
+
+#include "audio/core/SamplesBuffer.h"
+#include "audio/core/AudioPeak.h"
+#include "audio/core/Filters.h"
+#include "audio/Resampler.h"
+#include "audio/vorbis/VorbisEncoder.h"
+#include "audio/vorbis/VorbisDecoder.h"
+#include "audio/vorbis/Vorbis.h"
+
+#include <QTest>
+#include <QtMath>
+#include <cmath>
+#include <vector>
+
+using audio::SamplesBuffer;
+
+namespace {
+
+const int SAMPLE_RATES[] = { 44100, 48000, 96000 };
+
+void fillWithSine(SamplesBuffer &buffer, int sampleRate, quint64 firstFrame = 0)
+{
+    const double phaseIncrement = 2 * M_PI * 440.0 / sampleRate;
+    for (int c = 0; c < buffer.getChannels(); ++c) {
+        float *samples = buffer.getSamplesArray(c);
+        for (uint s = 0; s < buffer.getFrameLenght(); ++s)
+            samples[s] = 0.5f * static_cast<float>(std::sin(phaseIncrement * (firstFrame + s)));
+    }
+}
+
+} // namespace
+
+void BenchmarkAudio::createBlockRows(bool usingSampleRates)
+{
+    QTest::addColumn<int>("frames");
+    QTest::addColumn<int>("channels");
+    QTest::addColumn<int>("sampleRate");
+
+    for (int frames = 32; frames <= 4096; frames *= 2) {
+        for (int channels = 1; channels <= 2; ++channels) {
+            if (!usingSampleRates) {
+                QTest::newRow(qPrintable(QString("%1 frames, %2 channels").arg(frames).arg(channels))) << frames << channels << 44100;
+                continue;
+            }
+
+            for (int sampleRate : SAMPLE_RATES)
+                QTest::newRow(qPrintable(QString("%1 frames, %2 channels, %3 Hz").arg(frames).arg(channels).arg(sampleRate))) << frames << channels << sampleRate;
+        }
+    }
+}
+
+void BenchmarkAudio::computePeak_data()
+{
+    createBlockRows(false);
+}
+
+void BenchmarkAudio::computePeak()
+{
+    QFETCH(int, frames);
+    QFETCH(int, channels);
+    QFETCH(int, sampleRate);
+
+    SamplesBuffer buffer(channels, frames);
+    fillWithSine(buffer, sampleRate);
+
+    float peak = 0;
+    QBENCHMARK {
+        peak += buffer.computePeak().getMaxPeak();
+    }
+
+    QVERIFY(peak > 0);
+}
+
+void BenchmarkAudio::applyGain_data()
+{
+    createBlockRows(false);
+}
+
+void BenchmarkAudio::applyGain()
+{
+    QFETCH(int, frames);
+    QFETCH(int, channels);
+    QFETCH(int, sampleRate);
+
+    SamplesBuffer buffer(channels, frames);
+    fillWithSine(buffer, sampleRate);
+
+    // unity gains, the same kernel cost without decaying the buffer into denormals along the iterations
+    QBENCHMARK {
+        buffer.applyGain(1.0f, 1.0f, 1.0f, 1.0f); // the overload used by the mixer (gain and pan)
+    }
+}
+
+void BenchmarkAudio::add_data()
+{
+    createBlockRows(false);
+}
+
+void BenchmarkAudio::add()
+{
+    QFETCH(int, frames);
+    QFETCH(int, channels);
+    QFETCH(int, sampleRate);
+
+    SamplesBuffer buffer(channels, frames);
+    fillWithSine(buffer, sampleRate);
+
+    SamplesBuffer mix(2, frames);
+    mix.zero();
+
+    QBENCHMARK {
+        mix.add(buffer);
+    }
+}
+
+void BenchmarkAudio::filter_data()
+{
+    createBlockRows(true);
+}
+
+void BenchmarkAudio::filter()
+{
+    QFETCH(int, frames);
+    QFETCH(int, channels);
+    QFETCH(int, sampleRate);
+
+    SamplesBuffer input(channels, frames);
+    fillWithSine(input, sampleRate);
+
+    SamplesBuffer buffer(channels, frames);
+
+    std::vector<audio::Filter> filters(channels, audio::Filter(audio::Filter::HighPass, sampleRate, 220.0)); // one filter per channel, like the low cut
+
+    QBENCHMARK {
+        buffer.set(input); // refilled in each iteration, filtering the filtered block decays it into denormals
+        for (int c = 0; c < channels; ++c)
+            filters[c].process(buffer.getSamplesArray(c), frames);
+    }
+}
+
+void BenchmarkAudio::resample_data()
+{
+    createBlockRows(true);
+}
+
+void BenchmarkAudio::resample()
+{
+    QFETCH(int, frames);
+    QFETCH(int, channels);
+    QFETCH(int, sampleRate);
+
+    // the interval sample rate is different from the audio driver sample rate
+    const int targetSampleRate = sampleRate == 48000 ? 44100 : 48000;
+    const int outFrames = qCeil(static_cast<double>(frames) * targetSampleRate / sampleRate);
+
+    SamplesBuffer in(channels, frames);
+    fillWithSine(in, sampleRate);
+
+    SamplesBuffer out(channels, outFrames);
+
+    std::vector<PolyphaseResampler> resamplers(channels);
+
+    QBENCHMARK {
+        for (int c = 0; c < channels; ++c)
+            resamplers[c].process(in.getSamplesArray(c), frames, out.getSamplesArray(c), outFrames);
+    }
+}
+
+void BenchmarkAudio::vorbisEncode_data()
+{
+    createBlockRows(true);
+}
+
+void BenchmarkAudio::vorbisEncode()
+{
+    QFETCH(int, frames);
+    QFETCH(int, channels);
+    QFETCH(int, sampleRate);
+
+    SamplesBuffer buffer(channels, frames);
+    vorbis::Encoder encoder(channels, sampleRate, vorbis::EncoderQualityNormal);
+
+    quint64 position = 0;
+    qint64 encodedBytes = 0;
+    QBENCHMARK {
+        fillWithSine(buffer, sampleRate, position); // a continuous signal, a repeated block is easier to encode
+        position += frames;
+        encodedBytes += encoder.encode(buffer).size();
+    }
+
+    encodedBytes += encoder.finishIntervalEncoding().size();
+    QVERIFY(encodedBytes > 0);
+}
+
+void BenchmarkAudio::vorbisDecode_data()
+{
+    createBlockRows(true);
+}
+
+void BenchmarkAudio::vorbisDecode()
+{
+    QFETCH(int, frames);
+    QFETCH(int, channels);
+    QFETCH(int, sampleRate);
+
+    // encoding one second, like a short interval
+    SamplesBuffer buffer(channels, sampleRate);
+    fillWithSine(buffer, sampleRate);
+
+    vorbis::Encoder encoder(channels, sampleRate, vorbis::EncoderQualityNormal);
+    QByteArray encodedData = encoder.encode(buffer);
+    encodedData.append(encoder.finishIntervalEncoding());
+
+    qint64 decodedFrames = 0;
+    QBENCHMARK {
+        vorbis::Decoder decoder;
+        decoder.setInputData(encodedData);
+        decoder.initialize();
+
+        while (!decoder.isFinished() && decoder.isValid()) {
+            const SamplesBuffer &decoded = decoder.decode(frames);
+            if (decoded.isEmpty())
+                break;
+
+            decodedFrames += decoded.getFrameLenght();
+        }
+    }
+
+    QVERIFY(decodedFrames > 0);
+}
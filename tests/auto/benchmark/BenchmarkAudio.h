@@ -0,0 +1,44 @@
+#ifndef BENCHMARK_AUDIO_H
+#define BENCHMARK_AUDIO_H
+
+#include <QObject>
+
+/**
+    Performance tests (QBENCHMARK) for the hot audio functions, using the typical block sizes
+    (32 to 4096 frames), mono and stereo and the common sample rates. Use QTest output options to
+    save machine readable results and compare them across commits, i.e. './benchmark -o results.csv,csv'
+    or './benchmark -o results.xml,xml'.
+*/
+
+class BenchmarkAudio : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void computePeak_data();
+    void computePeak();
+
+    void applyGain_data();
+    void applyGain();
+
+    void add_data();
+    void add();
+
+    void filter_data();
+    void filter();
+
+    void resample_data();
+    void resample();
+
+    void vorbisEncode_data();
+    void vorbisEncode();
+
+    // one second of audio decoded in blocks
+    void vorbisDecode_data();
+    void vorbisDecode();
+
+private:
+    static void createBlockRows(bool usingSampleRates);
+};
+
+#endif // BENCHMARK_AUDIO_H
@@ -0,0 +1,48 @@
+# QBENCHMARK performance tests. Save the results with './benchmark -o results.csv,csv' (or xml) to compare commits.
+
+QT += testlib
+QT -= gui
+CONFIG += testcase
+CONFIG += c++11
+CONFIG += release # benchmarking optimized code
+TEMPLATE = app
+TARGET = benchmark
+
+INCLUDEPATH += .
+INCLUDEPATH += ../../../src/Common
+INCLUDEPATH += ../../../libs/includes/ogg
+INCLUDEPATH += ../../../libs/includes/vorbis
+VPATH += ../../../src/Common
+
+DEFINES += OV_EXCLUDE_STATIC_CALLBACKS  #avoid ogg static callback warnings
+
+HEADERS += BenchmarkAudio.h
+HEADERS += audio/core/SamplesBuffer.h
+HEADERS += audio/core/SimdKernels.h
+HEADERS += audio/core/AudioPeak.h
+HEADERS += audio/core/Filters.h
+HEADERS += audio/Resampler.h
+HEADERS += audio/vorbis/VorbisEncoder.h
+HEADERS += audio/vorbis/VorbisDecoder.h
+
+SOURCES += BenchmarkAudio.cpp
+SOURCES += audio/core/SamplesBuffer.cpp
+SOURCES += audio/core/SimdKernels.cpp
+SOURCES += audio/core/AudioPeak.cpp
+SOURCES += audio/core/Filters.cpp
+SOURCES += audio/Resampler.cpp
+SOURCES += audio/vorbis/VorbisEncoder.cpp
+SOURCES += audio/vorbis/VorbisDecoder.cpp
+SOURCES += log/logging.cpp
+
+SOURCES += test_Benchmark.cpp
+
+linux{
+    contains(QMAKE_HOST.arch, x86_64) {
+        LIBS_PATH = "static/linux64"
+    } else {
+        LIBS_PATH = "static/linux32"
+    }
+
+    LIBS += -L$$PWD/../../../libs/$$LIBS_PATH -lvorbisfile -lvorbisenc -lvorbis -logg
+}
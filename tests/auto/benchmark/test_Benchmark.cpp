@@ -0,0 +1,10 @@
+#include <QtTest>
+
+#include "BenchmarkAudio.h"
+
+int main(int argc, char *argv[])
+{
+    BenchmarkAudio benchmarkAudio;
+
+    return QTest::qExec(&benchmarkAudio, argc, argv);
+}
@@ -2,6 +2,7 @@
 QT += testlib
 QT -= gui
 CONFIG += testcase
+CONFIG += c++11
 TEMPLATE = app
 TARGET = testFile
 INCLUDEPATH += .
@@ -9,6 +10,16 @@ INCLUDEPATH += ../../../src/Common
 VPATH += ../../../src/Common
 
 HEADERS += file/FileUtils.h
+HEADERS += file/FileReader.h
+HEADERS += file/WaveFileReader.h
+HEADERS += audio/core/SamplesBuffer.h
+HEADERS += audio/core/SimdKernels.h
+HEADERS += audio/core/AudioPeak.h
 
 SOURCES += file/FileUtils.cpp
+SOURCES += file/FileReader.cpp
+SOURCES += file/WaveFileReader.cpp
+SOURCES += audio/core/SamplesBuffer.cpp
+SOURCES += audio/core/SimdKernels.cpp
+SOURCES += audio/core/AudioPeak.cpp
 SOURCES += test_File.cpp
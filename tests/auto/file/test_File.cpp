@@ -1,7 +1,11 @@
 #include <QObject>
 #include <QString>
 #include <QtTest/QtTest>
+#include <QTemporaryFile>
+#include <QtEndian>
+#include <cstring>
 #include "file/FileUtils.h"
+#include "file/WaveFileReader.h"
 
 class TestFile: public QObject
 {
@@ -10,8 +14,142 @@ class TestFile: public QObject
 private slots:
     void sanitizeFileName();
     void sanitizeFileName_data();
+
+    void readWaveFile();
+    void readWaveFile_data();
+    void readWaveFileInChunks();
+
+private:
+    static QByteArray createWaveFile(quint16 format, quint16 channels, quint16 bitsPerSample, const QByteArray &samples);
+    static QByteArray encodeSamples(const QList<float> &samples, quint16 bitsPerSample, bool floatingPoint);
 };
 
+QByteArray TestFile::encodeSamples(const QList<float> &samples, quint16 bitsPerSample, bool floatingPoint)
+{
+    QByteArray bytes;
+    for (float sample : samples) {
+        uchar buffer[4];
+        if (floatingPoint) {
+            quint32 value;
+            std::memcpy(&value, &sample, sizeof(value));
+            qToLittleEndian<quint32>(value, buffer);
+        }
+        else if (bitsPerSample == 8) {
+            buffer[0] = static_cast<uchar>(sample * 128 + 128);
+        }
+        else {
+            const qint64 maxValue = static_cast<qint64>(1) << (bitsPerSample - 1);
+            const qint32 value = static_cast<qint32>(qBound(-maxValue, static_cast<qint64>(sample * maxValue), maxValue - 1));
+            qToLittleEndian<qint32>(value, buffer); // the low bytes are the sample
+        }
+        bytes.append(reinterpret_cast<const char *>(buffer), bitsPerSample / 8);
+    }
+
+    return bytes;
+}
+
+QByteArray TestFile::createWaveFile(quint16 format, quint16 channels, quint16 bitsPerSample, const QByteArray &samples)
+{
+    QByteArray wave;
+    QDataStream stream(&wave, QIODevice::WriteOnly);
+    stream.setByteOrder(QDataStream::LittleEndian);
+
+    const quint32 sampleRate = 44100;
+    const quint16 blockAlign = channels * bitsPerSample / 8;
+
+    stream.writeRawData("RIFF", 4);
+    stream << static_cast<quint32>(4 + 26 + 8 + 16 + 8 + samples.size());
+    stream.writeRawData("WAVE", 4);
+
+    stream.writeRawData("LIST", 4); // a chunk before 'fmt ', must be skipped
+    stream << static_cast<quint32>(17);
+    stream.writeRawData("unknown chunk 17b\0", 18); // odd size + padding byte
+
+    stream.writeRawData("fmt ", 4);
+    stream << static_cast<quint32>(16) << format << channels << sampleRate << (sampleRate * blockAlign) << blockAlign << bitsPerSample;
+
+    stream.writeRawData("data", 4);
+    stream << static_cast<quint32>(samples.size());
+    stream.writeRawData(samples.constData(), samples.size());
+
+    return wave;
+}
+
+void TestFile::readWaveFile()
+{
+    QFETCH(quint16, format);
+    QFETCH(quint16, channels);
+    QFETCH(quint16, bitsPerSample);
+
+    QList<float> samples; // interleaved
+    for (int i = 0; i < 1001 * channels; ++i)
+        samples << ((i * 37) % 200 - 100) / 128.0f;
+
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    file.write(createWaveFile(format, channels, bitsPerSample, encodeSamples(samples, bitsPerSample, format == 3)));
+    file.close();
+
+    audio::WaveFileReader reader;
+    audio::SamplesBuffer buffer(2);
+    quint32 sampleRate = 0;
+    QVERIFY(reader.read(file.fileName(), buffer, sampleRate));
+
+    QCOMPARE(sampleRate, static_cast<quint32>(44100));
+    QCOMPARE(buffer.getFrameLenght(), 1001u);
+    QCOMPARE(buffer.getChannels(), qMin(static_cast<int>(channels), 2));
+
+    const float tolerance = bitsPerSample == 8 ? 1.0f / 100 : 1.0f / 10000;
+    for (uint f = 0; f < buffer.getFrameLenght(); ++f) {
+        for (int c = 0; c < buffer.getChannels(); ++c)
+            QVERIFY(qAbs(buffer.get(c, f) - samples.at(f * channels + c)) <= tolerance);
+    }
+}
+
+void TestFile::readWaveFile_data()
+{
+    QTest::addColumn<quint16>("format");
+    QTest::addColumn<quint16>("channels");
+    QTest::addColumn<quint16>("bitsPerSample");
+
+    QTest::newRow("8 bits mono") << quint16(1) << quint16(1) << quint16(8);
+    QTest::newRow("16 bits mono") << quint16(1) << quint16(1) << quint16(16);
+    QTest::newRow("16 bits stereo") << quint16(1) << quint16(2) << quint16(16);
+    QTest::newRow("24 bits stereo") << quint16(1) << quint16(2) << quint16(24);
+    QTest::newRow("32 bits stereo") << quint16(1) << quint16(2) << quint16(32);
+    QTest::newRow("32 bits float stereo") << quint16(3) << quint16(2) << quint16(32);
+    QTest::newRow("16 bits 4 channels") << quint16(1) << quint16(4) << quint16(16);
+}
+
+void TestFile::readWaveFileInChunks()
+{
+    QList<float> samples;
+    for (int i = 0; i < 10000 * 2; ++i)
+        samples << (i % 100) / 100.0f;
+
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    file.write(createWaveFile(3, 2, 32, encodeSamples(samples, 32, true)));
+    file.close();
+
+    audio::WaveFileReader reader;
+    QVERIFY(reader.open(file.fileName()));
+    QCOMPARE(reader.getTotalFrames(), static_cast<quint64>(10000));
+
+    audio::SamplesBuffer chunk(2, 3000);
+    uint totalFrames = 0;
+    uint frames = 0;
+    while ((frames = reader.readFrames(chunk, 0, 3000)) > 0) {
+        for (uint f = 0; f < frames; ++f) {
+            QCOMPARE(chunk.get(0, f), samples.at((totalFrames + f) * 2));
+            QCOMPARE(chunk.get(1, f), samples.at((totalFrames + f) * 2 + 1));
+        }
+        totalFrames += frames;
+    }
+
+    QCOMPARE(totalFrames, 10000u);
+}
+
 void TestFile::sanitizeFileName()
 {
     QFETCH(QString, original);
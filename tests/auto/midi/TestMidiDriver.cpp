@@ -0,0 +1,109 @@
+#include "TestMidiDriver.h"
+
+#include <QTest>
+
+#include "midi/MidiDriver.h"
+
+using midi::MidiDriver;
+using midi::MidiMessage;
+
+namespace {
+
+const int SAMPLE_RATE = 44100;
+const uint BLOCK_FRAMES = 441; // 10 ms
+const qint64 BLOCK_START_TIME = 1000000; // us, the previous block started in 990000 us
+
+const qint32 NOTE_ON = 0x7F4090;
+const qint32 NOTE_OFF = 0x004080;
+
+} // namespace
+
+void TestMidiDriver::timestampsAreConvertedInFrameOffsets_data()
+{
+    QTest::addColumn<qint64>("timestamp");
+    QTest::addColumn<quint32>("expectedOffset");
+
+    QTest::newRow("Previous block start") << qint64(990000) << quint32(0);
+    QTest::newRow("Half of previous block") << qint64(995000) << quint32(220);
+    QTest::newRow("Previous block end") << qint64(999999) << quint32(440);
+    QTest::newRow("Older than previous block (clamped)") << qint64(980000) << quint32(0);
+    QTest::newRow("After current block start (clamped)") << qint64(1005000) << quint32(BLOCK_FRAMES - 1);
+}
+
+void TestMidiDriver::timestampsAreConvertedInFrameOffsets()
+{
+    QFETCH(qint64, timestamp);
+    QFETCH(quint32, expectedOffset);
+
+    std::vector<MidiMessage> messages;
+    messages.push_back(MidiMessage(NOTE_ON, 0, timestamp));
+
+    MidiDriver::computeFrameOffsets(messages, BLOCK_START_TIME, BLOCK_FRAMES, SAMPLE_RATE);
+
+    QCOMPARE(messages.front().getFrameOffset(), expectedOffset);
+}
+
+void TestMidiDriver::messagesWithoutTimestampAreInBlockStart()
+{
+    std::vector<MidiMessage> messages;
+    messages.push_back(MidiMessage(NOTE_ON, 0, 995000));
+    messages.push_back(MidiMessage(NOTE_OFF, 1)); // no timestamp
+
+    MidiDriver::computeFrameOffsets(messages, BLOCK_START_TIME, BLOCK_FRAMES, SAMPLE_RATE);
+
+    QCOMPARE(messages.at(0).getSourceDeviceIndex(), 1);
+    QCOMPARE(messages.at(0).getFrameOffset(), quint32(0));
+    QCOMPARE(messages.at(1).getFrameOffset(), quint32(220));
+}
+
+void TestMidiDriver::messagesAreSortedByFrameOffset()
+{
+    // the devices are pulled one by one, so the messages are sorted only by device
+    std::vector<MidiMessage> messages;
+    messages.push_back(MidiMessage(NOTE_ON, 0, 992000)); // 88
+    messages.push_back(MidiMessage(NOTE_OFF, 0, 998000)); // 352
+    messages.push_back(MidiMessage(NOTE_ON, 1, 990500)); // 22
+    messages.push_back(MidiMessage(NOTE_OFF, 1, 994000)); // 176
+    messages.push_back(MidiMessage(NOTE_ON, 1, 992000)); // 88, after the device 0 message
+
+    MidiDriver::computeFrameOffsets(messages, BLOCK_START_TIME, BLOCK_FRAMES, SAMPLE_RATE);
+
+    const quint32 expectedOffsets[] = { 22, 88, 88, 176, 352 };
+    const int expectedDevices[] = { 1, 0, 1, 1, 0 };
+
+    QCOMPARE(messages.size(), size_t(5));
+    for (size_t i = 0; i < messages.size(); ++i) {
+        QCOMPARE(messages.at(i).getFrameOffset(), expectedOffsets[i]);
+        QCOMPARE(messages.at(i).getSourceDeviceIndex(), expectedDevices[i]);
+    }
+}
+
+void TestMidiDriver::messagesAreSlicedInIntervalBoundary()
+{
+    const uint blockFrames = 256;
+    const uint intervalEnd = 100; // the interval is finished in the middle of the block
+
+    std::vector<MidiMessage> blockMessages;
+    const quint32 offsets[] = { 0, 99, 100, 255 };
+    for (quint32 offset : offsets) {
+        blockMessages.push_back(MidiMessage(NOTE_ON, 0));
+        blockMessages.back().setFrameOffset(offset);
+    }
+
+    std::vector<MidiMessage> slicedMessages;
+    slicedMessages.reserve(blockMessages.size());
+
+    MidiDriver::sliceMessages(blockMessages, 0, intervalEnd, slicedMessages);
+    QCOMPARE(slicedMessages.size(), size_t(2));
+    QCOMPARE(slicedMessages.at(0).getFrameOffset(), quint32(0));
+    QCOMPARE(slicedMessages.at(1).getFrameOffset(), quint32(99));
+
+    // the offsets in the new interval part are relative to the part start
+    MidiDriver::sliceMessages(blockMessages, intervalEnd, blockFrames - intervalEnd, slicedMessages);
+    QCOMPARE(slicedMessages.size(), size_t(2));
+    QCOMPARE(slicedMessages.at(0).getFrameOffset(), quint32(0));
+    QCOMPARE(slicedMessages.at(1).getFrameOffset(), quint32(155));
+
+    // the original offsets are not changed, the block messages are shared by all parts
+    QCOMPARE(blockMessages.at(2).getFrameOffset(), quint32(100));
+}
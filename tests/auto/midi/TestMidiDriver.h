@@ -0,0 +1,24 @@
+#ifndef TESTMIDIDRIVER_H
+#define TESTMIDIDRIVER_H
+
+#include <QObject>
+
+class TestMidiDriver: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    // the timestamps are converted in offsets inside the previous block duration (one block of constant latency)
+    void timestampsAreConvertedInFrameOffsets();
+    void timestampsAreConvertedInFrameOffsets_data();
+
+    void messagesWithoutTimestampAreInBlockStart();
+
+    // the messages from different devices are interleaved, the arrival order is preserved for the same offset
+    void messagesAreSortedByFrameOffset();
+
+    // NinjamController split the block in the interval end, each message is played in only one part
+    void messagesAreSlicedInIntervalBoundary();
+};
+
+#endif // TESTMIDIDRIVER_H
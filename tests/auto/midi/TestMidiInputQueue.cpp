@@ -0,0 +1,137 @@
+#include "TestMidiInputQueue.h"
+
+#include <QTest>
+
+#include <thread>
+
+#include "midi/MidiInputQueue.h"
+
+using midi::MidiInputQueue;
+using midi::MidiMessage;
+
+namespace {
+
+MidiMessage createNoteOn(int sequence)
+{
+    // the note and the velocity are used to identify the message
+    return MidiMessage(0x90 | ((sequence % 128) << 8) | (((sequence / 128) % 128) << 16), 0, sequence + 1);
+}
+
+int getSequence(const MidiMessage &message)
+{
+    return static_cast<int>(message.getTimestamp() - 1);
+}
+
+} // namespace
+
+void TestMidiInputQueue::messagesAreDequeuedInArrivalOrder()
+{
+    MidiInputQueue queue(16);
+    for (int i = 0; i < 10; ++i)
+        QVERIFY(queue.enqueue(createNoteOn(i)));
+
+    std::vector<MidiMessage> buffer;
+    buffer.reserve(16);
+    queue.dequeue(buffer);
+
+    QCOMPARE(buffer.size(), size_t(10));
+    for (int i = 0; i < 10; ++i) {
+        QCOMPARE(getSequence(buffer.at(i)), i);
+        QCOMPARE(buffer.at(i).getData1(), i);
+    }
+
+    buffer.clear();
+    queue.dequeue(buffer);
+    QVERIFY(buffer.empty());
+    QCOMPARE(queue.takeDroppedMessages(), 0);
+}
+
+void TestMidiInputQueue::dequeueIsLimitedByBufferCapacity()
+{
+    MidiInputQueue queue(16);
+    for (int i = 0; i < 12; ++i)
+        QVERIFY(queue.enqueue(createNoteOn(i)));
+
+    std::vector<MidiMessage> buffer;
+    buffer.reserve(8);
+    const size_t capacity = buffer.capacity();
+    QVERIFY(capacity < 12);
+
+    queue.dequeue(buffer);
+    QCOMPARE(buffer.size(), capacity);
+    QCOMPARE(buffer.capacity(), capacity); // no allocation
+
+    // next block
+    buffer.clear();
+    queue.dequeue(buffer);
+    QCOMPARE(buffer.size(), 12 - capacity);
+    QCOMPARE(getSequence(buffer.front()), static_cast<int>(capacity));
+    QCOMPARE(getSequence(buffer.back()), 11);
+}
+
+void TestMidiInputQueue::overflowedMessagesAreDropped()
+{
+    const int capacity = 16;
+    const int sendedMessages = 100;
+
+    MidiInputQueue queue(capacity);
+    int acceptedMessages = 0;
+    for (int i = 0; i < sendedMessages; ++i) {
+        if (queue.enqueue(createNoteOn(i)))
+            ++acceptedMessages;
+    }
+
+    QVERIFY(acceptedMessages >= capacity); // all slots were allocated, maybe more than the requested capacity
+    QVERIFY(acceptedMessages < sendedMessages);
+
+    QCOMPARE(queue.takeDroppedMessages(), sendedMessages - acceptedMessages);
+    QCOMPARE(queue.takeDroppedMessages(), 0); // the counter is reset
+
+    // the oldest messages are preserved
+    std::vector<MidiMessage> buffer;
+    buffer.reserve(sendedMessages);
+    queue.dequeue(buffer);
+    QCOMPARE(static_cast<int>(buffer.size()), acceptedMessages);
+    for (int i = 0; i < acceptedMessages; ++i)
+        QCOMPARE(getSequence(buffer.at(i)), i);
+
+    // the queue is usable again after the audio thread consumed the messages
+    QVERIFY(queue.enqueue(createNoteOn(sendedMessages)));
+    QCOMPARE(queue.takeDroppedMessages(), 0);
+}
+
+void TestMidiInputQueue::messagesAreNotLostBetweenThreads()
+{
+    const int sendedMessages = 100000;
+
+    MidiInputQueue queue;
+
+    std::thread midiThread([&]() {
+        for (int i = 0; i < sendedMessages; ++i) {
+            while (!queue.enqueue(createNoteOn(i)))
+                std::this_thread::yield(); // waiting the audio thread, the dropped messages are counted
+        }
+    });
+
+    std::vector<MidiMessage> buffer;
+    buffer.reserve(64);
+
+    int receivedMessages = 0;
+    bool inOrder = true;
+    while (receivedMessages < sendedMessages) {
+        buffer.clear();
+        queue.dequeue(buffer);
+        for (const auto &message : buffer) {
+            if (getSequence(message) != receivedMessages)
+                inOrder = false;
+            ++receivedMessages;
+        }
+        if (buffer.empty())
+            std::this_thread::yield();
+    }
+
+    midiThread.join();
+
+    QVERIFY(inOrder);
+    QCOMPARE(receivedMessages, sendedMessages);
+}
@@ -0,0 +1,23 @@
+#ifndef TESTMIDIINPUTQUEUE_H
+#define TESTMIDIINPUTQUEUE_H
+
+#include <QObject>
+
+class TestMidiInputQueue: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void messagesAreDequeuedInArrivalOrder();
+
+    // the audio thread is not allocating, the messages exceeding the block buffer capacity are kept for the next block
+    void dequeueIsLimitedByBufferCapacity();
+
+    // the queue is full when the audio thread is not consuming, the newest messages are dropped and counted
+    void overflowedMessagesAreDropped();
+
+    // one MIDI thread producing while the audio thread is consuming
+    void messagesAreNotLostBetweenThreads();
+};
+
+#endif // TESTMIDIINPUTQUEUE_H
@@ -1,6 +1,7 @@
 QT += testlib
 QT -= gui
 CONFIG += testcase
+CONFIG += c++11
 TEMPLATE = app
 TARGET = midi
 
@@ -8,7 +9,17 @@ INCLUDEPATH += .
 INCLUDEPATH += ../../../src/Common
 VPATH += ../../../src/Common
 
+HEADERS += TestMidiDriver.h
+HEADERS += TestMidiInputQueue.h
 HEADERS += midi/MidiMessage.h
+HEADERS += midi/MidiDriver.h
+HEADERS += midi/MidiInputQueue.h
+HEADERS += audio/readerwriterqueue.h
+
+SOURCES += TestMidiDriver.cpp
+SOURCES += TestMidiInputQueue.cpp
 SOURCES += midi/MidiMessage.cpp
+SOURCES += midi/MidiDriver.cpp
+SOURCES += log/logging.cpp
 
 SOURCES += test_MidiMessage.cpp
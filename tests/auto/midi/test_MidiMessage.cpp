@@ -2,6 +2,8 @@
 #include <QtTest/QtTest>
 #include <QString>
 #include "midi/MidiMessage.h"
+#include "TestMidiDriver.h"
+#include "TestMidiInputQueue.h"
 
 using namespace midi;
 
@@ -43,8 +45,16 @@ void TestMidiMessage::transpose_data()
 
 int main(int argc, char *argv[])
 {
-    TestMidiMessage test;
-    return QTest::qExec(&test, argc, argv);
+    TestMidiMessage testMidiMessage;
+    TestMidiDriver testMidiDriver;
+    TestMidiInputQueue testMidiInputQueue;
+
+    int result = QTest::qExec(&testMidiMessage, argc, argv);
+
+    result |= QTest::qExec(&testMidiDriver, argc, argv);
+    result |= QTest::qExec(&testMidiInputQueue, argc, argv);
+
+    return result;
 }
 
 #include "test_MidiMessage.moc"
@@ -151,6 +151,38 @@ void TestMessagesSerialization::downloadIntervalBegin()
     QCOMPARE(msg.getMessageType(), otherMsg.getMessageType());
 }
 
+void TestMessagesSerialization::clientSetUserMask()
+{
+    // the client can subscribe many users in the same message
+    auto msg = ClientSetUserMask("user1@127.0.0", 0xFFFFFFFF);
+    msg.addUserMask("user2@127.0.0", 0x3);
+    msg.addUserMask("usér3 😀@127.0.0", 0);
+    msg.addUserMask("user2@127.0.0", 0x1); // replacing the previous mask
+
+    quint32 payload = 0;
+    for (auto userName : msg.getUsersMasks().keys())
+        payload += userName.toUtf8().size() + 1 + 4;
+
+    QCOMPARE(msg.getPayload(), payload);
+
+    QBuffer device;
+    device.open(QIODevice::ReadWrite);
+    msg.serializeTo(&device);
+
+    device.reset();
+
+    auto header = MessageHeader::from(&device);
+    QCOMPARE(header.getPayload(), payload);
+
+    auto otherMsg = ClientSetUserMask::from(&device, payload);
+
+    QCOMPARE(otherMsg.getUsersMasks().size(), 3);
+    QCOMPARE(otherMsg.getUsersMasks()["user2@127.0.0"], quint32(0x1));
+    QCOMPARE(otherMsg.getUsersMasks(), msg.getUsersMasks());
+    QCOMPARE(otherMsg.getPayload(), msg.getPayload());
+    QVERIFY(device.atEnd());
+}
+
 void TestMessagesSerialization::authChallengeMessage_data()
 {
     QTest::addColumn<QString>("licenceText");
@@ -28,6 +28,8 @@ private slots:
 
     void downloadIntervalBegin();
 
+    void clientSetUserMask();
+
     void downloadIntervalWrite_data();
     void downloadIntervalWrite();
 
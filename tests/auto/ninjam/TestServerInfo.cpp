@@ -17,6 +17,21 @@ void TestServerInfo::addUser()
     QVERIFY(server.containsUser(user));
 }
 
+void TestServerInfo::findUser()
+{
+    ServerInfo server("localhost", 2040, 2);
+    QString userFullName("anon@localhost");
+    server.addUser(User(userFullName));
+    server.addUserChannel(userFullName, UserChannel("channel 0", 0, 0, true));
+
+    QVERIFY(server.findUser("not in server") == nullptr);
+
+    const User *user = server.findUser(userFullName);
+    QVERIFY(user != nullptr);
+    QCOMPARE(user->getFullName(), userFullName);
+    QVERIFY(user->channelIsActive(0));
+    QVERIFY(!user->channelIsActive(1)); // not existing channel
+}
 
 void TestServerInfo::addUserChannel_data()
 {
@@ -9,6 +9,7 @@ class TestServerInfo : public QObject
 
 private slots:
     void addUser();
+    void findUser();
 
     void addUserChannel_data();
     void addUserChannel();
@@ -0,0 +1,111 @@
+#include "TestUploadScheduler.h"
+#include "ninjam/client/UploadScheduler.h"
+#include <QTest>
+
+using ninjam::client::UploadScheduler;
+
+void TestUploadScheduler::chunkSize_data()
+{
+    QTest::addColumn<int>("uplinkRate"); // bytes per second
+    QTest::addColumn<int>("msToIntervalEnd");
+    QTest::addColumn<bool>("voiceChat");
+    QTest::addColumn<int>("expectedChunkSize");
+
+    const int minChunk = static_cast<int>(UploadScheduler::MIN_CHUNK_SIZE);
+    const int maxChunk = static_cast<int>(UploadScheduler::MAX_CHUNK_SIZE);
+    const int defaultChunk = static_cast<int>(UploadScheduler::DEFAULT_CHUNK_SIZE);
+
+    QTest::newRow("Voice chat") << 32000 << 10000 << true << 1;
+    QTest::newRow("Uplink rate not measured") << 0 << 10000 << false << defaultChunk;
+    QTest::newRow("Fast uplink, interval end is far") << 32000 << 10000 << false << 8000; // 250 ms
+    QTest::newRow("Interval ending") << 32000 << 400 << false << 3200; // 100 ms
+    QTest::newRow("Slow uplink") << 1000 << 10000 << false << minChunk;
+    QTest::newRow("Very fast uplink") << 1000000 << 10000 << false << maxChunk;
+    QTest::newRow("Late interval") << 32000 << -100 << false << minChunk;
+}
+
+void TestUploadScheduler::chunkSize()
+{
+    QFETCH(int, uplinkRate);
+    QFETCH(int, msToIntervalEnd);
+    QFETCH(bool, voiceChat);
+    QFETCH(int, expectedChunkSize);
+
+    QCOMPARE(UploadScheduler::getChunkSize(uplinkRate, msToIntervalEnd, voiceChat), expectedChunkSize);
+}
+
+void TestUploadScheduler::uploadHeadroom()
+{
+    UploadScheduler scheduler;
+
+    scheduler.intervalFinished(1000, 5000);
+    scheduler.intervalFinished(3000, 10000);
+
+    QVERIFY(!scheduler.bytesSent(999, 0, 100)); // last byte of first interval not sent yet
+    QVERIFY(scheduler.bytesSent(1500, 0, 1000));
+    QCOMPARE(scheduler.getUploadHeadroom(), static_cast<qint64>(4000));
+    QVERIFY(!scheduler.lastIntervalWasLate());
+
+    QVERIFY(scheduler.bytesSent(3000, 0, 10500));
+    QCOMPARE(scheduler.getUploadHeadroom(), static_cast<qint64>(-500));
+    QVERIFY(scheduler.lastIntervalWasLate());
+
+    scheduler.reset();
+    QCOMPARE(scheduler.getUploadHeadroom(), static_cast<qint64>(0));
+    QVERIFY(!scheduler.bytesSent(10000, 0, 20000));
+}
+
+void TestUploadScheduler::uplinkRate()
+{
+    UploadScheduler scheduler;
+    QCOMPARE(scheduler.getUplinkRate(), 0L); // not measured yet
+
+    // the socket is not saturated, the lower bound is not used as the uplink rate
+    scheduler.bytesSent(4000, 0, 1000);
+    scheduler.bytesSent(8000, 0, 1600);
+    QCOMPARE(scheduler.getUplinkRate(), 0L);
+
+    // the backlog is growing, the period starting with an empty backlog is not used
+    scheduler.bytesSent(9000, 3000, 1700);
+    scheduler.bytesSent(10000, 6000, 2000);
+    scheduler.bytesSent(10500, 8000, 2100);
+    QCOMPARE(scheduler.getUplinkRate(), 0L);
+
+    // the backlog is never empty, the socket is draining at the uplink speed
+    scheduler.bytesSent(11500, 9000, 2300);
+    scheduler.bytesSent(12500, 10000, 2600);
+    QCOMPARE(scheduler.getUplinkRate(), 4000L); // 2000 bytes in 500 ms
+
+    // the backlog was drained faster than the measured rate, the lower bound is used
+    scheduler.bytesSent(20500, 0, 3000);
+    scheduler.bytesSent(22500, 0, 3100);
+    QCOMPARE(scheduler.getUplinkRate(), 20000L); // 10000 bytes in 500 ms
+
+    scheduler.reset();
+    QCOMPARE(scheduler.getUplinkRate(), 0L);
+}
+
+void TestUploadScheduler::chunkSizeAdaptsToSlowDrain()
+{
+    UploadScheduler scheduler;
+    const qint64 msToIntervalEnd = 10000;
+    QCOMPARE(scheduler.getChunkSize(msToIntervalEnd, false), static_cast<int>(UploadScheduler::DEFAULT_CHUNK_SIZE));
+
+    // 8000 bytes written each 100 ms, the socket is draining only 1000 bytes (10000 bytes per second)
+    quint64 sentBytes = 0;
+    qint64 backlog = 0;
+    for (qint64 time = 0; time <= 1000; time += 100) {
+        scheduler.bytesSent(sentBytes, backlog, time);
+        sentBytes += 1000;
+        backlog += 7000;
+    }
+
+    QCOMPARE(scheduler.getUplinkRate(), 10000L);
+    QCOMPARE(scheduler.getChunkSize(msToIntervalEnd, false), 2500); // 250 ms in the measured uplink
+
+    // the interval was uploaded after the deadline, the chunks are minimal
+    scheduler.intervalFinished(sentBytes, 1000);
+    scheduler.bytesSent(sentBytes, backlog, 1100);
+    QVERIFY(scheduler.lastIntervalWasLate());
+    QCOMPARE(scheduler.getChunkSize(msToIntervalEnd, false), static_cast<int>(UploadScheduler::MIN_CHUNK_SIZE));
+}
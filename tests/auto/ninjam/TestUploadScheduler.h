@@ -0,0 +1,19 @@
+#ifndef TEST_UPLOAD_SCHEDULER_H
+#define TEST_UPLOAD_SCHEDULER_H
+
+#include <QObject>
+
+class TestUploadScheduler : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void chunkSize_data();
+    void chunkSize();
+
+    void uploadHeadroom();
+    void uplinkRate();
+    void chunkSizeAdaptsToSlowDrain();
+};
+
+#endif
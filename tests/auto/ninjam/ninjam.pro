@@ -16,20 +16,24 @@ HEADERS += TestServerClientCommunication.h
 
 HEADERS += log/logging.h
 HEADERS += TestServerInfo.h
+HEADERS += TestUploadScheduler.h
 HEADERS += ninjam/client/ServerInfo.h
 HEADERS += ninjam/client/User.h
 HEADERS += ninjam/client/UserChannel.h
 HEADERS += ninjam/client/Service.h
+HEADERS += ninjam/client/UploadScheduler.h
 HEADERS += ninjam/Ninjam.h
 HEADERS += ninjam/server/Server.h
 
 SOURCES += log/logging.cpp
 SOURCES += ninjam/Ninjam.cpp
 SOURCES += TestServerInfo.cpp
+SOURCES += TestUploadScheduler.cpp
 SOURCES += ninjam/client/ServerInfo.cpp
 SOURCES += ninjam/client/User.cpp
 SOURCES += ninjam/client/UserChannel.cpp
 SOURCES += ninjam/client/Service.cpp
+SOURCES += ninjam/client/UploadScheduler.cpp
 SOURCES += ninjam/client/ServerMessages.cpp
 SOURCES += ninjam/client/ServerMessagesHandler.cpp
 SOURCES += ninjam/client/ClientMessages.cpp
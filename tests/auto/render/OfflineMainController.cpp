@@ -0,0 +1,34 @@
+#include "OfflineMainController.h"
+#include "NinjamController.h"
+
+OfflineMainController::OfflineMainController(const persistence::Settings &settings, int sampleRate) :
+    MainController(settings),
+    sampleRate(sampleRate)
+{
+    setSampleRate(sampleRate);
+}
+
+QString OfflineMainController::getJamtabaFlavor() const
+{
+    return "Offline";
+}
+
+float OfflineMainController::getSampleRate() const
+{
+    return sampleRate;
+}
+
+controller::NinjamController *OfflineMainController::createNinjamController()
+{
+    return new controller::NinjamController(this);
+}
+
+void OfflineMainController::setCSS(const QString &css)
+{
+    Q_UNUSED(css) // no GUI
+}
+
+void OfflineMainController::pullMidiMessagesFromDevices(std::vector<midi::MidiMessage> &outBuffer)
+{
+    Q_UNUSED(outBuffer); // no MIDI devices
+}
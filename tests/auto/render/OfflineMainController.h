@@ -0,0 +1,31 @@
+#ifndef OFFLINE_MAIN_CONTROLLER_H
+#define OFFLINE_MAIN_CONTROLLER_H
+
+#include "MainController.h"
+
+/**
+    MainController without audio driver, MIDI devices, plugins and main window. The audio
+    callbacks are called by the OfflineRenderer, as fast as possible.
+*/
+
+class OfflineMainController : public controller::MainController
+{
+public:
+    OfflineMainController(const persistence::Settings &settings, int sampleRate);
+
+    QString getJamtabaFlavor() const override;
+
+    float getSampleRate() const override;
+
+protected:
+    controller::NinjamController *createNinjamController() override;
+
+    void setCSS(const QString &css) override;
+
+    void pullMidiMessagesFromDevices(std::vector<midi::MidiMessage> &outBuffer) override;
+
+private:
+    int sampleRate;
+};
+
+#endif // OFFLINE_MAIN_CONTROLLER_H
@@ -0,0 +1,288 @@
+#include "OfflineRenderer.h"
+#include "OfflineMainController.h"
+
+#include "NinjamController.h"
+#include "audio/core/LocalInputNode.h"
+#include "audio/core/SamplesBuffer.h"
+#include "audio/core/AllocationTripwire.h"
+#include "audio/vorbis/VorbisEncoder.h"
+#include "audio/vorbis/Vorbis.h"
+#include "ninjam/client/Service.h"
+#include "ninjam/client/ServerInfo.h"
+#include "ninjam/client/User.h"
+#include "ninjam/client/UserChannel.h"
+#include "persistence/Settings.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QRegularExpression>
+#include <QThread>
+#include <QtMath>
+
+#include <algorithm>
+#include <cmath>
+
+using ninjam::client::ServerInfo;
+using ninjam::client::User;
+using ninjam::client::UserChannel;
+
+OfflineRenderer::Settings::Settings() :
+    sampleRate(44100),
+    bufferSize(128),
+    bpm(120),
+    bpi(16),
+    intervals(8),
+    remoteChannels(4),
+    realTimePacing(false)
+{
+
+}
+
+OfflineRenderer::Report::Report() :
+    callbacks(0),
+    deadline(0),
+    p50(0),
+    p90(0),
+    p99(0),
+    max(0),
+    deadlineMisses(0),
+    allocations(0),
+    fedIntervals(0),
+    outputPeak(0),
+    realTimeFactor(0)
+{
+
+}
+
+QString OfflineRenderer::Report::toString() const
+{
+    return QString("%1 callbacks (deadline %2 us): p50 %3 us, p90 %4 us, p99 %5 us, max %6 us, %7 deadline misses, %8 allocations, %9 intervals fed, %10x real time")
+            .arg(callbacks)
+            .arg(deadline / 1000)
+            .arg(p50 / 1000.0, 0, 'f', 1)
+            .arg(p90 / 1000.0, 0, 'f', 1)
+            .arg(p99 / 1000.0, 0, 'f', 1)
+            .arg(max / 1000.0, 0, 'f', 1)
+            .arg(deadlineMisses)
+            .arg(allocations)
+            .arg(fedIntervals)
+            .arg(realTimeFactor, 0, 'f', 1);
+}
+
+OfflineRenderer::OfflineRenderer(const Settings &settings) :
+    settings(settings)
+{
+
+}
+
+OfflineRenderer::Intervals OfflineRenderer::loadRecordedIntervals() const
+{
+    // JamRecorder files are named as 'userName (channelName) part N.ogg'
+    static const QRegularExpression fileNameRegex("^(.+) \\((.*)\\) part (\\d+)\\.ogg$");
+
+    Intervals intervals;
+    QMap<QString, QStringList> channelsNames; // user => channels, the channel index is the first appearance order
+    int firstPart = -1;
+
+    QDirIterator iterator(settings.recordingPath, QStringList() << "*.ogg", QDir::Files, QDirIterator::Subdirectories);
+    while (iterator.hasNext()) {
+        QString filePath = iterator.next();
+        auto match = fileNameRegex.match(iterator.fileName());
+        if (!match.hasMatch())
+            continue;
+
+        QFile file(filePath);
+        if (!file.open(QFile::ReadOnly)) {
+            qWarning() << "Can't read" << filePath;
+            continue;
+        }
+
+        QString userName = match.captured(1);
+        QString channelName = match.captured(2);
+        int part = match.captured(3).toInt();
+
+        QStringList &userChannels = channelsNames[userName];
+        if (!userChannels.contains(channelName))
+            userChannels.append(channelName);
+
+        RemoteInterval interval;
+        interval.userFullName = userName + "@127.0.0.1";
+        interval.channelName = channelName;
+        interval.channelIndex = static_cast<quint8>(userChannels.indexOf(channelName));
+        interval.encodedData = file.readAll();
+
+        intervals[part].append(interval);
+
+        if (firstPart < 0 || part < firstPart)
+            firstPart = part;
+    }
+
+    // the first recorded interval is fed in the session start
+    Intervals sessionIntervals;
+    for (auto part : intervals.keys())
+        sessionIntervals.insert(part - firstPart, intervals[part]);
+
+    return sessionIntervals;
+}
+
+OfflineRenderer::Intervals OfflineRenderer::synthesizeIntervals(uint samplesPerInterval) const
+{
+    Intervals intervals;
+
+    audio::SamplesBuffer buffer(2, samplesPerInterval);
+
+    for (int channel = 0; channel < settings.remoteChannels; ++channel) {
+        double frequency = 220.0 * qPow(2.0, channel * 4 / 12.0); // every channel is a different chord note
+        generateSineWave(buffer, 0, frequency, settings.sampleRate, 0.2f);
+
+        vorbis::Encoder encoder(buffer.getChannels(), settings.sampleRate, vorbis::EncoderQualityNormal);
+
+        RemoteInterval interval;
+        interval.userFullName = QString("offline user %1@127.0.0.1").arg(channel / 2); // 2 channels per user
+        interval.channelName = QString("channel %1").arg(channel % 2);
+        interval.channelIndex = static_cast<quint8>(channel % 2);
+        interval.encodedData = encoder.encode(buffer);
+        interval.encodedData.append(encoder.finishIntervalEncoding());
+
+        // the same encoded interval is repeated in the whole session
+        for (int i = 0; i < settings.intervals; ++i)
+            intervals[i].append(interval);
+    }
+
+    return intervals;
+}
+
+void OfflineRenderer::generateSineWave(audio::SamplesBuffer &buffer, quint64 firstFrame, double frequency, int sampleRate, float gain)
+{
+    const double phaseIncrement = 2 * M_PI * frequency / sampleRate;
+    for (uint c = 0; c < buffer.getChannels(); ++c) {
+        float *samples = buffer.getSamplesArray(c);
+        for (uint s = 0; s < buffer.getFrameLenght(); ++s)
+            samples[s] = gain * static_cast<float>(std::sin(phaseIncrement * (firstFrame + s)));
+    }
+}
+
+qint64 OfflineRenderer::percentile(const QList<qint64> &sortedTimes, double percent)
+{
+    if (sortedTimes.isEmpty())
+        return 0;
+
+    int index = qCeil(percent * sortedTimes.size()) - 1;
+
+    return sortedTimes.at(qBound(0, index, sortedTimes.size() - 1));
+}
+
+OfflineRenderer::Report OfflineRenderer::render()
+{
+    Report report;
+
+    persistence::Settings jamtabaSettings; // using the defaults, the user settings are not loaded
+    OfflineMainController controller(jamtabaSettings, settings.sampleRate);
+    controller.setAudioBuffersLayout(1, 2, settings.bufferSize); // mono input, stereo output, like the rendered buffers
+    controller.start();
+
+    auto inputTrack = new audio::LocalInputNode(&controller, 0, true);
+    inputTrack->setAudioInputSelection(0, 1);
+    controller.addInputTrackNode(inputTrack); // deleted by controller
+
+    const uint samplesPerInterval = static_cast<uint>(settings.sampleRate * (60000.0 / settings.bpm * settings.bpi) / 1000.0);
+
+    Intervals intervals = settings.recordingPath.isEmpty() ? synthesizeIntervals(samplesPerInterval) : loadRecordedIntervals();
+
+    // the remote users are in the server when the session starts
+    ServerInfo server("offline", 2049, 8);
+    server.setBpm(settings.bpm);
+    server.setBpi(settings.bpi);
+    for (const auto &sessionInterval : intervals) {
+        for (const auto &remoteInterval : sessionInterval) {
+            server.addUser(User(remoteInterval.userFullName));
+            if (!server.getUser(remoteInterval.userFullName).hasChannel(remoteInterval.channelIndex))
+                server.addUserChannel(remoteInterval.userFullName, UserChannel(remoteInterval.channelName, remoteInterval.channelIndex, 0, true));
+        }
+    }
+
+    controller.connectInNinjamServer(server);
+
+    auto ninjamController = controller.getNinjamController();
+    auto ninjamService = controller.getNinjamService();
+    if (!ninjamController || !ninjamController->isRunning()) {
+        qCritical() << "Ninjam controller is not running!";
+        return report;
+    }
+
+    const quint64 totalFrames = static_cast<quint64>(ninjamController->getSamplesPerInterval()) * settings.intervals;
+    const uint bufferSize = static_cast<uint>(settings.bufferSize);
+
+    audio::SamplesBuffer in(1, bufferSize);
+    audio::SamplesBuffer out(2, bufferSize);
+
+    report.deadline = static_cast<qint64>(bufferSize * 1000000000.0 / settings.sampleRate);
+
+    QList<qint64> times;
+    times.reserve(static_cast<int>(totalFrames / bufferSize + 1));
+
+    const quint64 initialAllocations = audio::tripwire::getDetectedAllocations();
+
+    QElapsedTimer renderTimer;
+    renderTimer.start();
+
+    int nextInterval = 0;
+    for (quint64 frame = 0; frame < totalFrames; frame += bufferSize) {
+        if (frame >= static_cast<quint64>(nextInterval) * ninjamController->getSamplesPerInterval()) {
+            // the intervals are 'downloaded' in the interval start and played in the next interval
+            for (const auto &remoteInterval : intervals.value(nextInterval)) {
+                User user = server.getUser(remoteInterval.userFullName);
+                emit ninjamService->audioIntervalCompleted(user, remoteInterval.channelIndex, remoteInterval.encodedData);
+                report.fedIntervals++;
+            }
+
+            nextInterval++;
+
+            QCoreApplication::processEvents(); // the queued signals (encoded audio to upload, etc.)
+        }
+
+        if (settings.inputScript)
+            settings.inputScript(in, frame);
+        else
+            generateSineWave(in, frame, 440.0, settings.sampleRate, 0.5f);
+        out.zero();
+
+        QElapsedTimer callbackTimer;
+        callbackTimer.start();
+
+        controller.process(in, out, settings.sampleRate);
+
+        qint64 callbackTime = callbackTimer.nsecsElapsed();
+        times.append(callbackTime);
+
+        if (callbackTime > report.deadline)
+            report.deadlineMisses++;
+
+        report.outputPeak = qMax(report.outputPeak, out.computePeak().getMaxPeak());
+
+        if (settings.realTimePacing && callbackTime < report.deadline)
+            QThread::usleep(static_cast<unsigned long>((report.deadline - callbackTime) / 1000));
+    }
+
+    qint64 renderTime = renderTimer.nsecsElapsed();
+
+    report.allocations = audio::tripwire::getDetectedAllocations() - initialAllocations;
+    report.callbacks = static_cast<quint64>(times.size());
+
+    std::sort(times.begin(), times.end());
+    report.p50 = percentile(times, 0.5);
+    report.p90 = percentile(times, 0.9);
+    report.p99 = percentile(times, 0.99);
+    report.max = times.isEmpty() ? 0 : times.last();
+
+    double sessionTime = totalFrames * 1000000000.0 / settings.sampleRate;
+    report.realTimeFactor = renderTime > 0 ? sessionTime / renderTime : 0;
+
+    controller.stop();
+    QCoreApplication::processEvents();
+
+    return report;
+}
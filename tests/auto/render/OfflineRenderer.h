@@ -0,0 +1,93 @@
+#ifndef OFFLINE_RENDERER_H
+#define OFFLINE_RENDERER_H
+
+#include <QString>
+#include <QList>
+#include <QMap>
+#include <QByteArray>
+#include <QtGlobal>
+
+#include <functional>
+
+namespace audio {
+class SamplesBuffer;
+}
+
+/**
+    Headless session render. The full audio path (MainController::process -> NinjamController::process
+    -> AudioMixer -> NinjamTrackNode) is called in a loop, without sound card and network, as fast as
+    possible. The local input is scripted and the remote channels are fed with Ogg vorbis intervals,
+    recorded with JamRecorder or synthesized.
+*/
+
+class OfflineRenderer
+{
+public:
+    struct Settings
+    {
+        Settings();
+
+        int sampleRate;
+        int bufferSize; // frames per audio callback
+        int bpm;
+        int bpi;
+        int intervals; // session length
+        int remoteChannels; // synthesized remote channels, used when 'recordingPath' is empty
+
+        // folder with the .ogg intervals recorded by JamRecorder, the files are fed in the recorded order
+        QString recordingPath;
+
+        // fill the local input buffer, called before every audio callback. A sine wave is used when not set.
+        std::function<void(audio::SamplesBuffer &input, quint64 firstFrame)> inputScript;
+
+        bool realTimePacing; // sleep after every callback, like a sound card. The decoders are not starved.
+    };
+
+    struct Report
+    {
+        Report();
+
+        quint64 callbacks;
+        qint64 deadline; // nanoseconds available for each callback (buffer size / sample rate)
+
+        // callback CPU time percentiles, in nanoseconds
+        qint64 p50;
+        qint64 p90;
+        qint64 p99;
+        qint64 max;
+
+        quint64 deadlineMisses; // callbacks slower than the deadline, a xrun when using a real sound card
+        quint64 allocations; // detected only when building with CONFIG+=allocation_tripwire
+
+        quint64 fedIntervals;
+        float outputPeak;
+        double realTimeFactor; // session duration / render time
+
+        QString toString() const;
+    };
+
+    explicit OfflineRenderer(const Settings &settings = Settings());
+
+    Report render();
+
+private:
+    struct RemoteInterval
+    {
+        QString userFullName;
+        QString channelName;
+        quint8 channelIndex;
+        QByteArray encodedData;
+    };
+
+    using Intervals = QMap<int, QList<RemoteInterval>>; // interval index => remote channels intervals
+
+    Settings settings;
+
+    Intervals loadRecordedIntervals() const;
+    Intervals synthesizeIntervals(uint samplesPerInterval) const;
+
+    static void generateSineWave(audio::SamplesBuffer &buffer, quint64 firstFrame, double frequency, int sampleRate, float gain);
+    static qint64 percentile(const QList<qint64> &sortedTimes, double percent);
+};
+
+#endif // OFFLINE_RENDERER_H
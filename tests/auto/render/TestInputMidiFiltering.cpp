@@ -0,0 +1,138 @@
+#include "TestInputMidiFiltering.h"
+#include "OfflineMainController.h"
+
+#include "audio/core/AudioNodeProcessor.h"
+#include "audio/core/LocalInputNode.h"
+#include "audio/core/SamplesBuffer.h"
+#include "midi/MidiMessage.h"
+#include "persistence/Settings.h"
+
+#include <QTest>
+
+#include <vector>
+
+using audio::LocalInputNode;
+using audio::SamplesBuffer;
+using midi::MidiMessage;
+
+namespace {
+
+const int SAMPLE_RATE = 44100;
+const int BUFFER_SIZE = 256;
+
+// a plugin recording the MIDI messages sended by the input node
+class MidiRecorder : public audio::AudioNodeProcessor
+{
+public:
+    void process(const SamplesBuffer &, SamplesBuffer &, std::vector<MidiMessage> &midiMessages) override
+    {
+        received.insert(received.end(), midiMessages.begin(), midiMessages.end());
+    }
+
+    void suspend() override {}
+    void resume() override {}
+    void updateGui() override {}
+    void openEditor(const QPoint &) override {}
+    void closeEditor() override {}
+
+    std::vector<MidiMessage> received;
+};
+
+MidiMessage createNoteOn(int device, int channel, quint8 note, quint8 velocity = 100)
+{
+    return MidiMessage(0x90 | channel | (note << 8) | (velocity << 16), device);
+}
+
+} // namespace
+
+void TestInputMidiFiltering::nodesAreFilteringSharedMessages()
+{
+    persistence::Settings settings;
+    OfflineMainController controller(settings, SAMPLE_RATE);
+
+    auto keyboard = new LocalInputNode(&controller, 0);
+    keyboard->setMidiInputSelection(0, -1); // device 0, all channels
+    keyboard->setMidiLowerNote(60);
+    keyboard->setMidiHigherNote(72);
+    keyboard->setTranspose(12);
+    controller.addInputTrackNode(keyboard); // deleted by controller
+
+    auto drums = new LocalInputNode(&controller, 1);
+    drums->setMidiInputSelection(1, 2); // device 1, channel 2
+    controller.addInputTrackNode(drums);
+
+    auto keyboardRecorder = new MidiRecorder(); // deleted by the node
+    keyboard->addProcessor(keyboardRecorder, 0);
+
+    auto drumsRecorder = new MidiRecorder();
+    drums->addProcessor(drumsRecorder, 0);
+
+    std::vector<MidiMessage> sharedMessages;
+    sharedMessages.push_back(createNoteOn(0, 0, 64)); // keyboard
+    sharedMessages.push_back(createNoteOn(0, 0, 80)); // out of keyboard range
+    sharedMessages.push_back(createNoteOn(1, 2, 36)); // drums
+    sharedMessages.push_back(createNoteOn(1, 3, 36)); // wrong channel
+    sharedMessages.push_back(createNoteOn(2, 0, 64)); // device without input node
+
+    SamplesBuffer in(2, BUFFER_SIZE);
+    SamplesBuffer out(2, BUFFER_SIZE);
+    in.zero();
+
+    keyboard->processReplacing(in, out, SAMPLE_RATE, sharedMessages);
+    drums->processReplacing(in, out, SAMPLE_RATE, sharedMessages);
+
+    QCOMPARE(keyboardRecorder->received.size(), size_t(1));
+    QCOMPARE(keyboardRecorder->received.front().getData1(), 64 + 12); // transposed copy
+    QCOMPARE(keyboardRecorder->received.front().getSourceDeviceIndex(), 0);
+
+    QCOMPARE(drumsRecorder->received.size(), size_t(1));
+    QCOMPARE(drumsRecorder->received.front().getData1(), 36);
+    QCOMPARE(drumsRecorder->received.front().getChannel(), 2);
+
+    // the shared messages are not changed by the nodes
+    QCOMPARE(sharedMessages.size(), size_t(5));
+    QCOMPARE(sharedMessages.front().getData1(), 64);
+
+    QCOMPARE(keyboard->getMidiActivityValue(), quint8(100));
+    QCOMPARE(drums->getMidiActivityValue(), quint8(100));
+}
+
+void TestInputMidiFiltering::routedMessagesAreAcceptedOnlyOnce()
+{
+    persistence::Settings settings;
+    OfflineMainController controller(settings, SAMPLE_RATE);
+
+    auto vocoder = new LocalInputNode(&controller, 0); // first subchannel, audio input
+    vocoder->setAudioInputSelection(0, 1);
+    controller.addInputTrackNode(vocoder);
+
+    auto keyboard = new LocalInputNode(&controller, 0); // second subchannel, routing MIDI to the vocoder
+    keyboard->setMidiInputSelection(1, -1);
+    controller.addInputTrackNode(keyboard);
+    keyboard->setRoutingMidiInput(true);
+
+    QVERIFY(vocoder->isReceivingRoutedMidiInput());
+    QVERIFY(keyboard->isRoutingMidiInput());
+
+    auto vocoderRecorder = new MidiRecorder();
+    vocoder->addProcessor(vocoderRecorder, 0);
+
+    std::vector<MidiMessage> sharedMessages;
+    sharedMessages.push_back(createNoteOn(0, 0, 60)); // not routed
+    sharedMessages.push_back(createNoteOn(1, 0, 62, 90));
+    sharedMessages.push_back(createNoteOn(1, 5, 64, 80));
+
+    SamplesBuffer in(2, BUFFER_SIZE);
+    SamplesBuffer out(2, BUFFER_SIZE);
+    in.zero();
+
+    vocoder->processReplacing(in, out, SAMPLE_RATE, sharedMessages);
+
+    // the messages are sended in the timing order
+    QCOMPARE(vocoderRecorder->received.size(), size_t(2));
+    QCOMPARE(vocoderRecorder->received.at(0).getData1(), 62);
+    QCOMPARE(vocoderRecorder->received.at(1).getData1(), 64);
+
+    // the keyboard is not rendering, but the MIDI activity meter is updated
+    QCOMPARE(keyboard->getMidiActivityValue(), quint8(90));
+}
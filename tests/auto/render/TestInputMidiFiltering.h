@@ -0,0 +1,18 @@
+#ifndef TEST_INPUT_MIDI_FILTERING_H
+#define TEST_INPUT_MIDI_FILTERING_H
+
+#include <QObject>
+
+class TestInputMidiFiltering : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    // the MIDI messages are shared by all input nodes, each node is copying only the accepted messages
+    void nodesAreFilteringSharedMessages();
+
+    // the second subchannel is routing the accepted messages to the first subchannel (vocoders)
+    void routedMessagesAreAcceptedOnlyOnce();
+};
+
+#endif // TEST_INPUT_MIDI_FILTERING_H
@@ -0,0 +1,154 @@
+#include "TestLookAheadDecoding.h"
+
+#include "audio/NinjamTrackNode.h"
+#include "audio/core/SamplesBuffer.h"
+#include "audio/vorbis/VorbisEncoder.h"
+#include "audio/vorbis/Vorbis.h"
+#include "midi/MidiMessage.h"
+
+#include <QElapsedTimer>
+#include <QTest>
+#include <QtMath>
+
+#include <vector>
+
+namespace {
+
+const qint64 DEFAULT_BUDGET = 64 * 1024 * 1024;
+const int SAMPLE_RATE = 44100;
+const int BUFFER_SIZE = 512;
+
+} // namespace
+
+QByteArray TestLookAheadDecoding::encodeInterval(int frames)
+{
+    audio::SamplesBuffer buffer(2, frames);
+    const double phaseIncrement = 2 * M_PI * 440.0 / SAMPLE_RATE;
+    for (int i = 0; i < frames; ++i) {
+        float sample = static_cast<float>(qSin(phaseIncrement * i) * 0.5);
+        buffer.set(0, i, sample);
+        buffer.set(1, i, sample);
+    }
+
+    vorbis::Encoder encoder(buffer.getChannels(), SAMPLE_RATE, vorbis::EncoderQualityNormal);
+    QByteArray encodedData = encoder.encode(buffer);
+    encodedData.append(encoder.finishIntervalEncoding());
+
+    return encodedData;
+}
+
+qint64 TestLookAheadDecoding::waitLookAheadDecoding()
+{
+    qint64 previousBytes = -1;
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < 5000) {
+        qint64 bytes = NinjamTrackNode::getLookAheadDecodedBytes();
+        if (bytes == previousBytes)
+            return bytes;
+
+        previousBytes = bytes;
+        QTest::qWait(100);
+    }
+
+    return previousBytes;
+}
+
+float TestLookAheadDecoding::processBlocks(NinjamTrackNode &node, int blocks)
+{
+    audio::SamplesBuffer in(2, BUFFER_SIZE);
+    audio::SamplesBuffer out(2, BUFFER_SIZE);
+    std::vector<midi::MidiMessage> midiBuffer;
+
+    float peak = 0;
+    for (int i = 0; i < blocks; ++i) {
+        in.zero();
+        out.zero();
+        node.processReplacing(in, out, SAMPLE_RATE, midiBuffer);
+        peak = qMax(peak, out.computePeak().getMaxPeak());
+    }
+
+    return peak;
+}
+
+void TestLookAheadDecoding::cleanup()
+{
+    NinjamTrackNode::setLookAheadDecodingBudget(DEFAULT_BUDGET);
+}
+
+void TestLookAheadDecoding::decodedBlocksAreLimitedByBudget()
+{
+    const qint64 budget = 256 * 1024;
+    NinjamTrackNode::setLookAheadDecodingBudget(budget);
+
+    {
+        NinjamTrackNode node(1);
+        node.addVorbisEncodedInterval(encodeInterval(SAMPLE_RATE * 10)); // much more than the budget
+
+        qint64 decodedBytes = waitLookAheadDecoding();
+        QVERIFY(decodedBytes > budget / 2);
+        QVERIFY(decodedBytes <= budget);
+    }
+
+    // the node is destroyed, the decoder is retired and the blocks are returned to the pool
+    QTRY_COMPARE(NinjamTrackNode::getLookAheadDecodedBytes(), static_cast<qint64>(0));
+}
+
+void TestLookAheadDecoding::missingBlocksAreDecodedInAudioThread()
+{
+    NinjamTrackNode::setLookAheadDecodingBudget(0); // nothing can be decoded ahead
+
+    NinjamTrackNode node(1);
+    node.addVorbisEncodedInterval(encodeInterval(SAMPLE_RATE));
+    QVERIFY(node.startNewInterval());
+
+    QVERIFY(processBlocks(node, 8) > 0);
+    QCOMPARE(node.getDecodingUnderruns(), static_cast<quint64>(8));
+    QCOMPARE(NinjamTrackNode::getLookAheadDecodedBytes(), static_cast<qint64>(0));
+}
+
+void TestLookAheadDecoding::playingIntervalHasBudgetPriority()
+{
+    const qint64 blockBytes = 4096 * 2 * static_cast<qint64>(sizeof(float)); // look ahead blocks have 4096 stereo frames
+    const qint64 budget = 16 * blockBytes;
+    NinjamTrackNode::setLookAheadDecodingBudget(budget);
+
+    {
+        NinjamTrackNode bufferingNode(1); // future intervals, not playing
+        bufferingNode.addVorbisEncodedInterval(encodeInterval(SAMPLE_RATE * 10));
+        bufferingNode.addVorbisEncodedInterval(encodeInterval(SAMPLE_RATE * 10));
+        qint64 bufferedBytes = waitLookAheadDecoding();
+        QVERIFY(bufferedBytes < budget); // a part of the budget is reserved
+
+        NinjamTrackNode playingNode(2);
+        playingNode.addVorbisEncodedInterval(encodeInterval(SAMPLE_RATE * 2));
+        QVERIFY(playingNode.startNewInterval());
+        QVERIFY(waitLookAheadDecoding() > bufferedBytes);
+
+        QVERIFY(processBlocks(playingNode, 16) > 0);
+        QCOMPARE(playingNode.getDecodingUnderruns(), static_cast<quint64>(0));
+    }
+
+    QTRY_COMPARE(NinjamTrackNode::getLookAheadDecodedBytes(), static_cast<qint64>(0));
+}
+
+void TestLookAheadDecoding::decodedIntervalIsPlayedWithoutUnderruns()
+{
+    const int intervalFrames = SAMPLE_RATE * 2;
+
+    {
+        NinjamTrackNode node(1);
+        node.addVorbisEncodedInterval(encodeInterval(intervalFrames));
+        QVERIFY(waitLookAheadDecoding() > 0);
+
+        QVERIFY(node.startNewInterval());
+
+        const int blocks = (intervalFrames + BUFFER_SIZE - 1) / BUFFER_SIZE;
+        QVERIFY(processBlocks(node, blocks) > 0);
+        QCOMPARE(node.getDecodingUnderruns(), static_cast<quint64>(0));
+
+        QVERIFY(!node.startNewInterval()); // no more intervals, the played decoder is retired
+    }
+
+    QTRY_COMPARE(NinjamTrackNode::getLookAheadDecodedBytes(), static_cast<qint64>(0));
+}
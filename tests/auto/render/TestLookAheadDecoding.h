@@ -0,0 +1,34 @@
+#ifndef TEST_LOOK_AHEAD_DECODING_H
+#define TEST_LOOK_AHEAD_DECODING_H
+
+#include <QObject>
+#include <QByteArray>
+
+class NinjamTrackNode;
+
+class TestLookAheadDecoding : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void cleanup(); // the default budget is restored, the look ahead thread is shared by all tests
+
+    // the decoded (not consumed) blocks never exceed the memory budget
+    void decodedBlocksAreLimitedByBudget();
+
+    // the missing blocks are decoded in the audio thread and counted
+    void missingBlocksAreDecodedInAudioThread();
+
+    // the buffered intervals are not using the budget reserved to the playing interval
+    void playingIntervalHasBudgetPriority();
+
+    // an interval decoded ahead is played without underruns, the blocks are recycled after the interval
+    void decodedIntervalIsPlayedWithoutUnderruns();
+
+private:
+    static QByteArray encodeInterval(int frames);
+    static qint64 waitLookAheadDecoding(); // wait until the decoded bytes are stable
+    static float processBlocks(NinjamTrackNode &node, int blocks); // return the output peak
+};
+
+#endif // TEST_LOOK_AHEAD_DECODING_H
@@ -0,0 +1,65 @@
+#include "TestOfflineRender.h"
+#include "OfflineRenderer.h"
+
+#include <QTest>
+
+void TestOfflineRender::renderSession_data()
+{
+    QTest::addColumn<int>("bufferSize");
+    QTest::addColumn<int>("sampleRate");
+
+    QTest::newRow("64 samples, 44100 Hz") << 64 << 44100;
+    QTest::newRow("128 samples, 44100 Hz") << 128 << 44100;
+    QTest::newRow("256 samples, 48000 Hz") << 256 << 48000;
+    QTest::newRow("512 samples, 48000 Hz") << 512 << 48000;
+}
+
+void TestOfflineRender::renderSession()
+{
+    QFETCH(int, bufferSize);
+    QFETCH(int, sampleRate);
+
+    OfflineRenderer::Settings settings;
+    settings.bufferSize = bufferSize;
+    settings.sampleRate = sampleRate;
+    settings.bpm = 120;
+    settings.bpi = 4;
+    settings.intervals = 4;
+    settings.remoteChannels = 4;
+
+    OfflineRenderer renderer(settings);
+    auto report = renderer.render();
+
+    qInfo() << qPrintable(report.toString());
+
+    quint64 samplesPerInterval = static_cast<quint64>(sampleRate * (60000.0 / settings.bpm * settings.bpi) / 1000.0);
+    quint64 expectedCallbacks = (samplesPerInterval * settings.intervals + bufferSize - 1) / bufferSize;
+
+    QCOMPARE(report.callbacks, expectedCallbacks);
+    QCOMPARE(report.fedIntervals, static_cast<quint64>(settings.intervals * settings.remoteChannels));
+    QVERIFY(report.outputPeak > 0); // the local input and the remote channels are audible
+    QVERIFY(report.p50 <= report.p99);
+    QVERIFY(report.p99 <= report.max);
+}
+
+void TestOfflineRender::renderRecordedSession()
+{
+    QString recordingPath = QString::fromLocal8Bit(qgetenv("JAMTABA_RENDER_RECORDING"));
+    if (recordingPath.isEmpty())
+        QSKIP("JAMTABA_RENDER_RECORDING is not set");
+
+    OfflineRenderer::Settings settings;
+    settings.recordingPath = recordingPath;
+
+    bool ok = false;
+    int bufferSize = qgetenv("JAMTABA_RENDER_BUFFER_SIZE").toInt(&ok);
+    if (ok && bufferSize > 0)
+        settings.bufferSize = bufferSize;
+
+    OfflineRenderer renderer(settings);
+    auto report = renderer.render();
+
+    qInfo() << qPrintable(report.toString());
+
+    QVERIFY(report.fedIntervals > 0);
+}
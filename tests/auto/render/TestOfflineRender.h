@@ -0,0 +1,19 @@
+#ifndef TEST_OFFLINE_RENDER_H
+#define TEST_OFFLINE_RENDER_H
+
+#include <QObject>
+
+class TestOfflineRender : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    // synthesized remote intervals, the timing report is printed for each buffer size
+    void renderSession_data();
+    void renderSession();
+
+    // intervals recorded with JamRecorder, the folder is passed in JAMTABA_RENDER_RECORDING environment variable
+    void renderRecordedSession();
+};
+
+#endif // TEST_OFFLINE_RENDER_H
@@ -0,0 +1,39 @@
+# Headless session render harness: the full audio engine (Jamtaba-common.pri) without sound card,
+# network and main window. Use 'qmake CONFIG+=allocation_tripwire' to count the audio thread allocations.
+
+TEMPLATE = app
+TARGET = render
+
+include(../../../PROJECTS/Jamtaba-common.pri)
+
+QT += testlib
+CONFIG += testcase
+
+INCLUDEPATH += .
+VPATH += $$SOURCE_PATH/Standalone
+
+HEADERS += OfflineMainController.h
+HEADERS += OfflineRenderer.h
+HEADERS += TestInputMidiFiltering.h
+HEADERS += TestLookAheadDecoding.h
+HEADERS += TestOfflineRender.h
+
+SOURCES += ConfiguratorStandalone.cpp
+SOURCES += OfflineMainController.cpp
+SOURCES += OfflineRenderer.cpp
+SOURCES += TestInputMidiFiltering.cpp
+SOURCES += TestLookAheadDecoding.cpp
+SOURCES += TestOfflineRender.cpp
+SOURCES += test_Render.cpp
+
+linux{
+    contains(QMAKE_HOST.arch, x86_64) {
+        LIBS_PATH = "static/linux64"
+    } else {
+        LIBS_PATH = "static/linux32"
+    }
+
+    LIBS += -L$$PWD/../../../libs/$$LIBS_PATH -lminimp3 -lvorbisfile -lvorbisenc -lvorbis -logg -lavformat -lavcodec -lswscale -lavutil -lswresample -lminiupnpc -lx264
+    LIBS += -ldl
+    LIBS += -lz
+}
@@ -0,0 +1,28 @@
+#include <QApplication>
+#include <QStandardPaths>
+#include <QtTest>
+
+#include "TestOfflineRender.h"
+#include "TestLookAheadDecoding.h"
+#include "TestInputMidiFiltering.h"
+
+int main(int argc, char *argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen"); // running in CI, without display
+
+    QStandardPaths::setTestModeEnabled(true); // the user cache and presets are not touched
+
+    QApplication application(argc, argv); // MainController is using QApplication
+
+    TestOfflineRender testOfflineRender;
+    TestLookAheadDecoding testLookAheadDecoding;
+    TestInputMidiFiltering testInputMidiFiltering;
+
+    int result = QTest::qExec(&testOfflineRender, argc, argv);
+
+    result |= QTest::qExec(&testLookAheadDecoding, argc, argv);
+    result |= QTest::qExec(&testInputMidiFiltering, argc, argv);
+
+    return result;
+}
@@ -0,0 +1,346 @@
+#include "TestVstBridge.h"
+
+#include <QTest>
+#include <QThread>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+
+#include <atomic>
+#include <vector>
+
+#include "vst/VstBridge.h"
+#include "audio/core/AudioNodeProcessor.h"
+#include "audio/core/SamplesBuffer.h"
+
+using vst::BridgeChannel;
+using vst::BridgeClient;
+using vst::BridgeServer;
+using audio::SamplesBuffer;
+
+namespace {
+
+// the in-tree processors are used as 'plugins', no VST binaries are necessary to test the bridge
+class StubProcessor : public audio::AudioNodeProcessor
+{
+public:
+    void suspend() override {}
+    void resume() override {}
+    void updateGui() override {}
+    void openEditor(const QPoint &) override {}
+    void closeEditor() override {}
+};
+
+class GainProcessor : public StubProcessor
+{
+public:
+    void process(const SamplesBuffer &in, SamplesBuffer &out, std::vector<midi::MidiMessage> &) override
+    {
+        out.set(in);
+        out.applyGain(0.5f, 1.0f);
+    }
+};
+
+class StalledProcessor : public StubProcessor
+{
+public:
+    StalledProcessor() :
+        released(false)
+    {
+    }
+
+    void process(const SamplesBuffer &, SamplesBuffer &, std::vector<midi::MidiMessage> &) override
+    {
+        while (!released.load())
+            QThread::msleep(1);
+    }
+
+    std::atomic<bool> released;
+};
+
+class MidiRecorder : public StubProcessor
+{
+public:
+    void process(const SamplesBuffer &, SamplesBuffer &, std::vector<midi::MidiMessage> &midiMessages) override
+    {
+        received.insert(received.end(), midiMessages.begin(), midiMessages.end());
+    }
+
+    std::vector<midi::MidiMessage> received;
+};
+
+QString createKey()
+{
+    static int instances = 0;
+    return QString("JamtabaTestVstBridge-%1-%2").arg(QCoreApplication::applicationPid()).arg(instances++);
+}
+
+bool waitReply(const BridgeChannel &channel)
+{
+    auto block = channel.getBlock();
+
+    QElapsedTimer timer;
+    timer.start();
+    while (block->replySequence.load() != block->requestSequence.load()) {
+        if (timer.elapsed() > 1000)
+            return false;
+
+        QThread::usleep(100);
+    }
+
+    return true;
+}
+
+float inputSample(quint64 frame, int channel)
+{
+    return (frame % 1000) / 1000.0f * (channel == 0 ? 1.0f : -1.0f);
+}
+
+void fillInput(SamplesBuffer &in, quint64 firstFrame)
+{
+    for (int c = 0; c < in.getChannels(); ++c) {
+        for (uint s = 0; s < in.getFrameLenght(); ++s)
+            in.set(c, s, inputSample(firstFrame + s, c));
+    }
+}
+
+} // namespace
+
+void TestVstBridge::outputIsDelayedByConstantLatency_data()
+{
+    QTest::addColumn<int>("latency");
+    QTest::addColumn<int>("firstBlockSize");
+    QTest::addColumn<int>("secondBlockSize");
+
+    QTest::newRow("Fixed 128 samples blocks") << 128 << 128 << 128;
+    QTest::newRow("Split blocks, 100 + 28 samples") << 128 << 100 << 28;
+    QTest::newRow("Fixed 512 samples blocks") << 512 << 512 << 512;
+}
+
+void TestVstBridge::outputIsDelayedByConstantLatency()
+{
+    QFETCH(int, latency);
+    QFETCH(int, firstBlockSize);
+    QFETCH(int, secondBlockSize);
+
+    BridgeChannel channel(createKey());
+    QVERIFY(channel.create());
+
+    GainProcessor processor;
+    BridgeServer server(channel, processor);
+    server.start();
+
+    BridgeClient client(channel);
+    client.reset(static_cast<uint>(latency));
+
+    SamplesBuffer in(2, BridgeChannel::MAX_FRAMES);
+    SamplesBuffer out(2, BridgeChannel::MAX_FRAMES);
+    std::vector<midi::MidiMessage> midiBuffer;
+
+    quint64 frame = 0;
+    for (int block = 0; block < 64; ++block) {
+        uint frames = static_cast<uint>(block % 2 ? secondBlockSize : firstBlockSize);
+        in.setFrameLenght(frames);
+        out.setFrameLenght(frames);
+        fillInput(in, frame);
+
+        client.process(in, out, midiBuffer);
+        QVERIFY(waitReply(channel)); // the next callback will never miss the deadline
+
+        for (int c = 0; c < 2; ++c) {
+            for (uint s = 0; s < frames; ++s) {
+                quint64 outputFrame = frame + s;
+                float expected = outputFrame < static_cast<quint64>(latency) ? 0.0f : inputSample(outputFrame - latency, c) * 0.5f;
+                QCOMPARE(out.get(c, s), expected);
+            }
+        }
+
+        frame += frames;
+    }
+
+    QCOMPARE(client.getMissedBlocks(), 0u);
+    QVERIFY(!client.isWatchdogTriggered());
+
+    server.stop();
+}
+
+void TestVstBridge::splitBlocksAreSentInOneRequest_data()
+{
+    QTest::addColumn<int>("hostBlockSize");
+    QTest::addColumn<int>("firstSubBlockSize");
+
+    QTest::newRow("128 samples, 100 + 28") << 128 << 100;
+    QTest::newRow("256 samples, 1 + 255") << 256 << 1;
+    QTest::newRow("512 samples, 300 + 212") << 512 << 300;
+}
+
+void TestVstBridge::splitBlocksAreSentInOneRequest()
+{
+    QFETCH(int, hostBlockSize);
+    QFETCH(int, firstSubBlockSize);
+
+    BridgeChannel channel(createKey());
+    QVERIFY(channel.create());
+
+    GainProcessor processor;
+    BridgeServer server(channel, processor);
+    server.start();
+
+    BridgeClient client(channel);
+    client.reset(static_cast<uint>(hostBlockSize));
+
+    SamplesBuffer in(2, BridgeChannel::MAX_FRAMES);
+    SamplesBuffer out(2, BridgeChannel::MAX_FRAMES);
+    std::vector<midi::MidiMessage> midiBuffer;
+
+    quint64 frame = 0;
+    for (int hostBlock = 0; hostBlock < 32; ++hostBlock) {
+        const uint subBlocks[2] = { static_cast<uint>(firstSubBlockSize), static_cast<uint>(hostBlockSize - firstSubBlockSize) };
+        for (uint frames : subBlocks) { // no waiting between the sub-blocks
+            in.setFrameLenght(frames);
+            out.setFrameLenght(frames);
+            fillInput(in, frame);
+
+            client.process(in, out, midiBuffer);
+
+            for (int c = 0; c < 2; ++c) {
+                for (uint s = 0; s < frames; ++s) {
+                    quint64 outputFrame = frame + s;
+                    float expected = outputFrame < static_cast<quint64>(hostBlockSize) ? 0.0f : inputSample(outputFrame - hostBlockSize, c) * 0.5f;
+                    QCOMPARE(out.get(c, s), expected);
+                }
+            }
+
+            frame += frames;
+        }
+
+        QVERIFY(waitReply(channel)); // the next host block will never miss the deadline
+    }
+
+    QCOMPARE(client.getMissedBlocks(), 0u);
+    QVERIFY(!client.isWatchdogTriggered());
+
+    server.stop();
+}
+
+void TestVstBridge::latencyFollowsBlockSizeChange()
+{
+    BridgeChannel channel(createKey());
+    QVERIFY(channel.create());
+
+    GainProcessor processor;
+    BridgeServer server(channel, processor);
+    server.start();
+
+    BridgeClient client(channel);
+
+    SamplesBuffer in(2, BridgeChannel::MAX_FRAMES);
+    SamplesBuffer out(2, BridgeChannel::MAX_FRAMES);
+    std::vector<midi::MidiMessage> midiBuffer;
+
+    const uint blockSizes[2] = { 256, 512 };
+    for (uint blockSize : blockSizes) {
+        client.reset(blockSize);
+        in.setFrameLenght(blockSize);
+        out.setFrameLenght(blockSize);
+
+        for (quint64 frame = 0; frame < blockSize * 16; frame += blockSize) {
+            fillInput(in, frame);
+
+            client.process(in, out, midiBuffer);
+            QVERIFY(waitReply(channel));
+
+            for (int c = 0; c < 2; ++c) {
+                for (uint s = 0; s < blockSize; ++s) {
+                    quint64 outputFrame = frame + s;
+                    float expected = outputFrame < blockSize ? 0.0f : inputSample(outputFrame - blockSize, c) * 0.5f;
+                    QCOMPARE(out.get(c, s), expected);
+                }
+            }
+        }
+    }
+
+    QCOMPARE(client.getMissedBlocks(), 0u);
+
+    server.stop();
+}
+
+void TestVstBridge::watchdogBypassStalledBridge()
+{
+    const uint frames = 64;
+
+    BridgeChannel channel(createKey());
+    QVERIFY(channel.create());
+
+    StalledProcessor processor;
+    BridgeServer server(channel, processor);
+    server.start();
+
+    BridgeClient client(channel);
+    client.reset(frames);
+
+    SamplesBuffer in(2, frames);
+    SamplesBuffer out(2, frames);
+    std::vector<midi::MidiMessage> midiBuffer;
+
+    client.process(in, out, midiBuffer); // the request is never replied
+    QVERIFY(!client.isWatchdogTriggered());
+
+    quint64 frame = frames;
+    for (int block = 1; block <= BridgeClient::MAX_CONSECUTIVE_MISSES; ++block) {
+        fillInput(in, frame);
+        client.process(in, out, midiBuffer);
+
+        QCOMPARE(client.getMissedBlocks(), static_cast<quint32>(block)); // one miss per callback
+
+        if (block > 1) { // the passed input is delayed like the processed output
+            for (uint s = 0; s < frames; ++s)
+                QCOMPARE(out.get(0, s), inputSample(frame - frames + s, 0));
+        }
+
+        frame += frames;
+    }
+
+    QVERIFY(client.isWatchdogTriggered());
+
+    processor.released = true;
+    server.stop();
+}
+
+void TestVstBridge::midiMessagesAreForwarded()
+{
+    const uint frames = 256;
+
+    BridgeChannel channel(createKey());
+    QVERIFY(channel.create());
+
+    MidiRecorder processor;
+    BridgeServer server(channel, processor);
+    server.start();
+
+    BridgeClient client(channel);
+    client.reset(frames);
+
+    SamplesBuffer in(2, frames);
+    SamplesBuffer out(2, frames);
+
+    std::vector<midi::MidiMessage> midiBuffer;
+    midiBuffer.push_back(midi::MidiMessage(0x90 | (60 << 8) | (100 << 16), 0)); // note on
+    midiBuffer.back().setFrameOffset(17);
+    midiBuffer.push_back(midi::MidiMessage(0x80 | (60 << 8), 0)); // note off
+    midiBuffer.back().setFrameOffset(200);
+
+    client.process(in, out, midiBuffer);
+    QVERIFY(waitReply(channel));
+
+    QCOMPARE(processor.received.size(), static_cast<size_t>(2));
+
+    QCOMPARE(processor.received[0].getStatus(), 0x90);
+    QCOMPARE(processor.received[0].getData1(), 60);
+    QCOMPARE(processor.received[0].getData2(), 100);
+    QCOMPARE(processor.received[0].getFrameOffset(), 17u);
+
+    QCOMPARE(processor.received[1].getStatus(), 0x80);
+    QCOMPARE(processor.received[1].getFrameOffset(), 200u);
+
+    server.stop();
+}
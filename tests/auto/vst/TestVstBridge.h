@@ -0,0 +1,28 @@
+#ifndef TESTVSTBRIDGE_H
+#define TESTVSTBRIDGE_H
+
+#include <QObject>
+
+class TestVstBridge: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    // the bridged output is the processed input delayed by a constant latency, even with variable block sizes
+    void outputIsDelayedByConstantLatency();
+    void outputIsDelayedByConstantLatency_data();
+
+    // NinjamController split the host block, the sub-blocks are processed back to back in the same callback
+    void splitBlocksAreSentInOneRequest();
+    void splitBlocksAreSentInOneRequest_data();
+
+    // the audio driver was restarted with a new buffer size, the latency follows the new block size
+    void latencyFollowsBlockSizeChange();
+
+    // a stalled bridge is bypassed after MAX_CONSECUTIVE_MISSES blocks, the dry signal keeps the latency
+    void watchdogBypassStalledBridge();
+
+    void midiMessagesAreForwarded();
+};
+
+#endif // TESTVSTBRIDGE_H
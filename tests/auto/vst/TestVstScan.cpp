@@ -0,0 +1,168 @@
+#include "TestVstScan.h"
+
+#include <QTest>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QDateTime>
+
+#include "vst/ScanMessage.h"
+#include "vst/PluginScanCache.h"
+
+using vst::ScanMessage;
+using vst::PluginScanCache;
+
+namespace {
+
+void writeFile(const QString &path, const QByteArray &content)
+{
+    QFile file(path);
+    QVERIFY(file.open(QFile::WriteOnly));
+    file.write(content);
+}
+
+} // namespace
+
+void TestVstScan::messagesAreParsedFromChunks()
+{
+    QByteArray data = ScanMessage(ScanMessage::ScanStarted, "C:/VST/Synth.dll").serialize();
+    data.append(ScanMessage(ScanMessage::PluginFounded, "C:/VST/Synth.dll", "Synth", "Jamtaba").serialize());
+    data.append(ScanMessage(ScanMessage::NotAPlugin, "C:/VST/readme.dll").serialize());
+
+    QList<ScanMessage> messages;
+    QByteArray buffer;
+    ScanMessage message;
+    for (char byte : data) { // worst case, one byte per read
+        buffer.append(byte);
+        while (ScanMessage::parse(buffer, message))
+            messages.append(message);
+    }
+
+    QCOMPARE(messages.size(), 3);
+
+    QCOMPARE(messages.at(0).getType(), ScanMessage::ScanStarted);
+    QCOMPARE(messages.at(0).getPath(), QString("C:/VST/Synth.dll"));
+
+    QCOMPARE(messages.at(1).getType(), ScanMessage::PluginFounded);
+    QCOMPARE(messages.at(1).getName(), QString("Synth"));
+    QCOMPARE(messages.at(1).getManufacturer(), QString("Jamtaba"));
+
+    QCOMPARE(messages.at(2).getType(), ScanMessage::NotAPlugin);
+    QCOMPARE(messages.at(2).getPath(), QString("C:/VST/readme.dll"));
+
+    QVERIFY(buffer.isEmpty());
+}
+
+void TestVstScan::messagesAreParsedAfterGarbage_data()
+{
+    QTest::addColumn<QByteArray>("garbage");
+
+    QTest::newRow("Text") << QByteArray("Plugin initialized!\nLicense OK\n");
+    QTest::newRow("Partial magic") << QByteArray("\x4A\x54\x53", 3);
+    QTest::newRow("Magic and a huge size") << QByteArray("\x4A\x54\x53\x4D\xFF\xFF\xFF\xFF", 8);
+}
+
+void TestVstScan::messagesAreParsedAfterGarbage()
+{
+    QFETCH(QByteArray, garbage);
+
+    QByteArray buffer(garbage);
+    buffer.append(ScanMessage(ScanMessage::PluginFounded, "/vst/Delay.so", "Delay", "").serialize());
+    buffer.append(garbage);
+    buffer.append(ScanMessage(ScanMessage::NotAPlugin, "/vst/libfoo.so").serialize());
+
+    ScanMessage message;
+    QVERIFY(ScanMessage::parse(buffer, message));
+    QCOMPARE(message.getType(), ScanMessage::PluginFounded);
+    QCOMPARE(message.getPath(), QString("/vst/Delay.so"));
+
+    QVERIFY(ScanMessage::parse(buffer, message));
+    QCOMPARE(message.getType(), ScanMessage::NotAPlugin);
+    QCOMPARE(message.getPath(), QString("/vst/libfoo.so"));
+
+    QVERIFY(!ScanMessage::parse(buffer, message));
+}
+
+void TestVstScan::cacheEntriesAreFingerprinted()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    QString pluginPath = dir.path() + "/Plugin.dll";
+    writeFile(pluginPath, "first version");
+
+    PluginScanCache cache(dir.path() + "/cache.bin");
+    QVERIFY(!cache.isUpToDate(QFileInfo(pluginPath)));
+
+    cache.update(QFileInfo(pluginPath), true, "Plugin", "Vendor");
+    QVERIFY(cache.isUpToDate(QFileInfo(pluginPath)));
+
+    writeFile(pluginPath, "the second version is bigger"); // plugin updated
+    QVERIFY(!cache.isUpToDate(QFileInfo(pluginPath)));
+
+    cache.update(QFileInfo(pluginPath), false);
+    QVERIFY(cache.isUpToDate(QFileInfo(pluginPath)));
+    QVERIFY(!cache.getEntry(pluginPath).validPlugin);
+
+    cache.remove(pluginPath);
+    QVERIFY(!cache.isUpToDate(QFileInfo(pluginPath)));
+}
+
+void TestVstScan::cacheIsPersisted()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    QString validPlugin = dir.path() + "/Valid.dll";
+    QString invalidPlugin = dir.path() + "/Invalid.dll";
+    writeFile(validPlugin, "valid");
+    writeFile(invalidPlugin, "invalid");
+
+    QString cacheFile = dir.path() + "/cache.bin";
+    {
+        PluginScanCache cache(cacheFile);
+        QVERIFY(!cache.load()); // no file in first scan
+        cache.update(QFileInfo(validPlugin), true, "Valid", "Vendor");
+        cache.update(QFileInfo(invalidPlugin), false);
+        QVERIFY(cache.save());
+    }
+
+    PluginScanCache cache(cacheFile);
+    QVERIFY(cache.load());
+    QCOMPARE(cache.getSize(), 2);
+
+    QVERIFY(cache.isUpToDate(QFileInfo(validPlugin)));
+    QVERIFY(cache.isUpToDate(QFileInfo(invalidPlugin)));
+
+    auto entry = cache.getEntry(validPlugin);
+    QVERIFY(entry.validPlugin);
+    QCOMPARE(entry.name, QString("Valid"));
+    QCOMPARE(entry.manufacturer, QString("Vendor"));
+
+    writeFile(cacheFile, "corrupted"); // invalid header
+    QVERIFY(!cache.load());
+    QCOMPARE(cache.getSize(), 0);
+}
+
+void TestVstScan::missingFilesAreRemovedFromCache()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    QString installedPlugin = dir.path() + "/Installed.dll";
+    QString removedPlugin = dir.path() + "/Removed.dll";
+    writeFile(installedPlugin, "installed");
+    writeFile(removedPlugin, "removed");
+
+    PluginScanCache cache(dir.path() + "/cache.bin");
+    cache.update(QFileInfo(installedPlugin), true, "Installed", "Vendor");
+    cache.update(QFileInfo(removedPlugin), false);
+    QCOMPARE(cache.removeMissingFiles(), 0);
+
+    QVERIFY(QFile::remove(removedPlugin)); // plugin uninstalled
+    QCOMPARE(cache.removeMissingFiles(), 1);
+    QCOMPARE(cache.getSize(), 1);
+    QVERIFY(cache.isUpToDate(QFileInfo(installedPlugin)));
+
+    cache.clear(); // scanning all plugins again
+    QCOMPARE(cache.getSize(), 0);
+}
@@ -0,0 +1,24 @@
+#ifndef TESTVSTSCAN_H
+#define TESTVSTSCAN_H
+
+#include <QObject>
+
+class TestVstScan: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    // the scanner messages can be received in small chunks, mixed with garbage written by plugins
+    void messagesAreParsedFromChunks();
+    void messagesAreParsedAfterGarbage();
+    void messagesAreParsedAfterGarbage_data();
+
+    // changed files are scanned again, unchanged files are skipped
+    void cacheEntriesAreFingerprinted();
+    void cacheIsPersisted();
+
+    // deleted plugin files are not kept in the cache forever
+    void missingFilesAreRemovedFromCache();
+};
+
+#endif // TESTVSTSCAN_H
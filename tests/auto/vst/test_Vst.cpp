@@ -0,0 +1,17 @@
+#include <QObject>
+
+#include <QtTest>
+#include "TestVstBridge.h"
+#include "TestVstScan.h"
+
+int main(int argc, char *argv[])
+{
+    TestVstBridge testVstBridge;
+    TestVstScan testVstScan;
+
+    int result = QTest::qExec(&testVstBridge, argc, argv);
+
+    result |= QTest::qExec(&testVstScan, argc, argv);
+
+    return result;
+}
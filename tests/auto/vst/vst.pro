@@ -0,0 +1,41 @@
+QT += testlib
+QT -= gui
+CONFIG += testcase
+CONFIG += c++11
+TEMPLATE = app
+TARGET = vst
+
+INCLUDEPATH += .
+INCLUDEPATH += ../../../src/Common
+VPATH += ../../../src/Common
+
+HEADERS += TestVstBridge.h
+HEADERS += TestVstScan.h
+HEADERS += vst/VstBridge.h
+HEADERS += vst/ScanMessage.h
+HEADERS += vst/PluginScanCache.h
+HEADERS += persistence/CacheHeader.h
+HEADERS += audio/core/AudioNodeProcessor.h
+HEADERS += audio/core/SamplesBuffer.h
+HEADERS += audio/core/SimdKernels.h
+HEADERS += audio/core/SamplesRingBuffer.h
+HEADERS += audio/core/AudioPeak.h
+HEADERS += midi/MidiMessage.h
+
+SOURCES += TestVstBridge.cpp
+SOURCES += TestVstScan.cpp
+SOURCES += vst/VstBridge.cpp
+SOURCES += vst/ScanMessage.cpp
+SOURCES += vst/PluginScanCache.cpp
+SOURCES += persistence/CacheHeader.cpp
+SOURCES += audio/core/AudioNodeProcessor.cpp
+SOURCES += audio/core/SamplesBuffer.cpp
+SOURCES += audio/core/SimdKernels.cpp
+SOURCES += audio/core/SamplesRingBuffer.cpp
+SOURCES += audio/core/AudioPeak.cpp
+SOURCES += midi/MidiMessage.cpp
+SOURCES += log/logging.cpp
+
+linux:LIBS += -lrt # shm_open in old glibc versions
+
+SOURCES += test_Vst.cpp